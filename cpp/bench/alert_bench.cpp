@@ -0,0 +1,79 @@
+#include "bench.h"
+#include "alert_engine.h"
+#include <cstdio>
+#include <string>
+
+// One evaluation of every rule bound to the CPU, disk and process samples
+// of a 256-core host, by rule count. Rules are spread over the host, every
+// core, every disk and the ranked processes, and none of them fires, which
+// is the steady state (allocsPerOp should be zero); cpu-busy has one core
+// past the per-core thresholds, measured once its rules have fired.
+MONITOR_BENCH_SUITE(alerts) {
+    Snapshot snap;
+    CPUInfo& cpu = editSection(snap.cpu);
+    std::vector<DiskInfo>& disks = editSection(snap.disks);
+    std::vector<ProcessInfo>& processes = editSection(snap.processes);
+    cpu.coreUsage.assign(256, 40.0);
+    cpu.coreTimes.resize(256);
+    disks.resize(16);
+    for (size_t i = 0; i < disks.size(); ++i) {
+        disks[i].name = "nvme" + std::to_string(i) + "n1";
+        disks[i].total = 1000.0;
+        disks[i].free = 500.0;
+    }
+    processes.resize(32);
+    for (size_t i = 0; i < processes.size(); ++i) {
+        processes[i].pid = static_cast<int>(1000 + i);
+        processes[i].name = "worker" + std::to_string(i % 4);
+        processes[i].cpuUsage = 20.0;
+        processes[i].memoryUsage = 256.0;
+    }
+
+    const char* const templates[] = {
+        "cpu.usage > %d for 10s",
+        "cpu.core.* > %d for 30s clear 80",
+        "disk.*.free < %dMB",
+        "disk.*.usedPercent > %d clear 85",
+        "process.*.cpuUsage > %d for 5s",
+        "process.worker1.memoryUsage > %dGB",
+    };
+    const size_t ruleCounts[] = {100, 1000, 5000};
+    for (size_t count : ruleCounts) {
+        std::vector<std::string> rules;
+        for (size_t i = 0; i < count; ++i) {
+            char rule[64];
+            std::snprintf(rule, sizeof(rule), templates[i % 6], static_cast<int>(90 + i % 9));
+            rules.push_back(rule);
+        }
+        AlertEngine engine;
+        std::string error;
+        engine.compile(rules, error);
+
+        int64_t now = 0;
+        const std::pair<Collector, const char*> collectors[] = {
+            {Collector::CPU, "cpu"}, {Collector::Disk, "disk"}, {Collector::Process, "process"}};
+        for (const auto& entry : collectors) {
+            Collector collector = entry.first;
+            results.push_back(bench::measure(
+                std::string("alerts/evaluate/") + entry.second + "/rules:" + std::to_string(count),
+                [&] {
+                    now += 250;
+                    engine.evaluate(collector, snap, now, now);
+                }));
+        }
+
+        // One busy core keeps the per-core rules firing, so they visit every
+        // core instead of being ruled out by the column's range. The longest
+        // `for` (30 s) passes before measuring.
+        cpu.coreUsage[0] = 99.5;
+        for (int i = 0; i < 124; ++i) {
+            now += 250;
+            engine.evaluate(Collector::CPU, snap, now, now);
+        }
+        results.push_back(bench::measure("alerts/evaluate/cpu-busy/rules:" + std::to_string(count), [&] {
+            now += 250;
+            engine.evaluate(Collector::CPU, snap, now, now);
+        }));
+        cpu.coreUsage[0] = 40.0;
+    }
+}
@@ -0,0 +1,50 @@
+#include "bench.h"
+#include "anomaly_detector.h"
+#include <string>
+
+// One sample scored by every detector and folded into the baselines, by
+// core count, on a host with 8 disks, 4 interfaces and 32 ranked processes.
+// The detectors are warmed up first and nothing is flagged, which is the
+// steady state (allocsPerOp should be zero).
+MONITOR_BENCH_SUITE(anomalies) {
+    const size_t coreCounts[] = {8, 64, 256};
+    for (size_t cores : coreCounts) {
+        AnomalyDetector detector;
+
+        Snapshot snap;
+        CPUInfo& cpu = editSection(snap.cpu);
+        std::vector<DiskInfo>& disks = editSection(snap.disks);
+        NetworkInfo& network = editSection(snap.network);
+        std::vector<ProcessInfo>& processes = editSection(snap.processes);
+        snap.timestampMs = 1700000000000;
+        cpu.coreUsage.assign(cores, 12.5);
+        disks.resize(8);
+        for (size_t i = 0; i < disks.size(); ++i) disks[i].name = "sd" + std::string(1, 'a' + i);
+        network.interfaces.resize(4);
+        for (size_t i = 0; i < network.interfaces.size(); ++i) {
+            network.interfaces[i].name = "eth" + std::to_string(i);
+        }
+        processes.resize(32);
+        for (size_t i = 0; i < processes.size(); ++i) {
+            processes[i].pid = static_cast<int>(1000 + i);
+            processes[i].name = "worker";
+        }
+        int64_t now = 0;
+        auto record = [&] {
+            now += 1000;
+            snap.timestampMs += 1000;
+            double wobble = static_cast<double>(now / 1000 % 3);
+            cpu.totalUsage = 40.0 + wobble;
+            for (size_t i = 0; i < cores; ++i) cpu.coreUsage[i] = 40.0 + wobble;
+            for (ProcessInfo& proc : processes) proc.cpuUsage = 10.0 + wobble;
+            detector.record(snap, now);
+        };
+        for (int i = 0; i < 300; ++i) record();
+
+        std::string suffix = "/cores:" + std::to_string(cores) + "/kb:" + std::to_string(detector.memoryBytes() / 1024);
+        results.push_back(bench::measure("anomalies/record" + suffix, record));
+
+        AnomalyInfo info;
+        results.push_back(bench::measure("anomalies/report" + suffix, [&] { detector.report(info); }));
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Minimal benchmark harness for monitor_bench. Suites register themselves
+// with MONITOR_BENCH_SUITE and report one Result per measured operation.
+namespace bench {
+
+// Incremented by the global operator new replacement in bench_main.cpp
+extern std::atomic<uint64_t> allocationCount;
+
+// Syscalls made by the process so far, or -1 where they cannot be counted.
+// Every syscall is counted through the raw_syscalls:sys_enter tracepoint
+// when perf can open it (tracefs mounted, and root, CAP_PERFMON or
+// perf_event_paranoid <= 1). Otherwise only the read- and write-family
+// calls of /proc/self/io (syscr and syscw) are, which misses opens, closes,
+// getdents and io_uring submissions; see syscallsExact().
+int64_t syscallCount();
+bool syscallsExact();
+
+// The capture given with --capture (see src/linux/capture.h), or empty.
+// Suites that replay it add nothing without one.
+const std::string& capturePath();
+
+struct Result {
+    std::string name;
+    uint64_t iterations = 0;
+    double nsPerOp = 0.0;
+    double allocsPerOp = 0.0;
+    double bytesPerOp = 0.0; // Output size, where meaningful
+    double syscallsPerOp = -1.0; // From syscallCount(), or set exactly by the suite; -1 if unknown
+    bool syscallsExact = false; // Every syscall, not only reads and writes
+};
+
+using Suite = void (*)(std::vector<Result>& results);
+
+struct Registration {
+    Registration(const char* name, Suite suite);
+};
+
+// Runs `op` in growing batches until at least `minTime` has elapsed and
+// returns the per-operation averages. `op` is run once beforehand so that
+// reusable buffers reach their steady-state capacity. Reading the syscall
+// counter costs one read of its own, which is subtracted.
+template <typename Op>
+Result measure(const std::string& name, Op op,
+               std::chrono::nanoseconds minTime = std::chrono::milliseconds(300)) {
+    op();
+
+    using Clock = std::chrono::steady_clock;
+    uint64_t iterations = 0;
+    uint64_t batch = 1;
+    uint64_t allocsBefore = allocationCount.load(std::memory_order_relaxed);
+    int64_t syscallsBefore = syscallCount();
+    auto start = Clock::now();
+    auto elapsed = Clock::duration::zero();
+    while (elapsed < minTime) {
+        for (uint64_t i = 0; i < batch; ++i) op();
+        iterations += batch;
+        batch *= 2;
+        elapsed = Clock::now() - start;
+    }
+    uint64_t allocs = allocationCount.load(std::memory_order_relaxed) - allocsBefore;
+    int64_t syscallsAfter = syscallCount();
+
+    Result result;
+    result.name = name;
+    result.iterations = iterations;
+    result.nsPerOp = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    result.allocsPerOp = static_cast<double>(allocs) / iterations;
+    result.syscallsExact = syscallsExact();
+    if (syscallsBefore >= 0 && syscallsAfter >= 0) {
+        int64_t syscalls = syscallsAfter - syscallsBefore - 1;
+        result.syscallsPerOp = static_cast<double>(syscalls > 0 ? syscalls : 0) / iterations;
+    }
+    return result;
+}
+
+} // namespace bench
+
+#define MONITOR_BENCH_SUITE(name)                                          \
+    static void name(std::vector<bench::Result>& results);                \
+    static bench::Registration name##_registration(#name, name);          \
+    static void name(std::vector<bench::Result>& results)
@@ -0,0 +1,219 @@
+#include "bench.h"
+#include "json_writer.h"
+#include "platform.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <thread>
+#ifdef MONITOR_BACKEND_LINUX
+#include "linux/procfs.h"
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+std::atomic<uint64_t> allocationCount{0};
+
+namespace {
+struct SuiteEntry {
+    const char* name;
+    Suite suite;
+};
+
+std::vector<SuiteEntry>& registry() {
+    static std::vector<SuiteEntry> suites;
+    return suites;
+}
+
+std::string captureFile;
+
+#ifdef MONITOR_BACKEND_LINUX
+// Counter of the raw_syscalls:sys_enter tracepoint for this process and
+// the threads it starts, or -1
+int openSyscallCounter() {
+    const char* const idFiles[] = {"/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+                                   "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"};
+    for (const char* path : idFiles) {
+        uint64_t id = 0;
+        if (!(std::ifstream(path) >> id)) continue;
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_TRACEPOINT;
+        attr.size = sizeof(attr);
+        attr.config = id;
+        attr.inherit = 1;
+        long fd = ::syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+        if (fd >= 0) return static_cast<int>(fd);
+    }
+    return -1;
+}
+
+int syscallCounter() {
+    static int fd = openSyscallCounter();
+    return fd;
+}
+#endif
+}
+
+Registration::Registration(const char* name, Suite suite) {
+    registry().push_back({name, suite});
+}
+
+const std::string& capturePath() {
+    return captureFile;
+}
+
+bool syscallsExact() {
+#ifdef MONITOR_BACKEND_LINUX
+    return syscallCounter() >= 0;
+#else
+    return false;
+#endif
+}
+
+int64_t syscallCount() {
+#ifdef MONITOR_BACKEND_LINUX
+    if (syscallCounter() >= 0) {
+        uint64_t value = 0;
+        if (::read(syscallCounter(), &value, sizeof(value)) == sizeof(value)) return static_cast<int64_t>(value);
+    }
+
+    static ProcFile ioFile;
+    if (!ioFile.isOpen() && !ioFile.open("/proc/self/io")) return -1;
+    if (!ioFile.read()) return -1;
+    int64_t count = 0;
+    const char* end = ioFile.end();
+    for (const char* p = ioFile.begin(); p < end; p = procfs::nextLine(p, end)) {
+        if (procfs::startsWith(p, end, "syscr:") || procfs::startsWith(p, end, "syscw:")) {
+            uint64_t value = 0;
+            procfs::parseU64(p + 6, end, value);
+            count += static_cast<int64_t>(value);
+        }
+    }
+    return count;
+#else
+    return -1;
+#endif
+}
+
+} // namespace bench
+
+// Count every heap allocation made by the process
+void* operator new(size_t size) {
+    bench::allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+// One document per run, for diffing between builds: the host, then every
+// result in run order. Syscalls are syscallsPerOp when every call was
+// counted, readWritesPerOp when only reads and writes were, and left out
+// where they are unknown.
+std::string formatJson(const std::vector<bench::Result>& results) {
+    std::string out;
+    JsonWriter json(out, 3);
+    json.beginObject();
+    json.key("host");
+    json.beginObject();
+    json.field("cpus", static_cast<int>(std::thread::hardware_concurrency()));
+#ifdef MONITOR_BACKEND_LINUX
+    utsname system;
+    if (uname(&system) == 0) json.field("kernel", system.release);
+    json.field("backend", "linux");
+#else
+    json.field("backend", "windows");
+#endif
+    json.endObject();
+    json.key("results");
+    json.beginArray();
+    for (const bench::Result& r : results) {
+        json.beginObject();
+        json.field("name", r.name);
+        json.field("iterations", r.iterations);
+        json.field("nsPerOp", r.nsPerOp);
+        json.field("allocsPerOp", r.allocsPerOp);
+        json.field("bytesPerOp", r.bytesPerOp);
+        if (r.syscallsPerOp >= 0.0) json.field(r.syscallsExact ? "syscallsPerOp" : "readWritesPerOp", r.syscallsPerOp);
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+    out += '\n';
+    return out;
+}
+}
+
+// Usage: monitor_bench [--json FILE|-] [--capture FILE] [suite-substring]
+int main(int argc, char** argv) {
+    const char* filter = nullptr;
+    const char* jsonPath = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            bench::captureFile = argv[++i];
+        } else {
+            filter = argv[i];
+        }
+    }
+    // With "--json -" the document is the only thing on stdout
+    bool table = !jsonPath || std::strcmp(jsonPath, "-") != 0;
+    bench::syscallCount(); // Open the counter before anything is measured
+
+    if (table) {
+        std::printf("%-56s %12s %14s %12s %12s %12s\n", "benchmark", "iterations", "ns/op", "allocs/op",
+                    "bytes/op", "syscalls/op");
+    }
+    std::vector<bench::Result> all;
+    bool readWritesOnly = false;
+    for (const auto& entry : bench::registry()) {
+        if (filter && !std::strstr(entry.name, filter)) continue;
+
+        std::vector<bench::Result> results;
+        entry.suite(results);
+        for (const bench::Result& r : results) {
+            all.push_back(r);
+            if (!table) continue;
+            std::printf("%-56s %12llu %14.1f %12.2f %12.0f", r.name.c_str(),
+                        static_cast<unsigned long long>(r.iterations), r.nsPerOp, r.allocsPerOp, r.bytesPerOp);
+            if (r.syscallsPerOp >= 0.0) {
+                std::printf(" %12.1f%s\n", r.syscallsPerOp, r.syscallsExact ? "" : "*");
+                readWritesOnly = readWritesOnly || !r.syscallsExact;
+            } else {
+                std::printf(" %12s\n", "-");
+            }
+            std::fflush(stdout);
+        }
+    }
+
+    if (table && readWritesOnly) {
+        std::printf("* read- and write-family syscalls only (/proc/self/io); every syscall is counted where\n"
+                    "  perf can open the raw_syscalls:sys_enter tracepoint\n");
+    }
+
+    if (jsonPath) {
+        std::string document = formatJson(all);
+        if (!table) {
+            std::cout << document;
+        } else if (!(std::ofstream(jsonPath) << document)) {
+            std::cerr << "Cannot write " << jsonPath << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,349 @@
+#include "bench.h"
+#include "cpu_monitor.h"
+#include "disk_monitor.h"
+#include "memory_monitor.h"
+#include "network_monitor.h"
+#include "process_monitor.h"
+#include "self_monitor.h"
+#include "latency_histogram.h"
+#include <string>
+
+#ifdef MONITOR_BACKEND_LINUX
+#include "linux/capture.h"
+#include "linux/cgroup_monitor.h"
+#include "temp_tree.h"
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+namespace {
+// A cgroupfs-like tree: slices of ten groups each, every group with the
+// files a fully delegated cgroup has
+void makeCgroupFixture(const TempTree& tree, size_t groups) {
+    static const char* const files[][2] = {
+        {"cpu.stat", "usage_usec 123456789\nuser_usec 100000000\nsystem_usec 23456789\nnr_periods 0\n"
+                     "nr_throttled 0\nthrottled_usec 0\n"},
+        {"memory.current", "104857600\n"},
+        {"memory.stat", "anon 52428800\nfile 41943040\nkernel 4194304\nkernel_stack 65536\n"
+                        "pagetables 131072\nsock 0\nshmem 0\nfile_mapped 1048576\n"},
+        {"io.stat", "8:0 rbytes=1048576 wbytes=2097152 rios=256 wios=512 dbytes=0 dios=0\n"},
+        {"cpu.pressure", "some avg10=0.00 avg60=0.00 avg300=0.00 total=1000\n"
+                         "full avg10=0.00 avg60=0.00 avg300=0.00 total=0\n"},
+        {"memory.pressure", "some avg10=0.00 avg60=0.00 avg300=0.00 total=1000\n"
+                            "full avg10=0.00 avg60=0.00 avg300=0.00 total=500\n"},
+        {"io.pressure", "some avg10=0.00 avg60=0.00 avg300=0.00 total=1000\n"
+                        "full avg10=0.00 avg60=0.00 avg300=0.00 total=500\n"},
+    };
+    std::vector<std::string> directories{""};
+    for (size_t i = 0; i + 1 < groups; ++i) {
+        std::string path = "slice" + std::to_string(i / 10);
+        if (i % 10 == 0) {
+            directories.push_back(path);
+            if (++i + 1 >= groups) break;
+        }
+        directories.push_back(path + "/group" + std::to_string(i));
+    }
+    for (const std::string& directory : directories) {
+        std::string prefix = directory.empty() ? std::string() : directory + "/";
+        for (const auto& file : files) tree.write(prefix + file[0], file[1]);
+    }
+}
+
+// Synthetic trees are laid out like /, for the collectors' setRoot()
+
+// <root>/proc with `count` processes that have only their stat files
+void makeProcFixture(const TempTree& tree, int count) {
+    for (int pid = 1; pid <= count; ++pid) {
+        std::string stat = std::to_string(pid) + " (worker " + std::to_string(pid % 100) +
+                           ") S 1 1 1 0 -1 4194560 1200 0 0 0 " + std::to_string(pid % 977) +
+                           " 35 0 0 20 0 4 0 " + std::to_string(1000 + pid) +
+                           " 104857600 2560 18446744073709551615 1 1 0 0 0 0 0 0 0 0 0 0 17 0 0 0 0 0 0\n";
+        tree.write("proc/" + std::to_string(pid) + "/stat", stat);
+    }
+}
+
+// /proc/stat and /proc/cpuinfo of a machine with `cores` CPUs
+void makeCpuFixture(const TempTree& tree, int cores) {
+    std::string stat = "cpu  4705 356 584 3699176 23060 0 277 0 0 0\n";
+    std::string cpuinfo;
+    for (int i = 0; i < cores; ++i) {
+        stat += "cpu" + std::to_string(i) + " " + std::to_string(1000 + i) + " 89 146 924794 5765 0 69 0 0 0\n";
+        cpuinfo += "processor\t: " + std::to_string(i) + "\nmodel name\t: Synthetic CPU\ncpu MHz\t\t: " +
+                   std::to_string(2000 + i % 1000) + ".000\n\n";
+    }
+    stat += "intr 114930548 113199788 3 0 5 263 0 4 [...]\nctxt 1990473\nbtime 1062191376\nprocesses 2915\n"
+            "procs_running 1\nprocs_blocked 0\n";
+    tree.write("proc/stat", stat);
+    tree.write("proc/cpuinfo", cpuinfo);
+}
+
+// /proc/diskstats with `disks` NVMe devices
+void makeDiskFixture(const TempTree& tree, int disks) {
+    std::string diskstats;
+    for (int i = 0; i < disks; ++i) {
+        diskstats += " 259       " + std::to_string(i) + " nvme" + std::to_string(i) +
+                     "n1 1153720 2137 83318918 284311 4017386 1794133 241339296 4016451 0 1770076 4322763 0 0 0 0\n";
+    }
+    tree.write("proc/diskstats", diskstats);
+}
+}
+#endif
+
+// Cost of one collector tick against the live system, then against
+// synthetic trees across the range of machine sizes
+MONITOR_BENCH_SUITE(cpu) {
+    CPUMonitor cpu;
+    if (!cpu.initialize()) return;
+    cpu.update();
+    results.push_back(bench::measure("cpu/update/cores:" + std::to_string(cpu.getInfo().coreCount), [&] { cpu.update(); }));
+
+#ifdef MONITOR_BACKEND_LINUX
+    for (int cores : {8, 64, 512}) {
+        TempTree tree("monitor_cpu_bench");
+        if (tree.path().empty()) return;
+        makeCpuFixture(tree, cores);
+        CPUMonitor synthetic;
+        synthetic.setRoot(tree.path());
+        if (!synthetic.initialize()) continue;
+        synthetic.update();
+        results.push_back(bench::measure("cpu/update/fixture/cores:" + std::to_string(synthetic.getInfo().coreCount),
+                                         [&] { synthetic.update(); }));
+    }
+#endif
+}
+
+MONITOR_BENCH_SUITE(memory) {
+    MemoryMonitor memory;
+    if (!memory.initialize()) return;
+    memory.update();
+    results.push_back(bench::measure("memory/update", [&] { memory.update(); }));
+}
+
+MONITOR_BENCH_SUITE(disk) {
+    DiskMonitor disks;
+    if (!disks.initialize()) return;
+    disks.update();
+    size_t devices = disks.getInfo().size();
+    results.push_back(bench::measure("disk/update/devices:" + std::to_string(devices), [&] { disks.update(); }));
+
+#ifdef MONITOR_BACKEND_LINUX
+    for (int count : {1, 20, 200}) {
+        TempTree tree("monitor_disk_bench");
+        if (tree.path().empty()) return;
+        makeDiskFixture(tree, count);
+        DiskMonitor synthetic;
+        synthetic.setRoot(tree.path());
+        if (!synthetic.initialize()) continue;
+        synthetic.update();
+        results.push_back(bench::measure("disk/update/fixture/devices:" + std::to_string(count),
+                                         [&] { synthetic.update(); }));
+    }
+#endif
+}
+
+MONITOR_BENCH_SUITE(network) {
+    NetworkMonitor network;
+    if (!network.initialize()) return;
+    network.update();
+    size_t interfaces = network.getInfo().interfaces.size();
+    results.push_back(bench::measure("network/update/interfaces:" + std::to_string(interfaces), [&] { network.update(); }));
+}
+
+// Self-instrumentation: the timing wrapped around every sample, and the
+// once-a-second read of the monitor's own usage
+MONITOR_BENCH_SUITE(self) {
+    LatencyHistogram histogram;
+    int64_t value = 1;
+    results.push_back(bench::measure("self/time-and-record", [&] {
+        int64_t begin = monotonicNanos();
+        value = value * 3 % 1000003;
+        histogram.record(monotonicNanos() - begin + value);
+    }));
+
+    SelfMonitor self;
+    if (!self.initialize()) return;
+    self.update();
+    results.push_back(bench::measure("self/update", [&] { self.update(); }));
+}
+
+// Event mode samples the known PIDs; scan mode lists /proc every time
+MONITOR_BENCH_SUITE(process) {
+    for (bool useEvents : {false, true}) {
+        ProcessMonitor processes;
+        processes.setEventTracking(useEvents);
+        if (!processes.initialize()) return;
+        if (useEvents && !processes.isEventDriven()) continue; // Connector unavailable
+        processes.update();
+        std::string name = useEvents ? "process/update/events" : "process/update/scan";
+        name += "/processes:" + std::to_string(processes.getActivity().total);
+        results.push_back(bench::measure(name, [&] { processes.update(); }));
+    }
+
+    // The expensive fields only cost per ranked process, not per process
+    ProcessMonitor detailed;
+    if (!detailed.initialize()) return;
+    detailed.setFields(kProcessAllFields);
+    detailed.update();
+    results.push_back(bench::measure("process/update/all-fields", [&] { detailed.update(); }));
+
+#ifdef MONITOR_BACKEND_LINUX
+    // Scans of synthetic trees. Ranking keeps the top 32 with a partial
+    // selection; "top:all" sorts and reports every process instead.
+    for (int count : {100, 1000, 10000, 100000}) {
+        TempTree tree("monitor_process_bench");
+        if (tree.path().empty()) return;
+        makeProcFixture(tree, count);
+        for (bool all : {false, true}) {
+            if (all && count < 100000) continue;
+            ProcessMonitor synthetic;
+            synthetic.setEventTracking(false);
+            synthetic.setRoot(tree.path());
+            if (all) synthetic.setTopCapacity(static_cast<size_t>(count));
+            if (!synthetic.initialize()) continue;
+            synthetic.update();
+            results.push_back(bench::measure("process/update/fixture/processes:" + std::to_string(count) +
+                                                 (all ? "/top:all" : "/top:32"),
+                                             [&] { synthetic.update(); }));
+        }
+    }
+#endif
+}
+
+#ifdef MONITOR_BACKEND_LINUX
+// One synchronous open/read/close per process against io_uring batches, on
+// a synthetic tree and then on the live /proc
+MONITOR_BENCH_SUITE(procread) {
+    auto run = [&](const std::string& root, const std::string& label) {
+        for (bool batched : {false, true}) {
+            ProcessMonitor processes;
+            processes.setEventTracking(false);
+            processes.setBatchedReads(batched);
+            if (!root.empty()) processes.setRoot(root);
+            if (!processes.initialize()) return;
+            if (batched && !processes.isBatched()) continue; // io_uring unavailable
+            processes.update();
+            uint64_t before = processes.getReadSyscalls();
+            uint64_t updates = 0;
+            bench::Result result = bench::measure(
+                "procread/" + label + (batched ? "/io_uring" : "/sync") +
+                    "/processes:" + std::to_string(processes.getActivity().total),
+                [&] {
+                    processes.update();
+                    ++updates;
+                });
+            // Every open, read, close and io_uring_enter of the stat reads;
+            // listing /proc costs both modes the same
+            result.syscallsPerOp = static_cast<double>(processes.getReadSyscalls() - before) / updates;
+            result.syscallsExact = true;
+            results.push_back(result);
+        }
+    };
+
+    const int kProcesses = 50000;
+    {
+        TempTree tree("monitor_proc_bench");
+        if (!tree.path().empty()) {
+            makeProcFixture(tree, kProcesses);
+            run(tree.path(), "fixture");
+        }
+    }
+    run(std::string(), "live");
+}
+
+// Fixture trees of growing size, then the live hierarchy
+MONITOR_BENCH_SUITE(cgroup) {
+    const size_t groupCounts[] = {100, 1000, 4000};
+    for (size_t count : groupCounts) {
+        TempTree tree("monitor_cgroup_bench");
+        if (tree.path().empty()) return;
+        makeCgroupFixture(tree, count);
+        CgroupOptions options;
+        options.root = tree.path();
+        CgroupMonitor cgroups(options);
+        if (!cgroups.initialize()) continue;
+        cgroups.update();
+        results.push_back(bench::measure("cgroup/update/fixture/groups:" + std::to_string(cgroups.groupCount()),
+                                         [&] { cgroups.update(); }));
+    }
+
+    CgroupMonitor live{CgroupOptions()};
+    if (!live.initialize()) return;
+    live.update();
+    results.push_back(bench::measure("cgroup/update/live/groups:" + std::to_string(live.groupCount()),
+                                     [&] { live.update(); }));
+}
+
+// Every collector against a recorded host (--capture FILE), one update per
+// recorded tick. A tick cannot be repeated, so each result covers the
+// capture once instead of a timed loop.
+MONITOR_BENCH_SUITE(replay) {
+    if (bench::capturePath().empty()) return;
+    CaptureReplayer replayer;
+    if (!replayer.open(bench::capturePath()) || !replayer.nextTick()) return;
+    procfs::pinNow(replayer.tickTime());
+
+    CPUMonitor cpu;
+    MemoryMonitor memory;
+    DiskMonitor disk;
+    NetworkMonitor network;
+    ProcessMonitor processes;
+    cpu.setRoot(replayer.root());
+    memory.setRoot(replayer.root());
+    disk.setRoot(replayer.root());
+    network.setRoot(replayer.root());
+    processes.setRoot(replayer.root());
+    CgroupOptions options;
+    options.prefix = replayer.root();
+    CgroupMonitor cgroups(options);
+
+    struct Collector {
+        std::string name;
+        std::function<void()> update;
+        double ns = 0.0;
+        uint64_t allocations = 0;
+        int64_t syscalls = 0;
+    };
+    std::vector<Collector> collectors;
+    if (cpu.initialize()) collectors.push_back({"cpu", [&] { cpu.update(); }});
+    if (memory.initialize()) collectors.push_back({"memory", [&] { memory.update(); }});
+    if (disk.initialize()) collectors.push_back({"disk", [&] { disk.update(); }});
+    if (network.initialize()) collectors.push_back({"network", [&] { network.update(); }});
+    if (processes.initialize()) collectors.push_back({"process", [&] { processes.update(); }});
+    if (cgroups.initialize()) collectors.push_back({"cgroup", [&] { cgroups.update(); }});
+    for (Collector& collector : collectors) collector.update();
+
+    bool countingSyscalls = bench::syscallCount() >= 0;
+    uint64_t ticks = 0;
+    while (replayer.nextTick()) {
+        procfs::pinNow(replayer.tickTime());
+        for (Collector& collector : collectors) {
+            uint64_t allocations = bench::allocationCount.load(std::memory_order_relaxed);
+            int64_t syscalls = bench::syscallCount();
+            auto start = std::chrono::steady_clock::now();
+            collector.update();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            collector.ns += std::chrono::duration<double, std::nano>(elapsed).count();
+            collector.allocations += bench::allocationCount.load(std::memory_order_relaxed) - allocations;
+            collector.syscalls += bench::syscallCount() - syscalls - 1;
+        }
+        ++ticks;
+    }
+    procfs::pinNow(std::chrono::steady_clock::time_point());
+    if (ticks == 0) return;
+
+    for (const Collector& collector : collectors) {
+        bench::Result result;
+        result.name = "replay/" + collector.name + "/ticks:" + std::to_string(ticks);
+        if (collector.name == "process") result.name += "/processes:" + std::to_string(processes.getActivity().total);
+        if (collector.name == "cgroup") result.name += "/groups:" + std::to_string(cgroups.groupCount());
+        result.iterations = ticks;
+        result.nsPerOp = collector.ns / ticks;
+        result.allocsPerOp = static_cast<double>(collector.allocations) / ticks;
+        if (countingSyscalls) {
+            result.syscallsPerOp = static_cast<double>(std::max<int64_t>(collector.syscalls, 0)) / ticks;
+            result.syscallsExact = bench::syscallsExact();
+        }
+        results.push_back(result);
+    }
+}
+#endif
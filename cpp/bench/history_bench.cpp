@@ -0,0 +1,34 @@
+#include "bench.h"
+#include "metric_history.h"
+#include <string>
+
+// Cost of folding one snapshot into every tier, and of range queries
+MONITOR_BENCH_SUITE(history) {
+    const size_t coreCounts[] = {8, 64, 256};
+    for (size_t cores : coreCounts) {
+        MetricHistory history(cores, 16);
+
+        Snapshot snap;
+        CPUInfo& cpu = editSection(snap.cpu);
+        std::vector<DiskInfo>& disks = editSection(snap.disks);
+        cpu.coreUsage.assign(cores, 12.5);
+        disks.resize(8);
+        snap.timestampMs = 1700000000000LL;
+
+        std::string suffix = "/cores:" + std::to_string(cores);
+        results.push_back(bench::measure("history/record" + suffix, [&] {
+            snap.timestampMs += 1000;
+            cpu.totalUsage = static_cast<double>(snap.timestampMs % 100);
+            history.record(snap);
+        }));
+
+        std::vector<HistoryPoint> points;
+        int64_t now = snap.timestampMs;
+        results.push_back(bench::measure("history/query-1h" + suffix, [&] {
+            history.query(HistoryMetric::CpuCore, cores - 1, now - 3600 * 1000LL, now, points);
+        }));
+        results.push_back(bench::measure("history/query-1d" + suffix, [&] {
+            history.query(HistoryMetric::CpuTotal, 0, now - 86400 * 1000LL, now, points);
+        }));
+    }
+}
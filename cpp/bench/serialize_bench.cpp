@@ -0,0 +1,145 @@
+#include "bench.h"
+#include "snapshot_json.h"
+#include "wire_protocol.h"
+#include "system_monitor.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+// Synthetic snapshot with every list populated to the requested size
+Snapshot makeSnapshot(int cores, int disks, int processes) {
+    Snapshot snap;
+    CPUInfo& cpu = editSection(snap.cpu);
+    cpu.coreCount = cores;
+    cpu.totalUsage = 37.25;
+    cpu.frequency = 3400.0;
+    for (int i = 0; i < cores; ++i) cpu.coreUsage.push_back((i * 7919 % 10000) / 100.0);
+
+    GPUInfo& gpu = editSection(snap.gpu);
+    gpu.name = "Synthetic GPU \"Model\" 9000";
+    gpu.usage = 12.5;
+    MemoryInfo& memory = editSection(snap.memory);
+    memory.total = 65536.0;
+    memory.used = 40000.5;
+    memory.free = 25535.5;
+    memory.usagePercent = 61.04;
+
+    std::vector<DiskInfo>& diskList = editSection(snap.disks);
+    for (int i = 0; i < disks; ++i) {
+        DiskInfo disk;
+        disk.name = "nvme" + std::to_string(i) + "n1";
+        disk.mountPoint = "/mnt/data" + std::to_string(i);
+        disk.total = 3725.29;
+        disk.used = 1000.0 + i;
+        disk.free = disk.total - disk.used;
+        disk.readSpeed = i * 1.5;
+        disk.writeSpeed = i * 0.75;
+        diskList.push_back(disk);
+    }
+
+    NetworkInfo& network = editSection(snap.network);
+    network.downloadSpeed = 12.34;
+    network.uploadSpeed = 5.67;
+    network.activeConnections = 4321;
+
+    std::vector<ProcessInfo>& processList = editSection(snap.processes);
+    for (int i = 0; i < processes; ++i) {
+        ProcessInfo proc;
+        proc.name = "worker-" + std::to_string(i);
+        proc.pid = 1000 + i;
+        proc.cpuUsage = (i * 31 % 1000) / 10.0;
+        proc.memoryUsage = 100.0 + i * 3.25;
+        processList.push_back(proc);
+    }
+    return snap;
+}
+
+} // namespace
+
+// Pretty ostringstream path (toJSON) against the compact NDJSON writer
+MONITOR_BENCH_SUITE(serialize) {
+    struct Scale {
+        int cores;
+        int disks;
+        int processes;
+    };
+    const Scale scales[] = {{8, 4, 10}, {64, 100, 300}, {192, 300, 500}, {512, 200, 32}};
+
+    for (const Scale& scale : scales) {
+        Snapshot snap = makeSnapshot(scale.cores, scale.disks, scale.processes);
+        size_t maxProcesses = snap.processes->size();
+        std::string suffix = "/cores:" + std::to_string(scale.cores) + "/disks:" + std::to_string(scale.disks) +
+                             "/procs:" + std::to_string(scale.processes);
+
+        std::string pretty;
+        bench::Result prettyResult = bench::measure("serialize/pretty" + suffix, [&] {
+            pretty = formatSnapshotJSON(snap, maxProcesses);
+        });
+        prettyResult.bytesPerOp = static_cast<double>(pretty.size());
+        results.push_back(prettyResult);
+
+        std::string compact;
+        bench::Result compactResult = bench::measure("serialize/ndjson" + suffix, [&] {
+            writeSnapshotNDJSON(snap, compact, maxProcesses);
+        });
+        compactResult.bytesPerOp = static_cast<double>(compact.size());
+        results.push_back(compactResult);
+    }
+
+    // The public entry point on a live sample
+    SystemMonitor monitor;
+    if (!monitor.initialize()) return;
+    monitor.update();
+    std::string json;
+    bench::Result live = bench::measure("serialize/toJSON/live", [&] { json = monitor.toJSON(); });
+    live.bytesPerOp = static_cast<double>(json.size());
+    results.push_back(live);
+}
+
+// Per-tick cost of NDJSON against the binary delta stream on a sequence of
+// snapshots where only the volatile fields move (a 10 Hz sampling loop)
+MONITOR_BENCH_SUITE(wire) {
+    const int kTicks = 64;
+    std::vector<Snapshot> ticks;
+    Snapshot base = makeSnapshot(64, 8, 10);
+    for (int t = 0; t < kTicks; ++t) {
+        Snapshot snap = base;
+        snap.version = t + 1;
+        snap.timestampMs = 1700000000000LL + t * 100;
+        CPUInfo& cpu = editSection(snap.cpu);
+        cpu.totalUsage = 30.0 + (t % 7);
+        for (size_t i = 0; i < cpu.coreUsage.size(); i += 3) cpu.coreUsage[i] += (t * 13 + i) % 5;
+        MemoryInfo& memory = editSection(snap.memory);
+        memory.used += t * 0.25;
+        memory.free -= t * 0.25;
+        editSection(snap.network).downloadSpeed = (t * 37 % 100) / 10.0;
+        std::vector<ProcessInfo>& processes = editSection(snap.processes);
+        for (size_t i = 0; i < processes.size(); ++i) processes[i].cpuUsage += (t + i) % 3;
+        ticks.push_back(snap);
+    }
+
+    size_t tick = 0;
+    std::string line;
+    size_t ndjsonBytes = 0;
+    bench::Result ndjson = bench::measure("wire/ndjson/cores:64/disks:8/procs:10", [&] {
+        writeSnapshotNDJSON(ticks[tick++ % ticks.size()], line);
+        ndjsonBytes += line.size();
+    });
+    ndjson.bytesPerOp = static_cast<double>(ndjsonBytes) / (ndjson.iterations + 1);
+    results.push_back(ndjson);
+
+    // Steady state: the encoder has already seen the layout and strings
+    WireEncoder encoder;
+    std::string frames;
+    encoder.encode(ticks[0], frames);
+    tick = 1;
+    size_t wireBytes = 0;
+    bench::Result wire = bench::measure("wire/binary/cores:64/disks:8/procs:10", [&] {
+        frames.clear();
+        encoder.encode(ticks[tick++ % ticks.size()], frames);
+        wireBytes += frames.size();
+    });
+    wire.bytesPerOp = static_cast<double>(wireBytes) / (wire.iterations + 1);
+    results.push_back(wire);
+}
@@ -0,0 +1,33 @@
+#include "bench.h"
+#include "rolling_stats.h"
+#include <string>
+
+// One sample into every window, and the per-second summary, by core count.
+// Samples are 5 s apart so every one of them recycles a 1-minute pane.
+MONITOR_BENCH_SUITE(stats) {
+    const size_t coreCounts[] = {8, 64, 256};
+    for (size_t cores : coreCounts) {
+        RollingStats stats;
+
+        Snapshot snap;
+        CPUInfo& cpu = editSection(snap.cpu);
+        std::vector<DiskInfo>& disks = editSection(snap.disks);
+        cpu.coreUsage.assign(cores, 12.5);
+        disks.resize(8);
+        for (size_t i = 0; i < disks.size(); ++i) disks[i].name = "sd" + std::string(1, 'a' + i);
+        int64_t now = 0;
+        auto record = [&] {
+            now += 5000;
+            cpu.totalUsage = static_cast<double>(now / 1000 % 100);
+            for (size_t i = 0; i < cores; ++i) cpu.coreUsage[i] = static_cast<double>((now / 1000 + i) % 100);
+            stats.record(snap, now);
+        };
+        for (int i = 0; i < 720; ++i) record(); // Fill the hour window
+
+        std::string suffix = "/cores:" + std::to_string(cores) + "/kb:" + std::to_string(stats.memoryBytes() / 1024);
+        results.push_back(bench::measure("stats/record" + suffix, record));
+
+        RollingStatsInfo info;
+        results.push_back(bench::measure("stats/summarize" + suffix, [&] { stats.summarize(info); }));
+    }
+}
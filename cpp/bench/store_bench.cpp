@@ -0,0 +1,120 @@
+#include "bench.h"
+#include "gorilla_codec.h"
+#include <cmath>
+#include <string>
+#include <vector>
+
+#ifdef MONITOR_BACKEND_LINUX
+#include "linux/metric_store.h"
+#include <cstdlib>
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+// Column codecs on one 60-sample batch; bytesPerOp is the encoded size
+MONITOR_BENCH_SUITE(compression) {
+    const size_t samples = 60;
+    std::vector<int64_t> timestamps(samples);
+    std::vector<double> smooth(samples);
+    std::vector<double> noisy(samples);
+    for (size_t i = 0; i < samples; ++i) {
+        // A 1 s cadence with a little scheduling jitter
+        timestamps[i] = 1700000000000LL + static_cast<int64_t>(i) * 1000 + (i % 7 == 3 ? 2 : 0);
+        smooth[i] = 8192.0 + static_cast<double>(i / 10);
+        noisy[i] = 35.0 + 20.0 * std::sin(static_cast<double>(i) * 0.7);
+    }
+
+    std::vector<uint8_t> encoded;
+    std::vector<int64_t> decodedTimestamps(samples);
+    std::vector<double> decodedValues(samples);
+
+    bench::Result result = bench::measure("gorilla/timestamps-encode", [&] {
+        encoded.clear();
+        gorilla::encodeTimestamps(timestamps.data(), samples, encoded);
+    });
+    result.bytesPerOp = static_cast<double>(encoded.size());
+    results.push_back(result);
+    results.push_back(bench::measure("gorilla/timestamps-decode", [&] {
+        gorilla::decodeTimestamps(encoded.data(), encoded.size(), samples, decodedTimestamps.data());
+    }));
+
+    const std::pair<const char*, const std::vector<double>*> columns[] = {{"smooth", &smooth}, {"noisy", &noisy}};
+    for (const auto& column : columns) {
+        std::string suffix = std::string("/") + column.first;
+        result = bench::measure("gorilla/values-encode" + suffix, [&] {
+            encoded.clear();
+            gorilla::encodeValues(column.second->data(), samples, encoded);
+        });
+        result.bytesPerOp = static_cast<double>(encoded.size());
+        results.push_back(result);
+        results.push_back(bench::measure("gorilla/values-decode" + suffix, [&] {
+            gorilla::decodeValues(encoded.data(), encoded.size(), samples, decodedValues.data());
+        }));
+    }
+}
+
+#ifdef MONITOR_BACKEND_LINUX
+namespace {
+void removeDirectory(const std::string& path) {
+    if (DIR* dir = opendir(path.c_str())) {
+        while (struct dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') unlink((path + "/" + entry->d_name).c_str());
+        }
+        closedir(dir);
+    }
+    rmdir(path.c_str());
+}
+}
+
+// Sampler-side cost of append() (the writer thread does the I/O), and
+// range queries over the files it produced
+MONITOR_BENCH_SUITE(store) {
+    char pattern[] = "/tmp/monitor_store_bench.XXXXXX";
+    if (!mkdtemp(pattern)) return;
+    std::string directory = pattern;
+
+    const size_t coreCounts[] = {8, 64};
+    for (size_t cores : coreCounts) {
+        StoreOptions options;
+        options.directory = directory + "/cores" + std::to_string(cores);
+        std::string suffix = "/cores:" + std::to_string(cores);
+        {
+            MetricStore store(options);
+            if (!store.open()) continue;
+
+            Snapshot snap;
+            CPUInfo& cpu = editSection(snap.cpu);
+            std::vector<DiskInfo>& disks = editSection(snap.disks);
+            cpu.coreUsage.assign(cores, 12.5);
+            disks.resize(4);
+            for (size_t i = 0; i < disks.size(); ++i) disks[i].name = "sd" + std::string(1, char('a' + i));
+            snap.timestampMs = 1700000000000LL;
+
+            // One day of samples to query
+            for (int i = 0; i < 86400; ++i) {
+                snap.timestampMs += 1000;
+                cpu.totalUsage = static_cast<double>(i % 100);
+                store.append(snap);
+                if (i % 300 == 0) store.flush(); // Stay within the pending-batch bound
+            }
+            store.flush();
+
+            int64_t now = snap.timestampMs;
+            std::vector<StorePoint> points;
+            results.push_back(bench::measure("store/query-1h" + suffix, [&] {
+                store.query("cpu.usage", now - 3600 * 1000LL, now, points);
+            }));
+            results.push_back(bench::measure("store/query-1d" + suffix, [&] {
+                store.query("cpu.core.0", now - 86400 * 1000LL, now, points);
+            }));
+
+            results.push_back(bench::measure("store/append" + suffix, [&] {
+                snap.timestampMs += 1000;
+                store.append(snap);
+            }));
+        }
+        removeDirectory(options.directory);
+    }
+    removeDirectory(directory);
+}
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <ftw.h>
+#include <stdio.h>
+#include <string>
+#include <sys/stat.h>
+
+// A directory under /tmp, removed with everything in it when the TempTree
+// goes out of scope. Synthetic /proc, /sys and cgroupfs trees are built in
+// one and handed to a collector's setRoot(); path() is empty if it could
+// not be created.
+class TempTree {
+public:
+    // `name` labels the directory, e.g. "monitor_cpu_bench"
+    explicit TempTree(const std::string& name) {
+        std::string pattern = "/tmp/" + name + ".XXXXXX";
+        if (::mkdtemp(&pattern[0])) root = pattern;
+    }
+    ~TempTree() {
+        if (!root.empty()) removeAll(root);
+    }
+
+    TempTree(const TempTree&) = delete;
+    TempTree& operator=(const TempTree&) = delete;
+
+    const std::string& path() const { return root; }
+
+    // Creates <path>/relative and any missing parents
+    bool makeDirectory(const std::string& relative) const {
+        std::string path = root;
+        size_t begin = 0;
+        while (begin < relative.size()) {
+            size_t end = relative.find('/', begin);
+            if (end == std::string::npos) end = relative.size();
+            path += "/" + relative.substr(begin, end - begin);
+            if (::mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) return false;
+            begin = end + 1;
+        }
+        return true;
+    }
+
+    // Replaces <path>/relative with `content`, creating its directory
+    bool write(const std::string& relative, const std::string& content) const {
+        size_t slash = relative.rfind('/');
+        if (slash != std::string::npos && !makeDirectory(relative.substr(0, slash))) return false;
+        std::ofstream file(root + "/" + relative, std::ios::binary | std::ios::trunc);
+        return static_cast<bool>(file << content);
+    }
+
+    // Removes <path>/relative and everything below it
+    void remove(const std::string& relative) const { removeAll(root + "/" + relative); }
+
+private:
+    std::string root;
+
+    static void removeAll(const std::string& path) {
+        ::nftw(path.c_str(), [](const char* entry, const struct stat*, int, FTW*) { return ::remove(entry); }, 64,
+               FTW_DEPTH | FTW_PHYS);
+    }
+};
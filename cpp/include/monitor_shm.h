@@ -0,0 +1,61 @@
+#ifndef MONITOR_SHM_H
+#define MONITOR_SHM_H
+
+/*
+ * Reader for the shared snapshot ring published by `monitor --shm NAME`
+ * (libmonitor_shm). Plain C ABI so it can be loaded with ctypes; see
+ * python/monitor_shm.py.
+ *
+ * Each snapshot is one NDJSON document (the `--format ndjson` line without
+ * its newline). Reads touch only shared memory: no syscalls, no locks, and
+ * the writer never waits for readers.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct mc_shm_reader mc_shm_reader;
+
+/* Attaches to the ring `name` (e.g. "/monitor_core"). NULL if it does not
+ * exist or is not a compatible ring. */
+mc_shm_reader* mc_shm_open(const char* name);
+void mc_shm_close(mc_shm_reader* reader);
+
+/* Number of snapshots published so far (0 before the first one) */
+uint64_t mc_shm_published(const mc_shm_reader* reader);
+
+/* Snapshots the writer dropped because they did not fit a slot. While this
+ * grows, the newest readable snapshot is stale; restart the writer with a
+ * larger --shm-slot-bytes. */
+uint64_t mc_shm_dropped(const mc_shm_reader* reader);
+
+/* Process id of the writer, to detect a writer that has gone away */
+int64_t mc_shm_writer_pid(const mc_shm_reader* reader);
+
+/* Copies the newest snapshot into `buffer`. Returns its length, 0 if
+ * nothing has been published yet, or -(required capacity) if `buffer` is
+ * too small. `counter` (optional) receives its publish number. */
+int64_t mc_shm_read_latest(mc_shm_reader* reader, char* buffer, size_t capacity, uint64_t* counter);
+
+/* Zero-copy access: points `data` at the newest snapshot inside the shared
+ * mapping. The bytes are only known to be consistent if mc_shm_validate()
+ * returns 1 for `token` after they have been used; otherwise the writer
+ * reused the slot (it has slotCount - 1 more publishes of headroom) and the
+ * result must be discarded. Returns 0 if nothing has been published. */
+int mc_shm_peek_latest(mc_shm_reader* reader, const char** data, size_t* length, uint64_t* token);
+int mc_shm_validate(const mc_shm_reader* reader, uint64_t token);
+
+/* Blocks until more than `after` snapshots have been published or
+ * `timeout_ms` elapses (negative waits forever). Returns 1 if a newer
+ * snapshot exists. This is the only call that may enter the kernel. */
+int mc_shm_wait(mc_shm_reader* reader, uint64_t after, int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MONITOR_SHM_H */
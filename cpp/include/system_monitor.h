@@ -3,6 +3,8 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <chrono>
+#include <cstdint>
 
 // Forward declarations
 struct CPUInfo;
@@ -11,16 +13,111 @@ struct MemoryInfo;
 struct DiskInfo;
 struct NetworkInfo;
 struct ProcessInfo;
+struct Snapshot;
+class MetricHistory;
+class MetricStore;
+
+// Collectors sampled by SystemMonitor, each on its own cadence
+enum class Collector {
+    CPU,
+    GPU,
+    Memory,
+    Disk,
+    Network,
+    Process
+};
 
 class SystemMonitor {
 public:
     SystemMonitor();
     ~SystemMonitor();
 
+    // Reads /proc, /sys and cgroupfs under `prefix` instead of the live
+    // host: a tree replayed from a capture (see linux/capture.h) or built
+    // by a benchmark. Disk capacity and netlink socket states are not
+    // available there. Linux only; call before initialize().
+    void setRoot(const std::string& prefix);
+
+    // Reads per-process stat files in io_uring batches, one syscall per
+    // batch instead of three per process (Linux 5.15+; the default
+    // synchronous reads are kept where io_uring is unavailable). Call
+    // before initialize().
+    void setBatchedProcessReads(bool enabled);
+
     bool initialize();
+    // Samples every collector once on the calling thread
     void update();
 
-    // Getters
+    // Background sampling: collectors run on a small worker pool, each at
+    // its own interval, until stop(). Intervals can only change while stopped.
+    bool setSamplingInterval(Collector collector, std::chrono::milliseconds interval);
+    bool start();
+    void stop();
+
+    // Keeps a bounded multi-resolution history of the main metrics (see
+    // metric_history.h), recorded once per second from the sampling loop.
+    // Call after initialize() and before start().
+    bool enableHistory(size_t maxDisks = 16);
+    // nullptr unless history is enabled. Queries never block the sampler.
+    const MetricHistory* history() const;
+
+    // Persists every metric once per second to a compressed on-disk store
+    // in `directory` (see linux/metric_store.h). Writes happen on the
+    // store's own thread. Call after initialize() and before start(); false
+    // if the directory is unusable or the backend has no store.
+    bool enableStore(const std::string& directory);
+    // nullptr unless the store is enabled
+    const MetricStore* store() const;
+
+    // Samples every cgroup v2 group under `root` (the cgroup2 mount when
+    // empty) every two seconds into Snapshot::cgroups (see
+    // linux/cgroup_monitor.h). Call after initialize() and before start();
+    // false if there is no cgroup v2 hierarchy or the backend has none.
+    bool enableCgroups(const std::string& root = std::string());
+
+    // Samples every thread of `pids` (scheduler run and wait time, switches,
+    // migrations) `rateHz` times per second on a dedicated thread pinned to
+    // one CPU, and summarizes the samples into Snapshot::threads every
+    // second (see linux/thread_sampler.h). Call after initialize() and
+    // before start(); false if none of the PIDs exist or the backend has no
+    // sampler.
+    bool enableThreadSampler(const std::vector<int>& pids, unsigned rateHz = 250);
+
+    // Keeps rolling p50/p95/p99/max, mean and standard deviation of CPU
+    // (total and per core), memory, network and disk throughput over
+    // windows of `windowSeconds` (see rolling_stats.h; empty for
+    // RollingStats::defaultWindows()), refreshed into Snapshot::stats every
+    // second. Call after initialize() and before start().
+    bool enableStats(const std::vector<int>& windowSeconds = {});
+
+    // Scores every host, core, disk and interface series and the top
+    // processes once per second against an EWMA baseline (z-score and
+    // CUSUM) and a daily Holt-Winters baseline, and reports the anomalous
+    // ones in Snapshot::anomalies (see anomaly_detector.h). Call after
+    // initialize() and before start().
+    bool enableAnomalyDetection();
+
+    // Evaluates alert rules such as "cpu.usage > 90 for 10s" or
+    // "disk.*.free < 5GB clear 8GB" (see alert_engine.h) right after the
+    // collector they read publishes, and reports firing rules and recent
+    // transitions in Snapshot::alerts. Call after initialize() and before
+    // start(); on a rule that does not parse, returns false and sets
+    // `error` to the reason.
+    bool enableAlerts(const std::vector<std::string>& rules, std::string* error = nullptr);
+
+    // Optional per-process fields (a mask of ProcessField). The expensive
+    // ones are collected only for the ranked processes in the snapshot and
+    // for watched PIDs, never for every process. Safe to call at any time;
+    // takes effect on the next process sample.
+    void setProcessFields(uint32_t fields);
+    // PIDs reported in Snapshot::watchedProcesses whatever their rank
+    void setWatchedProcesses(const std::vector<int>& pids);
+
+    // Latest published sample of every collector. Lock-free and allocation
+    // free for readers; the snapshot stays valid for as long as it is held.
+    std::shared_ptr<const Snapshot> snapshot() const;
+
+    // Getters (copies out of the current snapshot)
     CPUInfo getCPUInfo() const;
     GPUInfo getGPUInfo() const;
     MemoryInfo getMemoryInfo() const;
@@ -30,6 +127,9 @@ public:
 
     // JSON export
     std::string toJSON() const;
+    // Compact single-line form of toJSON() for NDJSON streams. Overwrites
+    // `out`, reusing its capacity, so a long-lived buffer avoids allocation.
+    void toNDJSON(std::string& out) const;
 
 private:
     class Impl;
@@ -37,11 +137,27 @@ private:
 };
 
 // Data structures
+// Share of the elapsed CPU time spent in each state, in percent. The fields
+// add up to 100 for a CPU that was online during the whole interval.
+struct CPUTimes {
+    double user = 0.0;
+    double nice = 0.0;
+    double system = 0.0;
+    double idle = 0.0;
+    double iowait = 0.0;
+    double irq = 0.0;
+    double softirq = 0.0; // Deferred interrupt work (DPCs on Windows)
+    double steal = 0.0; // Taken by the hypervisor for other guests
+};
+
 struct CPUInfo {
     double totalUsage = 0.0;
     std::vector<double> coreUsage;
     int coreCount = 0;
-    double frequency = 0.0; // MHz
+    double frequency = 0.0; // MHz, average over cores with a known frequency
+    CPUTimes times; // Whole machine
+    std::vector<CPUTimes> coreTimes;
+    std::vector<double> coreFrequency; // MHz, 0 when unknown
 };
 
 struct GPUInfo {
@@ -52,11 +168,48 @@ struct GPUInfo {
     double temperature = 0.0; // Celsius (if available)
 };
 
+// Pressure stall information: share of time in which some (or all)
+// non-idle tasks were stalled on memory, averaged over 10, 60 and 300 s
+struct MemoryPressure {
+    double some10 = 0.0; // Percent
+    double some60 = 0.0;
+    double some300 = 0.0;
+    double full10 = 0.0;
+    double full60 = 0.0;
+    double full300 = 0.0;
+    bool available = false; // False when the kernel has no PSI
+};
+
 struct MemoryInfo {
     double total = 0.0; // MB
-    double used = 0.0; // MB
-    double free = 0.0; // MB
+    double used = 0.0; // MB, total minus available
+    double free = 0.0; // MB, available to new allocations without swapping
     double usagePercent = 0.0;
+
+    // Breakdown, MB
+    double cached = 0.0; // Page cache, excluding shmem
+    double buffers = 0.0;
+    double slab = 0.0; // Kernel object caches (kernel pools on Windows)
+    double slabReclaimable = 0.0;
+    double shmem = 0.0;
+    double swapTotal = 0.0;
+    double swapUsed = 0.0;
+    double dirty = 0.0;
+    double writeback = 0.0;
+    double hugePagesTotal = 0.0;
+    double hugePagesUsed = 0.0;
+
+    // Paging activity, per second
+    double pageFaults = 0.0;
+    double majorFaults = 0.0; // Faults that had to read from disk
+    double swapIn = 0.0; // Pages
+    double swapOut = 0.0; // Pages
+    double pagesScanned = 0.0; // Scanned for reclaim (kswapd and direct)
+    double pagesReclaimed = 0.0;
+    double allocStalls = 0.0; // Allocations that entered direct reclaim
+    uint64_t oomKills = 0; // Since boot
+
+    MemoryPressure pressure;
 };
 
 struct DiskInfo {
@@ -67,12 +220,64 @@ struct DiskInfo {
     double free = 0.0; // GB
     double readSpeed = 0.0; // MB/s
     double writeSpeed = 0.0; // MB/s
+    double readIops = 0.0; // Completed reads/s
+    double writeIops = 0.0; // Completed writes/s
+    double queueDepth = 0.0; // Average requests queued or in service
+    double latency = 0.0; // ms per completed request, queueing included
 };
 
-struct NetworkInfo {
+struct InterfaceInfo {
+    std::string name;
     double downloadSpeed = 0.0; // MB/s
     double uploadSpeed = 0.0; // MB/s
+    double rxPackets = 0.0; // Packets/s
+    double txPackets = 0.0; // Packets/s
+    uint64_t rxErrors = 0; // Totals since the interface appeared
+    uint64_t txErrors = 0;
+    uint64_t rxDropped = 0;
+    uint64_t txDropped = 0;
+};
+
+struct SocketStats {
+    // Kernel-maintained totals, read every sample without visiting sockets
+    int tcp = 0; // TCP sockets in use, IPv4 + IPv6, TIME_WAIT excluded
+    int tcpTimeWait = 0;
+    int tcpOrphan = 0;
+    int udp = 0;
+    // Breakdown by TCP state and connected UDP sockets. Gathered by a
+    // socket dump, so it is refreshed on a slower cadence than the totals.
+    int established = 0;
+    int synSent = 0;
+    int synRecv = 0;
+    int finWait1 = 0;
+    int finWait2 = 0;
+    int closeWait = 0;
+    int lastAck = 0;
+    int listen = 0;
+    int closing = 0;
+    int closed = 0;
+    int udpConnected = 0;
+};
+
+struct NetworkInfo {
+    double downloadSpeed = 0.0; // MB/s, all interfaces except loopback
+    double uploadSpeed = 0.0; // MB/s
     int activeConnections = 0;
+    SocketStats sockets;
+    std::vector<InterfaceInfo> interfaces;
+};
+
+// Optional ProcessInfo fields, combined into a mask
+enum ProcessField : uint32_t {
+    kProcessThreads = 1u << 0,
+    kProcessState = 1u << 1,
+    kProcessUid = 1u << 2,
+    kProcessContextSwitches = 1u << 3,
+    kProcessFds = 1u << 4,
+    kProcessIo = 1u << 5,
+    kProcessPss = 1u << 6, // PSS and swap; the most expensive field on Linux
+    kProcessCmdline = 1u << 7,
+    kProcessAllFields = (1u << 8) - 1,
 };
 
 struct ProcessInfo {
@@ -80,4 +285,217 @@ struct ProcessInfo {
     int pid = 0;
     double cpuUsage = 0.0;
     double memoryUsage = 0.0; // MB
+
+    // Optional fields; `fields` marks the ones that were collected
+    uint32_t fields = 0;
+    int threads = 0;
+    char state = 0; // R, S, D, Z, T, ...
+    int uid = -1;
+    int fdCount = 0; // Open handles on Windows
+    double ioReadSpeed = 0.0; // MB/s, storage I/O
+    double ioWriteSpeed = 0.0; // MB/s
+    double voluntarySwitches = 0.0; // Per second
+    double involuntarySwitches = 0.0; // Per second
+    double pss = 0.0; // MB, proportional set size
+    double swap = 0.0; // MB
+    std::string cmdline;
+};
+
+struct ProcessActivity {
+    int total = 0; // Live processes
+    uint64_t spawned = 0; // Processes started since the previous process sample
+    uint64_t exited = 0; // Processes that ended since the previous process sample
+    // True when the counts come from kernel process events and include
+    // processes that lived less than one interval. Otherwise they are the
+    // difference between two scans, which misses those.
+    bool eventDriven = false;
+};
+
+// One cgroup v2 group. Rates cover the interval since the previous sample;
+// pressure values are the share of that interval in which tasks stalled.
+struct CgroupInfo {
+    std::string path; // Relative to the cgroup root; "/" for the root itself
+    int parent = -1; // Index in Snapshot::cgroups, -1 for the root
+    double cpuUsage = 0.0; // Percent of one CPU
+    double cpuThrottled = 0.0; // Percent of the interval spent throttled
+    double memoryCurrent = 0.0; // MB
+    double memoryAnon = 0.0; // MB
+    double memoryFile = 0.0; // MB, page cache
+    double ioReadSpeed = 0.0; // MB/s
+    double ioWriteSpeed = 0.0; // MB/s
+    double ioReadIops = 0.0;
+    double ioWriteIops = 0.0;
+    double cpuPressure = 0.0; // Percent, some tasks stalled
+    double memoryPressure = 0.0; // Percent, some tasks stalled
+    double memoryPressureFull = 0.0; // Percent, all tasks stalled
+    double ioPressure = 0.0;
+    double ioPressureFull = 0.0;
+};
+
+// One thread of a process watched by the thread sampler, summarized over the
+// interval since the previous summary. Percentiles are over the individual
+// samples: a thread that ran 2 ms of a 4 ms sample period counts as 50.
+struct ThreadStats {
+    int pid = 0;
+    int tid = 0;
+    std::string name;
+    uint64_t samples = 0;
+    double cpuUsage = 0.0; // Percent of one CPU, mean over the interval
+    double cpuP50 = 0.0;
+    double cpuP95 = 0.0;
+    double cpuP99 = 0.0;
+    double cpuMax = 0.0;
+    // Share of each sample period spent runnable but waiting for a CPU
+    double waitP50 = 0.0; // Percent
+    double waitP95 = 0.0;
+    double waitP99 = 0.0;
+    double waitMax = 0.0;
+    double contextSwitches = 0.0; // Per second (times the thread was scheduled in)
+    double migrations = 0.0; // Per second; CPU changes seen between two samples
+};
+
+// Health of the thread sampler itself
+struct ThreadSamplerStats {
+    bool enabled = false;
+    bool pinned = false; // Sampler thread bound to one CPU
+    double rate = 0.0; // Samples per second achieved over the interval
+    double overhead = 0.0; // Sampler thread CPU time, percent of one CPU
+    uint64_t dropped = 0; // Samples lost to a full ring, since start
+    uint64_t missedTicks = 0; // Ticks skipped after an overrun, since start
+};
+
+// Latency of one collector's samples since start (update and publication).
+// Percentiles come from a log-bucketed histogram, within 1/32 of the value.
+struct CollectorTiming {
+    std::string name; // "cpu", "memory", ..., "cgroup", "threads"
+    uint64_t samples = 0;
+    uint64_t skipped = 0; // Ticks dropped because the previous sample still ran
+    double lastUs = 0.0; // Microseconds
+    double meanUs = 0.0;
+    double p50Us = 0.0;
+    double p95Us = 0.0;
+    double p99Us = 0.0;
+    double maxUs = 0.0;
+    // How late samples started: deadline to start, in microseconds. Grows
+    // when other collectors hold every scheduler worker.
+    double lateP99Us = 0.0;
+    double lateMaxUs = 0.0;
+};
+
+// The monitor's own cost. Rates cover the interval since the previous
+// self sample.
+struct SelfInfo {
+    double cpuUsage = 0.0; // Percent of one CPU
+    double cpuSeconds = 0.0; // User and system time since the process started
+    double rssMB = 0.0;
+    // Syscalls per second. Linux counts read- and write-family calls
+    // (/proc/self/io), Windows every I/O operation, so this is a lower bound.
+    double syscalls = 0.0;
+    std::vector<CollectorTiming> collectors;
+};
+
+// Statistics of one metric over one sliding window. Percentiles come from a
+// log-bucketed sketch and are within 5% of the true value.
+struct WindowStats {
+    uint64_t count = 0; // Samples in the window
+    double mean = 0.0;
+    double stddev = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+struct MetricStats {
+    std::string name; // "cpu.usage", "cpu.core.3", "disk.sda.readSpeed", ...
+    std::vector<WindowStats> windows; // Parallel to RollingStatsInfo::windows
 };
+
+struct RollingStatsInfo {
+    std::vector<int> windows; // Window lengths in seconds; empty unless enabled
+    std::vector<MetricStats> metrics;
+};
+
+// A series whose latest sample one detector finds anomalous
+struct MetricAnomaly {
+    std::string metric; // "cpu.core.3", "disk.sda.latency", "process.1234.cpuUsage", ...
+    std::string detector; // "zscore", "seasonal" or "cusum"
+    double value = 0.0;
+    double expected = 0.0; // Baseline the value is compared with
+    double score = 0.0; // Signed; standard deviations, or MADs for "seasonal"
+    int64_t sinceMs = 0; // Unix time the detector started flagging the series
+};
+
+struct AnomalyInfo {
+    uint64_t series = 0; // Series scored; 0 unless anomaly detection is enabled
+    std::vector<MetricAnomaly> flagged;
+};
+
+// A rule currently firing for one target
+struct ActiveAlert {
+    std::string rule; // The rule as given, e.g. "disk.*.free < 5GB"
+    std::string target; // Core index, disk or interface name, PID; empty for host metrics
+    double value = 0.0; // Value that made the rule fire
+    int64_t sinceMs = 0; // Unix time it fired
+};
+
+// A rule starting or stopping to fire for one target
+struct AlertEvent {
+    uint64_t sequence = 0; // Increments with every event since start
+    int64_t timestampMs = 0; // Unix time
+    bool firing = false; // False when resolved
+    std::string rule;
+    std::string target;
+    double value = 0.0;
+};
+
+struct AlertsInfo {
+    std::vector<ActiveAlert> active; // In the order they fired
+    // The latest events, oldest first. A reader that polls less often than
+    // alerts change uses `sequence` to skip the ones it has seen.
+    std::vector<AlertEvent> events;
+};
+
+// Immutable, versioned view of the latest sample of every collector.
+// A new snapshot is published whenever any collector finishes a sample.
+// Each section is shared by every snapshot until a sample replaces it, so
+// a publication copies only the section that changed. Sections are never
+// null; build a new one and assign it to change a section.
+struct Snapshot {
+    template <typename T>
+    using Section = std::shared_ptr<const T>;
+
+    uint64_t version = 0;     // Increments on every publication
+    int64_t timestampMs = 0;  // Unix time of the publication
+    Section<CPUInfo> cpu = std::make_shared<CPUInfo>();
+    Section<GPUInfo> gpu = std::make_shared<GPUInfo>();
+    Section<MemoryInfo> memory = std::make_shared<MemoryInfo>();
+    Section<std::vector<DiskInfo>> disks = std::make_shared<std::vector<DiskInfo>>();
+    Section<NetworkInfo> network = std::make_shared<NetworkInfo>();
+    // Ranked, highest first
+    Section<std::vector<ProcessInfo>> processes = std::make_shared<std::vector<ProcessInfo>>();
+    // Live watched PIDs, in the order given
+    Section<std::vector<ProcessInfo>> watchedProcesses = std::make_shared<std::vector<ProcessInfo>>();
+    Section<ProcessActivity> processActivity = std::make_shared<ProcessActivity>();
+    // Pre-order (parents first); empty unless enabled
+    Section<std::vector<CgroupInfo>> cgroups = std::make_shared<std::vector<CgroupInfo>>();
+    // By pid, then tid; empty unless the thread sampler is enabled
+    Section<std::vector<ThreadStats>> threads = std::make_shared<std::vector<ThreadStats>>();
+    Section<ThreadSamplerStats> threadSampler = std::make_shared<ThreadSamplerStats>();
+    Section<RollingStatsInfo> stats = std::make_shared<RollingStatsInfo>();
+    Section<AnomalyInfo> anomalies = std::make_shared<AnomalyInfo>();
+    Section<AlertsInfo> alerts = std::make_shared<AlertsInfo>(); // Empty unless alert rules are set
+    Section<SelfInfo> self = std::make_shared<SelfInfo>();
+};
+
+// Replaces `section` with a copy of itself and returns the copy to change,
+// for code that builds a snapshot field by field (tests, benchmarks). The
+// reference stays valid until the section is replaced, and must not be
+// written once the snapshot has been copied.
+template <typename T>
+T& editSection(Snapshot::Section<T>& section) {
+    auto copy = std::make_shared<T>(*section);
+    T& value = *copy;
+    section = std::move(copy);
+    return value;
+}
@@ -0,0 +1,810 @@
+#include "alert_engine.h"
+#include "snapshot_metrics.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace {
+const double kNoData = std::numeric_limits<double>::quiet_NaN();
+// A check's state per target: idle, firing, or since when its comparison has held
+constexpr int64_t kIdle = std::numeric_limits<int64_t>::min();
+constexpr int64_t kFiring = std::numeric_limits<int64_t>::max();
+constexpr uint32_t kNoSlot = UINT32_MAX;
+constexpr uint32_t kNoGroup = UINT32_MAX;
+constexpr size_t kCollectors = 6;
+
+enum Scope : uint8_t { kHost, kCore, kDisk, kInterface, kProcess, kScopes };
+enum Op : uint8_t { kAbove, kAtLeast, kBelow, kAtMost };
+enum Select : uint8_t { kAny, kByKey, kByLabel }; // Every target, by index or PID, by name
+
+constexpr MetricUnit kPlain = MetricUnit::Plain;
+constexpr MetricUnit kMegabytes = MetricUnit::Megabytes;
+constexpr MetricUnit kGigabytes = MetricUnit::Gigabytes;
+
+double coreTime(const CPUInfo& cpu, size_t core, double CPUTimes::*field) {
+    return core < cpu.coreTimes.size() ? cpu.coreTimes[core].*field : kNoData;
+}
+
+// cpu.core.N is the usage series of SnapshotMetrics; cpu.core.N.<field> adds these
+struct CoreField {
+    const char* name;
+    MetricUnit unit;
+    double (*read)(const CPUInfo&, size_t);
+};
+
+const CoreField kCoreFields[] = {
+    {"usage", kPlain, [](const CPUInfo& cpu, size_t i) { return cpu.coreUsage[i]; }},
+    {"frequency", kPlain,
+     [](const CPUInfo& cpu, size_t i) { return i < cpu.coreFrequency.size() ? cpu.coreFrequency[i] : kNoData; }},
+    {"user", kPlain, [](const CPUInfo& cpu, size_t i) { return coreTime(cpu, i, &CPUTimes::user); }},
+    {"system", kPlain, [](const CPUInfo& cpu, size_t i) { return coreTime(cpu, i, &CPUTimes::system); }},
+    {"iowait", kPlain, [](const CPUInfo& cpu, size_t i) { return coreTime(cpu, i, &CPUTimes::iowait); }},
+    {"irq", kPlain, [](const CPUInfo& cpu, size_t i) { return coreTime(cpu, i, &CPUTimes::irq); }},
+    {"softirq", kPlain, [](const CPUInfo& cpu, size_t i) { return coreTime(cpu, i, &CPUTimes::softirq); }},
+    {"steal", kPlain, [](const CPUInfo& cpu, size_t i) { return coreTime(cpu, i, &CPUTimes::steal); }},
+};
+
+// The SnapshotMetrics disk series, and the capacity fields only rules need
+const std::vector<MetricField<DiskInfo>>& diskFields() {
+    static const std::vector<MetricField<DiskInfo>> fields = [] {
+        std::vector<MetricField<DiskInfo>> all = SnapshotMetrics::diskFields();
+        all.push_back({"total", Collector::Disk, kGigabytes, false,
+                       [](const DiskInfo& d) { return d.total > 0.0 ? d.total : kNoData; }});
+        all.push_back({"usedPercent", Collector::Disk, kPlain, false,
+                       [](const DiskInfo& d) { return d.total > 0.0 ? d.used / d.total * 100.0 : kNoData; }});
+        return all;
+    }();
+    return fields;
+}
+
+// Optional fields that were not collected have no value rather than zero
+double optional(const ProcessInfo& p, uint32_t field, double value) {
+    return (p.fields & field) ? value : kNoData;
+}
+
+const MetricField<ProcessInfo> kProcessFields[] = {
+    {"cpuUsage", Collector::Process, kPlain, false, [](const ProcessInfo& p) { return p.cpuUsage; }},
+    {"memoryUsage", Collector::Process, kMegabytes, false, [](const ProcessInfo& p) { return p.memoryUsage; }},
+    {"threads", Collector::Process, kPlain, false,
+     [](const ProcessInfo& p) { return optional(p, kProcessThreads, p.threads); }},
+    {"fdCount", Collector::Process, kPlain, false,
+     [](const ProcessInfo& p) { return optional(p, kProcessFds, p.fdCount); }},
+    {"ioReadSpeed", Collector::Process, kMegabytes, false,
+     [](const ProcessInfo& p) { return optional(p, kProcessIo, p.ioReadSpeed); }},
+    {"ioWriteSpeed", Collector::Process, kMegabytes, false,
+     [](const ProcessInfo& p) { return optional(p, kProcessIo, p.ioWriteSpeed); }},
+    {"voluntarySwitches", Collector::Process, kPlain, false,
+     [](const ProcessInfo& p) { return optional(p, kProcessContextSwitches, p.voluntarySwitches); }},
+    {"involuntarySwitches", Collector::Process, kPlain, false,
+     [](const ProcessInfo& p) { return optional(p, kProcessContextSwitches, p.involuntarySwitches); }},
+    {"pss", Collector::Process, kMegabytes, false, [](const ProcessInfo& p) { return optional(p, kProcessPss, p.pss); }},
+    {"swap", Collector::Process, kMegabytes, false,
+     [](const ProcessInfo& p) { return optional(p, kProcessPss, p.swap); }},
+};
+
+template <typename Fields>
+long findField(const Fields& fields, const std::string& name) {
+    long index = 0;
+    for (const auto& field : fields) {
+        if (name == field.name) return index;
+        ++index;
+    }
+    return -1;
+}
+
+// FNV-1a; identifies disks, interfaces and process names
+uint64_t hashName(const std::string& name) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : name) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+template <int OpIndex>
+inline bool passes(double value, double level) {
+    switch (OpIndex) {
+    case kAbove: return value > level;
+    case kAtLeast: return value >= level;
+    case kBelow: return value < level;
+    default: return value <= level;
+    }
+}
+
+struct ParsedRule {
+    uint8_t scope = kHost;
+    uint16_t field = 0;
+    MetricUnit unit = kPlain;
+    bool cumulative = false;
+    Collector collector = Collector::CPU;
+    uint8_t op = kAbove;
+    uint8_t select = kAny;
+    uint64_t selector = 0;
+    double threshold = 0.0;
+    double clear = 0.0;
+    int64_t forMs = 0;
+};
+
+void skipSpace(const char*& p) {
+    while (std::isspace(static_cast<unsigned char>(*p))) ++p;
+}
+
+bool allDigits(const std::string& text) {
+    return !text.empty() &&
+           std::all_of(text.begin(), text.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)); });
+}
+
+template <typename Fields>
+bool bindField(const Fields& fields, const std::string& name, ParsedRule& rule) {
+    long field = findField(fields, name);
+    if (field < 0) return false;
+    rule.field = static_cast<uint16_t>(field);
+    rule.unit = fields[static_cast<size_t>(field)].unit;
+    rule.collector = fields[static_cast<size_t>(field)].collector;
+    rule.cumulative = fields[static_cast<size_t>(field)].cumulative;
+    return true;
+}
+
+// A SnapshotMetrics name, or <group>.<target>.<field> where the target is
+// `*`, a core index, a disk, interface or process name, or a PID. Targets
+// may contain dots (VLAN interfaces, process names): the field is the part
+// after the last one.
+bool resolveMetric(const std::string& path, ParsedRule& rule, std::string& error) {
+    if (bindField(SnapshotMetrics::hostFields(), path, rule)) return true;
+
+    size_t dot = path.find('.');
+    std::string group = path.substr(0, dot);
+    std::string target;
+    std::string name;
+    bool found = false;
+    if (path.compare(0, 9, "cpu.core.") == 0) {
+        rule.scope = kCore;
+        rule.collector = Collector::CPU;
+        size_t fieldDot = path.find('.', 9);
+        target = path.substr(9, fieldDot == std::string::npos ? std::string::npos : fieldDot - 9);
+        name = fieldDot == std::string::npos ? std::string("usage") : path.substr(fieldDot + 1);
+        long field = findField(kCoreFields, name);
+        if (field >= 0) {
+            rule.field = static_cast<uint16_t>(field);
+            rule.unit = kCoreFields[field].unit;
+            found = true;
+        }
+        group = "cpu.core";
+    } else {
+        size_t last = path.rfind('.');
+        if (dot == std::string::npos || last == dot ||
+            (group != "disk" && group != "network" && group != "process")) {
+            error = "unknown metric '" + path + "'";
+            return false;
+        }
+        target = path.substr(dot + 1, last - dot - 1);
+        name = path.substr(last + 1);
+        if (group == "disk") {
+            rule.scope = kDisk;
+            found = bindField(diskFields(), name, rule);
+        } else if (group == "network") {
+            rule.scope = kInterface;
+            found = bindField(SnapshotMetrics::interfaceFields(), name, rule);
+        } else {
+            rule.scope = kProcess;
+            found = bindField(kProcessFields, name, rule);
+        }
+    }
+    if (!found) {
+        error = "unknown field '" + name + "' of " + group;
+        return false;
+    }
+
+    if (target == "*") {
+        rule.select = kAny;
+    } else if (target.empty()) {
+        error = "empty target in '" + path + "'";
+        return false;
+    } else if ((rule.scope == kCore || rule.scope == kProcess) && allDigits(target)) {
+        rule.select = kByKey;
+        rule.selector = std::strtoull(target.c_str(), nullptr, 10);
+    } else if (rule.scope == kCore) {
+        error = "a core is selected by index, got '" + target + "'";
+        return false;
+    } else {
+        rule.select = kByLabel;
+        rule.selector = hashName(target);
+    }
+    return true;
+}
+
+// A number with an optional size suffix, in the metric's unit
+bool parseAmount(const char*& p, MetricUnit unit, double& value, std::string& error) {
+    char* end = nullptr;
+    value = std::strtod(p, &end);
+    if (end == p || !std::isfinite(value)) {
+        error = "expected a number";
+        return false;
+    }
+    p = end;
+    std::string suffix;
+    while (std::isalpha(static_cast<unsigned char>(*p)) || *p == '%' || *p == '/') suffix += *p++;
+    if (suffix.size() >= 2 && suffix.compare(suffix.size() - 2, 2, "/s") == 0) suffix.resize(suffix.size() - 2);
+    if (suffix.empty() || suffix == "%") return true;
+
+    double megabytes = 0.0;
+    char scale = static_cast<char>(std::toupper(static_cast<unsigned char>(suffix[0])));
+    std::string tail = suffix.substr(1);
+    if (scale == 'K') megabytes = 1.0 / 1024.0;
+    else if (scale == 'M') megabytes = 1.0;
+    else if (scale == 'G') megabytes = 1024.0;
+    else if (scale == 'T') megabytes = 1024.0 * 1024.0;
+    if (megabytes == 0.0 || !(tail.empty() || tail == "B" || tail == "iB")) {
+        error = "unknown unit '" + suffix + "'";
+        return false;
+    }
+    if (unit == kPlain) {
+        error = "'" + suffix + "' on a metric that is not a size or speed";
+        return false;
+    }
+    value *= megabytes / (unit == kGigabytes ? 1024.0 : 1.0);
+    return true;
+}
+
+bool parseDuration(const char*& p, int64_t& ms, std::string& error) {
+    char* end = nullptr;
+    double value = std::strtod(p, &end);
+    if (end == p || !std::isfinite(value) || value < 0.0) {
+        error = "expected a duration such as 10s";
+        return false;
+    }
+    p = end;
+    std::string suffix;
+    while (std::isalpha(static_cast<unsigned char>(*p))) suffix += *p++;
+    double scale = 0.0;
+    if (suffix == "ms") scale = 1.0;
+    else if (suffix.empty() || suffix == "s") scale = 1000.0;
+    else if (suffix == "m") scale = 60000.0;
+    else if (suffix == "h") scale = 3600000.0;
+    if (scale == 0.0) {
+        error = "unknown duration unit '" + suffix + "'";
+        return false;
+    }
+    ms = static_cast<int64_t>(value * scale);
+    return true;
+}
+
+bool parseRule(const std::string& text, ParsedRule& rule, std::string& error) {
+    const char* p = text.c_str();
+    skipSpace(p);
+    std::string path;
+    while (*p && !std::isspace(static_cast<unsigned char>(*p)) && *p != '<' && *p != '>') path += *p++;
+    if (path.empty()) {
+        error = "expected a metric";
+        return false;
+    }
+    if (!resolveMetric(path, rule, error)) return false;
+
+    skipSpace(p);
+    if (p[0] == '>' || p[0] == '<') {
+        bool above = p[0] == '>';
+        bool inclusive = p[1] == '=';
+        rule.op = above ? (inclusive ? kAtLeast : kAbove) : (inclusive ? kAtMost : kBelow);
+        p += inclusive ? 2 : 1;
+    } else {
+        error = "expected >, >=, < or <= after " + path;
+        return false;
+    }
+    skipSpace(p);
+    if (!parseAmount(p, rule.unit, rule.threshold, error)) return false;
+    rule.clear = rule.threshold;
+
+    bool hasFor = false;
+    bool hasClear = false;
+    for (;;) {
+        skipSpace(p);
+        if (!*p) break;
+        std::string word;
+        while (std::isalpha(static_cast<unsigned char>(*p))) word += *p++;
+        skipSpace(p);
+        if (word == "for" && !hasFor) {
+            if (!parseDuration(p, rule.forMs, error)) return false;
+            hasFor = true;
+        } else if (word == "clear" && !hasClear) {
+            if (!parseAmount(p, rule.unit, rule.clear, error)) return false;
+            hasClear = true;
+        } else {
+            error = word.empty() ? std::string("unexpected '") + *p + "'" : "unexpected '" + word + "'";
+            return false;
+        }
+    }
+
+    bool above = rule.op == kAbove || rule.op == kAtLeast;
+    if (above ? rule.clear > rule.threshold : rule.clear < rule.threshold) {
+        error = above ? "clear level must not be above the threshold" : "clear level must not be below the threshold";
+        return false;
+    }
+    return true;
+}
+}
+
+struct AlertEngine::Column {
+    uint8_t scope;
+    uint16_t field;
+    bool cumulative; // Totals, compared as their increase per second
+    std::vector<double> values; // One per target of the scope
+    double low; // Range of `values`, NaN aside
+    double high;
+    // Cumulative columns: the previous totals per slot, and when they were read
+    std::vector<double> previous;
+    std::vector<uint64_t> previousTick; // Per slot
+    uint64_t tick;
+    int64_t previousMs;
+};
+
+struct AlertEngine::Check {
+    uint32_t rule;
+    uint32_t column;
+    uint32_t group; // kNoGroup for a check of one target
+    uint8_t scope;
+    uint8_t op;
+    uint8_t select;
+    uint64_t selector;
+    double threshold;
+    double clear;
+    int64_t forMs;
+    std::vector<int64_t> since; // Per slot of the scope: kIdle, kFiring or a time
+    std::vector<double> latest; // Per slot, the latest value while firing
+    size_t live; // Slots pending or firing
+};
+
+// The `*` checks on one column with one comparison, by threshold: ascending
+// for > and >=, descending for < and <=, so the checks a value passes come
+// first
+struct AlertEngine::Group {
+    uint32_t column;
+    uint8_t scope;
+    uint8_t op;
+    std::vector<uint32_t> checks;
+    std::vector<uint32_t> liveAt; // Per slot: checks pending or firing there
+    size_t live; // Sum of liveAt
+};
+
+// Targets of one scope. A slot holds one target's state for every check
+// and is reused once the target is gone.
+struct AlertEngine::Slots {
+    std::vector<uint64_t> keys; // Per slot: core index, name hash or PID
+    std::vector<uint64_t> seenTick; // Per slot; 0 while free
+    std::vector<std::string> targets; // Per slot, as reported
+    std::vector<uint32_t> checks; // Checks on this scope
+    std::vector<uint32_t> groups; // Groups on this scope
+
+    // This sample's targets
+    size_t elements = 0;
+    std::vector<uint64_t> elementKeys;
+    std::vector<uint64_t> elementLabels; // Name hash (index for cores)
+    std::vector<uint32_t> elementSlots;
+};
+
+struct AlertEngine::Program {
+    std::vector<uint8_t> scopes;
+    std::vector<uint32_t> columns;
+    std::vector<uint32_t> checks; // Of one target each
+    std::vector<uint32_t> groups;
+};
+
+AlertEngine::AlertEngine() : scopes(kScopes), programs(kCollectors) {}
+
+AlertEngine::~AlertEngine() = default;
+
+bool AlertEngine::validate(const std::string& rule, std::string& error) {
+    ParsedRule parsed;
+    return parseRule(rule, parsed, error);
+}
+
+bool AlertEngine::compile(const std::vector<std::string>& ruleTexts, std::string& error) {
+    std::vector<ParsedRule> parsed(ruleTexts.size());
+    for (size_t i = 0; i < ruleTexts.size(); ++i) {
+        std::string reason;
+        if (!parseRule(ruleTexts[i], parsed[i], reason)) {
+            error = "rule " + std::to_string(i + 1) + ": " + reason;
+            return false;
+        }
+    }
+
+    rules.clear();
+    columns.clear();
+    checks.clear();
+    groups.clear();
+    scopes.assign(kScopes, Slots());
+    programs.assign(kCollectors, Program());
+    alerts = AlertsInfo();
+    activeRefs.clear();
+
+    for (size_t i = 0; i < parsed.size(); ++i) {
+        const ParsedRule& rule = parsed[i];
+        std::string text = ruleTexts[i];
+        text.erase(0, text.find_first_not_of(" \t"));
+        text.erase(text.find_last_not_of(" \t\r\n") + 1);
+        rules.push_back(std::move(text));
+
+        Program& program = programs[static_cast<size_t>(rule.collector)];
+        uint32_t column = 0;
+        while (column < columns.size() &&
+               (columns[column].scope != rule.scope || columns[column].field != rule.field)) {
+            ++column;
+        }
+        if (column == columns.size()) {
+            columns.push_back(Column{rule.scope, rule.field, rule.cumulative, {}, 0.0, 0.0, {}, {}, 0, 0});
+            program.columns.push_back(column);
+        }
+        if (std::find(program.scopes.begin(), program.scopes.end(), rule.scope) == program.scopes.end()) {
+            program.scopes.push_back(rule.scope);
+        }
+
+        uint32_t index = static_cast<uint32_t>(checks.size());
+        uint32_t group = kNoGroup;
+        if (rule.select == kAny) {
+            group = 0;
+            while (group < groups.size() && (groups[group].column != column || groups[group].op != rule.op)) ++group;
+            if (group == groups.size()) {
+                groups.push_back(Group{column, rule.scope, rule.op, {}, {}, 0});
+                program.groups.push_back(group);
+                scopes[rule.scope].groups.push_back(group);
+            }
+            groups[group].checks.push_back(index);
+        } else {
+            program.checks.push_back(index);
+        }
+        checks.push_back(Check{static_cast<uint32_t>(i), column, group, rule.scope, rule.op, rule.select,
+                               rule.selector, rule.threshold, rule.clear, rule.forMs, {}, {}, 0});
+        scopes[rule.scope].checks.push_back(index);
+    }
+
+    for (Group& group : groups) {
+        bool above = group.op == kAbove || group.op == kAtLeast;
+        std::stable_sort(group.checks.begin(), group.checks.end(), [&](uint32_t a, uint32_t b) {
+            return above ? checks[a].threshold < checks[b].threshold : checks[a].threshold > checks[b].threshold;
+        });
+    }
+    return true;
+}
+
+// Maps this sample's targets of `scope` to slots, and resolves the
+// targets that are gone
+void AlertEngine::prepare(size_t scope, const Snapshot& snapshot, int64_t unixMs) {
+    Slots& slots = scopes[scope];
+    const std::vector<DiskInfo>& disks = *snapshot.disks;
+    switch (scope) {
+    case kHost:
+        slots.elements = 1;
+        break;
+    case kCore:
+        slots.elements = snapshot.cpu->coreUsage.size();
+        break;
+    case kDisk:
+        slots.elements = disks.size();
+        break;
+    case kInterface:
+        slots.elements = snapshot.network->interfaces.size();
+        break;
+    case kProcess:
+        slots.elements = processList.size();
+        break;
+    }
+    slots.elementKeys.resize(slots.elements);
+    slots.elementLabels.resize(slots.elements);
+    slots.elementSlots.resize(slots.elements, kNoSlot);
+    for (size_t i = 0; i < slots.elements; ++i) {
+        uint64_t key = i;
+        uint64_t label = i;
+        if (scope == kDisk) {
+            key = label = hashName(disks[i].name);
+        } else if (scope == kInterface) {
+            key = label = hashName(snapshot.network->interfaces[i].name);
+        } else if (scope == kProcess) {
+            key = static_cast<uint64_t>(processList[i]->pid);
+            label = hashName(processList[i]->name);
+        }
+        slots.elementKeys[i] = key;
+        slots.elementLabels[i] = label;
+
+        // Targets mostly keep their position, so try last sample's slot first
+        uint32_t slot = slots.elementSlots[i];
+        size_t capacity = slots.keys.size();
+        if (slot >= capacity || slots.seenTick[slot] == 0 || slots.keys[slot] != key) {
+            slot = kNoSlot;
+            for (size_t s = 0; s < capacity && slot == kNoSlot; ++s) {
+                if (slots.seenTick[s] != 0 && slots.keys[s] == key) slot = static_cast<uint32_t>(s);
+            }
+        }
+        if (slot == kNoSlot) {
+            for (size_t s = 0; s < capacity && slot == kNoSlot; ++s) {
+                if (slots.seenTick[s] == 0) slot = static_cast<uint32_t>(s);
+            }
+            if (slot == kNoSlot) {
+                slot = static_cast<uint32_t>(capacity);
+                size_t grown = std::max<size_t>(4, capacity * 2);
+                slots.keys.resize(grown);
+                slots.seenTick.resize(grown, 0);
+                slots.targets.resize(grown);
+                for (uint32_t check : slots.checks) {
+                    checks[check].since.resize(grown, kIdle);
+                    checks[check].latest.resize(grown);
+                }
+                for (uint32_t group : slots.groups) groups[group].liveAt.resize(grown, 0);
+            }
+            slots.keys[slot] = key;
+            if (scope == kHost) slots.targets[slot].clear();
+            else if (scope == kCore) slots.targets[slot] = std::to_string(i);
+            else if (scope == kDisk) slots.targets[slot] = disks[i].name;
+            else if (scope == kInterface) slots.targets[slot] = snapshot.network->interfaces[i].name;
+            else slots.targets[slot] = std::to_string(processList[i]->pid);
+        } else if (slots.seenTick[slot] == tick) {
+            slot = kNoSlot; // Same key twice in one sample; the first one wins
+        }
+        if (slot != kNoSlot) slots.seenTick[slot] = tick;
+        slots.elementSlots[i] = slot;
+    }
+
+    for (size_t s = 0; s < slots.keys.size(); ++s) {
+        if (slots.seenTick[s] == 0 || slots.seenTick[s] == tick) continue;
+        for (uint32_t index : slots.checks) {
+            Check& check = checks[index];
+            if (check.since[s] == kFiring) {
+                resolve(check, static_cast<uint32_t>(s), check.latest[s], unixMs);
+            } else if (check.since[s] != kIdle) {
+                check.since[s] = kIdle;
+                stopped(check, static_cast<uint32_t>(s));
+            }
+        }
+        slots.seenTick[s] = 0;
+    }
+}
+
+void AlertEngine::extract(Column& column, const Snapshot& snapshot, int64_t nowMs) {
+    const Slots& slots = scopes[column.scope];
+    column.values.resize(slots.elements);
+    double* out = column.values.data();
+    switch (column.scope) {
+    case kHost:
+        out[0] = SnapshotMetrics::hostFields()[column.field].read(snapshot);
+        break;
+    case kCore: {
+        auto read = kCoreFields[column.field].read;
+        for (size_t i = 0; i < slots.elements; ++i) out[i] = read(*snapshot.cpu, i);
+        break;
+    }
+    case kDisk: {
+        auto read = diskFields()[column.field].read;
+        const std::vector<DiskInfo>& disks = *snapshot.disks;
+        for (size_t i = 0; i < slots.elements; ++i) out[i] = read(disks[i]);
+        break;
+    }
+    case kInterface: {
+        auto read = SnapshotMetrics::interfaceFields()[column.field].read;
+        for (size_t i = 0; i < slots.elements; ++i) out[i] = read(snapshot.network->interfaces[i]);
+        break;
+    }
+    case kProcess: {
+        auto read = kProcessFields[column.field].read;
+        for (size_t i = 0; i < slots.elements; ++i) out[i] = read(*processList[i]);
+        break;
+    }
+    }
+    if (column.cumulative) toRates(column, nowMs);
+
+    // std::min and std::max keep their first argument over a NaN
+    double low = std::numeric_limits<double>::infinity();
+    double high = -low;
+    for (size_t i = 0; i < slots.elements; ++i) {
+        low = std::min(low, out[i]);
+        high = std::max(high, out[i]);
+    }
+    column.low = low;
+    column.high = high;
+}
+
+// Replaces the totals just read with their increase per second since the
+// previous sample. A target seen for the first time, or whose total went
+// back (a re-created interface), has no value until the next sample.
+void AlertEngine::toRates(Column& column, int64_t nowMs) {
+    const Slots& slots = scopes[column.scope];
+    if (column.previous.size() < slots.keys.size()) {
+        column.previous.resize(slots.keys.size(), 0.0);
+        column.previousTick.resize(slots.keys.size(), 0);
+    }
+    double seconds = (nowMs - column.previousMs) / 1000.0;
+    bool haveInterval = column.tick != 0 && seconds > 0.0;
+    double* values = column.values.data();
+    for (size_t i = 0; i < slots.elements; ++i) {
+        uint32_t slot = slots.elementSlots[i];
+        double total = values[i];
+        if (slot == kNoSlot) {
+            values[i] = kNoData;
+            continue;
+        }
+        bool known = haveInterval && column.previousTick[slot] == column.tick && total >= column.previous[slot];
+        values[i] = known ? (total - column.previous[slot]) / seconds : kNoData;
+        column.previous[slot] = total;
+        column.previousTick[slot] = tick;
+    }
+    column.tick = tick;
+    column.previousMs = nowMs;
+}
+
+void AlertEngine::started(Check& check, uint32_t slot) {
+    ++check.live;
+    if (check.group == kNoGroup) return;
+    Group& group = groups[check.group];
+    ++group.liveAt[slot];
+    ++group.live;
+}
+
+void AlertEngine::stopped(Check& check, uint32_t slot) {
+    --check.live;
+    if (check.group == kNoGroup) return;
+    Group& group = groups[check.group];
+    --group.liveAt[slot];
+    --group.live;
+}
+
+// One check on one target's value
+template <int OpIndex>
+inline void AlertEngine::step(Check& check, uint32_t slot, double value, int64_t nowMs, int64_t unixMs) {
+    int64_t state = check.since[slot];
+
+    // Idle is the common case: one load and one compare (a NaN fails it)
+    if (state == kIdle) {
+        if (!passes<OpIndex>(value, check.threshold)) return;
+        check.since[slot] = state = nowMs;
+        started(check, slot);
+    } else if (std::isnan(value)) {
+        return; // No data keeps the state
+    } else if (state == kFiring) {
+        check.latest[slot] = value;
+        if (!passes<OpIndex>(value, check.clear)) resolve(check, slot, value, unixMs);
+        return;
+    } else if (!passes<OpIndex>(value, check.threshold)) {
+        check.since[slot] = kIdle;
+        stopped(check, slot);
+        return;
+    }
+    if (nowMs - state >= check.forMs) fire(check, slot, value, unixMs);
+}
+
+// A check of one target
+template <int OpIndex>
+void AlertEngine::run(Check& check, int64_t nowMs, int64_t unixMs) {
+    const Column& column = columns[check.column];
+    // Nothing pending or firing, and no target past the threshold
+    bool above = OpIndex == kAbove || OpIndex == kAtLeast;
+    if (check.live == 0 && !passes<OpIndex>(above ? column.high : column.low, check.threshold)) return;
+
+    const Slots& slots = scopes[check.scope];
+    const uint64_t* ids = check.select == kByLabel ? slots.elementLabels.data() : slots.elementKeys.data();
+    for (size_t i = 0; i < slots.elements; ++i) {
+        uint32_t slot = slots.elementSlots[i];
+        if (ids[i] == check.selector && slot != kNoSlot) step<OpIndex>(check, slot, column.values[i], nowMs, unixMs);
+    }
+}
+
+template <int OpIndex>
+void AlertEngine::runGroup(Group& group, int64_t nowMs, int64_t unixMs) {
+    const Column& column = columns[group.column];
+    // Nothing pending or firing, and no target past the lowest threshold
+    bool above = OpIndex == kAbove || OpIndex == kAtLeast;
+    double first = checks[group.checks.front()].threshold;
+    if (group.live == 0 && !passes<OpIndex>(above ? column.high : column.low, first)) return;
+
+    const Slots& slots = scopes[group.scope];
+    const double* values = column.values.data();
+    const uint32_t* slotOf = slots.elementSlots.data();
+    const uint32_t* liveAt = group.liveAt.data();
+    for (size_t i = 0; i < slots.elements; ++i) {
+        uint32_t slot = slotOf[i];
+        if (slot == kNoSlot) continue;
+        double value = values[i];
+        if (liveAt[slot] == 0) {
+            // Every check is idle for this target: only the ones whose
+            // threshold the value passes start, and they come first
+            for (uint32_t index : group.checks) {
+                Check& check = checks[index];
+                if (!passes<OpIndex>(value, check.threshold)) break;
+                step<OpIndex>(check, slot, value, nowMs, unixMs);
+            }
+        } else {
+            for (uint32_t index : group.checks) step<OpIndex>(checks[index], slot, value, nowMs, unixMs);
+        }
+    }
+}
+
+void AlertEngine::fire(Check& check, uint32_t slot, double value, int64_t unixMs) {
+    check.since[slot] = kFiring;
+    check.latest[slot] = value;
+
+    if (spareAlerts.empty()) {
+        alerts.active.emplace_back();
+    } else {
+        alerts.active.push_back(std::move(spareAlerts.back()));
+        spareAlerts.pop_back();
+    }
+    ActiveAlert& alert = alerts.active.back();
+    alert.rule.assign(rules[check.rule]);
+    alert.target.assign(scopes[check.scope].targets[slot]);
+    alert.value = value;
+    alert.sinceMs = unixMs;
+    activeRefs.push_back(ActiveRef{static_cast<uint32_t>(&check - checks.data()), slot});
+    pushEvent(check, slot, true, value, unixMs);
+}
+
+void AlertEngine::resolve(Check& check, uint32_t slot, double value, int64_t unixMs) {
+    check.since[slot] = kIdle;
+    stopped(check, slot);
+
+    uint32_t index = static_cast<uint32_t>(&check - checks.data());
+    for (size_t i = 0; i < activeRefs.size(); ++i) {
+        if (activeRefs[i].check == index && activeRefs[i].slot == slot) {
+            activeRefs.erase(activeRefs.begin() + static_cast<long>(i));
+            auto alert = alerts.active.begin() + static_cast<long>(i);
+            spareAlerts.push_back(std::move(*alert));
+            alerts.active.erase(alert);
+            break;
+        }
+    }
+    pushEvent(check, slot, false, value, unixMs);
+}
+
+void AlertEngine::pushEvent(const Check& check, uint32_t slot, bool firing, double value, int64_t unixMs) {
+    // Once full, the oldest event is moved to the back and overwritten
+    if (alerts.events.size() >= kRecentEvents) {
+        std::rotate(alerts.events.begin(), alerts.events.begin() + 1, alerts.events.end());
+    } else {
+        alerts.events.emplace_back();
+    }
+    AlertEvent& event = alerts.events.back();
+    event.sequence = ++sequence;
+    event.timestampMs = unixMs;
+    event.firing = firing;
+    event.rule.assign(rules[check.rule]);
+    event.target.assign(scopes[check.scope].targets[slot]);
+    event.value = value;
+    changed = true;
+}
+
+bool AlertEngine::evaluate(Collector collector, const Snapshot& snapshot, int64_t nowMs, int64_t unixMs) {
+    Program& program = programs[static_cast<size_t>(collector)];
+    if (program.checks.empty() && program.groups.empty()) return false;
+    changed = false;
+    ++tick;
+
+    if (collector == Collector::Process) {
+        processList.clear();
+        for (const ProcessInfo& proc : *snapshot.processes) processList.push_back(&proc);
+        for (const ProcessInfo& proc : *snapshot.watchedProcesses) {
+            bool ranked = std::any_of(snapshot.processes->begin(), snapshot.processes->end(),
+                                      [&](const ProcessInfo& other) { return other.pid == proc.pid; });
+            if (!ranked) processList.push_back(&proc);
+        }
+    }
+    for (uint8_t scope : program.scopes) prepare(scope, snapshot, unixMs);
+    for (uint32_t column : program.columns) extract(columns[column], snapshot, nowMs);
+
+    for (uint32_t index : program.groups) {
+        Group& group = groups[index];
+        switch (group.op) {
+        case kAbove: runGroup<kAbove>(group, nowMs, unixMs); break;
+        case kAtLeast: runGroup<kAtLeast>(group, nowMs, unixMs); break;
+        case kBelow: runGroup<kBelow>(group, nowMs, unixMs); break;
+        default: runGroup<kAtMost>(group, nowMs, unixMs); break;
+        }
+    }
+    for (uint32_t index : program.checks) {
+        Check& check = checks[index];
+        switch (check.op) {
+        case kAbove: run<kAbove>(check, nowMs, unixMs); break;
+        case kAtLeast: run<kAtLeast>(check, nowMs, unixMs); break;
+        case kBelow: run<kBelow>(check, nowMs, unixMs); break;
+        default: run<kAtMost>(check, nowMs, unixMs); break;
+        }
+    }
+    return changed;
+}
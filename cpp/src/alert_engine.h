@@ -0,0 +1,119 @@
+#pragma once
+
+#include "../include/system_monitor.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Threshold alerts evaluated inside the monitor, as each collector publishes.
+//
+// A rule compares one metric with a threshold:
+//
+//   METRIC OP NUMBER[UNIT] [for DURATION] [clear NUMBER[UNIT]]
+//
+//   cpu.usage > 90 for 10s
+//   cpu.core.* >= 99 for 30s clear 80
+//   disk.*.free < 5GB
+//   disk.sda.usedPercent > 90 clear 85
+//   network.eth0.rxErrors > 0            (errors per second)
+//   process.*.memoryUsage > 2GB for 1m
+//   process.nginx.cpuUsage > 50          (by name; process.1234 by PID)
+//
+// METRIC is a series name as SnapshotMetrics gives it (cpu.usage,
+// cpu.core.3, disk.sda.free, network.eth0.rxErrors, ...) or a process
+// field, process.<pid or name>.<field>. A `*` in place of the core, disk,
+// interface or process matches every one of them; processes are the
+// ranked and watched ones in the snapshot. Rules can also read
+// cpu.core.N.<field> (frequency and the CPU time shares), disk total and
+// usedPercent. Totals that only grow (network.*.rxErrors, txErrors,
+// rxDropped, txDropped and memory.oomKills) are compared as their increase
+// per second, which has no value on a target's first sample. OP is >, >=,
+// < or <=. Sizes and speeds take K, M, G or T (binary, with an optional B
+// and /s) and are converted to the field's unit; `%` is allowed and
+// ignored. DURATION is a number with ms, s, m or h.
+//
+// A target fires once the comparison has held on every sample for the
+// `for` duration, and resolves when the value is no longer past the
+// `clear` level (the threshold by default), so a value hovering around the
+// threshold does not flap. A target that disappears (a process exits or
+// leaves the ranking, a disk is unmounted) resolves.
+//
+// Rules are compiled once into checks bound to a field reader; the fields
+// a collector's rules use are extracted into one column each per sample.
+// Checks of every target (`*`) on the same column and comparison form a
+// group sorted by threshold, so one pass over the column serves all of
+// them: where none is pending or firing, a value visits only the checks it
+// passes, and a group whose column does not reach its lowest threshold is
+// skipped whole. Checks of one target scan the column for it. State lives
+// in per-target slots that are reused as targets come and go, and resolved
+// alerts and old events are recycled, so evaluation does not allocate once
+// the tables have grown to the number of targets and alerts.
+// Not thread safe: SystemMonitor calls evaluate() under its publish lock.
+class AlertEngine {
+public:
+    static constexpr size_t kRecentEvents = 32;
+
+    AlertEngine();
+    ~AlertEngine();
+
+    AlertEngine(const AlertEngine&) = delete;
+    AlertEngine& operator=(const AlertEngine&) = delete;
+
+    // Parses one rule without adding it; on failure `error` says why
+    static bool validate(const std::string& rule, std::string& error);
+
+    // Replaces the rule set. On a rule that does not parse, returns false,
+    // sets `error` to "rule N: reason" and keeps the previous rules.
+    bool compile(const std::vector<std::string>& rules, std::string& error);
+
+    // Runs the rules that read `collector`'s fields against `snapshot`,
+    // which has just received that collector's sample. `nowMs` is any
+    // clock that does not go backwards (durations are measured on it);
+    // `unixMs` stamps the alerts. Returns true if info() changed.
+    bool evaluate(Collector collector, const Snapshot& snapshot, int64_t nowMs, int64_t unixMs);
+
+    const AlertsInfo& info() const { return alerts; }
+    size_t ruleCount() const { return rules.size(); }
+
+private:
+    struct Column;
+    struct Check;
+    struct Group;
+    struct Slots;
+    struct Program;
+
+    std::vector<std::string> rules;
+    std::vector<Column> columns;
+    std::vector<Check> checks;
+    std::vector<Group> groups;
+    std::vector<Slots> scopes;
+    std::vector<Program> programs; // Indexed by Collector
+
+    std::vector<const ProcessInfo*> processList; // Ranked, then watched
+    AlertsInfo alerts;
+    struct ActiveRef {
+        uint32_t check;
+        uint32_t slot;
+    };
+    std::vector<ActiveRef> activeRefs; // Parallel to alerts.active
+    std::vector<ActiveAlert> spareAlerts; // Resolved, their strings kept for reuse
+    uint64_t sequence = 0;
+    uint64_t tick = 0;
+    bool changed = false;
+
+    void prepare(size_t scope, const Snapshot& snapshot, int64_t unixMs);
+    void extract(Column& column, const Snapshot& snapshot, int64_t nowMs);
+    void toRates(Column& column, int64_t nowMs);
+    template <int OpIndex>
+    void step(Check& check, uint32_t slot, double value, int64_t nowMs, int64_t unixMs);
+    template <int OpIndex>
+    void run(Check& check, int64_t nowMs, int64_t unixMs);
+    template <int OpIndex>
+    void runGroup(Group& group, int64_t nowMs, int64_t unixMs);
+    void started(Check& check, uint32_t slot);
+    void stopped(Check& check, uint32_t slot);
+    void fire(Check& check, uint32_t slot, double value, int64_t unixMs);
+    void resolve(Check& check, uint32_t slot, double value, int64_t unixMs);
+    void pushEvent(const Check& check, uint32_t slot, bool firing, double value, int64_t unixMs);
+};
@@ -0,0 +1,245 @@
+#include "anomaly_detector.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+const double kNoValue = std::numeric_limits<double>::quiet_NaN();
+constexpr int64_t kDayMs = 86400000;
+constexpr double kRelativeDeviation = 0.02;
+
+// Time constants, seconds
+constexpr double kBaselineSeconds = 600.0; // EWMA mean and variance
+constexpr double kLevelSeconds = 6 * 3600.0; // Holt-Winters level
+constexpr double kTrendSeconds = 86400.0;
+constexpr double kErrorSeconds = 3600.0; // Mean absolute forecast error
+// Share of a seasonal offset replaced by one day's visit to its bucket
+constexpr double kSeasonWeight = 0.5;
+
+const char* const kDetectorNames[] = {"zscore", "cusum", "seasonal"};
+
+// Moves per-series rows to their new index; `from` gives the old index of
+// every new series, -1 for a new one
+template <typename T>
+void remap(std::vector<T>& data, const std::vector<long>& from, size_t width, T fill) {
+    std::vector<T> out(from.size() * width, fill);
+    for (size_t s = 0; s < from.size(); ++s) {
+        if (from[s] < 0) continue;
+        const T* source = data.data() + static_cast<size_t>(from[s]) * width;
+        std::copy(source, source + width, out.data() + s * width);
+    }
+    data = std::move(out);
+}
+
+double clamp(double value, double low, double high) {
+    return std::min(std::max(value, low), high);
+}
+}
+
+AnomalyDetector::AnomalyDetector() : slotPids(kProcessSlots, 0), slotSeen(kProcessSlots, 0) {}
+
+size_t AnomalyDetector::memoryBytes() const {
+    size_t doubles = values.size() + means.size() + variances.size() + cusumHigh.size() + cusumLow.size() +
+                     levels.size() + trends.size() + errors.size() + zscores.size() + baselines.size() +
+                     forecasts.size() + seasonalScores.size();
+    return doubles * sizeof(double) + (seasonStart.size() + since.size()) * sizeof(int64_t) +
+           counts.size() * sizeof(uint32_t) + seasonal.size() * sizeof(float) + flags.size();
+}
+
+// New core, disk or interface set: lay out the host series again, keeping
+// the state of every series that still exists
+void AnomalyDetector::remapHost() {
+    const std::vector<std::string>& host = metrics.names();
+    std::unordered_map<std::string, long> previous;
+    for (size_t s = 0; s < hostSeries; ++s) previous.emplace(names[s], static_cast<long>(s));
+
+    std::vector<long> from(host.size() + 2 * kProcessSlots, -1);
+    for (size_t s = 0; s < host.size(); ++s) {
+        auto found = previous.find(host[s]);
+        if (found != previous.end()) from[s] = found->second;
+    }
+    if (!names.empty()) {
+        for (size_t k = 0; k < 2 * kProcessSlots; ++k) from[host.size() + k] = static_cast<long>(hostSeries + k);
+    }
+
+    remap<std::string>(names, from, 1, std::string());
+    remap<uint32_t>(counts, from, 1, 0);
+    remap<double>(means, from, 1, 0.0);
+    remap<double>(variances, from, 1, 0.0);
+    remap<double>(cusumHigh, from, 1, 0.0);
+    remap<double>(cusumLow, from, 1, 0.0);
+    remap<double>(levels, from, 1, 0.0);
+    remap<double>(trends, from, 1, 0.0);
+    remap<double>(errors, from, 1, 0.0);
+    remap<int64_t>(seasonStart, from, 1, -1);
+    remap<float>(seasonal, from, kSeasonBuckets, 0.0f);
+    remap<uint8_t>(flags, from, 1, 0);
+    remap<int64_t>(since, from, 3, 0);
+    remap<double>(zscores, from, 1, 0.0);
+    remap<double>(baselines, from, 1, 0.0);
+    remap<double>(forecasts, from, 1, 0.0);
+    remap<double>(seasonalScores, from, 1, 0.0);
+
+    std::copy(host.begin(), host.end(), names.begin());
+    hostSeries = host.size();
+    values.assign(names.size(), kNoValue);
+}
+
+void AnomalyDetector::reset(size_t series) {
+    counts[series] = 0;
+    cusumHigh[series] = cusumLow[series] = 0.0;
+    seasonStart[series] = -1;
+    std::fill_n(seasonal.begin() + static_cast<long>(series * kSeasonBuckets), kSeasonBuckets, 0.0f);
+    flags[series] = 0;
+}
+
+// Gives every ranked process a slot (the one it had, a free one, or the
+// least recently seen) and fills in its values
+void AnomalyDetector::placeProcesses(const Snapshot& snapshot, int64_t nowMs) {
+    std::fill(values.begin() + static_cast<long>(hostSeries), values.end(), kNoValue);
+    for (const ProcessInfo& proc : *snapshot.processes) {
+        size_t slot = kProcessSlots;
+        for (size_t s = 0; s < kProcessSlots && slot == kProcessSlots; ++s) {
+            if (slotPids[s] == proc.pid) slot = s;
+        }
+        if (slot == kProcessSlots) {
+            slot = 0;
+            for (size_t s = 1; s < kProcessSlots; ++s) {
+                if (slotPids[slot] == 0) break;
+                if (slotPids[s] == 0 || slotSeen[s] < slotSeen[slot]) slot = s;
+            }
+            if (slotSeen[slot] == nowMs && slotPids[slot] != 0) continue; // More processes than slots
+            slotPids[slot] = proc.pid;
+            size_t series = hostSeries + 2 * slot;
+            std::string prefix = "process." + std::to_string(proc.pid);
+            names[series] = prefix + ".cpuUsage";
+            names[series + 1] = prefix + ".memoryUsage";
+            reset(series);
+            reset(series + 1);
+        }
+        slotSeen[slot] = nowMs;
+        values[hostSeries + 2 * slot] = proc.cpuUsage;
+        values[hostSeries + 2 * slot + 1] = proc.memoryUsage;
+    }
+}
+
+void AnomalyDetector::record(const Snapshot& snapshot, int64_t nowMs) {
+    if (metrics.update(snapshot) || names.empty()) remapHost();
+    std::copy(metrics.values().begin(), metrics.values().end(), values.begin());
+    placeProcesses(snapshot, nowMs);
+
+    // Per-sample smoothing factors, shared by every series
+    double dt = lastMs < 0 ? 1.0 : clamp((nowMs - lastMs) / 1000.0, 1e-3, 3600.0);
+    lastMs = nowMs;
+    const double baselineRate = 1.0 - std::exp(-dt / kBaselineSeconds);
+    const double levelRate = 1.0 - std::exp(-dt / kLevelSeconds);
+    const double trendRate = 1.0 - std::exp(-dt / kTrendSeconds);
+    const double errorRate = 1.0 - std::exp(-dt / kErrorSeconds);
+    const double seasonRate = 1.0 - std::pow(1.0 - kSeasonWeight, dt / (kDayMs / 1000.0 / kSeasonBuckets));
+    const int64_t unixMs = snapshot.timestampMs;
+    const size_t bucket = static_cast<size_t>(((unixMs / 1000) % 86400 + 86400) % 86400 * kSeasonBuckets / 86400);
+
+    const size_t series = names.size();
+    for (size_t i = 0; i < series; ++i) {
+        double x = values[i];
+        if (std::isnan(x)) {
+            flags[i] = 0;
+            continue;
+        }
+        // The first sample only starts the clock: rates read 0 before
+        // there is a delta. The second seeds the baselines.
+        if (counts[i] < 2) {
+            if (counts[i] == 0) {
+                seasonStart[i] = nowMs;
+            } else {
+                means[i] = levels[i] = x;
+                variances[i] = trends[i] = errors[i] = 0.0;
+            }
+            ++counts[i];
+            flags[i] = 0;
+            continue;
+        }
+        // Scores count once the baseline has seen a full time constant;
+        // measured on nowMs, so a wall clock step neither ends nor extends it
+        bool warm = nowMs - seasonStart[i] >= static_cast<int64_t>(kBaselineSeconds * 1000);
+        uint8_t raised = 0;
+
+        // EWMA z-score, and CUSUM of the z-scores
+        double mean = means[i];
+        double deviation = std::max(std::sqrt(variances[i]), std::max(kRelativeDeviation * std::fabs(mean), kMinDeviation));
+        double z = (x - mean) / deviation;
+        double bounded = clamp(z, -kZLimit, kZLimit);
+        if (warm) {
+            cusumHigh[i] = std::min(2 * kCusumLimit, std::max(0.0, cusumHigh[i] + bounded - kCusumSlack));
+            cusumLow[i] = std::min(2 * kCusumLimit, std::max(0.0, cusumLow[i] - bounded - kCusumSlack));
+        }
+        if (warm && std::fabs(z) > kZLimit) raised |= kZScore;
+        if (warm && std::max(cusumHigh[i], cusumLow[i]) > kCusumLimit) raised |= kCusum;
+        zscores[i] = z;
+        baselines[i] = mean;
+
+        double clipped = warm ? mean + bounded * deviation : x;
+        double delta = clipped - mean;
+        // 1/n (Welford) until that falls below the EWMA rate, so the early
+        // mean and variance are those of every sample so far
+        double rate = std::max(1.0 / counts[i], baselineRate);
+        means[i] = mean + rate * delta;
+        variances[i] = (1.0 - rate) * (variances[i] + rate * delta * delta);
+
+        // Holt-Winters: forecast from level, trend and this bucket's offset
+        float& offset = seasonal[i * kSeasonBuckets + bucket];
+        double predicted = levels[i] + trends[i] * dt;
+        double forecast = predicted + offset;
+        double scale = std::max(errors[i], std::max(kRelativeDeviation * std::fabs(forecast), kMinDeviation));
+        double score = (x - forecast) / scale;
+        bool seasoned = nowMs - seasonStart[i] >= kDayMs;
+        if (seasoned && std::fabs(score) > kSeasonalLimit) raised |= kSeasonal;
+        forecasts[i] = forecast;
+        seasonalScores[i] = score;
+
+        double observed = seasoned ? forecast + clamp(score, -kSeasonalLimit, kSeasonalLimit) * scale : x;
+        double level = predicted + levelRate * (observed - offset - predicted);
+        trends[i] += trendRate * ((level - levels[i]) / dt - trends[i]);
+        levels[i] = level;
+        offset += static_cast<float>(seasonRate * (observed - level - offset));
+        errors[i] += errorRate * (std::fabs(observed - forecast) - errors[i]);
+
+        if (counts[i] < UINT32_MAX) ++counts[i];
+        uint8_t started = raised & static_cast<uint8_t>(~flags[i]);
+        for (size_t d = 0; d < 3; ++d) {
+            if (started & (1u << d)) since[i * 3 + d] = unixMs;
+        }
+        flags[i] = raised;
+    }
+}
+
+void AnomalyDetector::report(AnomalyInfo& out) const {
+    out.series = 0;
+    for (double value : values) {
+        if (!std::isnan(value)) ++out.series;
+    }
+    out.flagged.clear();
+    for (size_t i = 0; i < flags.size(); ++i) {
+        if (flags[i] == 0) continue;
+        for (size_t d = 0; d < 3; ++d) {
+            if (!(flags[i] & (1u << d))) continue;
+            MetricAnomaly anomaly;
+            anomaly.metric = names[i];
+            anomaly.detector = kDetectorNames[d];
+            anomaly.value = values[i];
+            anomaly.sinceMs = since[i * 3 + d];
+            if (d == 0) {
+                anomaly.expected = baselines[i];
+                anomaly.score = zscores[i];
+            } else if (d == 1) {
+                anomaly.expected = baselines[i];
+                anomaly.score = cusumHigh[i] >= cusumLow[i] ? cusumHigh[i] : -cusumLow[i];
+            } else {
+                anomaly.expected = forecasts[i];
+                anomaly.score = seasonalScores[i];
+            }
+            out.flagged.push_back(std::move(anomaly));
+        }
+    }
+}
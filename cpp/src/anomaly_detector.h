@@ -0,0 +1,105 @@
+#pragma once
+
+#include "../include/system_monitor.h"
+#include "snapshot_metrics.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Online anomaly scoring of every SnapshotMetrics series (host, per core,
+// per disk, per interface) and of the CPU and memory of the top processes.
+// Each series runs three detectors, updated in O(1) per sample:
+//
+//   zscore    distance from an exponentially weighted mean, in exponentially
+//             weighted standard deviations (10 minute time constant);
+//             flagged beyond kZLimit. Catches spikes.
+//   cusum     two-sided CUSUM of those z-scores with slack kCusumSlack;
+//             flagged while a sum exceeds kCusumLimit. Catches sustained
+//             shifts too small for the z-score.
+//   seasonal  additive Holt-Winters: a slow level and trend plus one
+//             seasonal offset per 15 minutes of the day, scored as the
+//             forecast error over its mean absolute value; flagged beyond
+//             kSeasonalLimit once the series has a day of history. Tells a
+//             nightly backup from a real surge.
+//
+// A series' first sample is skipped (a rate reads 0 before it has a
+// delta) and the next one seeds its baselines. The mean and variance then
+// weigh every sample equally until the EWMA weight is the larger, and
+// nothing is flagged before 10 minutes have passed, so the deviation is
+// measured before anything is scored against it.
+//
+// Baselines see outliers clipped to kZLimit deviations, so one spike does
+// not blind them. Deviations have a floor of 2% of the mean (at least
+// kMinDeviation in the metric's unit), so a flat series is not flagged for
+// a trivial wobble.
+//
+// State is structure-of-arrays over series and fixed once the layout is
+// known: a few doubles plus 96 seasonal floats per series, about 500
+// bytes. Processes get kProcessSlots slots, kept for a process while it
+// drops in and out of the ranking and recycled least recently seen first.
+// When cores, disks or interfaces change, surviving series keep their
+// state. Single-threaded: one task calls record().
+class AnomalyDetector {
+public:
+    static constexpr size_t kSeasonBuckets = 96; // 15 minutes each
+    static constexpr size_t kProcessSlots = 64;
+    static constexpr double kZLimit = 6.0;
+    static constexpr double kCusumSlack = 1.0;
+    static constexpr double kCusumLimit = 12.0;
+    static constexpr double kSeasonalLimit = 8.0;
+    static constexpr double kMinDeviation = 0.5;
+
+    AnomalyDetector();
+
+    AnomalyDetector(const AnomalyDetector&) = delete;
+    AnomalyDetector& operator=(const AnomalyDetector&) = delete;
+
+    // Scores the snapshot's values and updates the baselines. `nowMs` is a
+    // clock that does not go backwards; time constants, warm-up and the
+    // day before seasonal scoring are all measured on it. Only the seasonal
+    // bucket and the reported start times come from snapshot.timestampMs.
+    void record(const Snapshot& snapshot, int64_t nowMs);
+
+    // Series flagged by the last record()
+    void report(AnomalyInfo& out) const;
+
+    size_t seriesCount() const { return names.size(); }
+    size_t memoryBytes() const;
+
+private:
+    enum Detector : uint8_t { kZScore = 1, kCusum = 2, kSeasonal = 4 };
+
+    SnapshotMetrics metrics;
+    size_t hostSeries = 0; // Series before the process slots
+    std::vector<std::string> names;
+    std::vector<double> values; // This sample, NaN where there is none
+
+    // Per series
+    std::vector<uint32_t> counts;
+    std::vector<double> means;
+    std::vector<double> variances;
+    std::vector<double> cusumHigh;
+    std::vector<double> cusumLow;
+    std::vector<double> levels;
+    std::vector<double> trends; // Per second
+    std::vector<double> errors; // Mean absolute forecast error
+    std::vector<int64_t> seasonStart; // nowMs of the first sample, -1 before
+    std::vector<float> seasonal; // [series][bucket]
+    std::vector<uint8_t> flags; // Detector bits set by the last record()
+    std::vector<int64_t> since; // [series][3], Unix ms each flag was raised
+    std::vector<double> zscores; // Last scores, for report()
+    std::vector<double> baselines; // Mean the last z-score was taken against
+    std::vector<double> forecasts;
+    std::vector<double> seasonalScores;
+
+    // Process slots
+    std::vector<int> slotPids; // 0 when free
+    std::vector<int64_t> slotSeen;
+
+    int64_t lastMs = -1;
+
+    void reset(size_t series);
+    void remapHost();
+    void placeProcesses(const Snapshot& snapshot, int64_t nowMs);
+};
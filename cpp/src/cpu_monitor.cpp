@@ -1,8 +1,20 @@
 #include "cpu_monitor.h"
 #include <pdhmsg.h>
 #include <psapi.h>
+#include <cstdlib>
+#include <cstring>
 
-CPUMonitor::CPUMonitor() : query(nullptr), initialized(false) {}
+namespace {
+const char* const kBreakdownPaths[] = {
+    "\\Processor Information(*)\\% User Time",
+    "\\Processor Information(*)\\% Privileged Time",
+    "\\Processor Information(*)\\% Interrupt Time",
+    "\\Processor Information(*)\\% DPC Time",
+    "\\Processor Information(*)\\% Idle Time",
+};
+}
+
+CPUMonitor::CPUMonitor() : query(nullptr), breakdownCounters(), frequencyCounter(nullptr), initialized(false) {}
 
 CPUMonitor::~CPUMonitor() {
     if (query) {
@@ -41,6 +53,27 @@ bool CPUMonitor::initialize() {
         }
     }
 
+    info.coreTimes.resize(info.coreCount);
+    info.coreFrequency.assign(info.coreCount, 0.0);
+
+    // Breakdown and frequency are optional; older systems lack the
+    // Processor Information object
+    for (int i = 0; i < kBreakdownCounters; ++i) {
+        if (PdhAddEnglishCounterA(query, kBreakdownPaths[i], 0, &breakdownCounters[i]) != ERROR_SUCCESS) {
+            breakdownCounters[i] = nullptr;
+        }
+    }
+    if (PdhAddEnglishCounterA(query, "\\Processor Information(*)\\Processor Frequency", 0, &frequencyCounter) !=
+        ERROR_SUCCESS) {
+        frequencyCounter = nullptr;
+    }
+    WORD groups = GetActiveProcessorGroupCount();
+    int first = 0;
+    for (WORD group = 0; group < groups; ++group) {
+        groupFirstCore.push_back(first);
+        first += static_cast<int>(GetActiveProcessorCount(group));
+    }
+
     // Initial collection
     PdhCollectQueryData(query);
 
@@ -66,8 +99,83 @@ void CPUMonitor::update() {
         }
     }
 
-    // Get CPU frequency (simplified - actual frequency requires WMI)
-    info.frequency = 0.0; // Will be set via WMI if needed
+    // Time breakdown. Privileged time includes interrupts and DPCs, which
+    // are reported separately as irq and softirq.
+    auto timesOf = [this](int core) -> CPUTimes* {
+        if (core < 0) return &info.times;
+        return core < static_cast<int>(info.coreTimes.size()) ? &info.coreTimes[core] : nullptr;
+    };
+    if (breakdownCounters[UserTime]) {
+        readInstances(breakdownCounters[UserTime], [&](int core, double v) {
+            if (CPUTimes* times = timesOf(core)) times->user = v;
+        });
+    }
+    if (breakdownCounters[PrivilegedTime]) {
+        readInstances(breakdownCounters[PrivilegedTime], [&](int core, double v) {
+            if (CPUTimes* times = timesOf(core)) times->system = v;
+        });
+    }
+    if (breakdownCounters[InterruptTime]) {
+        readInstances(breakdownCounters[InterruptTime], [&](int core, double v) {
+            if (CPUTimes* times = timesOf(core)) times->irq = v;
+        });
+    }
+    if (breakdownCounters[DpcTime]) {
+        readInstances(breakdownCounters[DpcTime], [&](int core, double v) {
+            if (CPUTimes* times = timesOf(core)) times->softirq = v;
+        });
+    }
+    if (breakdownCounters[IdleTime]) {
+        readInstances(breakdownCounters[IdleTime], [&](int core, double v) {
+            if (CPUTimes* times = timesOf(core)) times->idle = v;
+        });
+    }
+    for (int core = -1; core < static_cast<int>(info.coreTimes.size()); ++core) {
+        CPUTimes* times = timesOf(core);
+        double system = times->system - times->irq - times->softirq;
+        times->system = system > 0.0 ? system : 0.0;
+    }
+
+    if (frequencyCounter) {
+        readInstances(frequencyCounter, [&](int core, double mhz) {
+            if (core < 0) {
+                info.frequency = mhz;
+            } else if (core < static_cast<int>(info.coreFrequency.size())) {
+                info.coreFrequency[core] = mhz;
+            }
+        });
+    }
+}
+
+template <typename Apply>
+void CPUMonitor::readInstances(PDH_HCOUNTER counter, Apply apply) {
+    DWORD bytes = static_cast<DWORD>(counterArray.size());
+    DWORD count = 0;
+    auto* items = reinterpret_cast<PDH_FMT_COUNTERVALUE_ITEM_A*>(counterArray.data());
+    PDH_STATUS status = PdhGetFormattedCounterArrayA(counter, PDH_FMT_DOUBLE, &bytes, &count, items);
+    if (status == PDH_MORE_DATA) {
+        counterArray.resize(bytes);
+        items = reinterpret_cast<PDH_FMT_COUNTERVALUE_ITEM_A*>(counterArray.data());
+        status = PdhGetFormattedCounterArrayA(counter, PDH_FMT_DOUBLE, &bytes, &count, items);
+    }
+    if (status != ERROR_SUCCESS) return;
+
+    for (DWORD i = 0; i < count; ++i) {
+        if (items[i].FmtValue.CStatus != PDH_CSTATUS_VALID_DATA) continue;
+        const char* name = items[i].szName;
+        double value = items[i].FmtValue.doubleValue;
+        if (std::strcmp(name, "_Total") == 0) {
+            apply(-1, value);
+            continue;
+        }
+        // "group,index"; per-group totals ("0,_Total") are skipped
+        const char* comma = std::strchr(name, ',');
+        if (!comma || std::strstr(name, "_Total")) continue;
+        int group = std::atoi(name);
+        int index = std::atoi(comma + 1);
+        if (group < 0 || group >= static_cast<int>(groupFirstCore.size())) continue;
+        apply(groupFirstCore[group] + index, value);
+    }
 }
 
 CPUInfo CPUMonitor::getInfo() const {
@@ -1,11 +1,21 @@
 #pragma once
 
 #include "../include/system_monitor.h"
+#include "platform.h"
+
+#ifdef MONITOR_BACKEND_LINUX
+#include "linux/procfs.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#else
 #include <windows.h>
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
 #endif
 #include <pdh.h>
+#endif
 
 class CPUMonitor {
 public:
@@ -16,10 +26,60 @@ public:
     void update();
     CPUInfo getInfo() const;
 
+#ifdef MONITOR_BACKEND_LINUX
+    // Prefix for every /proc and /sys path: a captured or synthetic tree
+    // laid out like / (see linux/capture.h). Empty for the live host. Call
+    // before initialize().
+    void setRoot(const std::string& prefix) { root = prefix; }
+#endif
+
 private:
+#ifdef MONITOR_BACKEND_LINUX
+    // /proc/stat columns that are kept; guest time is already part of
+    // user/nice
+    enum State { User, Nice, System, Idle, IoWait, Irq, SoftIrq, Steal, kStates };
+
+    // Structure of arrays, one vector per state so the delta loops run over
+    // contiguous memory and vectorize. Row 0 is the aggregate "cpu" line,
+    // row i + 1 is core i.
+    std::string root;
+    ProcFile statFile;
+    size_t rows = 0;
+    // Cumulative jiffies, held as doubles (exact below 2^53) so the deltas
+    // need no integer conversion
+    std::vector<double> current[kStates];
+    std::vector<double> last[kStates];
+    std::vector<double> share[kStates]; // Percent of the interval
+    std::vector<double> rowTotal;
+
+    // scaling_cur_freq per core, or /proc/cpuinfo when cpufreq is missing.
+    // Re-read at most once per kFrequencyInterval.
+    std::vector<std::unique_ptr<ProcFile>> frequencyFiles;
+    ProcFile cpuinfoFile;
+    std::chrono::steady_clock::time_point lastFrequencyTime;
+
+    size_t countCores();
+    bool sample();
+    void computeShares();
+    void sampleFrequency();
+#else
     PDH_HQUERY query;
     PDH_HCOUNTER totalCounter;
     std::vector<PDH_HCOUNTER> coreCounters;
+
+    // Wildcard \Processor Information(*) counters for the time breakdown
+    // and frequency; null when unavailable
+    enum Breakdown { UserTime, PrivilegedTime, InterruptTime, DpcTime, IdleTime, kBreakdownCounters };
+    PDH_HCOUNTER breakdownCounters[kBreakdownCounters];
+    PDH_HCOUNTER frequencyCounter;
+    std::vector<char> counterArray; // Reused PdhGetFormattedCounterArray buffer
+    std::vector<int> groupFirstCore; // Processor group -> index of its first core
+
+    // Calls `apply(core, value)` for every per-core instance ("group,index");
+    // core -1 is the machine-wide _Total
+    template <typename Apply>
+    void readInstances(PDH_HCOUNTER counter, Apply apply);
+#endif
     CPUInfo info;
     bool initialized;
 };
@@ -1,7 +1,16 @@
 #pragma once
 
 #include "../include/system_monitor.h"
+#include "platform.h"
+
+#ifdef MONITOR_BACKEND_LINUX
+#include "linux/procfs.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#else
 #include <windows.h>
+#endif
 #include <vector>
 
 class DiskMonitor {
@@ -11,7 +20,44 @@ public:
     void update();
     std::vector<DiskInfo> getInfo() const;
 
+#ifdef MONITOR_BACKEND_LINUX
+    // Prefix for every /proc path: a captured or synthetic tree laid out
+    // like / (see linux/capture.h). Empty for the live host; with a prefix
+    // there is no capacity, only I/O. Call before initialize().
+    void setRoot(const std::string& prefix) { root = prefix; }
+#endif
+
 private:
     std::vector<DiskInfo> disks;
     bool initialized;
+#ifdef MONITOR_BACKEND_LINUX
+    // Cumulative /proc/diskstats counters of one device
+    struct DeviceCounters {
+        uint32_t major = 0;
+        uint32_t minor = 0;
+        uint64_t reads = 0;
+        uint64_t sectorsRead = 0;
+        uint64_t readMs = 0;
+        uint64_t writes = 0;
+        uint64_t sectorsWritten = 0;
+        uint64_t writeMs = 0;
+        uint64_t weightedMs = 0; // Sum of time every request spent queued or in service
+    };
+
+    std::string root;
+    ProcFile diskstatsFile;
+    ProcFile mountinfoFile;
+    // Indexed like the first deviceCount entries of `disks`
+    std::vector<DeviceCounters> lastCounters;
+    std::vector<DeviceCounters> currentCounters;
+    size_t deviceCount;
+    bool rootfsEntry; // "/" is not on a listed device (e.g. overlayfs)
+    std::chrono::steady_clock::time_point lastSampleTime;
+    std::chrono::steady_clock::time_point lastCapacityTime;
+    bool capacityValid;
+
+    bool readCounters();
+    void rebuildDevices();
+    void updateCapacity();
+#endif
 };
@@ -0,0 +1,245 @@
+#include "gorilla_codec.h"
+#include <cstring>
+
+namespace {
+
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out(out), accumulator(0), used(0) {}
+
+    // Writes the low `count` bits of `bits`, most significant first
+    void write(uint64_t bits, int count) {
+        while (count > 0) {
+            int take = count < 8 - used ? count : 8 - used;
+            uint64_t chunk = (bits >> (count - take)) & ((1u << take) - 1);
+            accumulator = static_cast<uint8_t>(accumulator | (chunk << (8 - used - take)));
+            used += take;
+            count -= take;
+            if (used == 8) {
+                out.push_back(accumulator);
+                accumulator = 0;
+                used = 0;
+            }
+        }
+    }
+
+    void finish() {
+        if (used > 0) out.push_back(accumulator);
+        accumulator = 0;
+        used = 0;
+    }
+
+private:
+    std::vector<uint8_t>& out;
+    uint8_t accumulator;
+    int used;
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t size) : data(data), bitCount(size * 8), position(0) {}
+
+    bool read(int count, uint64_t& value) {
+        if (position + static_cast<size_t>(count) > bitCount) return false;
+        value = 0;
+        while (count > 0) {
+            size_t byte = position >> 3;
+            int offset = static_cast<int>(position & 7);
+            int take = count < 8 - offset ? count : 8 - offset;
+            uint64_t chunk = (data[byte] >> (8 - offset - take)) & ((1u << take) - 1);
+            value = (value << take) | chunk;
+            position += take;
+            count -= take;
+        }
+        return true;
+    }
+
+private:
+    const uint8_t* data;
+    size_t bitCount;
+    size_t position;
+};
+
+uint64_t doubleBits(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double bitsDouble(uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+int leadingZeros(uint64_t v) {
+    return v == 0 ? 64 : __builtin_clzll(v);
+}
+
+int trailingZeros(uint64_t v) {
+    return v == 0 ? 64 : __builtin_ctzll(v);
+}
+
+// Delta-of-delta buckets: control prefix, payload width
+struct DodBucket {
+    uint64_t prefix;
+    int prefixBits;
+    int valueBits;
+};
+constexpr DodBucket kBuckets[] = {
+    {0b10, 2, 7},
+    {0b110, 3, 9},
+    {0b1110, 4, 12},
+};
+
+} // namespace
+
+namespace gorilla {
+
+void encodeTimestamps(const int64_t* timestamps, size_t count, std::vector<uint8_t>& out) {
+    BitWriter writer(out);
+    if (count == 0) return;
+
+    writer.write(static_cast<uint64_t>(timestamps[0]), 64);
+    int64_t previousDelta = 0;
+    for (size_t i = 1; i < count; ++i) {
+        int64_t delta = timestamps[i] - timestamps[i - 1];
+        int64_t dod = delta - previousDelta;
+        previousDelta = delta;
+
+        if (dod == 0) {
+            writer.write(0, 1);
+            continue;
+        }
+        bool written = false;
+        for (const DodBucket& bucket : kBuckets) {
+            int64_t low = -(int64_t(1) << (bucket.valueBits - 1)) + 1;
+            int64_t high = int64_t(1) << (bucket.valueBits - 1);
+            if (dod >= low && dod <= high) {
+                writer.write(bucket.prefix, bucket.prefixBits);
+                writer.write(static_cast<uint64_t>(dod - low), bucket.valueBits);
+                written = true;
+                break;
+            }
+        }
+        if (!written) {
+            writer.write(0b1111, 4);
+            writer.write(static_cast<uint64_t>(dod), 64);
+        }
+    }
+    writer.finish();
+}
+
+bool decodeTimestamps(const uint8_t* data, size_t size, size_t count, int64_t* out) {
+    BitReader reader(data, size);
+    if (count == 0) return true;
+
+    uint64_t raw;
+    if (!reader.read(64, raw)) return false;
+    out[0] = static_cast<int64_t>(raw);
+
+    int64_t previousDelta = 0;
+    for (size_t i = 1; i < count; ++i) {
+        int64_t dod = 0;
+        uint64_t bit;
+        if (!reader.read(1, bit)) return false;
+        if (bit) {
+            // Count further leading ones to select the bucket
+            int ones = 1;
+            while (ones < 4) {
+                if (!reader.read(1, bit)) return false;
+                if (!bit) break;
+                ++ones;
+            }
+            if (ones == 4) {
+                if (!reader.read(64, raw)) return false;
+                dod = static_cast<int64_t>(raw);
+            } else {
+                const DodBucket& bucket = kBuckets[ones - 1];
+                if (!reader.read(bucket.valueBits, raw)) return false;
+                int64_t low = -(int64_t(1) << (bucket.valueBits - 1)) + 1;
+                dod = static_cast<int64_t>(raw) + low;
+            }
+        }
+        previousDelta += dod;
+        out[i] = out[i - 1] + previousDelta;
+    }
+    return true;
+}
+
+void encodeValues(const double* values, size_t count, std::vector<uint8_t>& out) {
+    BitWriter writer(out);
+    if (count == 0) return;
+
+    uint64_t previous = doubleBits(values[0]);
+    writer.write(previous, 64);
+    int windowLeading = -1;
+    int windowTrailing = 0;
+
+    for (size_t i = 1; i < count; ++i) {
+        uint64_t current = doubleBits(values[i]);
+        uint64_t x = current ^ previous;
+        previous = current;
+
+        if (x == 0) {
+            writer.write(0, 1);
+            continue;
+        }
+        writer.write(1, 1);
+
+        int leading = leadingZeros(x);
+        int trailing = trailingZeros(x);
+        if (leading > 31) leading = 31;
+
+        if (windowLeading >= 0 && leading >= windowLeading && trailing >= windowTrailing) {
+            // Fits in the previous window
+            writer.write(0, 1);
+            int meaningful = 64 - windowLeading - windowTrailing;
+            writer.write(x >> windowTrailing, meaningful);
+        } else {
+            int meaningful = 64 - leading - trailing;
+            writer.write(1, 1);
+            writer.write(static_cast<uint64_t>(leading), 5);
+            writer.write(static_cast<uint64_t>(meaningful & 63), 6); // 64 is stored as 0
+            writer.write(x >> trailing, meaningful);
+            windowLeading = leading;
+            windowTrailing = trailing;
+        }
+    }
+    writer.finish();
+}
+
+bool decodeValues(const uint8_t* data, size_t size, size_t count, double* out) {
+    BitReader reader(data, size);
+    if (count == 0) return true;
+
+    uint64_t previous;
+    if (!reader.read(64, previous)) return false;
+    out[0] = bitsDouble(previous);
+    int windowLeading = 0;
+    int windowTrailing = 0;
+
+    for (size_t i = 1; i < count; ++i) {
+        uint64_t bit;
+        if (!reader.read(1, bit)) return false;
+        if (bit) {
+            if (!reader.read(1, bit)) return false;
+            if (bit) {
+                uint64_t leading, meaningful;
+                if (!reader.read(5, leading) || !reader.read(6, meaningful)) return false;
+                if (meaningful == 0) meaningful = 64;
+                windowLeading = static_cast<int>(leading);
+                windowTrailing = 64 - windowLeading - static_cast<int>(meaningful);
+                if (windowTrailing < 0) return false;
+            }
+            uint64_t bits;
+            int meaningful = 64 - windowLeading - windowTrailing;
+            if (!reader.read(meaningful, bits)) return false;
+            previous ^= bits << windowTrailing;
+        }
+        out[i] = bitsDouble(previous);
+    }
+    return true;
+}
+
+} // namespace gorilla
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Column codecs from Facebook's Gorilla TSDB paper:
+//  - timestamps as delta-of-delta with variable-width buckets, so a steady
+//    sampling period costs one bit per sample;
+//  - doubles XORed with their predecessor, storing only the meaningful
+//    bits and reusing the previous leading/trailing zero window when the
+//    new value fits in it.
+// Each call encodes one complete column; the first value is stored raw.
+namespace gorilla {
+
+// Appends the encoded column to `out` (byte aligned at the end)
+void encodeTimestamps(const int64_t* timestamps, size_t count, std::vector<uint8_t>& out);
+void encodeValues(const double* values, size_t count, std::vector<uint8_t>& out);
+
+// Decode exactly `count` values; false if the input is truncated
+bool decodeTimestamps(const uint8_t* data, size_t size, size_t count, int64_t* out);
+bool decodeValues(const uint8_t* data, size_t size, size_t count, double* out);
+
+} // namespace gorilla
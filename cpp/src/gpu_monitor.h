@@ -1,13 +1,17 @@
 #pragma once
 
 #include "../include/system_monitor.h"
+#include "platform.h"
+#include <string>
+
+#ifdef MONITOR_BACKEND_WINDOWS
 #include <windows.h>
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
 #endif
 #include <wbemidl.h>
 #include <comdef.h>
-#include <string>
+#endif
 
 class GPUMonitor {
 public:
@@ -19,10 +23,14 @@ public:
     GPUInfo getInfo() const;
 
 private:
+#ifdef MONITOR_BACKEND_WINDOWS
     IWbemLocator* pLocator;
     IWbemServices* pServices;
+#endif
     GPUInfo info;
     bool initialized;
 
+#ifdef MONITOR_BACKEND_WINDOWS
     bool queryWMI(const std::wstring& query, std::wstring& result);
+#endif
 };
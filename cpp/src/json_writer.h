@@ -0,0 +1,134 @@
+#pragma once
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Streaming writer for compact (single-line) JSON into a caller-owned
+// string. Numbers go through std::to_chars and nothing is buffered besides
+// the output itself, so once the string's capacity has grown to the size
+// of a typical document, writing another one performs no heap allocation.
+// The writer does not validate structure; callers pair begin/end calls.
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& out, int precision = 2)
+        : out(out), precision(precision), depth(0), afterKey(false) {
+        hasElements[0] = false;
+    }
+
+    void beginObject() { open('{'); }
+    void endObject() { close('}'); }
+    void beginArray() { open('['); }
+    void endArray() { close(']'); }
+
+    void key(std::string_view name) {
+        separator();
+        out += '"';
+        out.append(name.data(), name.size());
+        out += "\":";
+        afterKey = true;
+    }
+
+    void value(double v) {
+        separator();
+        // JSON has no NaN/Infinity
+        if (!std::isfinite(v)) v = 0.0;
+        char buffer[64];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), v, std::chars_format::fixed, precision);
+        out.append(buffer, result.ptr);
+    }
+
+    void value(int64_t v) {
+        separator();
+        char buffer[24];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), v);
+        out.append(buffer, result.ptr);
+    }
+
+    void value(uint64_t v) {
+        separator();
+        char buffer[24];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), v);
+        out.append(buffer, result.ptr);
+    }
+
+    void value(int v) { value(static_cast<int64_t>(v)); }
+
+    void value(bool v) {
+        separator();
+        out += v ? "true" : "false";
+    }
+
+    void value(std::string_view s) {
+        separator();
+        out += '"';
+        appendEscaped(s);
+        out += '"';
+    }
+
+    void value(const char* s) { value(std::string_view(s)); }
+    void value(const std::string& s) { value(std::string_view(s)); }
+
+    template <typename T>
+    void field(std::string_view name, const T& v) {
+        key(name);
+        value(v);
+    }
+
+private:
+    static constexpr int kMaxDepth = 32;
+
+    std::string& out;
+    int precision;
+    int depth;
+    bool afterKey;
+    bool hasElements[kMaxDepth + 1];
+
+    void separator() {
+        if (afterKey) {
+            afterKey = false;
+            return;
+        }
+        if (hasElements[depth]) out += ',';
+        hasElements[depth] = true;
+    }
+
+    void open(char bracket) {
+        separator();
+        out += bracket;
+        if (depth < kMaxDepth) ++depth;
+        hasElements[depth] = false;
+    }
+
+    void close(char bracket) {
+        out += bracket;
+        if (depth > 0) --depth;
+    }
+
+    // Same rules as the pretty printer: standard escapes, other control
+    // characters dropped, UTF-8 bytes passed through. Unescaped runs are
+    // appended in one call.
+    void appendEscaped(std::string_view s) {
+        size_t runStart = 0;
+        for (size_t i = 0; i < s.size(); ++i) {
+            unsigned char c = static_cast<unsigned char>(s[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+            out.append(s.data() + runStart, i - runStart);
+            runStart = i + 1;
+            switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: break; // Skip other control characters
+            }
+        }
+        out.append(s.data() + runStart, s.size() - runStart);
+    }
+};
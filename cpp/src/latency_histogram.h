@@ -0,0 +1,125 @@
+#pragma once
+
+#include "platform.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#ifdef MONITOR_BACKEND_LINUX
+#include <time.h>
+#endif
+
+// Monotonic nanoseconds for timing short sections. On Linux this is
+// CLOCK_MONOTONIC_RAW, which the vDSO serves without a syscall and NTP
+// never slews; elsewhere it is steady_clock.
+inline int64_t monotonicNanos() {
+#ifdef MONITOR_BACKEND_LINUX
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// HDR-style histogram of durations in nanoseconds. Values below 32 ns get a
+// bucket each; above that every power of two is split into 32 linear
+// sub-buckets, so a bucket is never wider than 1/32 of its values. Values
+// past 2^40 ns (about 18 minutes) land in the last bucket. The buckets are
+// fixed (about 9 KB), so record() never allocates.
+//
+// One writer at a time: record() uses plain relaxed loads and stores rather
+// than read-modify-write instructions. Readers on other threads may see a
+// recording half applied, which only skews a summary by that one sample.
+class LatencyHistogram {
+public:
+    struct Summary {
+        uint64_t count = 0;
+        double lastNs = 0.0;
+        double meanNs = 0.0;
+        double p50Ns = 0.0;
+        double p95Ns = 0.0;
+        double p99Ns = 0.0;
+        double maxNs = 0.0;
+    };
+
+    LatencyHistogram() {
+        for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+    }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(int64_t nanos) {
+        uint64_t value = nanos > 0 ? static_cast<uint64_t>(nanos) : 0;
+        bump(buckets[bucketIndex(value)], 1);
+        bump(sum, value);
+        if (value > maxValue.load(std::memory_order_relaxed)) maxValue.store(value, std::memory_order_relaxed);
+        last.store(value, std::memory_order_relaxed);
+    }
+
+    Summary summarize() const {
+        std::array<uint64_t, kBuckets> counts;
+        Summary summary;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            counts[i] = buckets[i].load(std::memory_order_relaxed);
+            summary.count += counts[i];
+        }
+        if (summary.count == 0) return summary;
+
+        double maxNs = static_cast<double>(maxValue.load(std::memory_order_relaxed));
+        summary.lastNs = static_cast<double>(last.load(std::memory_order_relaxed));
+        summary.meanNs = static_cast<double>(sum.load(std::memory_order_relaxed)) / summary.count;
+        summary.maxNs = maxNs;
+        // Nearest rank, reported as the bucket midpoint
+        const std::pair<double, double*> ranks[] = {
+            {0.50, &summary.p50Ns}, {0.95, &summary.p95Ns}, {0.99, &summary.p99Ns}};
+        for (const auto& rank : ranks) {
+            uint64_t target = static_cast<uint64_t>(rank.first * summary.count + 0.999999);
+            if (target == 0) target = 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < kBuckets; ++i) {
+                seen += counts[i];
+                if (seen >= target) {
+                    double value = bucketMidpoint(i);
+                    *rank.second = value < maxNs ? value : maxNs;
+                    break;
+                }
+            }
+        }
+        return summary;
+    }
+
+private:
+    static constexpr int kSubBits = 5;
+    static constexpr uint64_t kSubBuckets = uint64_t(1) << kSubBits;
+    static constexpr int kMaxBit = 40;
+    static constexpr size_t kBuckets = (kMaxBit - kSubBits + 2) * kSubBuckets;
+
+    std::array<std::atomic<uint64_t>, kBuckets> buckets;
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> maxValue{0};
+    std::atomic<uint64_t> last{0};
+
+    static void bump(std::atomic<uint64_t>& counter, uint64_t delta) {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    static size_t bucketIndex(uint64_t value) {
+        if (value < kSubBuckets) return static_cast<size_t>(value);
+        int bit = 63 - __builtin_clzll(value);
+        if (bit > kMaxBit) return kBuckets - 1;
+        int shift = bit - kSubBits;
+        return static_cast<size_t>((shift + 1) * kSubBuckets + ((value >> shift) - kSubBuckets));
+    }
+
+    static double bucketMidpoint(size_t index) {
+        if (index < kSubBuckets) return static_cast<double>(index);
+        int shift = static_cast<int>(index / kSubBuckets) - 1;
+        uint64_t low = (index % kSubBuckets + kSubBuckets) << shift;
+        return static_cast<double>(low) + ((uint64_t(1) << shift) - 1) / 2.0;
+    }
+};
@@ -0,0 +1,362 @@
+#include "capture.h"
+#include "cgroup_monitor.h"
+#include "procfs.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+const char kMagic[] = "MONCAP1\n";
+constexpr size_t kMagicLength = sizeof(kMagic) - 1;
+// Free space to leave for each read()
+constexpr size_t kReadChunk = 4096;
+// Flush the pending records once they reach this size
+constexpr size_t kFlushSize = 1024 * 1024;
+
+// Host-wide files the collectors read, besides cpufreq, processes and cgroups
+const char* const kSystemFiles[] = {
+    "/proc/stat", "/proc/cpuinfo", "/proc/meminfo", "/proc/vmstat", "/proc/pressure/memory",
+    "/proc/diskstats", "/proc/self/mountinfo", "/proc/net/dev", "/proc/net/sockstat", "/proc/net/sockstat6",
+};
+
+const char* const kProcessFiles[] = {"stat", "status", "io", "cmdline"};
+
+void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+bool getVarint(const std::string& data, size_t& position, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && position < data.size(); shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(data[position++]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool isNumber(const char* name) {
+    if (*name == '\0') return false;
+    for (; *name; ++name) {
+        if (*name < '0' || *name > '9') return false;
+    }
+    return true;
+}
+
+// Reads a whole file; procfs reports a size of 0, so read until EOF
+bool readWhole(const char* path, std::string& out) {
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    size_t length = 0;
+    for (;;) {
+        if (out.size() < length + kReadChunk) out.resize(std::max(out.size() * 2, length + kReadChunk));
+        ssize_t n = ::read(fd, &out[length], out.size() - length);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ::close(fd);
+            return false;
+        }
+        if (n == 0) break;
+        length += static_cast<size_t>(n);
+    }
+    ::close(fd);
+    out.resize(length);
+    return true;
+}
+
+bool writeAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t n = ::write(fd, data, length);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// mkdir -p of everything before the last '/' of `path`
+void makeParents(const std::string& path) {
+    for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+        ::mkdir(path.substr(0, slash).c_str(), 0755);
+    }
+}
+
+int removeEntry(const char* path, const struct stat*, int, struct FTW*) {
+    ::remove(path);
+    return 0;
+}
+}
+
+CaptureRecorder::CaptureRecorder() : fd(-1) {}
+
+CaptureRecorder::~CaptureRecorder() {
+    close();
+}
+
+bool CaptureRecorder::open(const std::string& path) {
+    close();
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    ids.clear();
+    entries.clear();
+    totals = CaptureStats();
+    cgroupRoot = CgroupMonitor::findCgroup2Root();
+    out.assign(kMagic, kMagicLength);
+    return flush();
+}
+
+bool CaptureRecorder::close() {
+    if (fd < 0) return true;
+    bool flushed = flush();
+    ::close(fd);
+    fd = -1;
+    return flushed;
+}
+
+bool CaptureRecorder::flush() {
+    if (out.empty()) return true;
+    bool written = writeAll(fd, out.data(), out.size());
+    totals.bytes += out.size();
+    out.clear();
+    return written;
+}
+
+// Reads one file and appends the difference to its previous content
+void CaptureRecorder::recordFile(const std::string& path) {
+    // Gone, or not readable by us (io of another user's process)
+    if (!readWhole(path.c_str(), content)) return;
+    ++totals.files;
+    totals.rawBytes += content.size();
+
+    auto found = ids.find(path);
+    uint32_t id;
+    if (found == ids.end()) {
+        id = static_cast<uint32_t>(entries.size());
+        ids.emplace(path, id);
+        entries.emplace_back();
+        out += 'P';
+        putVarint(out, id);
+        putVarint(out, path.size());
+        out += path;
+    } else {
+        id = found->second;
+    }
+
+    Entry& entry = entries[id];
+    entry.seenTick = totals.ticks;
+    if (entry.present && entry.content == content) return;
+
+    size_t prefix = 0;
+    size_t suffix = 0;
+    if (entry.present) {
+        const std::string& previous = entry.content;
+        size_t limit = std::min(previous.size(), content.size());
+        while (prefix < limit && previous[prefix] == content[prefix]) ++prefix;
+        while (suffix < limit - prefix &&
+               previous[previous.size() - 1 - suffix] == content[content.size() - 1 - suffix]) {
+            ++suffix;
+        }
+    }
+    out += 'F';
+    putVarint(out, id);
+    putVarint(out, prefix);
+    putVarint(out, suffix);
+    putVarint(out, content.size() - prefix - suffix);
+    out.append(content, prefix, content.size() - prefix - suffix);
+
+    entry.content.assign(content);
+    entry.present = true;
+}
+
+// The group's files, then every child group
+void CaptureRecorder::recordCgroup(const std::string& directory) {
+    for (size_t i = 0; const char* name = CgroupMonitor::fileName(i); ++i) {
+        recordFile(directory + "/" + name);
+    }
+    DIR* dir = ::opendir(directory.c_str());
+    if (!dir) return;
+    while (struct dirent* entry = ::readdir(dir)) {
+        if (entry->d_type != DT_DIR || entry->d_name[0] == '.') continue;
+        recordCgroup(directory + "/" + entry->d_name);
+    }
+    ::closedir(dir);
+}
+
+bool CaptureRecorder::recordTick() {
+    if (fd < 0) return false;
+
+    auto now = std::chrono::steady_clock::now();
+    if (totals.ticks == 0) firstTick = now;
+    ++totals.ticks;
+    totals.files = 0;
+    out += 'T';
+    auto offset = std::chrono::duration_cast<std::chrono::nanoseconds>(now - firstTick);
+    putVarint(out, static_cast<uint64_t>(offset.count()));
+
+    for (const char* path : kSystemFiles) {
+        pathBuffer.assign(path);
+        recordFile(pathBuffer);
+    }
+
+    // List each directory first, then read its files
+    std::vector<std::string> names;
+    int cpuDir = ::open("/sys/devices/system/cpu", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (cpuDir >= 0) {
+        procfs::forEachEntry(cpuDir, directoryBuffer, [&](const char* name, unsigned char) {
+            if (std::strncmp(name, "cpu", 3) == 0 && isNumber(name + 3)) names.emplace_back(name);
+        });
+        ::close(cpuDir);
+    }
+    for (const std::string& cpu : names) {
+        recordFile("/sys/devices/system/cpu/" + cpu + "/cpufreq/scaling_cur_freq");
+    }
+
+    names.clear();
+    int procDir = ::open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (procDir >= 0) {
+        procfs::forEachEntry(procDir, directoryBuffer, [&](const char* name, unsigned char) {
+            if (isNumber(name)) names.emplace_back(name);
+        });
+        ::close(procDir);
+    }
+    for (const std::string& pid : names) {
+        for (const char* file : kProcessFiles) {
+            pathBuffer.assign("/proc/").append(pid).append(1, '/').append(file);
+            recordFile(pathBuffer);
+        }
+        if (out.size() >= kFlushSize && !flush()) return false;
+    }
+
+    if (!cgroupRoot.empty()) recordCgroup(cgroupRoot);
+
+    // Files that were not there this tick
+    for (uint32_t id = 0; id < entries.size(); ++id) {
+        Entry& entry = entries[id];
+        if (!entry.present || entry.seenTick == totals.ticks) continue;
+        out += 'D';
+        putVarint(out, id);
+        entry.present = false;
+        entry.content.clear();
+    }
+    return flush();
+}
+
+CaptureReplayer::CaptureReplayer() : position(0), ownsDirectory(false), tickNanos(0), tickCount(0) {}
+
+CaptureReplayer::~CaptureReplayer() {
+    if (ownsDirectory) ::nftw(directory.c_str(), removeEntry, 64, FTW_DEPTH | FTW_PHYS);
+}
+
+bool CaptureReplayer::open(const std::string& path, const std::string& target) {
+    if (!readWhole(path.c_str(), data)) return false;
+    if (data.size() < kMagicLength || data.compare(0, kMagicLength, kMagic) != 0) return false;
+    position = kMagicLength;
+
+    if (target.empty()) {
+        char pattern[] = "/tmp/monitor-replay-XXXXXX";
+        if (!::mkdtemp(pattern)) return false;
+        directory = pattern;
+        ownsDirectory = true;
+    } else {
+        directory = target;
+        while (directory.size() > 1 && directory.back() == '/') directory.pop_back();
+        makeParents(directory + "/");
+        struct stat st;
+        if (::stat(directory.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) return false;
+    }
+    return true;
+}
+
+bool CaptureReplayer::nextTick() {
+    if (position >= data.size() || data[position] != 'T') return false;
+    ++position;
+    if (!getVarint(data, position, tickNanos)) return false;
+
+    while (position < data.size() && data[position] != 'T') {
+        char type = data[position++];
+        uint64_t id = 0;
+        if (!getVarint(data, position, id)) return false;
+
+        if (type == 'P') {
+            uint64_t length = 0;
+            if (!getVarint(data, position, length) || length > data.size() - position) return false;
+            if (id >= paths.size()) {
+                paths.resize(id + 1);
+                contents.resize(id + 1);
+            }
+            paths[id].assign(data, position, length);
+            position += length;
+        } else if (type == 'F') {
+            uint64_t prefix = 0;
+            uint64_t suffix = 0;
+            uint64_t length = 0;
+            if (!getVarint(data, position, prefix) || !getVarint(data, position, suffix) ||
+                !getVarint(data, position, length)) {
+                return false;
+            }
+            if (id >= paths.size() || length > data.size() - position) return false;
+            const std::string& previous = contents[id];
+            if (prefix > previous.size() || suffix > previous.size() - prefix) return false;
+
+            scratch.assign(previous, 0, prefix);
+            scratch.append(data, position, length);
+            scratch.append(previous, previous.size() - suffix, suffix);
+            contents[id].swap(scratch);
+            position += length;
+            if (!writeFile(static_cast<uint32_t>(id))) return false;
+        } else if (type == 'D') {
+            if (id >= paths.size()) return false;
+            removeFile(static_cast<uint32_t>(id));
+        } else {
+            return false;
+        }
+    }
+    ++tickCount;
+    return true;
+}
+
+// Truncates and rewrites in place so the inode, and any descriptor a
+// collector holds on it, stays the same
+bool CaptureReplayer::writeFile(uint32_t id) {
+    std::string path = directory + paths[id];
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0 && errno == ENOENT) {
+        makeParents(path);
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+    if (fd < 0) return false;
+    bool written = writeAll(fd, contents[id].data(), contents[id].size());
+    ::close(fd);
+    return written;
+}
+
+// Unlinks the file and every directory it leaves empty (an exited process,
+// a removed cgroup)
+void CaptureReplayer::removeFile(uint32_t id) {
+    std::string path = directory + paths[id];
+    ::unlink(path.c_str());
+    contents[id].clear();
+    for (size_t slash = path.rfind('/'); slash != std::string::npos && slash > directory.size();
+         slash = path.rfind('/')) {
+        path.resize(slash);
+        if (::rmdir(path.c_str()) != 0) break;
+    }
+}
+
+std::chrono::steady_clock::time_point CaptureReplayer::tickTime() const {
+    return std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::hours(1) + std::chrono::nanoseconds(tickNanos)));
+}
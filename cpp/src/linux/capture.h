@@ -0,0 +1,112 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Recording of the /proc, /sys and cgroupfs files the collectors read, and
+// replay of such a capture as a directory tree laid out like /, which
+// SystemMonitor::setRoot() then reads instead of the host.
+//
+// A capture is a sequence of records; every integer is a LEB128 varint:
+//
+//   "MONCAP1\n"                        header
+//   'P' id length path                 names file `id` (absolute path)
+//   'T' nanos                          starts a tick, nanos after the first
+//   'F' id prefix suffix length bytes  new content of `id`: the first
+//                                      `prefix` and last `suffix` bytes of
+//                                      its previous content around `bytes`
+//   'D' id                             file `id` no longer exists
+//
+// A tick only carries the files that changed, and mostly only the changed
+// middle of each, so a busy host compresses to a few percent of the bytes
+// read. Per process, the recorder keeps stat, status, io and cmdline;
+// smaps_rollup and fd directories are not captured.
+
+struct CaptureStats {
+    uint64_t ticks = 0;
+    uint64_t files = 0;    // Files read in the last tick
+    uint64_t rawBytes = 0; // Bytes read over all ticks
+    uint64_t bytes = 0;    // Bytes written to the capture
+};
+
+class CaptureRecorder {
+public:
+    CaptureRecorder();
+    ~CaptureRecorder();
+
+    CaptureRecorder(const CaptureRecorder&) = delete;
+    CaptureRecorder& operator=(const CaptureRecorder&) = delete;
+
+    // Creates (or truncates) the capture file
+    bool open(const std::string& path);
+    // Reads every file once and appends the changes as one tick. Returns
+    // false if the capture could not be written.
+    bool recordTick();
+    bool close();
+
+    const CaptureStats& stats() const { return totals; }
+
+private:
+    struct Entry {
+        std::string content;
+        uint64_t seenTick = 0; // Last tick the file existed in
+        bool present = false;
+    };
+
+    int fd;
+    std::string cgroupRoot;
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<Entry> entries;
+    std::chrono::steady_clock::time_point firstTick;
+    std::string out;
+    std::string content;
+    std::string pathBuffer;
+    std::vector<char> directoryBuffer;
+    CaptureStats totals;
+
+    void recordFile(const std::string& path);
+    void recordCgroup(const std::string& directory);
+    bool flush();
+};
+
+class CaptureReplayer {
+public:
+    CaptureReplayer();
+    // Removes the tree if open() created it
+    ~CaptureReplayer();
+
+    CaptureReplayer(const CaptureReplayer&) = delete;
+    CaptureReplayer& operator=(const CaptureReplayer&) = delete;
+
+    // Loads a capture and prepares to write it into `directory`, or into a
+    // new directory under /tmp when empty. No tick is applied yet.
+    bool open(const std::string& path, const std::string& directory = std::string());
+    // Rewrites the files of the next tick in place (open descriptors see
+    // the new content). False at the end of the capture or on a corrupt one.
+    bool nextTick();
+
+    // The tree to pass to SystemMonitor::setRoot()
+    const std::string& root() const { return directory; }
+    // When the current tick was recorded, on a steady_clock timeline that
+    // starts an hour in (never the zero collectors treat as "no sample")
+    std::chrono::steady_clock::time_point tickTime() const;
+    uint64_t ticks() const { return tickCount; }
+
+private:
+    std::string data;
+    size_t position;
+    std::string directory;
+    bool ownsDirectory;
+    std::vector<std::string> paths;
+    std::vector<std::string> contents;
+    std::string scratch;
+    uint64_t tickNanos;
+    uint64_t tickCount;
+
+    bool writeFile(uint32_t id);
+    void removeFile(uint32_t id);
+};
@@ -0,0 +1,487 @@
+#include "cgroup_monitor.h"
+#include "procfs.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr size_t kInitialBufferSize = 16 * 1024;
+constexpr size_t kEventBufferSize = 64 * 1024;
+constexpr double kBytesPerMB = 1024.0 * 1024.0;
+constexpr size_t kNoGroup = static_cast<size_t>(-1);
+// Descriptors left to the rest of the process (sockets, /proc files, clients)
+constexpr size_t kReservedDescriptors = 1024;
+
+const char* const kFileNames[] = {
+    "cpu.stat", "memory.current", "memory.stat", "io.stat", "cpu.pressure", "memory.pressure", "io.pressure",
+};
+
+uint64_t delta(uint64_t current, uint64_t previous) {
+    return current >= previous ? current - previous : 0;
+}
+
+// Value of the line "key N" in a flat keyed file (cpu.stat, memory.stat)
+uint64_t keyedValue(const char* p, const char* end, const char* key) {
+    size_t keyLength = std::strlen(key);
+    for (; p < end; p = procfs::nextLine(p, end)) {
+        if (procfs::startsWith(p, end, key) && p + keyLength < end && p[keyLength] == ' ') {
+            uint64_t value = 0;
+            procfs::parseU64(p + keyLength, end, value);
+            return value;
+        }
+    }
+    return 0;
+}
+
+// "total=N" on the "some" or "full" line of a pressure file
+uint64_t pressureTotal(const char* p, const char* end, const char* line) {
+    for (; p < end; p = procfs::nextLine(p, end)) {
+        if (!procfs::startsWith(p, end, line)) continue;
+        const char* lineEnd = p;
+        while (lineEnd < end && *lineEnd != '\n') ++lineEnd;
+        for (const char* q = p; q + 6 <= lineEnd; ++q) {
+            if (std::memcmp(q, "total=", 6) == 0) {
+                uint64_t value = 0;
+                procfs::parseU64(q + 6, lineEnd, value);
+                return value;
+            }
+        }
+        return 0;
+    }
+    return 0;
+}
+
+bool isDirectory(const std::string& path, const struct dirent* entry) {
+    if (entry->d_type == DT_DIR) return true;
+    if (entry->d_type != DT_UNKNOWN) return false;
+    struct stat st;
+    return ::stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+}
+
+CgroupMonitor::CgroupMonitor(CgroupOptions options) : config(std::move(options)) {}
+
+CgroupMonitor::~CgroupMonitor() {
+    for (Group& group : groups) {
+        if (group.alive) closeFiles(group);
+    }
+    if (inotifyFd >= 0) ::close(inotifyFd);
+}
+
+const char* CgroupMonitor::fileName(size_t index) {
+    return index < kFileCount ? kFileNames[index] : nullptr;
+}
+
+std::string CgroupMonitor::findCgroup2Root(const std::string& prefix) {
+    ProcFile mountinfo;
+    if (!mountinfo.open((prefix + "/proc/self/mountinfo").c_str()) || !mountinfo.read()) return std::string();
+
+    // id parent major:minor root mountpoint options [optional...] - fstype source superoptions
+    const char* p = mountinfo.begin();
+    const char* end = mountinfo.end();
+    for (; p < end; p = procfs::nextLine(p, end)) {
+        const char* q = p;
+        for (int field = 0; field < 4; ++field) q = procfs::skipToken(procfs::skipSpaces(q, end), end);
+        const char* path = procfs::skipSpaces(q, end);
+        const char* pathEnd = procfs::skipToken(path, end);
+
+        const char* separator = pathEnd;
+        while (separator < end && *separator != '\n' && !(separator[0] == '-' && separator[-1] == ' ')) {
+            ++separator;
+        }
+        if (separator >= end || *separator != '-') continue;
+        const char* type = procfs::skipSpaces(separator + 1, end);
+        const char* typeEnd = procfs::skipToken(type, end);
+        if (typeEnd - type == 7 && std::memcmp(type, "cgroup2", 7) == 0) {
+            return prefix + std::string(path, pathEnd);
+        }
+    }
+    return std::string();
+}
+
+bool CgroupMonitor::initialize() {
+    if (initialized) return true;
+    if (config.root.empty()) config.root = findCgroup2Root(config.prefix);
+    if (config.root.empty()) return false;
+    while (config.root.size() > 1 && config.root.back() == '/') config.root.pop_back();
+
+    struct stat st;
+    if (::stat(config.root.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) return false;
+
+    // Several descriptors per group; thousands of groups need more than the
+    // usual soft limit
+    struct rlimit limit;
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        if (limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            ::setrlimit(RLIMIT_NOFILE, &limit);
+            ::getrlimit(RLIMIT_NOFILE, &limit);
+        }
+        if (limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur > 2 * kReservedDescriptors) {
+            descriptorBudget = static_cast<size_t>(limit.rlim_cur) - kReservedDescriptors;
+        } else if (limit.rlim_cur != RLIM_INFINITY) {
+            descriptorBudget = static_cast<size_t>(limit.rlim_cur) / 2;
+        } else {
+            descriptorBudget = static_cast<size_t>(-1);
+        }
+    }
+
+    inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) return false;
+
+    buffer.resize(kInitialBufferSize);
+    eventBuffer.resize(kEventBufferSize);
+    addSubtree(kNoGroup, std::string());
+    if (liveGroups == 0) return false;
+
+    lastRescanTime = procfs::now();
+    initialized = true;
+    return true;
+}
+
+size_t CgroupMonitor::addGroup(size_t parent, const std::string& relativePath) {
+    if (liveGroups >= config.maxGroups) return kNoGroup;
+
+    std::string path = config.root + relativePath;
+    int watch = ::inotify_add_watch(inotifyFd, path.c_str(), IN_CREATE | IN_DELETE | IN_ONLYDIR);
+    if (watch < 0) return kNoGroup; // Removed already, or out of watches
+
+    size_t index;
+    if (!freeSlots.empty()) {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        index = groups.size();
+        groups.emplace_back();
+    }
+
+    Group& group = groups[index];
+    group = Group();
+    group.alive = true;
+    group.watch = watch;
+    group.parent = parent;
+    group.relativePath = relativePath;
+    group.info.path = relativePath.empty() ? "/" : relativePath;
+    for (int& fd : group.fds) fd = kAbsent;
+    openFiles(group, true);
+    groupByWatch[watch] = index;
+    ++liveGroups;
+
+    if (parent != kNoGroup) {
+        // Children stay sorted by path so the output order is stable
+        std::vector<size_t>& siblings = groups[parent].children;
+        auto position = std::lower_bound(siblings.begin(), siblings.end(), index, [&](size_t a, size_t b) {
+            return groups[a].relativePath < groups[b].relativePath;
+        });
+        siblings.insert(position, index);
+    }
+    return index;
+}
+
+// Adds a group and everything below it. The watch is registered before the
+// directory is listed, so a child created meanwhile is either listed here
+// or reported by inotify; duplicates are ignored.
+void CgroupMonitor::addSubtree(size_t parent, const std::string& relativePath) {
+    if (parent != kNoGroup) {
+        for (size_t child : groups[parent].children) {
+            if (groups[child].relativePath == relativePath) return;
+        }
+    }
+    size_t index = addGroup(parent, relativePath);
+    if (index == kNoGroup) return;
+
+    std::string path = config.root + relativePath;
+    DIR* dir = ::opendir(path.c_str());
+    if (!dir) return;
+    std::vector<std::string> names;
+    while (struct dirent* entry = ::readdir(dir)) {
+        if (entry->d_name[0] == '.') continue;
+        if (isDirectory(path + "/" + entry->d_name, entry)) names.emplace_back(entry->d_name);
+    }
+    ::closedir(dir);
+
+    for (const std::string& name : names) addSubtree(index, relativePath + "/" + name);
+}
+
+void CgroupMonitor::removeGroup(size_t index) {
+    Group& group = groups[index];
+    if (!group.alive) return;
+
+    std::vector<size_t> children;
+    children.swap(group.children);
+    for (size_t child : children) removeGroup(child);
+
+    // The kernel drops the watch of a removed directory by itself
+    ::inotify_rm_watch(inotifyFd, group.watch);
+    auto it = groupByWatch.find(group.watch);
+    if (it != groupByWatch.end() && it->second == index) groupByWatch.erase(it);
+    closeFiles(group);
+
+    if (group.parent != kNoGroup) {
+        std::vector<size_t>& siblings = groups[group.parent].children;
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), index), siblings.end());
+    }
+    group.alive = false;
+    group.relativePath.clear();
+    group.info = CgroupInfo();
+    freeSlots.push_back(index);
+    --liveGroups;
+}
+
+void CgroupMonitor::openFiles(Group& group, bool retryAbsent) {
+    for (int file = 0; file < kFileCount; ++file) {
+        int& fd = group.fds[file];
+        if (fd >= 0 || (fd == kAbsent && !retryAbsent)) continue;
+        if (fd == kReopen && openDescriptors >= descriptorBudget) continue;
+
+        std::string path = config.root + group.relativePath + "/" + kFileNames[file];
+        int opened = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (opened >= 0 && openDescriptors >= descriptorBudget) {
+            ::close(opened);
+            fd = kReopen;
+        } else if (opened >= 0) {
+            fd = opened;
+            ++openDescriptors;
+        } else if (errno == EMFILE || errno == ENFILE) {
+            fd = kReopen;
+        } else {
+            fd = kAbsent; // Controller not enabled for this group, or the root
+        }
+    }
+}
+
+void CgroupMonitor::closeFiles(Group& group) {
+    for (int& fd : group.fds) {
+        if (fd >= 0) {
+            ::close(fd);
+            --openDescriptors;
+        }
+        fd = kAbsent;
+    }
+}
+
+const char* CgroupMonitor::readFile(Group& group, File file, size_t& length) {
+    int fd = group.fds[file];
+    bool transient = false;
+    if (fd == kAbsent) return nullptr;
+    if (fd == kReopen) {
+        pathBuffer.assign(config.root).append(group.relativePath).append(1, '/').append(kFileNames[file]);
+        fd = ::open(pathBuffer.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return nullptr;
+        transient = true;
+    }
+
+    // Like ProcFile: one pread from offset 0 regenerates the whole file;
+    // grow the shared buffer if it came back full
+    bool ok = false;
+    for (;;) {
+        ssize_t n = ::pread(fd, buffer.data(), buffer.size(), 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (static_cast<size_t>(n) < buffer.size()) {
+            length = static_cast<size_t>(n);
+            ok = true;
+            break;
+        }
+        buffer.resize(buffer.size() * 2);
+    }
+    if (transient) ::close(fd);
+    return ok ? buffer.data() : nullptr;
+}
+
+void CgroupMonitor::sample(Group& group, double seconds) {
+    Counters current = group.counters;
+    CgroupInfo& info = group.info;
+    size_t length = 0;
+
+    if (const char* begin = readFile(group, CpuStat, length)) {
+        current.cpuUsec = keyedValue(begin, begin + length, "usage_usec");
+        current.throttledUsec = keyedValue(begin, begin + length, "throttled_usec");
+    }
+    if (const char* begin = readFile(group, MemoryCurrent, length)) {
+        uint64_t bytes = 0;
+        procfs::parseU64(begin, begin + length, bytes);
+        info.memoryCurrent = bytes / kBytesPerMB;
+    }
+    if (const char* begin = readFile(group, MemoryStat, length)) {
+        info.memoryAnon = keyedValue(begin, begin + length, "anon") / kBytesPerMB;
+        info.memoryFile = keyedValue(begin, begin + length, "file") / kBytesPerMB;
+    }
+    if (const char* begin = readFile(group, IoStat, length)) {
+        // "major:minor rbytes=N wbytes=N rios=N wios=N dbytes=N dios=N" per device
+        current.readBytes = current.writeBytes = current.readOps = current.writeOps = 0;
+        const char* end = begin + length;
+        for (const char* p = begin; p < end; p = procfs::nextLine(p, end)) {
+            const char* token = procfs::skipToken(p, end); // major:minor
+            for (;;) {
+                token = procfs::skipSpaces(token, end);
+                const char* tokenEnd = procfs::skipToken(token, end);
+                if (tokenEnd == token) break;
+                uint64_t value = 0;
+                if (procfs::startsWith(token, tokenEnd, "rbytes=")) {
+                    procfs::parseU64(token + 7, tokenEnd, value);
+                    current.readBytes += value;
+                } else if (procfs::startsWith(token, tokenEnd, "wbytes=")) {
+                    procfs::parseU64(token + 7, tokenEnd, value);
+                    current.writeBytes += value;
+                } else if (procfs::startsWith(token, tokenEnd, "rios=")) {
+                    procfs::parseU64(token + 5, tokenEnd, value);
+                    current.readOps += value;
+                } else if (procfs::startsWith(token, tokenEnd, "wios=")) {
+                    procfs::parseU64(token + 5, tokenEnd, value);
+                    current.writeOps += value;
+                }
+                token = tokenEnd;
+            }
+        }
+    }
+    if (const char* begin = readFile(group, CpuPressure, length)) {
+        current.cpuSomeUsec = pressureTotal(begin, begin + length, "some");
+    }
+    if (const char* begin = readFile(group, MemoryPressure, length)) {
+        current.memorySomeUsec = pressureTotal(begin, begin + length, "some");
+        current.memoryFullUsec = pressureTotal(begin, begin + length, "full");
+    }
+    if (const char* begin = readFile(group, IoPressure, length)) {
+        current.ioSomeUsec = pressureTotal(begin, begin + length, "some");
+        current.ioFullUsec = pressureTotal(begin, begin + length, "full");
+    }
+
+    if (group.sampled && seconds > 0.0) {
+        const Counters& last = group.counters;
+        double intervalUsec = seconds * 1e6;
+        info.cpuUsage = delta(current.cpuUsec, last.cpuUsec) / intervalUsec * 100.0;
+        info.cpuThrottled = delta(current.throttledUsec, last.throttledUsec) / intervalUsec * 100.0;
+        info.ioReadSpeed = delta(current.readBytes, last.readBytes) / kBytesPerMB / seconds;
+        info.ioWriteSpeed = delta(current.writeBytes, last.writeBytes) / kBytesPerMB / seconds;
+        info.ioReadIops = delta(current.readOps, last.readOps) / seconds;
+        info.ioWriteIops = delta(current.writeOps, last.writeOps) / seconds;
+        info.cpuPressure = delta(current.cpuSomeUsec, last.cpuSomeUsec) / intervalUsec * 100.0;
+        info.memoryPressure = delta(current.memorySomeUsec, last.memorySomeUsec) / intervalUsec * 100.0;
+        info.memoryPressureFull = delta(current.memoryFullUsec, last.memoryFullUsec) / intervalUsec * 100.0;
+        info.ioPressure = delta(current.ioSomeUsec, last.ioSomeUsec) / intervalUsec * 100.0;
+        info.ioPressureFull = delta(current.ioFullUsec, last.ioFullUsec) / intervalUsec * 100.0;
+    }
+    group.counters = current;
+    group.sampled = true;
+}
+
+void CgroupMonitor::drainEvents() {
+    bool overflowed = false;
+    for (;;) {
+        ssize_t n = ::read(inotifyFd, eventBuffer.data(), eventBuffer.size());
+        if (n <= 0) break; // EAGAIN: nothing left
+
+        for (const char* p = eventBuffer.data(); p < eventBuffer.data() + n;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(p);
+            p += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflowed = true;
+                continue;
+            }
+            if (!(event->mask & IN_ISDIR) || event->len == 0) continue;
+            auto it = groupByWatch.find(event->wd);
+            if (it == groupByWatch.end() || !groups[it->second].alive) continue;
+
+            size_t parent = it->second;
+            std::string child = groups[parent].relativePath + "/" + event->name;
+            if (event->mask & IN_CREATE) {
+                addSubtree(parent, child);
+            } else if (event->mask & IN_DELETE) {
+                for (size_t index : groups[parent].children) {
+                    if (groups[index].relativePath == child) {
+                        removeGroup(index);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    if (overflowed) rescan();
+}
+
+// Full walk: adds and removes whatever inotify missed and retries files that
+// were absent (controllers can be enabled after a group is created)
+void CgroupMonitor::rescan() {
+    std::vector<size_t> pending = {0};
+    while (!pending.empty()) {
+        size_t index = pending.back();
+        pending.pop_back();
+        if (!groups[index].alive) continue;
+
+        std::string path = config.root + groups[index].relativePath;
+        DIR* dir = ::opendir(path.c_str());
+        if (!dir) {
+            if (index != 0) removeGroup(index);
+            continue;
+        }
+        std::vector<std::string> present;
+        while (struct dirent* entry = ::readdir(dir)) {
+            if (entry->d_name[0] == '.') continue;
+            if (isDirectory(path + "/" + entry->d_name, entry)) {
+                present.push_back(groups[index].relativePath + "/" + entry->d_name);
+            }
+        }
+        ::closedir(dir);
+        std::sort(present.begin(), present.end());
+
+        std::vector<size_t> children = groups[index].children;
+        for (size_t child : children) {
+            if (!std::binary_search(present.begin(), present.end(), groups[child].relativePath)) removeGroup(child);
+        }
+        for (const std::string& childPath : present) addSubtree(index, childPath);
+
+        openFiles(groups[index], true);
+        for (size_t child : groups[index].children) pending.push_back(child);
+    }
+}
+
+void CgroupMonitor::update() {
+    if (!initialized) return;
+
+    auto now = procfs::now();
+    drainEvents();
+    if (now - lastRescanTime >= config.rescanInterval) {
+        rescan();
+        lastRescanTime = now;
+    }
+
+    double seconds = std::chrono::duration<double>(now - lastSampleTime).count();
+    bool haveInterval = lastSampleTime.time_since_epoch().count() != 0;
+    for (Group& group : groups) {
+        if (group.alive) sample(group, haveInterval ? seconds : 0.0);
+    }
+    lastSampleTime = now;
+}
+
+std::vector<CgroupInfo> CgroupMonitor::getInfo() const {
+    std::vector<CgroupInfo> result;
+    if (!initialized) return result;
+    result.reserve(liveGroups);
+
+    // Pre-order walk; each entry records its parent's output index
+    std::vector<std::pair<size_t, int>> pending = {{0, -1}};
+    while (!pending.empty()) {
+        size_t index = pending.back().first;
+        int parent = pending.back().second;
+        pending.pop_back();
+
+        const Group& group = groups[index];
+        int position = static_cast<int>(result.size());
+        result.push_back(group.info);
+        result.back().parent = parent;
+        for (auto child = group.children.rbegin(); child != group.children.rend(); ++child) {
+            pending.emplace_back(*child, position);
+        }
+    }
+    return result;
+}
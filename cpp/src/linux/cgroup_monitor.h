@@ -0,0 +1,106 @@
+#pragma once
+
+#include "../../include/system_monitor.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct CgroupOptions {
+    std::string root;            // cgroup2 mount point, or a fixture directory
+    std::string prefix;          // With an empty root: tree to find the mount in (see capture.h)
+    size_t maxGroups = 8192;     // Groups beyond this are not tracked
+    std::chrono::seconds rescanInterval{60}; // Full walk to repair missed events
+};
+
+// cgroup v2 collector. The hierarchy is walked once; afterwards inotify
+// reports created and removed groups, so a tick only re-reads the files of
+// known groups. Every group keeps its stat files open and re-reads them with
+// pread into one shared buffer. Held descriptors are capped below
+// RLIMIT_NOFILE so the rest of the process keeps some; past the cap, groups
+// open their files per read instead.
+//
+// Works on any directory laid out like cgroupfs, which is how it is tested
+// against fixtures.
+class CgroupMonitor {
+public:
+    explicit CgroupMonitor(CgroupOptions options);
+    ~CgroupMonitor();
+
+    CgroupMonitor(const CgroupMonitor&) = delete;
+    CgroupMonitor& operator=(const CgroupMonitor&) = delete;
+
+    // Finds the cgroup2 mount in <prefix>/proc/self/mountinfo and returns
+    // it under `prefix`; empty if none
+    static std::string findCgroup2Root(const std::string& prefix = std::string());
+    // Files read from every group; nullptr past the last one
+    static const char* fileName(size_t index);
+
+    bool initialize();
+    void update();
+    // Pre-order, parents before children
+    std::vector<CgroupInfo> getInfo() const;
+
+    size_t groupCount() const { return liveGroups; }
+
+private:
+    enum File { CpuStat, MemoryCurrent, MemoryStat, IoStat, CpuPressure, MemoryPressure, IoPressure, kFileCount };
+
+    static constexpr int kAbsent = -2;  // File does not exist for this group
+    static constexpr int kReopen = -1;  // Over the descriptor budget: open per read
+
+    // Cumulative counters from the previous read
+    struct Counters {
+        uint64_t cpuUsec = 0;
+        uint64_t throttledUsec = 0;
+        uint64_t readBytes = 0;
+        uint64_t writeBytes = 0;
+        uint64_t readOps = 0;
+        uint64_t writeOps = 0;
+        uint64_t cpuSomeUsec = 0;
+        uint64_t memorySomeUsec = 0;
+        uint64_t memoryFullUsec = 0;
+        uint64_t ioSomeUsec = 0;
+        uint64_t ioFullUsec = 0;
+    };
+
+    struct Group {
+        bool alive = false;
+        bool sampled = false; // Counters hold a baseline
+        int watch = -1;
+        size_t parent = 0;
+        std::vector<size_t> children;
+        std::string relativePath; // "" for the root
+        int fds[kFileCount];
+        Counters counters;
+        CgroupInfo info;
+    };
+
+    CgroupOptions config;
+    int inotifyFd = -1;
+    std::vector<Group> groups;          // Slot 0 is the root
+    std::vector<size_t> freeSlots;
+    std::unordered_map<int, size_t> groupByWatch;
+    size_t liveGroups = 0;
+    size_t openDescriptors = 0;
+    size_t descriptorBudget = 0;
+    std::vector<char> buffer;           // Shared by every pread
+    std::vector<char> eventBuffer;
+    std::string pathBuffer;             // Files opened per read
+    std::chrono::steady_clock::time_point lastSampleTime;
+    std::chrono::steady_clock::time_point lastRescanTime;
+    bool initialized = false;
+
+    size_t addGroup(size_t parent, const std::string& relativePath);
+    void addSubtree(size_t parent, const std::string& relativePath);
+    void removeGroup(size_t index);
+    void openFiles(Group& group, bool retryAbsent);
+    void closeFiles(Group& group);
+    void drainEvents();
+    void rescan();
+    // Contents in the shared buffer, or null; valid until the next read
+    const char* readFile(Group& group, File file, size_t& length);
+    void sample(Group& group, double seconds);
+};
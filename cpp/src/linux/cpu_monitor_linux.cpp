@@ -0,0 +1,237 @@
+#include "../cpu_monitor.h"
+#include <algorithm>
+#include <string>
+#include <unistd.h>
+
+namespace {
+constexpr std::chrono::milliseconds kFrequencyInterval(1000);
+}
+
+CPUMonitor::CPUMonitor() : initialized(false) {}
+
+CPUMonitor::~CPUMonitor() = default;
+
+// Configured CPUs, or more if /proc/stat lists a higher "cpuN" (CPUs
+// hot-added since boot). Under a root prefix (a fixture or a replayed
+// capture) only the tree's own /proc/stat counts, never this host's CPUs.
+size_t CPUMonitor::countCores() {
+    size_t cores = 1;
+    if (root.empty()) {
+        long configured = sysconf(_SC_NPROCESSORS_CONF);
+        if (configured > 0) cores = static_cast<size_t>(configured);
+    }
+    if (!statFile.read()) return cores;
+
+    const char* end = statFile.end();
+    for (const char* p = statFile.begin(); p < end && procfs::startsWith(p, end, "cpu"); p = procfs::nextLine(p, end)) {
+        // The aggregate line has a blank after "cpu", which parseU64 would skip
+        if (p + 3 >= end || p[3] < '0' || p[3] > '9') continue;
+        uint64_t index = 0;
+        procfs::parseU64(p + 3, end, index);
+        if (index + 1 > cores) cores = static_cast<size_t>(index) + 1;
+    }
+    return cores;
+}
+
+// Parses the aggregate "cpu" line and every "cpuN" line of /proc/stat into
+// the current[] columns. Cores that are offline have no line and keep their
+// previous counters.
+bool CPUMonitor::sample() {
+    if (!statFile.read()) return false;
+
+    const char* p = statFile.begin();
+    const char* end = statFile.end();
+    bool sawTotal = false;
+
+    while (p < end && procfs::startsWith(p, end, "cpu")) {
+        p += 3;
+
+        size_t row = rows;
+        if (p < end && *p == ' ') {
+            row = 0;
+            sawTotal = true;
+        } else {
+            uint64_t index = 0;
+            const char* q = procfs::parseU64(p, end, index);
+            if (q != p && index + 1 < rows) row = static_cast<size_t>(index) + 1;
+            p = q;
+        }
+
+        // user nice system idle iowait irq softirq steal; the guest columns
+        // that follow are skipped
+        uint64_t fields[kStates] = {};
+        for (uint64_t& field : fields) {
+            p = procfs::parseU64(p, end, field);
+        }
+
+        if (row < rows) {
+            for (int state = 0; state < kStates; ++state) current[state][row] = static_cast<double>(fields[state]);
+        }
+        p = procfs::nextLine(p, end);
+    }
+
+    return sawTotal;
+}
+
+// Deltas and percentages for every row, one state column at a time. The
+// loops are branch-free over contiguous arrays so the compiler vectorizes
+// them; counters that went backwards (iowait can) count as zero.
+void CPUMonitor::computeShares() {
+    double* total = rowTotal.data();
+    std::fill(rowTotal.begin(), rowTotal.end(), 0.0);
+
+    for (int state = 0; state < kStates; ++state) {
+        const double* now = current[state].data();
+        const double* then = last[state].data();
+        double* out = share[state].data();
+        for (size_t i = 0; i < rows; ++i) {
+            out[i] = std::max(now[i] - then[i], 0.0);
+            total[i] += out[i];
+        }
+    }
+
+    // Deltas are whole jiffies, so a row either advanced by at least one
+    // or all of its shares are zero and the scale does not matter
+    for (size_t i = 0; i < rows; ++i) total[i] = 100.0 / std::max(total[i], 1.0);
+    for (int state = 0; state < kStates; ++state) {
+        double* out = share[state].data();
+        for (size_t i = 0; i < rows; ++i) out[i] *= total[i];
+    }
+}
+
+void CPUMonitor::sampleFrequency() {
+    size_t cores = rows - 1;
+    bool anyCpufreq = false;
+    for (size_t i = 0; i < cores; ++i) {
+        ProcFile* file = frequencyFiles[i].get();
+        if (!file) continue;
+        anyCpufreq = true;
+        uint64_t khz = 0;
+        if (file->read()) procfs::parseU64(file->begin(), file->end(), khz);
+        info.coreFrequency[i] = static_cast<double>(khz) / 1000.0;
+    }
+
+    // No cpufreq driver (most VMs): "cpu MHz" of /proc/cpuinfo, which
+    // follows each "processor : N" line
+    if (!anyCpufreq && cpuinfoFile.isOpen() && cpuinfoFile.read()) {
+        const char* p = cpuinfoFile.begin();
+        const char* end = cpuinfoFile.end();
+        size_t core = cores;
+        for (; p < end; p = procfs::nextLine(p, end)) {
+            if (procfs::startsWith(p, end, "processor")) {
+                const char* q = p + 9;
+                while (q < end && (*q == ' ' || *q == '\t' || *q == ':')) ++q;
+                uint64_t index = cores;
+                procfs::parseU64(q, end, index);
+                core = static_cast<size_t>(index);
+            } else if (core < cores && procfs::startsWith(p, end, "cpu MHz")) {
+                const char* q = p + 7;
+                while (q < end && (*q == ' ' || *q == '\t' || *q == ':')) ++q;
+                uint64_t whole = 0;
+                q = procfs::parseU64(q, end, whole);
+                double mhz = static_cast<double>(whole);
+                if (q < end && *q == '.') {
+                    double scale = 0.1;
+                    for (++q; q < end && *q >= '0' && *q <= '9'; ++q, scale /= 10.0) mhz += (*q - '0') * scale;
+                }
+                info.coreFrequency[core] = mhz;
+            }
+        }
+    }
+
+    double sum = 0.0;
+    int known = 0;
+    for (double mhz : info.coreFrequency) {
+        if (mhz > 0.0) {
+            sum += mhz;
+            ++known;
+        }
+    }
+    info.frequency = known > 0 ? sum / known : 0.0;
+}
+
+bool CPUMonitor::initialize() {
+    if (!statFile.open((root + "/proc/stat").c_str())) {
+        return false;
+    }
+
+    size_t cores = countCores();
+    info.coreCount = static_cast<int>(cores);
+    info.coreUsage.assign(cores, 0.0);
+    info.coreTimes.assign(cores, CPUTimes{});
+    info.coreFrequency.assign(cores, 0.0);
+
+    rows = cores + 1;
+    for (int state = 0; state < kStates; ++state) {
+        current[state].assign(rows, 0.0);
+        last[state].assign(rows, 0.0);
+        share[state].assign(rows, 0.0);
+    }
+    rowTotal.assign(rows, 0.0);
+
+    // Initial collection
+    if (!sample()) {
+        statFile.close();
+        return false;
+    }
+    for (int state = 0; state < kStates; ++state) last[state] = current[state];
+
+    bool anyCpufreq = false;
+    frequencyFiles.resize(cores);
+    for (size_t i = 0; i < cores; ++i) {
+        std::string path = root + "/sys/devices/system/cpu/cpu" + std::to_string(i) + "/cpufreq/scaling_cur_freq";
+        auto file = std::make_unique<ProcFile>();
+        if (file->open(path.c_str())) {
+            frequencyFiles[i] = std::move(file);
+            anyCpufreq = true;
+        }
+    }
+    if (!anyCpufreq) cpuinfoFile.open((root + "/proc/cpuinfo").c_str());
+    sampleFrequency();
+    lastFrequencyTime = procfs::now();
+
+    initialized = true;
+    return true;
+}
+
+void CPUMonitor::update() {
+    if (!initialized) return;
+    if (!sample()) return;
+
+    computeShares();
+
+    // Busy is everything but idle and iowait, so a row whose counters did
+    // not advance (offline core) reads as 0 rather than 100
+    for (size_t row = 0; row < rows; ++row) {
+        CPUTimes& times = row == 0 ? info.times : info.coreTimes[row - 1];
+        times.user = share[User][row];
+        times.nice = share[Nice][row];
+        times.system = share[System][row];
+        times.idle = share[Idle][row];
+        times.iowait = share[IoWait][row];
+        times.irq = share[Irq][row];
+        times.softirq = share[SoftIrq][row];
+        times.steal = share[Steal][row];
+        double busy = times.user + times.nice + times.system + times.irq + times.softirq + times.steal;
+        busy = busy > 100.0 ? 100.0 : busy;
+        if (row == 0) {
+            info.totalUsage = busy;
+        } else {
+            info.coreUsage[row - 1] = busy;
+        }
+    }
+
+    // Same-size copies, no allocation. Offline cores keep their counters in
+    // current[], so their delta stays at zero on the next tick.
+    for (int state = 0; state < kStates; ++state) last[state] = current[state];
+
+    auto now = procfs::now();
+    if (now - lastFrequencyTime >= kFrequencyInterval) {
+        sampleFrequency();
+        lastFrequencyTime = now;
+    }
+}
+
+CPUInfo CPUMonitor::getInfo() const {
+    return info;
+}
@@ -0,0 +1,269 @@
+#include "../disk_monitor.h"
+#include <sys/statvfs.h>
+#include <cstring>
+#include <string>
+
+namespace {
+// statvfs and the mount table change slowly; the I/O counters do not
+constexpr std::chrono::seconds kCapacityInterval(30);
+
+constexpr double kSectorBytes = 512.0; // diskstats always counts 512-byte sectors
+constexpr double kBytesPerGB = 1024.0 * 1024.0 * 1024.0;
+constexpr double kBytesPerMB = 1024.0 * 1024.0;
+
+// Loop and RAM disks only add noise to the list
+bool ignoredDevice(const char* name, const char* end) {
+    return procfs::startsWith(name, end, "loop") || procfs::startsWith(name, end, "ram") ||
+           procfs::startsWith(name, end, "zram");
+}
+
+// Difference of a cumulative counter; a counter that went backwards
+// (device reset, 32-bit wrap) contributes nothing for one sample
+uint64_t delta(uint64_t current, uint64_t previous) {
+    return current >= previous ? current - previous : 0;
+}
+
+// Undoes the octal escapes (\040 for space etc.) in /proc/self/mountinfo
+std::string unescapeMountPath(const char* p, const char* end) {
+    std::string path;
+    while (p < end) {
+        if (*p == '\\' && end - p >= 4) {
+            path += static_cast<char>(((p[1] - '0') << 6) | ((p[2] - '0') << 3) | (p[3] - '0'));
+            p += 4;
+        } else {
+            path += *p++;
+        }
+    }
+    return path;
+}
+}
+
+DiskMonitor::DiskMonitor() : initialized(false), deviceCount(0), rootfsEntry(false), capacityValid(false) {}
+
+bool DiskMonitor::initialize() {
+    if (!diskstatsFile.open((root + "/proc/diskstats").c_str())) {
+        return false;
+    }
+    // Without the mount table there is no capacity, but I/O still works
+    mountinfoFile.open((root + "/proc/self/mountinfo").c_str());
+    initialized = true;
+    return true;
+}
+
+// Parses /proc/diskstats into currentCounters. Returns false if the device
+// list differs from the one `disks` was built for.
+//
+//   major minor name reads merged sectors ms writes merged sectors ms
+//   in_flight io_ms weighted_ms [discard and flush fields]
+bool DiskMonitor::readCounters() {
+    const char* p = diskstatsFile.begin();
+    const char* end = diskstatsFile.end();
+    size_t index = 0;
+    bool sameLayout = true;
+
+    while (p < end) {
+        uint64_t major = 0;
+        uint64_t minor = 0;
+        const char* q = procfs::parseU64(p, end, major);
+        q = procfs::parseU64(q, end, minor);
+        const char* name = procfs::skipSpaces(q, end);
+        const char* nameEnd = procfs::skipToken(name, end);
+        if (nameEnd == name) break;
+
+        if (!ignoredDevice(name, nameEnd)) {
+            uint64_t fields[11] = {};
+            q = nameEnd;
+            for (uint64_t& field : fields) {
+                q = procfs::parseU64(q, end, field);
+            }
+
+            if (index == currentCounters.size()) currentCounters.emplace_back();
+            DeviceCounters& counters = currentCounters[index];
+            counters.major = static_cast<uint32_t>(major);
+            counters.minor = static_cast<uint32_t>(minor);
+            counters.reads = fields[0];
+            counters.sectorsRead = fields[2];
+            counters.readMs = fields[3];
+            counters.writes = fields[4];
+            counters.sectorsWritten = fields[6];
+            counters.writeMs = fields[7];
+            counters.weightedMs = fields[10];
+
+            if (index >= deviceCount || lastCounters[index].major != counters.major ||
+                lastCounters[index].minor != counters.minor) {
+                sameLayout = false;
+            }
+            ++index;
+        }
+        p = procfs::nextLine(nameEnd, end);
+    }
+
+    currentCounters.resize(index);
+    return sameLayout && index == deviceCount;
+}
+
+// A device was added or removed: rebuild `disks` from the current file,
+// carrying over the previous counters of devices that are still present so
+// their rates continue without a gap
+void DiskMonitor::rebuildDevices() {
+    std::vector<DeviceCounters> previous;
+    previous.reserve(currentCounters.size());
+
+    std::vector<DiskInfo> rebuilt;
+    rebuilt.reserve(currentCounters.size() + 1);
+
+    const char* p = diskstatsFile.begin();
+    const char* end = diskstatsFile.end();
+    size_t index = 0;
+    while (p < end && index < currentCounters.size()) {
+        uint64_t ignored = 0;
+        const char* q = procfs::parseU64(p, end, ignored);
+        q = procfs::parseU64(q, end, ignored);
+        const char* name = procfs::skipSpaces(q, end);
+        const char* nameEnd = procfs::skipToken(name, end);
+        if (nameEnd == name) break;
+
+        if (!ignoredDevice(name, nameEnd)) {
+            const DeviceCounters& counters = currentCounters[index];
+            DeviceCounters carried = counters; // New device: no rate until its second sample
+            for (size_t i = 0; i < deviceCount; ++i) {
+                if (lastCounters[i].major == counters.major && lastCounters[i].minor == counters.minor) {
+                    carried = lastCounters[i];
+                    break;
+                }
+            }
+            previous.push_back(carried);
+
+            DiskInfo disk;
+            disk.name.assign(name, nameEnd);
+            for (size_t i = 0; i < disks.size(); ++i) {
+                if (disks[i].name == disk.name) {
+                    disk = disks[i];
+                    break;
+                }
+            }
+            rebuilt.push_back(std::move(disk));
+            ++index;
+        }
+        p = procfs::nextLine(nameEnd, end);
+    }
+
+    disks = std::move(rebuilt);
+    lastCounters = std::move(previous);
+    deviceCount = disks.size();
+    rootfsEntry = false;
+    capacityValid = false;
+}
+
+// Maps each device to its first mount point (preferring "/") and reads
+// its capacity with statvfs
+void DiskMonitor::updateCapacity() {
+    std::vector<std::string> mountPoints(deviceCount);
+    bool rootOnDevice = false;
+
+    if (mountinfoFile.isOpen() && mountinfoFile.read()) {
+        // id parent major:minor root mountpoint options ...
+        const char* p = mountinfoFile.begin();
+        const char* end = mountinfoFile.end();
+        while (p < end) {
+            const char* q = procfs::skipToken(procfs::skipSpaces(p, end), end);
+            q = procfs::skipToken(procfs::skipSpaces(q, end), end);
+
+            uint64_t major = 0;
+            uint64_t minor = 0;
+            q = procfs::parseU64(q, end, major);
+            if (q < end && *q == ':') q = procfs::parseU64(q + 1, end, minor);
+
+            const char* root = procfs::skipSpaces(q, end);
+            const char* path = procfs::skipSpaces(procfs::skipToken(root, end), end);
+            const char* pathEnd = procfs::skipToken(path, end);
+            bool isRoot = pathEnd - path == 1 && *path == '/';
+
+            // Only whole-device mounts; bind mounts of subdirectories repeat them
+            bool wholeDevice = root + 1 == procfs::skipToken(root, end) && *root == '/';
+            for (size_t i = 0; i < deviceCount && wholeDevice; ++i) {
+                if (currentCounters[i].major != major || currentCounters[i].minor != minor) continue;
+                if (mountPoints[i].empty() || isRoot) mountPoints[i] = unescapeMountPath(path, pathEnd);
+                if (isRoot) rootOnDevice = true;
+                break;
+            }
+            p = procfs::nextLine(pathEnd, end);
+        }
+    }
+
+    // A captured tree's mount points are not this host's to statvfs
+    bool live = root.empty();
+    for (size_t i = 0; i < deviceCount; ++i) {
+        DiskInfo& disk = disks[i];
+        disk.mountPoint = mountPoints[i];
+        disk.total = disk.used = disk.free = 0.0;
+
+        struct statvfs fs;
+        if (live && !disk.mountPoint.empty() && statvfs(disk.mountPoint.c_str(), &fs) == 0) {
+            // Convert bytes to GB
+            double blockSize = static_cast<double>(fs.f_frsize);
+            disk.total = fs.f_blocks * blockSize / kBytesPerGB;
+            disk.free = fs.f_bavail * blockSize / kBytesPerGB;
+            disk.used = disk.total - disk.free;
+        }
+    }
+
+    // Keep reporting the root filesystem when no listed device backs it
+    struct statvfs fs;
+    rootfsEntry = live && !rootOnDevice && statvfs("/", &fs) == 0;
+    disks.resize(deviceCount + (rootfsEntry ? 1 : 0));
+    if (rootfsEntry) {
+        DiskInfo& disk = disks.back();
+        disk.name = "rootfs";
+        disk.mountPoint = "/";
+        double blockSize = static_cast<double>(fs.f_frsize);
+        disk.total = fs.f_blocks * blockSize / kBytesPerGB;
+        disk.free = fs.f_bavail * blockSize / kBytesPerGB;
+        disk.used = disk.total - disk.free;
+    }
+
+    capacityValid = true;
+}
+
+void DiskMonitor::update() {
+    if (!initialized) return;
+    if (!diskstatsFile.read()) return;
+
+    auto now = procfs::now();
+    bool sameLayout = readCounters();
+    if (!sameLayout) rebuildDevices();
+
+    if (!capacityValid || now - lastCapacityTime >= kCapacityInterval) {
+        updateCapacity();
+        lastCapacityTime = now;
+    }
+
+    double seconds = std::chrono::duration<double>(now - lastSampleTime).count();
+    bool haveInterval = lastSampleTime.time_since_epoch().count() != 0 && seconds > 0.0;
+
+    for (size_t i = 0; i < deviceCount; ++i) {
+        const DeviceCounters& current = currentCounters[i];
+        const DeviceCounters& last = lastCounters[i];
+        DiskInfo& disk = disks[i];
+        if (!haveInterval) continue;
+
+        uint64_t reads = delta(current.reads, last.reads);
+        uint64_t writes = delta(current.writes, last.writes);
+        uint64_t serviceMs = delta(current.readMs, last.readMs) + delta(current.writeMs, last.writeMs);
+
+        disk.readSpeed = delta(current.sectorsRead, last.sectorsRead) * kSectorBytes / kBytesPerMB / seconds;
+        disk.writeSpeed = delta(current.sectorsWritten, last.sectorsWritten) * kSectorBytes / kBytesPerMB / seconds;
+        disk.readIops = reads / seconds;
+        disk.writeIops = writes / seconds;
+        // Average requests in flight: weighted time over wall time
+        disk.queueDepth = delta(current.weightedMs, last.weightedMs) / (seconds * 1000.0);
+        disk.latency = reads + writes > 0 ? static_cast<double>(serviceMs) / static_cast<double>(reads + writes) : 0.0;
+    }
+
+    lastCounters.swap(currentCounters);
+    lastSampleTime = now;
+}
+
+std::vector<DiskInfo> DiskMonitor::getInfo() const {
+    return disks;
+}
@@ -0,0 +1,27 @@
+#include "../gpu_monitor.h"
+
+// There is no vendor-neutral GPU API on Linux; like the WMI path, only the
+// placeholder values are reported until an NVML/DRM backend is added.
+GPUMonitor::GPUMonitor() : initialized(false) {
+    info.name = "Unknown";
+}
+
+GPUMonitor::~GPUMonitor() = default;
+
+bool GPUMonitor::initialize() {
+    initialized = true;
+    return true;
+}
+
+void GPUMonitor::update() {
+    if (!initialized) return;
+
+    info.usage = 0.0;
+    info.memoryUsed = 0.0;
+    info.memoryTotal = 0.0;
+    info.temperature = 0.0;
+}
+
+GPUInfo GPUMonitor::getInfo() const {
+    return info;
+}
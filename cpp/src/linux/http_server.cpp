@@ -0,0 +1,602 @@
+#include "http_server.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int kMaxEvents = 64;
+constexpr size_t kMaxClientMessage = 64 * 1024;
+constexpr size_t kMaxFrameHeader = 14; // 64-bit length and mask
+constexpr size_t kMaxControlPayload = 125;
+// Unsent responses and control frames; past this a client that is not
+// reading is dropped
+constexpr size_t kMaxPendingOutput = 64 * 1024;
+constexpr const char* kWebSocketGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+// SHA-1 (FIPS 180-1), only used for the WebSocket handshake
+void sha1(const std::string& message, uint8_t digest[20]) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    auto rotl = [](uint32_t v, int n) { return (v << n) | (v >> (32 - n)); };
+
+    std::string data = message;
+    uint64_t bitLength = static_cast<uint64_t>(message.size()) * 8;
+    data += static_cast<char>(0x80);
+    while (data.size() % 64 != 56) data += '\0';
+    for (int i = 7; i >= 0; --i) data += static_cast<char>((bitLength >> (i * 8)) & 0xFF);
+
+    for (size_t chunk = 0; chunk < data.size(); chunk += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i) {
+            const uint8_t* p = reinterpret_cast<const uint8_t*>(data.data() + chunk + i * 4);
+            w[i] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+        }
+        for (int i = 16; i < 80; ++i) w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; ++i) {
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotl(b, 30);
+            b = a;
+            a = temp;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+    for (int i = 0; i < 5; ++i) {
+        digest[i * 4] = static_cast<uint8_t>(h[i] >> 24);
+        digest[i * 4 + 1] = static_cast<uint8_t>(h[i] >> 16);
+        digest[i * 4 + 2] = static_cast<uint8_t>(h[i] >> 8);
+        digest[i * 4 + 3] = static_cast<uint8_t>(h[i]);
+    }
+}
+
+std::string base64(const uint8_t* data, size_t size) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    for (size_t i = 0; i < size; i += 3) {
+        uint32_t v = uint32_t(data[i]) << 16;
+        if (i + 1 < size) v |= uint32_t(data[i + 1]) << 8;
+        if (i + 2 < size) v |= data[i + 2];
+        out += alphabet[(v >> 18) & 63];
+        out += alphabet[(v >> 12) & 63];
+        out += i + 1 < size ? alphabet[(v >> 6) & 63] : '=';
+        out += i + 2 < size ? alphabet[v & 63] : '=';
+    }
+    return out;
+}
+
+// Unmasked server-to-client frame header (FIN set)
+void appendFrameHeader(std::string& out, uint8_t opcode, size_t length) {
+    out += static_cast<char>(0x80 | opcode);
+    if (length < 126) {
+        out += static_cast<char>(length);
+    } else if (length <= 0xFFFF) {
+        out += static_cast<char>(126);
+        out += static_cast<char>((length >> 8) & 0xFF);
+        out += static_cast<char>(length & 0xFF);
+    } else {
+        out += static_cast<char>(127);
+        for (int i = 7; i >= 0; --i) out += static_cast<char>((uint64_t(length) >> (i * 8)) & 0xFF);
+    }
+}
+
+std::string toLower(std::string s) {
+    for (char& c : s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t");
+    if (begin == std::string::npos) return std::string();
+    size_t end = s.find_last_not_of(" \t");
+    return s.substr(begin, end - begin + 1);
+}
+
+bool hasToken(const std::string& headerValue, const char* token) {
+    return toLower(headerValue).find(token) != std::string::npos;
+}
+
+const char* contentType(const std::string& path) {
+    auto endsWith = [&](const char* suffix) {
+        size_t n = std::strlen(suffix);
+        return path.size() >= n && path.compare(path.size() - n, n, suffix) == 0;
+    };
+    if (endsWith(".html")) return "text/html; charset=utf-8";
+    if (endsWith(".css")) return "text/css; charset=utf-8";
+    if (endsWith(".js")) return "application/javascript; charset=utf-8";
+    if (endsWith(".json")) return "application/json";
+    if (endsWith(".svg")) return "image/svg+xml";
+    if (endsWith(".png")) return "image/png";
+    if (endsWith(".ico")) return "image/x-icon";
+    return "application/octet-stream";
+}
+
+} // namespace
+
+HttpServer::HttpServer(HttpServerOptions options)
+    : config(std::move(options)), running(false), clients(0), dropped(0) {
+    if (config.maxQueuedFrames == 0) config.maxQueuedFrames = 1;
+}
+
+HttpServer::~HttpServer() {
+    stop();
+}
+
+bool HttpServer::start() {
+    if (running) return false;
+
+    listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) return false;
+    int one = 1;
+    ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(config.port);
+    if (::inet_pton(AF_INET, config.bindAddress.c_str(), &address.sin_addr) != 1 ||
+        ::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listenFd, SOMAXCONN) != 0) {
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    socklen_t length = sizeof(address);
+    ::getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length);
+    boundPort = ntohs(address.sin_port);
+
+    epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listenFd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+    event.data.fd = wakeFd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+
+    running = true;
+    loop = std::thread([this] { run(); });
+    return true;
+}
+
+void HttpServer::stop() {
+    if (!running.exchange(false)) return;
+
+    uint64_t one = 1;
+    ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+    (void)ignored;
+    loop.join();
+
+    ::close(listenFd);
+    ::close(wakeFd);
+    ::close(epollFd);
+    listenFd = wakeFd = epollFd = -1;
+}
+
+void HttpServer::broadcast(std::string_view message) {
+    if (!running) return;
+
+    auto frame = std::make_shared<std::string>();
+    frame->reserve(message.size() + 10);
+    appendFrameHeader(*frame, 0x1, message.size());
+    frame->append(message.data(), message.size());
+
+    {
+        std::lock_guard<std::mutex> lock(nextMutex);
+        nextFrame = std::move(frame);
+    }
+    uint64_t one = 1;
+    ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+    (void)ignored;
+}
+
+void HttpServer::run() {
+    epoll_event events[kMaxEvents];
+    while (running) {
+        int count = ::epoll_wait(epollFd, events, kMaxEvents, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == listenFd) {
+                acceptAll();
+                continue;
+            }
+            if (fd == wakeFd) {
+                uint64_t value;
+                ssize_t ignored = ::read(wakeFd, &value, sizeof(value));
+                (void)ignored;
+                Frame frame;
+                {
+                    std::lock_guard<std::mutex> lock(nextMutex);
+                    frame.swap(nextFrame);
+                }
+                if (frame) distribute(frame);
+                continue;
+            }
+
+            auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+            Connection& connection = it->second;
+            uint32_t ready = events[i].events;
+            bool keep = !(ready & EPOLLERR);
+            if (keep && (ready & (EPOLLIN | EPOLLHUP))) keep = onReadable(connection);
+            if (keep && (ready & EPOLLOUT)) keep = flush(connection);
+            if (!keep) closeConnection(fd);
+        }
+    }
+
+    while (!connections.empty()) closeConnection(connections.begin()->first);
+}
+
+void HttpServer::acceptAll() {
+    for (;;) {
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return; // EAGAIN, or a transient error such as EMFILE
+        if (connections.size() >= config.maxConnections) {
+            ::close(fd);
+            continue;
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            ::close(fd);
+            continue;
+        }
+        connections[fd].fd = fd;
+    }
+}
+
+bool HttpServer::onReadable(Connection& connection) {
+    // Stop reading at the largest input that can still parse; anything
+    // larger is rejected below, and the rest stays in the socket
+    const size_t limit = connection.websocket ? kMaxFrameHeader + kMaxClientMessage : config.maxRequestBytes;
+    char buffer[4096];
+    while (connection.input.size() <= limit) {
+        ssize_t n = ::recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            connection.input.append(buffer, static_cast<size_t>(n));
+            continue;
+        }
+        if (n == 0) return false; // Peer closed
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        return false;
+    }
+    if (connection.closing) {
+        connection.input.clear();
+        return true;
+    }
+
+    while (!connection.websocket) {
+        size_t end = connection.input.find("\r\n\r\n");
+        if (end == std::string::npos) {
+            if (connection.input.size() > config.maxRequestBytes) {
+                respond(connection, 431, "Request Header Fields Too Large", "text/plain", "", false);
+                return flush(connection);
+            }
+            return flush(connection);
+        }
+        std::string head = connection.input.substr(0, end);
+        connection.input.erase(0, end + 4);
+        if (!handleRequest(connection, head)) return false;
+        if (connection.closing) {
+            connection.input.clear();
+            return flush(connection);
+        }
+    }
+    return handleWebSocketInput(connection);
+}
+
+bool HttpServer::handleRequest(Connection& connection, const std::string& head) {
+    // Request line
+    size_t lineEnd = head.find("\r\n");
+    std::string requestLine = head.substr(0, lineEnd);
+    size_t firstSpace = requestLine.find(' ');
+    size_t secondSpace = firstSpace == std::string::npos ? std::string::npos : requestLine.find(' ', firstSpace + 1);
+    if (secondSpace == std::string::npos) {
+        respond(connection, 400, "Bad Request", "text/plain", "Bad Request\n", false);
+        return true;
+    }
+    std::string method = requestLine.substr(0, firstSpace);
+    std::string target = requestLine.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+    std::string version = requestLine.substr(secondSpace + 1);
+
+    // Headers used below
+    std::string connectionHeader, upgrade, key, contentLength;
+    size_t position = lineEnd == std::string::npos ? head.size() : lineEnd + 2;
+    while (position < head.size()) {
+        size_t next = head.find("\r\n", position);
+        if (next == std::string::npos) next = head.size();
+        std::string line = head.substr(position, next - position);
+        position = next + 2;
+
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        std::string name = toLower(trim(line.substr(0, colon)));
+        std::string value = trim(line.substr(colon + 1));
+        if (name == "connection") connectionHeader = value;
+        else if (name == "upgrade") upgrade = value;
+        else if (name == "sec-websocket-key") key = value;
+        else if (name == "content-length") contentLength = value;
+    }
+
+    bool keepAlive = version == "HTTP/1.1" ? !hasToken(connectionHeader, "close")
+                                           : hasToken(connectionHeader, "keep-alive");
+    if (method != "GET" || (!contentLength.empty() && contentLength != "0")) {
+        respond(connection, 405, "Method Not Allowed", "text/plain", "Method Not Allowed\n", false);
+        return true;
+    }
+
+    std::string query;
+    size_t questionMark = target.find('?');
+    if (questionMark != std::string::npos) {
+        query = target.substr(questionMark + 1);
+        target.resize(questionMark);
+    }
+
+    if (target == "/ws") {
+        if (!hasToken(upgrade, "websocket") || key.empty()) {
+            respond(connection, 400, "Bad Request", "text/plain", "Expected a WebSocket upgrade\n", false);
+            return true;
+        }
+        uint8_t digest[20];
+        sha1(key + kWebSocketGuid, digest);
+        connection.output += "HTTP/1.1 101 Switching Protocols\r\n"
+                             "Upgrade: websocket\r\n"
+                             "Connection: Upgrade\r\n"
+                             "Sec-WebSocket-Accept: ";
+        connection.output += base64(digest, sizeof(digest));
+        connection.output += "\r\n\r\n";
+        connection.websocket = true;
+        clients.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    if (target == "/api/status") {
+        respond(connection, 200, "OK", "application/json",
+                "{\"status\":\"running\",\"transport\":\"websocket\"}", keepAlive);
+        return true;
+    }
+
+    if (config.api && target.compare(0, 5, "/api/") == 0) {
+        std::string body;
+        if (config.api(target, query, body)) {
+            respond(connection, 200, "OK", "application/json", body, keepAlive);
+        } else {
+            respond(connection, 404, "Not Found", "text/plain", "Not Found\n", keepAlive);
+        }
+        return true;
+    }
+
+    sendFile(connection, target, keepAlive);
+    return true;
+}
+
+void HttpServer::sendFile(Connection& connection, const std::string& target, bool keepAlive) {
+    // No parent segments, encoded characters or backslashes
+    if (target.empty() || target[0] != '/' || target.find("..") != std::string::npos ||
+        target.find('%') != std::string::npos || target.find('\\') != std::string::npos) {
+        respond(connection, 404, "Not Found", "text/plain", "Not Found\n", keepAlive);
+        return;
+    }
+    std::string path = config.webRoot + (target == "/" ? std::string("/index.html") : target);
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || ::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        if (fd >= 0) ::close(fd);
+        respond(connection, 404, "Not Found", "text/plain", "Not Found\n", keepAlive);
+        return;
+    }
+    std::string body(static_cast<size_t>(st.st_size), '\0');
+    size_t filled = 0;
+    while (filled < body.size()) {
+        ssize_t n = ::read(fd, &body[filled], body.size() - filled);
+        if (n <= 0) break;
+        filled += static_cast<size_t>(n);
+    }
+    ::close(fd);
+    body.resize(filled);
+    respond(connection, 200, "OK", contentType(path), body, keepAlive);
+}
+
+void HttpServer::respond(Connection& connection, int status, const char* reason, const char* type,
+                         const std::string& body, bool keepAlive) {
+    std::string& out = connection.output;
+    out += "HTTP/1.1 ";
+    out += std::to_string(status);
+    out += ' ';
+    out += reason;
+    out += "\r\nContent-Type: ";
+    out += type;
+    out += "\r\nContent-Length: ";
+    out += std::to_string(body.size());
+    out += "\r\nCache-Control: no-cache\r\nConnection: ";
+    out += keepAlive ? "keep-alive" : "close";
+    out += "\r\n\r\n";
+    out += body;
+    if (!keepAlive) connection.closing = true;
+}
+
+bool HttpServer::handleWebSocketInput(Connection& connection) {
+    std::string& in = connection.input;
+    size_t consumed = 0;
+    while (in.size() - consumed >= 2) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(in.data() + consumed);
+        size_t available = in.size() - consumed;
+        uint8_t opcode = p[0] & 0x0F;
+        bool masked = (p[1] & 0x80) != 0;
+        uint64_t length = p[1] & 0x7F;
+        size_t header = 2;
+        if (length == 126) {
+            if (available < 4) break;
+            length = (uint64_t(p[2]) << 8) | p[3];
+            header = 4;
+        } else if (length == 127) {
+            if (available < 10) break;
+            length = 0;
+            for (int i = 0; i < 8; ++i) length = (length << 8) | p[2 + i];
+            header = 10;
+        }
+        // Clients must mask; messages to us are only ever small
+        if (!masked || length > kMaxClientMessage) return false;
+        if ((opcode & 0x8) && length > kMaxControlPayload) return false;
+        if (available < header + 4 + length) break;
+
+        const uint8_t* mask = p + header;
+        std::string payload(reinterpret_cast<const char*>(p + header + 4), static_cast<size_t>(length));
+        for (size_t i = 0; i < payload.size(); ++i) payload[i] = static_cast<char>(payload[i] ^ mask[i & 3]);
+        consumed += header + 4 + static_cast<size_t>(length);
+
+        if (opcode == 0x8) {
+            // Echo the status code and close once it is sent
+            appendFrameHeader(connection.output, 0x8, std::min<size_t>(payload.size(), 2));
+            connection.output.append(payload, 0, 2);
+            connection.closing = true;
+            break;
+        }
+        if (opcode == 0x9) {
+            // A peer that pings without reading the pongs is dropped
+            if (connection.output.size() - connection.outputOffset > kMaxPendingOutput) return false;
+            appendFrameHeader(connection.output, 0xA, payload.size());
+            connection.output += payload;
+        }
+        // Text, binary, continuation and pong frames are ignored
+    }
+    in.erase(0, consumed);
+    if (connection.closing) in.clear();
+    return flush(connection);
+}
+
+void HttpServer::distribute(const Frame& frame) {
+    std::vector<int> failed;
+    for (auto& entry : connections) {
+        Connection& connection = entry.second;
+        if (!connection.websocket || connection.closing) continue;
+
+        // Drop the oldest frames that have not started going out. The one
+        // in flight counts against the limit too; if it is all that is
+        // left, the new frame is the one dropped.
+        size_t oldest = connection.frameOffset > 0 ? 1 : 0;
+        while (connection.frames.size() >= config.maxQueuedFrames && oldest < connection.frames.size()) {
+            connection.frames.erase(connection.frames.begin() + static_cast<long>(oldest));
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (connection.frames.size() >= config.maxQueuedFrames) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        connection.frames.push_back(frame);
+        if (!flush(connection)) failed.push_back(entry.first);
+    }
+    for (int fd : failed) closeConnection(fd);
+}
+
+bool HttpServer::flush(Connection& connection) {
+    for (;;) {
+        // A partially sent frame must finish before anything else goes out
+        const char* data;
+        size_t size;
+        bool fromOutput = connection.frameOffset == 0 && connection.outputOffset < connection.output.size();
+        if (fromOutput) {
+            data = connection.output.data() + connection.outputOffset;
+            size = connection.output.size() - connection.outputOffset;
+        } else if (!connection.frames.empty()) {
+            data = connection.frames.front()->data() + connection.frameOffset;
+            size = connection.frames.front()->size() - connection.frameOffset;
+        } else {
+            break;
+        }
+
+        ssize_t n = ::send(connection.fd, data, size, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                if (!connection.wantWrite) {
+                    connection.wantWrite = true;
+                    updateInterest(connection);
+                }
+                return true;
+            }
+            return false;
+        }
+
+        size_t sent = static_cast<size_t>(n);
+        if (fromOutput) {
+            connection.outputOffset += sent;
+            if (connection.outputOffset == connection.output.size()) {
+                connection.output.clear();
+                connection.outputOffset = 0;
+            }
+        } else {
+            connection.frameOffset += sent;
+            if (connection.frameOffset == connection.frames.front()->size()) {
+                connection.frames.pop_front();
+                connection.frameOffset = 0;
+            }
+        }
+    }
+
+    if (connection.closing) return false;
+    if (connection.wantWrite) {
+        connection.wantWrite = false;
+        updateInterest(connection);
+    }
+    return true;
+}
+
+void HttpServer::updateInterest(Connection& connection) {
+    uint32_t events = EPOLLIN;
+    if (connection.wantWrite) events |= EPOLLOUT;
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = connection.fd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+}
+
+void HttpServer::closeConnection(int fd) {
+    auto it = connections.find(fd);
+    if (it == connections.end()) return;
+    if (it->second.websocket) clients.fetch_sub(1, std::memory_order_relaxed);
+    ::epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections.erase(it);
+}
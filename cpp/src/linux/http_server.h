@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+struct HttpServerOptions {
+    std::string bindAddress = "0.0.0.0";
+    uint16_t port = 8080;
+    std::string webRoot = "web";   // Served for GET requests outside /ws and /api
+    size_t maxQueuedFrames = 4;    // Per WebSocket client; older frames are dropped
+    size_t maxConnections = 1024;
+    size_t maxRequestBytes = 8192; // Request line and headers
+    // Answers GET /api/<name> other than /api/status: given the path and
+    // the query string, sets a JSON body and returns true, or false for a
+    // 404. Runs on the event loop thread, so it must not block.
+    std::function<bool(const std::string& path, const std::string& query, std::string& body)> api;
+};
+
+// Minimal HTTP/1.1 + WebSocket (RFC 6455) server on one epoll thread, for
+// serving the dashboard straight from `monitor`.
+//
+//   GET /...        static files from webRoot (index.html for "/")
+//   GET /api/status {"status":"running","transport":"websocket"}
+//   GET /api/...    whatever HttpServerOptions::api answers
+//   GET /ws         WebSocket upgrade; the client receives every broadcast
+//                   as a text message and may send nothing but control frames
+//
+// broadcast() takes a message serialized once by the caller. The server
+// frames it once and shares the same buffer with every client. Each client
+// has a bounded queue. A client that cannot keep up loses its oldest unsent
+// frames rather than growing the queue, so a slow reader only costs memory
+// for maxQueuedFrames shared buffers.
+class HttpServer {
+public:
+    explicit HttpServer(HttpServerOptions options);
+    ~HttpServer();
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    // Binds, listens and starts the event loop thread. False if the
+    // address cannot be bound.
+    bool start();
+    void stop();
+
+    // Queues `message` for every WebSocket client. Thread-safe; if the loop
+    // has not picked up the previous message yet, that one is replaced.
+    void broadcast(std::string_view message);
+
+    size_t clientCount() const { return clients.load(std::memory_order_relaxed); }
+    // Frames discarded for slow clients, over all clients
+    uint64_t droppedFrames() const { return dropped.load(std::memory_order_relaxed); }
+    uint16_t port() const { return boundPort; }
+
+private:
+    using Frame = std::shared_ptr<const std::string>;
+
+    struct Connection {
+        int fd = -1;
+        bool websocket = false;
+        bool closing = false;       // Close after the output drains
+        bool wantWrite = false;     // EPOLLOUT registered (only while output is blocked)
+        std::string input;
+        std::string output;         // HTTP responses and control frames, sent first
+        size_t outputOffset = 0;
+        std::deque<Frame> frames;   // Broadcast frames, shared between clients
+        size_t frameOffset = 0;     // Bytes of frames.front() already sent
+    };
+
+    HttpServerOptions config;
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1; // eventfd: a broadcast or stop() is pending
+    uint16_t boundPort = 0;
+    std::thread loop;
+    std::atomic<bool> running;
+
+    std::mutex nextMutex;
+    Frame nextFrame; // Handed from broadcast() to the loop
+
+    std::unordered_map<int, Connection> connections; // Loop thread only
+    std::atomic<size_t> clients;
+    std::atomic<uint64_t> dropped;
+
+    void run();
+    void acceptAll();
+    // These return false when the connection must be closed
+    bool onReadable(Connection& connection);
+    bool handleRequest(Connection& connection, const std::string& head);
+    bool handleWebSocketInput(Connection& connection);
+    void sendFile(Connection& connection, const std::string& target, bool keepAlive);
+    void respond(Connection& connection, int status, const char* reason, const char* contentType,
+                 const std::string& body, bool keepAlive);
+    void distribute(const Frame& frame);
+    bool flush(Connection& connection);
+    void updateInterest(Connection& connection);
+    void closeConnection(int fd);
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Perfect hash from a fixed set of keys to their position in that set,
+// built at compile time. Collectors use it to route "key value" lines of
+// procfs files (/proc/meminfo, /proc/vmstat) into fixed arrays without
+// comparing each line against every key or allocating strings:
+//
+//     enum Key { MemTotal, MemFree, kKeys };
+//     constexpr KeyTable<kKeys> kTable({"MemTotal", "MemFree"});
+//     int index = kTable.find(name, nameEnd); // Key, or -1
+//
+// The constructor searches for a hash seed that gives every key its own
+// slot. Declare tables constexpr so the search runs in the compiler.
+template <size_t N>
+class KeyTable {
+public:
+    static constexpr size_t kSlots = [] {
+        size_t slots = 8;
+        while (slots < 4 * N) slots *= 2;
+        return slots;
+    }();
+
+    constexpr explicit KeyTable(const std::array<std::string_view, N>& keys) : keys(keys), seed(0), slots() {
+        for (uint32_t candidate = 1; candidate < 100000; ++candidate) {
+            if (tryBuild(candidate)) {
+                seed = candidate;
+                return;
+            }
+        }
+    }
+
+    // Index of the key [begin, end) in the constructor's list, or -1
+    int find(const char* begin, const char* end) const {
+        std::string_view key(begin, static_cast<size_t>(end - begin));
+        int index = slots[hash(key, seed) & (kSlots - 1)] - 1;
+        return index >= 0 && keys[index] == key ? index : -1;
+    }
+
+    // False only if no seed was found (the table is then useless)
+    constexpr bool valid() const { return seed != 0; }
+
+private:
+    std::array<std::string_view, N> keys;
+    uint32_t seed;
+    std::array<int16_t, kSlots> slots; // Key index + 1; 0 is empty
+
+    // FNV-1a with the seed folded into the offset basis
+    static constexpr uint32_t hash(std::string_view key, uint32_t seed) {
+        uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+        for (char c : key) {
+            h ^= static_cast<uint8_t>(c);
+            h *= 16777619u;
+        }
+        return h ^ (h >> 15);
+    }
+
+    constexpr bool tryBuild(uint32_t candidate) {
+        for (auto& slot : slots) slot = 0;
+        for (size_t i = 0; i < N; ++i) {
+            auto& slot = slots[hash(keys[i], candidate) & (kSlots - 1)];
+            if (slot != 0) return false;
+            slot = static_cast<int16_t>(i + 1);
+        }
+        return true;
+    }
+};
@@ -0,0 +1,196 @@
+#include "../memory_monitor.h"
+#include "key_table.h"
+
+namespace {
+constexpr double kKbPerMB = 1024.0;
+
+enum MeminfoKey {
+    MemTotal, MemAvailable, Buffers, Cached, SwapTotal, SwapFree, Dirty, Writeback, Shmem, Slab, SReclaimable,
+    HugePagesTotal, HugePagesFree, Hugepagesize, kMeminfoKeys
+};
+
+constexpr KeyTable<kMeminfoKeys> kMeminfoTable({
+    "MemTotal", "MemAvailable", "Buffers", "Cached", "SwapTotal", "SwapFree", "Dirty", "Writeback", "Shmem", "Slab",
+    "SReclaimable", "HugePages_Total", "HugePages_Free", "Hugepagesize",
+});
+static_assert(kMeminfoTable.valid(), "no perfect hash for the meminfo keys");
+
+// /proc/vmstat counters and the rate each one adds to. Reclaim and stall
+// counters are split by reclaimer and zone, and the set varies by kernel.
+constexpr std::string_view kVmstatKeys[] = {
+    "pgfault", "pgmajfault", "pswpin", "pswpout",
+    "pgscan_kswapd", "pgscan_direct", "pgscan_khugepaged", "pgscan_proactive",
+    "pgsteal_kswapd", "pgsteal_direct", "pgsteal_khugepaged", "pgsteal_proactive",
+    "allocstall", "allocstall_dma", "allocstall_dma32", "allocstall_normal", "allocstall_movable", "allocstall_device",
+    "oom_kill",
+};
+constexpr size_t kVmstatKeyCount = sizeof(kVmstatKeys) / sizeof(kVmstatKeys[0]);
+constexpr int kOomKill = -1;
+constexpr int kVmstatRate[kVmstatKeyCount] = {
+    0, 1, 2, 3,
+    4, 4, 4, 4,
+    5, 5, 5, 5,
+    6, 6, 6, 6, 6, 6,
+    kOomKill,
+};
+
+constexpr KeyTable<kVmstatKeyCount> kVmstatTable([] {
+    std::array<std::string_view, kVmstatKeyCount> keys{};
+    for (size_t i = 0; i < kVmstatKeyCount; ++i) keys[i] = kVmstatKeys[i];
+    return keys;
+}());
+static_assert(kVmstatTable.valid(), "no perfect hash for the vmstat keys");
+
+// "key" up to the first ':' or blank of a line
+const char* keyEnd(const char* p, const char* end) {
+    while (p < end && *p != ':' && *p != ' ' && *p != '\n') ++p;
+    return p;
+}
+
+// avgN=D.DD; the fraction has two digits
+const char* parsePercent(const char* p, const char* end, double& out) {
+    uint64_t whole = 0;
+    p = procfs::parseU64(p, end, whole);
+    out = static_cast<double>(whole);
+    if (p < end && *p == '.') {
+        double scale = 0.1;
+        for (++p; p < end && *p >= '0' && *p <= '9'; ++p, scale /= 10.0) out += (*p - '0') * scale;
+    }
+    return p;
+}
+}
+
+MemoryMonitor::MemoryMonitor() : initialized(false) {}
+
+MemoryMonitor::~MemoryMonitor() = default;
+
+bool MemoryMonitor::initialize() {
+    if (!meminfoFile.open((root + "/proc/meminfo").c_str())) {
+        return false;
+    }
+    // Optional: activity rates and PSI
+    vmstatFile.open((root + "/proc/vmstat").c_str());
+    if (pressureFile.open((root + "/proc/pressure/memory").c_str()) && !pressureFile.read()) {
+        pressureFile.close(); // Built with PSI but booted with psi=0
+    }
+    initialized = true;
+    return true;
+}
+
+bool MemoryMonitor::readMeminfo() {
+    if (!meminfoFile.read()) return false;
+
+    // Values are in kB, except the HugePages_ counts
+    uint64_t values[kMeminfoKeys] = {};
+    int found = 0;
+    const char* p = meminfoFile.begin();
+    const char* end = meminfoFile.end();
+    for (; p < end && found < kMeminfoKeys; p = procfs::nextLine(p, end)) {
+        const char* nameEnd = keyEnd(p, end);
+        int key = kMeminfoTable.find(p, nameEnd);
+        if (key < 0) continue;
+        procfs::parseU64(nameEnd + 1, end, values[key]);
+        ++found;
+    }
+    if (values[MemTotal] == 0) return false;
+
+    // Convert kB to MB
+    info.total = values[MemTotal] / kKbPerMB;
+    info.free = values[MemAvailable] / kKbPerMB;
+    info.used = info.total - info.free;
+    info.usagePercent = (info.used / info.total) * 100.0;
+
+    // "Cached" includes shmem (tmpfs), which cannot be dropped like cache
+    uint64_t cached = values[Cached] > values[Shmem] ? values[Cached] - values[Shmem] : 0;
+    info.cached = cached / kKbPerMB;
+    info.buffers = values[Buffers] / kKbPerMB;
+    info.slab = values[Slab] / kKbPerMB;
+    info.slabReclaimable = values[SReclaimable] / kKbPerMB;
+    info.shmem = values[Shmem] / kKbPerMB;
+    info.swapTotal = values[SwapTotal] / kKbPerMB;
+    uint64_t swapFree = values[SwapFree] < values[SwapTotal] ? values[SwapFree] : values[SwapTotal];
+    info.swapUsed = (values[SwapTotal] - swapFree) / kKbPerMB;
+    info.dirty = values[Dirty] / kKbPerMB;
+    info.writeback = values[Writeback] / kKbPerMB;
+    double hugePageMB = values[Hugepagesize] / kKbPerMB;
+    info.hugePagesTotal = values[HugePagesTotal] * hugePageMB;
+    uint64_t hugeFree = values[HugePagesFree] < values[HugePagesTotal] ? values[HugePagesFree] : values[HugePagesTotal];
+    info.hugePagesUsed = (values[HugePagesTotal] - hugeFree) * hugePageMB;
+    return true;
+}
+
+void MemoryMonitor::readVmstat() {
+    if (!vmstatFile.isOpen() || !vmstatFile.read()) return;
+
+    uint64_t counters[kRates] = {};
+    uint64_t oomKills = 0;
+    const char* p = vmstatFile.begin();
+    const char* end = vmstatFile.end();
+    for (; p < end; p = procfs::nextLine(p, end)) {
+        const char* nameEnd = keyEnd(p, end);
+        int key = kVmstatTable.find(p, nameEnd);
+        if (key < 0) continue;
+        uint64_t value = 0;
+        procfs::parseU64(nameEnd, end, value);
+        int rate = kVmstatRate[key];
+        if (rate == kOomKill) {
+            oomKills = value;
+        } else {
+            counters[rate] += value;
+        }
+    }
+    info.oomKills = oomKills;
+
+    auto now = procfs::now();
+    double seconds = std::chrono::duration<double>(now - lastVmstatTime).count();
+    if (haveCounters && seconds > 0.0) {
+        double* rates[kRates] = {&info.pageFaults, &info.majorFaults, &info.swapIn, &info.swapOut,
+                                 &info.pagesScanned, &info.pagesReclaimed, &info.allocStalls};
+        for (int i = 0; i < kRates; ++i) {
+            uint64_t delta = counters[i] >= lastCounters[i] ? counters[i] - lastCounters[i] : 0;
+            *rates[i] = delta / seconds;
+        }
+    }
+    for (int i = 0; i < kRates; ++i) lastCounters[i] = counters[i];
+    lastVmstatTime = now;
+    haveCounters = true;
+}
+
+// some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+// full avg10=0.00 avg60=0.00 avg300=0.00 total=0
+void MemoryMonitor::readPressure() {
+    if (!pressureFile.isOpen() || !pressureFile.read()) return;
+
+    MemoryPressure& pressure = info.pressure;
+    const char* p = pressureFile.begin();
+    const char* end = pressureFile.end();
+    for (; p < end; p = procfs::nextLine(p, end)) {
+        bool some = procfs::startsWith(p, end, "some ");
+        if (!some && !procfs::startsWith(p, end, "full ")) continue;
+        double* fields[3] = {&pressure.full10, &pressure.full60, &pressure.full300};
+        if (some) {
+            fields[0] = &pressure.some10;
+            fields[1] = &pressure.some60;
+            fields[2] = &pressure.some300;
+        }
+        const char* q = p + 5;
+        for (double* field : fields) {
+            q = procfs::skipSpaces(q, end);
+            while (q < end && *q != '=' && *q != '\n') ++q;
+            if (q >= end || *q != '=') break;
+            q = parsePercent(q + 1, end, *field);
+        }
+    }
+    pressure.available = true;
+}
+
+void MemoryMonitor::update() {
+    if (!initialized) return;
+    if (!readMeminfo()) return;
+    readVmstat();
+    readPressure();
+}
+
+MemoryInfo MemoryMonitor::getInfo() const {
+    return info;
+}
@@ -0,0 +1,753 @@
+#include "metric_store.h"
+#include "../gorilla_codec.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char kFileMagic[8] = {'M', 'C', 'S', 'T', 'O', 'R', 'E', '1'};
+constexpr uint32_t kFileVersion = 1;
+constexpr uint32_t kBlockMagic = 0x314B4C42; // "BLK1"
+constexpr int64_t kDayMs = 24 * 3600 * 1000LL;
+// Recycled batch buffers kept by the writer
+constexpr size_t kSpareBatches = 2;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t seriesCount;
+    uint32_t headerBytes; // Including the names and padding
+    uint32_t crc;         // Of the bytes after this struct
+};
+
+struct BlockHeader {
+    uint32_t magic;
+    uint32_t payloadBytes; // Unpadded
+    uint32_t sampleCount;
+    uint32_t crc;          // Of this header (crc = 0) and the payload
+    int64_t firstMs;
+    int64_t lastMs;
+};
+
+static_assert(sizeof(FileHeader) == 24, "FileHeader layout");
+static_assert(sizeof(BlockHeader) == 32, "BlockHeader layout");
+
+// CRC-32 (IEEE 802.3), eight bytes per step (slicing-by-8): queries check
+// every block they decode
+struct CrcTable {
+    uint32_t entries[8][256];
+    constexpr CrcTable() : entries() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int slice = 1; slice < 8; ++slice) {
+                uint32_t previous = entries[slice - 1][i];
+                entries[slice][i] = entries[0][previous & 0xFF] ^ (previous >> 8);
+            }
+        }
+    }
+};
+constexpr CrcTable kCrcTable;
+
+uint32_t crc32(const void* data, size_t size, uint32_t crc = 0) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    const auto& t = kCrcTable.entries;
+    crc = ~crc;
+    for (; size >= 8; size -= 8, bytes += 8) {
+        uint32_t low = crc ^ (uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 | uint32_t(bytes[2]) << 16 |
+                              uint32_t(bytes[3]) << 24);
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+              t[3][bytes[4]] ^ t[2][bytes[5]] ^ t[1][bytes[6]] ^ t[0][bytes[7]];
+    }
+    for (; size > 0; --size) crc = t[0][(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+uint32_t blockCrc(const BlockHeader& header, const uint8_t* payload) {
+    BlockHeader copy = header;
+    copy.crc = 0;
+    return crc32(payload, header.payloadBytes, crc32(&copy, sizeof(copy)));
+}
+
+size_t align8(size_t n) {
+    return (n + 7) & ~size_t(7);
+}
+
+int64_t floorDiv(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+bool endsWith(const std::string& s, const char* suffix) {
+    size_t n = std::strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+bool writeAll(int fd, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        ssize_t n = ::write(fd, bytes, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void syncDirectory(const std::string& directory) {
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return;
+    ::fsync(fd);
+    ::close(fd);
+}
+
+// Read-only mapping of a whole file, or of its first `limit` bytes
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path, size_t limit = std::numeric_limits<size_t>::max()) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            size_t size = std::min(static_cast<size_t>(st.st_size), limit);
+            void* map = size > 0 ? ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+            if (map != MAP_FAILED) {
+                bytes = static_cast<const uint8_t*>(map);
+                length = size;
+            }
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile() {
+        if (bytes) ::munmap(const_cast<uint8_t*>(bytes), length);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+};
+
+void encodeFileHeader(const std::vector<std::string>& names, std::vector<uint8_t>& out) {
+    out.assign(sizeof(FileHeader), 0);
+    for (const std::string& name : names) {
+        uint16_t length = static_cast<uint16_t>(std::min<size_t>(name.size(), 0xFFFF));
+        const uint8_t* lengthBytes = reinterpret_cast<const uint8_t*>(&length);
+        out.insert(out.end(), lengthBytes, lengthBytes + sizeof(length));
+        out.insert(out.end(), name.begin(), name.begin() + length);
+    }
+    out.resize(align8(out.size()), 0);
+
+    FileHeader header;
+    std::memcpy(header.magic, kFileMagic, sizeof(header.magic));
+    header.version = kFileVersion;
+    header.seriesCount = static_cast<uint32_t>(names.size());
+    header.headerBytes = static_cast<uint32_t>(out.size());
+    header.crc = crc32(out.data() + sizeof(FileHeader), out.size() - sizeof(FileHeader));
+    std::memcpy(out.data(), &header, sizeof(header));
+}
+
+// Validates the file header. Returns its size (0 if invalid) and, if
+// requested, the series names.
+size_t parseFileHeader(const uint8_t* data, size_t size, uint32_t& seriesCount,
+                       std::vector<std::string>* names = nullptr) {
+    if (!data || size < sizeof(FileHeader)) return 0;
+    FileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0 || header.version != kFileVersion) return 0;
+    if (header.headerBytes < sizeof(FileHeader) || header.headerBytes > size) return 0;
+    if (crc32(data + sizeof(FileHeader), header.headerBytes - sizeof(FileHeader)) != header.crc) return 0;
+
+    seriesCount = header.seriesCount;
+    if (names) {
+        names->clear();
+        size_t offset = sizeof(FileHeader);
+        for (uint32_t i = 0; i < header.seriesCount; ++i) {
+            uint16_t length;
+            if (offset + sizeof(length) > header.headerBytes) return 0;
+            std::memcpy(&length, data + offset, sizeof(length));
+            offset += sizeof(length);
+            if (offset + length > header.headerBytes) return 0;
+            names->emplace_back(reinterpret_cast<const char*>(data + offset), length);
+            offset += length;
+        }
+    }
+    return header.headerBytes;
+}
+
+// Column of `series` in the file header, or -1
+long findSeries(const uint8_t* data, size_t headerBytes, uint32_t seriesCount, const std::string& series) {
+    size_t offset = sizeof(FileHeader);
+    for (uint32_t i = 0; i < seriesCount; ++i) {
+        uint16_t length;
+        if (offset + sizeof(length) > headerBytes) return -1;
+        std::memcpy(&length, data + offset, sizeof(length));
+        offset += sizeof(length);
+        if (offset + length > headerBytes) return -1;
+        if (length == series.size() && std::memcmp(data + offset, series.data(), length) == 0) {
+            return static_cast<long>(i);
+        }
+        offset += length;
+    }
+    return -1;
+}
+
+// Calls visit(offset, header) for consecutive well-formed blocks starting at
+// `offset` until it returns false. Returns the end of the last valid block.
+template <typename Visit>
+size_t walkBlocks(const uint8_t* data, size_t size, size_t offset, bool verify, Visit visit) {
+    while (offset + sizeof(BlockHeader) <= size) {
+        BlockHeader header;
+        std::memcpy(&header, data + offset, sizeof(header));
+        if (header.magic != kBlockMagic || header.sampleCount == 0) break;
+        size_t end = offset + sizeof(BlockHeader) + align8(header.payloadBytes);
+        if (end > size) break;
+        if (verify && blockCrc(header, data + offset + sizeof(BlockHeader)) != header.crc) break;
+        if (!visit(offset, header)) break;
+        offset = end;
+    }
+    return offset;
+}
+
+// Bounds of column `column` inside a block payload
+bool columnRange(const uint8_t* payload, const BlockHeader& header, uint32_t columns, uint32_t column,
+                 size_t& begin, size_t& end) {
+    size_t table = sizeof(uint32_t) * columns;
+    if (table > header.payloadBytes) return false;
+    uint32_t value;
+    if (column == 0) {
+        begin = table;
+    } else {
+        std::memcpy(&value, payload + sizeof(uint32_t) * (column - 1), sizeof(value));
+        begin = value;
+    }
+    std::memcpy(&value, payload + sizeof(uint32_t) * column, sizeof(value));
+    end = value;
+    return begin <= end && end <= header.payloadBytes;
+}
+
+struct StoreFile {
+    std::string path;
+    bool compacted = false; // day-*.mcs
+    int64_t startMs = 0;    // From the file name
+    int64_t firstMs = 0;    // From the blocks
+    int64_t lastMs = 0;
+};
+
+// Files of the store, by start time. Block bounds are only read when
+// `withBounds` is set.
+std::vector<StoreFile> listFiles(const std::string& directory, bool withBounds) {
+    std::vector<StoreFile> files;
+    DIR* dir = ::opendir(directory.c_str());
+    if (!dir) return files;
+    while (struct dirent* entry = ::readdir(dir)) {
+        const char* name = entry->d_name;
+        bool segment = std::strncmp(name, "seg-", 4) == 0;
+        bool day = std::strncmp(name, "day-", 4) == 0;
+        if ((!segment && !day) || !endsWith(name, ".mcs")) continue;
+
+        StoreFile file;
+        file.path = directory + "/" + name;
+        file.compacted = day;
+        file.startMs = std::strtoll(name + 4, nullptr, 10);
+        files.push_back(std::move(file));
+    }
+    ::closedir(dir);
+
+    std::sort(files.begin(), files.end(),
+              [](const StoreFile& a, const StoreFile& b) { return a.startMs < b.startMs; });
+
+    if (withBounds) {
+        for (StoreFile& file : files) {
+            MappedFile map(file.path);
+            uint32_t seriesCount;
+            size_t headerBytes = parseFileHeader(map.data(), map.size(), seriesCount);
+            file.firstMs = std::numeric_limits<int64_t>::max();
+            file.lastMs = std::numeric_limits<int64_t>::min();
+            if (headerBytes == 0) continue;
+            walkBlocks(map.data(), map.size(), headerBytes, false, [&](size_t, const BlockHeader& header) {
+                file.firstMs = std::min(file.firstMs, header.firstMs);
+                file.lastMs = std::max(file.lastMs, header.lastMs);
+                return true;
+            });
+        }
+    }
+    return files;
+}
+
+std::string storeFileName(const std::string& directory, const char* prefix, int64_t startMs, const char* suffix) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "/%s-%020" PRId64 "%s", prefix, startMs, suffix);
+    return directory + name;
+}
+
+} // namespace
+
+MetricStore::MetricStore(StoreOptions options) : config(std::move(options)), dropped(0) {
+    if (config.batchSamples == 0) config.batchSamples = 1;
+    if (config.segmentDurationMs <= 0) config.segmentDurationMs = 3600 * 1000;
+    if (config.maxPendingBatches == 0) config.maxPendingBatches = 1;
+}
+
+MetricStore::~MetricStore() {
+    if (writer.joinable()) {
+        flush();
+        {
+            std::lock_guard<std::mutex> lock(batchMutex);
+            stopping = true;
+        }
+        pendingReady.notify_all();
+        writer.join();
+    }
+    sealSegment();
+    if (lockFd >= 0) ::close(lockFd);
+}
+
+bool MetricStore::open() {
+    if (writer.joinable() || config.directory.empty()) return false;
+    if (::mkdir(config.directory.c_str(), 0755) != 0 && errno != EEXIST) return false;
+    struct stat st;
+    if (::stat(config.directory.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) return false;
+
+    // Recovery truncates files, which would break another writer's mapping
+    lockFd = ::open(config.directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (lockFd < 0) return false;
+    if (::flock(lockFd, LOCK_EX | LOCK_NB) != 0) {
+        ::close(lockFd);
+        lockFd = -1;
+        return false;
+    }
+
+    recover();
+    maintain(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+
+    writer = std::thread([this] { writerLoop(); });
+    return true;
+}
+
+void MetricStore::recover() {
+    DIR* dir = ::opendir(config.directory.c_str());
+    if (!dir) return;
+    std::vector<std::string> stale;
+    while (struct dirent* entry = ::readdir(dir)) {
+        std::string name = entry->d_name;
+        if (endsWith(name, ".tmp")) stale.push_back(config.directory + "/" + name);
+    }
+    ::closedir(dir);
+    for (const std::string& path : stale) ::unlink(path.c_str());
+
+    // Cut every file after its last valid block. A reader in another
+    // process may have it mapped, so instead of shrinking the file (which
+    // would SIGBUS that reader) the first invalid block header is zeroed.
+    std::vector<StoreFile> files = listFiles(config.directory, false);
+    for (const StoreFile& file : files) {
+        size_t validEnd = 0;
+        size_t fileSize = 0;
+        {
+            MappedFile map(file.path);
+            fileSize = map.size();
+            uint32_t seriesCount;
+            size_t headerBytes = parseFileHeader(map.data(), map.size(), seriesCount);
+            if (headerBytes > 0) {
+                validEnd = walkBlocks(map.data(), map.size(), headerBytes, true,
+                                      [](size_t, const BlockHeader&) { return true; });
+                if (validEnd == headerBytes) validEnd = 0; // No samples
+            }
+        }
+        if (validEnd == 0) {
+            ::unlink(file.path.c_str());
+        } else if (validEnd < fileSize) {
+            int fd = ::open(file.path.c_str(), O_WRONLY | O_CLOEXEC);
+            if (fd >= 0) {
+                const BlockHeader end{};
+                if (::pwrite(fd, &end, sizeof(end), static_cast<off_t>(validEnd)) == sizeof(end)) ::fsync(fd);
+                ::close(fd);
+            }
+        }
+    }
+
+    // A compaction interrupted after its rename leaves the merged segments
+    // behind; drop the ones a day file already covers
+    files = listFiles(config.directory, true);
+    for (const StoreFile& file : files) {
+        if (file.compacted) continue;
+        for (const StoreFile& day : files) {
+            if (day.compacted && floorDiv(day.firstMs, kDayMs) == floorDiv(file.firstMs, kDayMs) &&
+                day.firstMs <= file.firstMs && day.lastMs >= file.lastMs) {
+                ::unlink(file.path.c_str());
+                break;
+            }
+        }
+    }
+    syncDirectory(config.directory);
+}
+
+void MetricStore::append(const Snapshot& snapshot) {
+    std::lock_guard<std::mutex> lock(batchMutex);
+    if (snapshot.timestampMs <= lastTimestampMs) return;
+
+    if (metrics.update(snapshot) || !layout) {
+        enqueueLocked(); // The open batch keeps the previous layout
+        layout = std::make_shared<const std::vector<std::string>>(metrics.names());
+        current.names = layout;
+    }
+
+    current.timestamps.push_back(snapshot.timestampMs);
+    const std::vector<double>& values = metrics.values();
+    current.values.insert(current.values.end(), values.begin(), values.end());
+    lastTimestampMs = snapshot.timestampMs;
+
+    if (current.timestamps.size() >= config.batchSamples) enqueueLocked();
+}
+
+void MetricStore::enqueueLocked() {
+    if (current.timestamps.empty()) return;
+
+    if (pending.size() >= config.maxPendingBatches) {
+        spare.push_back(std::move(pending.front()));
+        pending.pop_front();
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    pending.push_back(std::move(current));
+
+    current = Batch();
+    if (!spare.empty()) {
+        current = std::move(spare.back());
+        spare.pop_back();
+        current.timestamps.clear();
+        current.values.clear();
+    }
+    current.names = layout;
+    pendingReady.notify_one();
+}
+
+void MetricStore::flush() {
+    std::unique_lock<std::mutex> lock(batchMutex);
+    enqueueLocked();
+    if (!writer.joinable()) return;
+    pendingDone.wait(lock, [this] { return pending.empty() && !writing; });
+}
+
+void MetricStore::writerLoop() {
+    std::unique_lock<std::mutex> lock(batchMutex);
+    for (;;) {
+        pendingReady.wait(lock, [this] { return stopping || !pending.empty(); });
+        if (pending.empty()) break; // Stopping, and drained
+
+        Batch batch = std::move(pending.front());
+        pending.pop_front();
+        writing = true;
+        lock.unlock();
+
+        writeBatch(batch);
+
+        lock.lock();
+        writing = false;
+        if (spare.size() < kSpareBatches) spare.push_back(std::move(batch));
+        pendingDone.notify_all();
+    }
+}
+
+void MetricStore::writeBatch(const Batch& batch) {
+    const size_t samples = batch.timestamps.size();
+    const uint32_t series = static_cast<uint32_t>(batch.names->size());
+    const uint32_t columns = series + 1;
+    const size_t payloadStart = sizeof(BlockHeader);
+
+    // Columns: timestamps, then each series
+    blockScratch.assign(payloadStart + sizeof(uint32_t) * columns, 0);
+    auto endColumn = [&](uint32_t column) {
+        uint32_t end = static_cast<uint32_t>(blockScratch.size() - payloadStart);
+        std::memcpy(blockScratch.data() + payloadStart + sizeof(uint32_t) * column, &end, sizeof(end));
+    };
+    gorilla::encodeTimestamps(batch.timestamps.data(), samples, blockScratch);
+    endColumn(0);
+    columnScratch.resize(samples);
+    for (uint32_t s = 0; s < series; ++s) {
+        for (size_t i = 0; i < samples; ++i) columnScratch[i] = batch.values[i * series + s];
+        gorilla::encodeValues(columnScratch.data(), samples, blockScratch);
+        endColumn(s + 1);
+    }
+
+    BlockHeader header;
+    header.magic = kBlockMagic;
+    header.payloadBytes = static_cast<uint32_t>(blockScratch.size() - payloadStart);
+    header.sampleCount = static_cast<uint32_t>(samples);
+    header.firstMs = batch.timestamps.front();
+    header.lastMs = batch.timestamps.back();
+    blockScratch.resize(payloadStart + align8(header.payloadBytes), 0);
+    header.crc = blockCrc(header, blockScratch.data() + payloadStart);
+    std::memcpy(blockScratch.data(), &header, sizeof(header));
+
+    const size_t blockBytes = blockScratch.size();
+    const int64_t slot = floorDiv(header.firstMs, config.segmentDurationMs);
+    if (active.fd < 0 || active.names != batch.names || active.slot != slot ||
+        active.used + blockBytes + sizeof(BlockHeader) > active.capacity) {
+        sealSegment();
+        maintain(header.lastMs);
+        if (!openSegment(batch, blockBytes)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    // Payload first, header last, then make the block durable
+    uint8_t* target = active.map + active.used;
+    std::memcpy(target + payloadStart, blockScratch.data() + payloadStart, blockBytes - payloadStart);
+    std::memcpy(target, blockScratch.data(), payloadStart);
+    const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t syncStart = active.used & ~(page - 1);
+    ::msync(active.map + syncStart, active.used + blockBytes - syncStart, MS_SYNC);
+    active.used += blockBytes;
+
+    std::lock_guard<std::mutex> lock(activeMutex);
+    activeCommitted = active.used;
+}
+
+bool MetricStore::openSegment(const Batch& batch, size_t blockBytes) {
+    std::vector<uint8_t> header;
+    encodeFileHeader(*batch.names, header);
+
+    // Named after the first sample; bump on collision (clock stepped back)
+    int64_t startMs = batch.timestamps.front();
+    std::string path;
+    int fd = -1;
+    for (int attempt = 0; attempt < 16 && fd < 0; ++attempt, ++startMs) {
+        path = storeFileName(config.directory, "seg", startMs, ".mcs");
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    }
+    if (fd < 0) return false;
+
+    // Room for a zeroed block header after the last block, see sealSegment()
+    size_t capacity = std::max(config.segmentCapacityBytes, header.size() + blockBytes + sizeof(BlockHeader));
+    void* map = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(capacity)) == 0) {
+        map = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (map == MAP_FAILED) {
+        ::close(fd);
+        ::unlink(path.c_str());
+        return false;
+    }
+
+    std::memcpy(map, header.data(), header.size());
+    ::msync(map, header.size(), MS_SYNC);
+    syncDirectory(config.directory);
+
+    active.path = path;
+    active.names = batch.names;
+    active.fd = fd;
+    active.map = static_cast<uint8_t*>(map);
+    active.capacity = capacity;
+    active.used = header.size();
+    active.slot = floorDiv(batch.timestamps.front(), config.segmentDurationMs);
+
+    std::lock_guard<std::mutex> lock(activeMutex);
+    activePath = path;
+    activeCommitted = active.used;
+    return true;
+}
+
+void MetricStore::sealSegment() {
+    if (active.fd < 0) return;
+
+    ::msync(active.map, active.used, MS_SYNC);
+    ::munmap(active.map, active.capacity);
+    // Give back the unused preallocation, but keep the zeroed header after
+    // the last block: a reader in another process still mapping the old
+    // length reads up to that header and no further, so it never touches
+    // a page past the new end of file
+    if (::ftruncate(active.fd, static_cast<off_t>(active.used + sizeof(BlockHeader))) == 0) ::fsync(active.fd);
+    ::close(active.fd);
+    {
+        std::lock_guard<std::mutex> lock(activeMutex);
+        activePath.clear();
+        activeCommitted = 0;
+    }
+    active = Segment();
+}
+
+void MetricStore::maintain(int64_t nowMs) {
+    std::vector<StoreFile> files = listFiles(config.directory, true);
+
+    // Retention
+    std::vector<StoreFile> kept;
+    {
+        std::unique_lock<std::shared_mutex> lock(filesMutex);
+        for (StoreFile& file : files) {
+            if (file.path != active.path && file.lastMs < nowMs - config.retentionMs) {
+                ::unlink(file.path.c_str());
+            } else {
+                kept.push_back(std::move(file));
+            }
+        }
+    }
+
+    // Merge the segments of each finished UTC day, in runs of equal layout
+    std::vector<std::string> run;
+    std::vector<std::string> runNames;
+    int64_t runDay = 0;
+    auto finishRun = [&] {
+        if (!run.empty()) compactGroup(run);
+        run.clear();
+    };
+    for (const StoreFile& file : kept) {
+        int64_t day = floorDiv(file.firstMs, kDayMs);
+        if (file.compacted || file.path == active.path || (day + 1) * kDayMs > nowMs) {
+            finishRun();
+            continue;
+        }
+
+        std::vector<std::string> names;
+        {
+            MappedFile map(file.path);
+            uint32_t seriesCount;
+            if (parseFileHeader(map.data(), map.size(), seriesCount, &names) == 0) continue;
+        }
+        if (run.empty() || day != runDay || names != runNames) {
+            finishRun();
+            runDay = day;
+            runNames = std::move(names);
+        }
+        run.push_back(file.path);
+    }
+    finishRun();
+}
+
+bool MetricStore::compactGroup(const std::vector<std::string>& paths) {
+    int64_t startMs = 0;
+    {
+        MappedFile first(paths.front());
+        uint32_t seriesCount;
+        size_t headerBytes = parseFileHeader(first.data(), first.size(), seriesCount);
+        if (headerBytes == 0) return false;
+        walkBlocks(first.data(), first.size(), headerBytes, false, [&](size_t, const BlockHeader& header) {
+            startMs = header.firstMs;
+            return false;
+        });
+    }
+
+    std::string finalPath = storeFileName(config.directory, "day", startMs, ".mcs");
+    std::string tmpPath = storeFileName(config.directory, "day", startMs, ".tmp");
+    if (::access(finalPath.c_str(), F_OK) == 0) return false;
+
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    // Blocks are self-contained, so merging is a copy of the valid ranges
+    bool ok = true;
+    for (size_t i = 0; i < paths.size() && ok; ++i) {
+        MappedFile map(paths[i]);
+        uint32_t seriesCount;
+        size_t headerBytes = parseFileHeader(map.data(), map.size(), seriesCount);
+        if (headerBytes == 0) continue;
+        if (i == 0) ok = writeAll(fd, map.data(), headerBytes);
+        size_t end = walkBlocks(map.data(), map.size(), headerBytes, true,
+                                [](size_t, const BlockHeader&) { return true; });
+        if (ok) ok = writeAll(fd, map.data() + headerBytes, end - headerBytes);
+    }
+    ok = ok && ::fsync(fd) == 0;
+    ::close(fd);
+    if (!ok) {
+        ::unlink(tmpPath.c_str());
+        return false;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(filesMutex);
+    if (::rename(tmpPath.c_str(), finalPath.c_str()) != 0) {
+        ::unlink(tmpPath.c_str());
+        return false;
+    }
+    syncDirectory(config.directory);
+    for (const std::string& path : paths) ::unlink(path.c_str());
+    syncDirectory(config.directory);
+    return true;
+}
+
+bool MetricStore::query(const std::string& series, int64_t fromMs, int64_t toMs,
+                        std::vector<StorePoint>& out) const {
+    out.clear();
+    if (fromMs > toMs) return false;
+
+    std::shared_lock<std::shared_mutex> filesLock(filesMutex);
+    std::string openPath;
+    size_t committed = 0;
+    {
+        std::lock_guard<std::mutex> lock(activeMutex);
+        openPath = activePath;
+        committed = activeCommitted;
+    }
+
+    bool found = false;
+    std::vector<int64_t> timestamps;
+    std::vector<double> values;
+    for (const StoreFile& file : listFiles(config.directory, false)) {
+        if (file.startMs > toMs) break;
+
+        // Bytes past the committed length of the open segment may be
+        // mid-write. Another process cannot know that length, so every block
+        // that is decoded is checked against its CRC first; a torn one can
+        // only be the last.
+        MappedFile map(file.path, file.path == openPath ? committed : std::numeric_limits<size_t>::max());
+        uint32_t seriesCount = 0;
+        size_t headerBytes = parseFileHeader(map.data(), map.size(), seriesCount);
+        if (headerBytes == 0) continue;
+        long index = findSeries(map.data(), headerBytes, seriesCount, series);
+        if (index < 0) continue;
+        found = true;
+
+        const uint32_t columns = seriesCount + 1;
+        walkBlocks(map.data(), map.size(), headerBytes, false, [&](size_t offset, const BlockHeader& header) {
+            if (header.lastMs < fromMs) return true;
+            if (header.firstMs > toMs) return false;
+
+            const uint8_t* payload = map.data() + offset + sizeof(BlockHeader);
+            if (blockCrc(header, payload) != header.crc) return false;
+            size_t tsBegin, tsEnd, valueBegin, valueEnd;
+            if (!columnRange(payload, header, columns, 0, tsBegin, tsEnd) ||
+                !columnRange(payload, header, columns, static_cast<uint32_t>(index) + 1, valueBegin, valueEnd)) {
+                return true;
+            }
+            timestamps.resize(header.sampleCount);
+            values.resize(header.sampleCount);
+            if (!gorilla::decodeTimestamps(payload + tsBegin, tsEnd - tsBegin, header.sampleCount, timestamps.data()) ||
+                !gorilla::decodeValues(payload + valueBegin, valueEnd - valueBegin, header.sampleCount, values.data())) {
+                return true;
+            }
+            for (uint32_t i = 0; i < header.sampleCount; ++i) {
+                if (timestamps[i] >= fromMs && timestamps[i] <= toMs) out.push_back({timestamps[i], values[i]});
+            }
+            return true;
+        });
+    }
+    return found;
+}
+
+std::vector<std::string> MetricStore::seriesNames() const {
+    std::lock_guard<std::mutex> lock(batchMutex);
+    return layout ? *layout : std::vector<std::string>();
+}
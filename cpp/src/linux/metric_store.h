@@ -0,0 +1,153 @@
+#pragma once
+
+#include "../../include/system_monitor.h"
+#include "../snapshot_metrics.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// On-disk, compressed store of the SnapshotMetrics series for long
+// retention (weeks of 1 s samples in a few hundred MB).
+//
+// Layout of the store directory:
+//   seg-<startMs>.mcs  one file per segmentDurationMs (an hour by default),
+//                      appended through a shared mapping
+//   day-<startMs>.mcs  sealed segments of a finished UTC day, merged
+//   *.tmp              an interrupted compaction, removed on open
+//
+// Every file starts with a header naming its series, followed by blocks.
+// A block holds one batch of samples in columns: timestamps as
+// delta-of-delta, then one XOR-compressed column per series (see
+// gorilla_codec.h). All integers use host byte order.
+//
+//   FileHeader   magic "MCSTORE1", version, seriesCount, headerBytes, crc
+//                then seriesCount x (u16 length, name bytes), padded to 8
+//   BlockHeader  magic, payloadBytes, sampleCount, crc, firstMs, lastMs
+//                then payload: u32 columnEnd[1 + seriesCount], columns
+//
+// The block CRC covers its header and payload. Opening the store zeroes
+// the first invalid block header of each file, so a crash loses at most
+// the batch that was being written. Files are never shrunk below what a
+// reader may have mapped: a sealed segment keeps one zeroed block header
+// after its last block, and readers stop there.
+//
+// append() runs on the sampler thread and only copies values into the
+// current batch; compression, writes, msync and maintenance (rotation,
+// compaction, retention) happen on a background writer thread.
+struct StoreOptions {
+    std::string directory;
+    size_t batchSamples = 60;                          // Samples per block, one msync each
+    int64_t segmentDurationMs = 3600 * 1000;           // Rotation period
+    int64_t retentionMs = 14 * 24 * 3600 * 1000LL;     // Files older than this are deleted
+    size_t segmentCapacityBytes = size_t(64) << 20;    // Sparse preallocation per segment
+    size_t maxPendingBatches = 8;                      // Oldest batch dropped beyond this
+};
+
+struct StorePoint {
+    int64_t timestampMs;
+    double value;
+};
+
+class MetricStore {
+public:
+    explicit MetricStore(StoreOptions options);
+    ~MetricStore(); // Flushes the current batch
+
+    MetricStore(const MetricStore&) = delete;
+    MetricStore& operator=(const MetricStore&) = delete;
+
+    // Creates the directory if needed, takes its writer lock, recovers
+    // existing files and starts the writer thread. False if the directory
+    // is unusable or another process is writing to it.
+    bool open();
+
+    // Adds one sample. Snapshots not newer than the previous sample are
+    // ignored. Never blocks on I/O.
+    void append(const Snapshot& snapshot);
+
+    // Hands the partial batch to the writer and waits until it is durable
+    void flush();
+
+    // Samples of `series` with timestamps in [fromMs, toMs], oldest first.
+    // Only the blocks overlapping the range are decoded, and only the
+    // requested column of each. Replaces `out`; false if no file has the series.
+    // Does not need open(), so another process can read a live store.
+    bool query(const std::string& series, int64_t fromMs, int64_t toMs, std::vector<StorePoint>& out) const;
+
+    // Series names of the current layout
+    std::vector<std::string> seriesNames() const;
+
+    // Batches dropped because the writer fell behind or could not open a
+    // segment for them
+    uint64_t droppedBatches() const { return dropped.load(std::memory_order_relaxed); }
+
+    const StoreOptions& options() const { return config; }
+
+private:
+    using Names = std::shared_ptr<const std::vector<std::string>>;
+
+    struct Batch {
+        Names names;
+        std::vector<int64_t> timestamps;
+        std::vector<double> values; // Row-major, names->size() per sample
+    };
+
+    struct Segment {
+        std::string path;
+        Names names;
+        int fd = -1;
+        uint8_t* map = nullptr;
+        size_t capacity = 0;
+        size_t used = 0;
+        int64_t slot = 0; // startMs / segmentDurationMs
+    };
+
+    StoreOptions config;
+
+    // Sampler side, guarded by batchMutex
+    mutable std::mutex batchMutex;
+    SnapshotMetrics metrics;
+    Names layout;
+    Batch current;
+    int64_t lastTimestampMs = 0;
+    std::vector<Batch> spare; // Recycled batch buffers
+
+    // Handoff to the writer, guarded by batchMutex
+    std::deque<Batch> pending;
+    std::condition_variable pendingReady;
+    std::condition_variable pendingDone;
+    bool writing = false;
+    bool stopping = false;
+    std::atomic<uint64_t> dropped;
+
+    // Writer thread state
+    std::thread writer;
+    int lockFd = -1; // flock on the directory
+    Segment active;
+    std::vector<uint8_t> blockScratch;
+    std::vector<double> columnScratch;
+
+    // Readers see the active segment up to its committed length. Compaction
+    // swaps files under the exclusive lock.
+    mutable std::mutex activeMutex;
+    std::string activePath;
+    size_t activeCommitted = 0;
+    mutable std::shared_mutex filesMutex;
+
+    void enqueueLocked();
+    void writerLoop();
+    void writeBatch(const Batch& batch);
+    bool openSegment(const Batch& batch, size_t blockBytes);
+    void sealSegment();
+    void recover();
+    void maintain(int64_t nowMs);
+    bool compactGroup(const std::vector<std::string>& paths);
+};
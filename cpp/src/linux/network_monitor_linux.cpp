@@ -0,0 +1,353 @@
+#include "../network_monitor.h"
+#include <linux/inet_diag.h>
+#include <linux/netlink.h>
+#include <linux/sock_diag.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+// A socket dump visits every socket, so per-state counts are refreshed
+// less often than the sockstat totals
+constexpr std::chrono::seconds kStateInterval(5);
+constexpr size_t kDiagBufferSize = 64 * 1024;
+
+constexpr double kBytesPerMB = 1024.0 * 1024.0;
+
+// Kernel TCP states (include/net/tcp_states.h)
+enum TcpState {
+    kEstablished = 1,
+    kSynSent,
+    kSynRecv,
+    kFinWait1,
+    kFinWait2,
+    kTimeWait,
+    kClose,
+    kCloseWait,
+    kLastAck,
+    kListen,
+    kClosing,
+    kNewSynRecv,
+    kStateCount
+};
+
+uint64_t delta(uint64_t current, uint64_t previous) {
+    return current >= previous ? current - previous : 0;
+}
+
+// Returns the value following `label` on the line that starts with
+// `prefix`, e.g. ("TCP:", "inuse") in /proc/net/sockstat
+int sockstatValue(const ProcFile& file, const char* prefix, const char* label) {
+    const char* p = file.begin();
+    const char* end = file.end();
+    size_t labelLength = std::strlen(label);
+    for (; p < end; p = procfs::nextLine(p, end)) {
+        if (!procfs::startsWith(p, end, prefix)) continue;
+        const char* q = procfs::skipToken(p, end);
+        while (q < end && *q != '\n') {
+            const char* token = procfs::skipSpaces(q, end);
+            const char* tokenEnd = procfs::skipToken(token, end);
+            uint64_t value = 0;
+            const char* next = procfs::parseU64(tokenEnd, end, value);
+            if (static_cast<size_t>(tokenEnd - token) == labelLength &&
+                std::memcmp(token, label, labelLength) == 0) {
+                return static_cast<int>(value);
+            }
+            if (next == tokenEnd) break;
+            q = next;
+        }
+        return 0;
+    }
+    return 0;
+}
+}
+
+NetworkMonitor::NetworkMonitor() : initialized(false), diagSocket(-1), diagSequence(0), diagQueries(0) {}
+
+NetworkMonitor::~NetworkMonitor() {
+    if (diagSocket >= 0) ::close(diagSocket);
+}
+
+bool NetworkMonitor::initialize() {
+    if (!netDevFile.open((root + "/proc/net/dev").c_str())) {
+        return false;
+    }
+    // Socket counts are optional; IPv6 may be disabled
+    sockstatFile.open((root + "/proc/net/sockstat").c_str());
+    sockstat6File.open((root + "/proc/net/sockstat6").c_str());
+
+    if (root.empty()) {
+        diagSocket = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+        if (diagSocket >= 0) {
+            diagBuffer.resize(kDiagBufferSize);
+            diagQueries = 0xf; // TCP and UDP over IPv4 and IPv6, until one is refused
+        }
+    }
+
+    initialized = true;
+    return true;
+}
+
+// Parses /proc/net/dev into currentCounters. Returns false if the
+// interface list differs from info.interfaces.
+//
+//   name: rx bytes packets errs drop fifo frame compressed multicast
+//         tx bytes packets errs drop fifo colls carrier compressed
+bool NetworkMonitor::readInterfaces() {
+    const char* p = netDevFile.begin();
+    const char* end = netDevFile.end();
+    p = procfs::nextLine(p, end);
+    p = procfs::nextLine(p, end);
+
+    size_t index = 0;
+    bool sameLayout = true;
+    while (p < end) {
+        const char* name = procfs::skipSpaces(p, end);
+        const char* colon = name;
+        while (colon < end && *colon != ':' && *colon != '\n') ++colon;
+        if (colon >= end || *colon != ':') break;
+
+        uint64_t fields[12] = {};
+        const char* q = colon + 1;
+        for (uint64_t& field : fields) {
+            q = procfs::parseU64(q, end, field);
+        }
+
+        if (index == currentCounters.size()) currentCounters.emplace_back();
+        InterfaceCounters& counters = currentCounters[index];
+        counters.rxBytes = fields[0];
+        counters.rxPackets = fields[1];
+        counters.rxErrors = fields[2];
+        counters.rxDropped = fields[3];
+        counters.txBytes = fields[8];
+        counters.txPackets = fields[9];
+        counters.txErrors = fields[10];
+        counters.txDropped = fields[11];
+
+        size_t nameLength = static_cast<size_t>(colon - name);
+        if (index >= info.interfaces.size() || info.interfaces[index].name.size() != nameLength ||
+            std::memcmp(info.interfaces[index].name.data(), name, nameLength) != 0) {
+            sameLayout = false;
+        }
+        ++index;
+        p = procfs::nextLine(q, end);
+    }
+
+    currentCounters.resize(index);
+    return sameLayout && index == info.interfaces.size();
+}
+
+// An interface was added or removed: rebuild info.interfaces, keeping the
+// counters of interfaces that are still present so their rates continue
+void NetworkMonitor::rebuildInterfaces() {
+    std::vector<InterfaceInfo> rebuilt;
+    std::vector<InterfaceCounters> previous;
+    rebuilt.reserve(currentCounters.size());
+    previous.reserve(currentCounters.size());
+
+    const char* p = netDevFile.begin();
+    const char* end = netDevFile.end();
+    p = procfs::nextLine(p, end);
+    p = procfs::nextLine(p, end);
+    while (p < end && rebuilt.size() < currentCounters.size()) {
+        const char* name = procfs::skipSpaces(p, end);
+        const char* colon = name;
+        while (colon < end && *colon != ':' && *colon != '\n') ++colon;
+        if (colon >= end || *colon != ':') break;
+
+        InterfaceInfo iface;
+        iface.name.assign(name, colon);
+        InterfaceCounters carried = currentCounters[rebuilt.size()]; // New: no rate until its second sample
+        for (size_t i = 0; i < info.interfaces.size(); ++i) {
+            if (info.interfaces[i].name == iface.name) {
+                iface = info.interfaces[i];
+                carried = lastCounters[i];
+                break;
+            }
+        }
+        rebuilt.push_back(std::move(iface));
+        previous.push_back(carried);
+        p = procfs::nextLine(colon, end);
+    }
+
+    info.interfaces = std::move(rebuilt);
+    lastCounters = std::move(previous);
+    currentCounters.resize(info.interfaces.size());
+}
+
+void NetworkMonitor::readSockstat() {
+    SocketStats& sockets = info.sockets;
+    if (sockstatFile.isOpen() && sockstatFile.read()) {
+        // "TCP: inuse N orphan N tw N alloc N mem N"; tw and orphan cover both families
+        sockets.tcp = sockstatValue(sockstatFile, "TCP:", "inuse");
+        sockets.tcpOrphan = sockstatValue(sockstatFile, "TCP:", "orphan");
+        sockets.tcpTimeWait = sockstatValue(sockstatFile, "TCP:", "tw");
+        sockets.udp = sockstatValue(sockstatFile, "UDP:", "inuse");
+    }
+    if (sockstat6File.isOpen() && sockstat6File.read()) {
+        sockets.tcp += sockstatValue(sockstat6File, "TCP6:", "inuse");
+        sockets.udp += sockstatValue(sockstat6File, "UDP6:", "inuse");
+    }
+}
+
+// Dumps the sockets of one family/protocol in `stateMask` through
+// NETLINK_SOCK_DIAG and adds them to counts[state]. No extensions are
+// requested, so each socket costs one small fixed-size message. Returns 0,
+// or a negative errno: the kernel's answer (-ENOENT when it has no diag
+// handler for the protocol) or that of the failed send or receive.
+int NetworkMonitor::countStates(uint8_t family, uint8_t protocol, uint32_t stateMask, int* counts) {
+    struct {
+        nlmsghdr header;
+        inet_diag_req_v2 request;
+    } message;
+    std::memset(&message, 0, sizeof(message));
+    message.header.nlmsg_len = sizeof(message);
+    message.header.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    message.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    message.header.nlmsg_seq = ++diagSequence;
+    message.request.sdiag_family = family;
+    message.request.sdiag_protocol = protocol;
+    message.request.idiag_states = stateMask;
+
+    sockaddr_nl kernel;
+    std::memset(&kernel, 0, sizeof(kernel));
+    kernel.nl_family = AF_NETLINK;
+    if (::sendto(diagSocket, &message, sizeof(message), 0, reinterpret_cast<sockaddr*>(&kernel),
+                 sizeof(kernel)) < 0) {
+        return -errno;
+    }
+
+    for (;;) {
+        ssize_t n = ::recv(diagSocket, diagBuffer.data(), diagBuffer.size(), 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -errno;
+        }
+        if (n == 0) return -EIO;
+
+        int remaining = static_cast<int>(n);
+        for (auto* header = reinterpret_cast<nlmsghdr*>(diagBuffer.data()); NLMSG_OK(header, remaining);
+             header = NLMSG_NEXT(header, remaining)) {
+            if (header->nlmsg_seq != diagSequence) continue; // Left over from an aborted dump
+            if (header->nlmsg_type == NLMSG_DONE) return 0;
+            if (header->nlmsg_type == NLMSG_ERROR) {
+                const auto* error = static_cast<const nlmsgerr*>(NLMSG_DATA(header));
+                return error->error < 0 ? error->error : -EIO;
+            }
+            if (header->nlmsg_type != SOCK_DIAG_BY_FAMILY) continue;
+
+            const auto* socket = static_cast<const inet_diag_msg*>(NLMSG_DATA(header));
+            if (socket->idiag_state < kStateCount) ++counts[socket->idiag_state];
+        }
+    }
+}
+
+void NetworkMonitor::updateSocketStates() {
+    // TIME_WAIT comes from sockstat; dumping it would dominate the cost on
+    // busy servers. Request sockets (NEW_SYN_RECV) are counted as SYN_RECV.
+    uint32_t tcpStates = ((1u << kStateCount) - 1) & ~(1u << kTimeWait);
+    uint32_t udpStates = 1u << kEstablished;
+
+    int tcp[kStateCount] = {};
+    int udp[kStateCount] = {};
+    struct Query {
+        uint8_t family;
+        uint8_t protocol;
+        uint32_t states;
+        int* counts;
+    };
+    const Query queries[] = {{AF_INET, IPPROTO_TCP, tcpStates, tcp},
+                             {AF_INET6, IPPROTO_TCP, tcpStates, tcp},
+                             {AF_INET, IPPROTO_UDP, udpStates, udp},
+                             {AF_INET6, IPPROTO_UDP, udpStates, udp}};
+    bool tcpFailed = false;
+    bool udpFailed = false;
+    for (size_t i = 0; i < 4; ++i) {
+        if (!(diagQueries & (1u << i))) continue;
+        int result = countStates(queries[i].family, queries[i].protocol, queries[i].states, queries[i].counts);
+        if (result == 0) continue;
+        // A family or protocol without a diag handler (IPv6 disabled, no
+        // udp_diag) is not asked again; the others still are
+        if (result == -ENOENT || result == -EOPNOTSUPP || result == -EAFNOSUPPORT) diagQueries &= ~(1u << i);
+        (queries[i].protocol == IPPROTO_TCP ? tcpFailed : udpFailed) = true;
+    }
+    if (diagQueries == 0) {
+        ::close(diagSocket);
+        diagSocket = -1;
+    }
+    // A partial dump would undercount; report nothing rather than stale or
+    // low figures
+    if (tcpFailed) std::fill(tcp, tcp + kStateCount, 0);
+    if (udpFailed) std::fill(udp, udp + kStateCount, 0);
+
+    SocketStats& sockets = info.sockets;
+    sockets.established = tcp[kEstablished];
+    sockets.synSent = tcp[kSynSent];
+    sockets.synRecv = tcp[kSynRecv] + tcp[kNewSynRecv];
+    sockets.finWait1 = tcp[kFinWait1];
+    sockets.finWait2 = tcp[kFinWait2];
+    sockets.closeWait = tcp[kCloseWait];
+    sockets.lastAck = tcp[kLastAck];
+    sockets.listen = tcp[kListen];
+    sockets.closing = tcp[kClosing];
+    sockets.closed = tcp[kClose];
+    sockets.udpConnected = udp[kEstablished];
+}
+
+void NetworkMonitor::update() {
+    if (!initialized) return;
+    if (!netDevFile.read()) return;
+
+    auto currentTime = procfs::now();
+    if (!readInterfaces()) rebuildInterfaces();
+
+    double timeDeltaSeconds = std::chrono::duration<double>(currentTime - lastUpdateTime).count();
+    bool haveInterval = lastUpdateTime.time_since_epoch().count() != 0 && timeDeltaSeconds > 0.0;
+
+    double download = 0.0;
+    double upload = 0.0;
+    for (size_t i = 0; i < info.interfaces.size(); ++i) {
+        const InterfaceCounters& current = currentCounters[i];
+        const InterfaceCounters& last = lastCounters[i];
+        InterfaceInfo& iface = info.interfaces[i];
+
+        iface.rxErrors = current.rxErrors;
+        iface.txErrors = current.txErrors;
+        iface.rxDropped = current.rxDropped;
+        iface.txDropped = current.txDropped;
+        if (!haveInterval) continue;
+
+        // Calculate speed in MB/s
+        iface.downloadSpeed = delta(current.rxBytes, last.rxBytes) / kBytesPerMB / timeDeltaSeconds;
+        iface.uploadSpeed = delta(current.txBytes, last.txBytes) / kBytesPerMB / timeDeltaSeconds;
+        iface.rxPackets = delta(current.rxPackets, last.rxPackets) / timeDeltaSeconds;
+        iface.txPackets = delta(current.txPackets, last.txPackets) / timeDeltaSeconds;
+
+        // Loopback traffic stays on the host
+        if (iface.name != "lo") {
+            download += iface.downloadSpeed;
+            upload += iface.uploadSpeed;
+        }
+    }
+    if (haveInterval) {
+        info.downloadSpeed = download;
+        info.uploadSpeed = upload;
+    }
+    lastCounters.swap(currentCounters);
+    lastUpdateTime = currentTime;
+
+    readSockstat();
+    if (diagSocket >= 0 && (lastStateTime.time_since_epoch().count() == 0 ||
+                            currentTime - lastStateTime >= kStateInterval)) {
+        updateSocketStates();
+        lastStateTime = currentTime;
+    }
+    info.activeConnections = info.sockets.tcp;
+}
+
+NetworkInfo NetworkMonitor::getInfo() const {
+    return info;
+}
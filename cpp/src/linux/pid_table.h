@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Open-addressing hash map keyed by PID with linear probing. Storage is one
+// flat array sized to a power of two; PID 0 marks an empty slot. Erase uses
+// backward-shift deletion, so there are no tombstones and the table never
+// degrades under churn. Capacity follows the peak number of live PIDs and is
+// never shrunk, which keeps memory flat once the host reaches steady state.
+template <typename Value>
+class PidTable {
+public:
+    struct Slot {
+        int pid = 0;
+        Value value{};
+    };
+
+    explicit PidTable(size_t initialCapacity = 1024) {
+        size_t capacity = 16;
+        while (capacity < initialCapacity) capacity <<= 1;
+        slots.resize(capacity);
+    }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return slots.size(); }
+
+    Value* find(int pid) {
+        size_t mask = slots.size() - 1;
+        for (size_t i = hash(pid) & mask;; i = (i + 1) & mask) {
+            if (slots[i].pid == pid) return &slots[i].value;
+            if (slots[i].pid == 0) return nullptr;
+        }
+    }
+
+    // Returns the value for `pid`, default-constructing it if absent.
+    // `inserted` reports whether a new entry was created.
+    Value& findOrInsert(int pid, bool& inserted) {
+        if ((count + 1) * 2 > slots.size()) grow();
+        size_t mask = slots.size() - 1;
+        for (size_t i = hash(pid) & mask;; i = (i + 1) & mask) {
+            if (slots[i].pid == pid) {
+                inserted = false;
+                return slots[i].value;
+            }
+            if (slots[i].pid == 0) {
+                slots[i].pid = pid;
+                slots[i].value = Value{};
+                ++count;
+                inserted = true;
+                return slots[i].value;
+            }
+        }
+    }
+
+    void erase(int pid) {
+        size_t mask = slots.size() - 1;
+        size_t i = hash(pid) & mask;
+        while (slots[i].pid != pid) {
+            if (slots[i].pid == 0) return;
+            i = (i + 1) & mask;
+        }
+
+        // Backward-shift: pull later members of the probe run into the hole
+        // when the hole lies between their home slot and where they sit.
+        size_t hole = i;
+        for (size_t j = (hole + 1) & mask; slots[j].pid != 0; j = (j + 1) & mask) {
+            size_t home = hash(slots[j].pid) & mask;
+            bool movable = (hole <= j) ? (home <= hole || home > j)
+                                       : (home <= hole && home > j);
+            if (movable) {
+                slots[hole] = slots[j];
+                hole = j;
+            }
+        }
+        slots[hole].pid = 0;
+        --count;
+    }
+
+    // Removes every entry for which `stale(pid, value)` is true.
+    // `scratch` is caller-owned so the sweep does not allocate.
+    template <typename Predicate>
+    void eraseIf(Predicate stale, std::vector<int>& scratch) {
+        scratch.clear();
+        for (const Slot& slot : slots) {
+            if (slot.pid != 0 && stale(slot.pid, slot.value)) scratch.push_back(slot.pid);
+        }
+        for (int pid : scratch) erase(pid);
+    }
+
+    template <typename Fn>
+    void forEach(Fn fn) {
+        for (Slot& slot : slots) {
+            if (slot.pid != 0) fn(slot.pid, slot.value);
+        }
+    }
+
+private:
+    std::vector<Slot> slots;
+    size_t count = 0;
+
+    static size_t hash(int pid) {
+        // Fibonacci hashing spreads sequential PIDs across the table
+        return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(pid)) * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+
+    void grow() {
+        std::vector<Slot> old;
+        old.swap(slots);
+        slots.resize(old.size() * 2);
+        count = 0;
+        bool inserted = false;
+        for (const Slot& slot : old) {
+            if (slot.pid != 0) findOrInsert(slot.pid, inserted) = slot.value;
+        }
+    }
+};
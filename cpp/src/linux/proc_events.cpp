@@ -0,0 +1,207 @@
+#include "proc_events.h"
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+constexpr int kAckTimeoutMs = 1000;
+constexpr int kReceiveBufferBytes = 4 * 1024 * 1024;
+constexpr size_t kDatagramBytes = 16 * 1024;
+}
+
+ProcEventListener::ProcEventListener(size_t maxPending)
+    : maxPending(maxPending), running(false), spawnedCount(0), exitedCount(0) {}
+
+ProcEventListener::~ProcEventListener() {
+    stop();
+}
+
+bool ProcEventListener::subscribe(bool listen) {
+    // nlmsghdr, then cn_msg whose payload is the multicast op
+    constexpr size_t kPayload = sizeof(cn_msg) + sizeof(proc_cn_mcast_op);
+    alignas(nlmsghdr) char buffer[NLMSG_SPACE(kPayload)];
+    std::memset(buffer, 0, sizeof(buffer));
+
+    auto* header = reinterpret_cast<nlmsghdr*>(buffer);
+    header->nlmsg_len = NLMSG_LENGTH(kPayload);
+    header->nlmsg_type = NLMSG_DONE;
+    header->nlmsg_pid = static_cast<uint32_t>(::getpid());
+
+    auto* message = static_cast<cn_msg*>(NLMSG_DATA(header));
+    message->id.idx = CN_IDX_PROC;
+    message->id.val = CN_VAL_PROC;
+    message->len = sizeof(proc_cn_mcast_op);
+    proc_cn_mcast_op op = listen ? PROC_CN_MCAST_LISTEN : PROC_CN_MCAST_IGNORE;
+    std::memcpy(message->data, &op, sizeof(op));
+
+    return ::send(socketFd, buffer, header->nlmsg_len, 0) == static_cast<ssize_t>(header->nlmsg_len);
+}
+
+bool ProcEventListener::start() {
+    if (running.load()) return true;
+
+    socketFd = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (socketFd < 0) return false;
+
+    // Bursts of forks (builds, test runners) outpace a default-sized buffer
+    int bufferBytes = kReceiveBufferBytes;
+    if (::setsockopt(socketFd, SOL_SOCKET, SO_RCVBUFFORCE, &bufferBytes, sizeof(bufferBytes)) != 0) {
+        ::setsockopt(socketFd, SOL_SOCKET, SO_RCVBUF, &bufferBytes, sizeof(bufferBytes));
+    }
+
+    sockaddr_nl address;
+    std::memset(&address, 0, sizeof(address));
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = CN_IDX_PROC;
+    address.nl_pid = 0; // Let the kernel pick a unique port id
+    bool ok = ::bind(socketFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0 && subscribe(true);
+
+    // The kernel answers the subscription with a PROC_EVENT_NONE ack that
+    // carries the error (EPERM without CAP_NET_ADMIN). Events may already
+    // be interleaved with it, so keep them.
+    int ackError = -1;
+    std::vector<char> datagram(kDatagramBytes);
+    while (ok && ackError < 0) {
+        pollfd readable = {socketFd, POLLIN, 0};
+        int ready = ::poll(&readable, 1, kAckTimeoutMs);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) {
+            ok = false;
+            break;
+        }
+        ssize_t n = ::recv(socketFd, datagram.data(), datagram.size(), 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ok = false;
+            break;
+        }
+        ackError = handle(datagram.data(), static_cast<size_t>(n));
+    }
+    if (ok && ackError != 0) ok = false;
+
+    if (ok) {
+        wakeFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        ok = wakeFd >= 0;
+    }
+    if (!ok) {
+        ::close(socketFd);
+        socketFd = -1;
+        spawnedCount.store(0);
+        exitedCount.store(0);
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        pending.clear();
+        return false;
+    }
+
+    running.store(true);
+    loop = std::thread(&ProcEventListener::run, this);
+    return true;
+}
+
+void ProcEventListener::stop() {
+    if (running.exchange(false)) {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+        if (loop.joinable()) loop.join();
+        subscribe(false);
+    }
+    if (socketFd >= 0) {
+        ::close(socketFd);
+        socketFd = -1;
+    }
+    if (wakeFd >= 0) {
+        ::close(wakeFd);
+        wakeFd = -1;
+    }
+}
+
+bool ProcEventListener::drain(std::vector<ProcEvent>& out) {
+    out.clear();
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    out.swap(pending);
+    bool complete = !lost;
+    lost = false;
+    return complete;
+}
+
+int ProcEventListener::handle(const char* data, size_t length) {
+    int ackError = -1;
+    int remaining = static_cast<int>(length);
+    for (auto* header = reinterpret_cast<const nlmsghdr*>(data); NLMSG_OK(header, remaining);
+         header = NLMSG_NEXT(header, remaining)) {
+        if (header->nlmsg_type == NLMSG_ERROR || header->nlmsg_type == NLMSG_NOOP) continue;
+
+        const auto* message = static_cast<const cn_msg*>(NLMSG_DATA(header));
+        if (message->id.idx != CN_IDX_PROC || message->id.val != CN_VAL_PROC) continue;
+        if (message->len < sizeof(proc_event) - sizeof(proc_event::event_data)) continue;
+        const auto* event = reinterpret_cast<const proc_event*>(message->data);
+
+        ProcEvent queued;
+        switch (event->what) {
+        case proc_event::PROC_EVENT_NONE:
+            ackError = static_cast<int>(event->event_data.ack.err);
+            continue;
+        case proc_event::PROC_EVENT_FORK:
+            // Threads are cloned too; only a new thread group is a process
+            if (event->event_data.fork.child_pid != event->event_data.fork.child_tgid) continue;
+            queued = {ProcEvent::Fork, event->event_data.fork.child_tgid};
+            spawnedCount.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case proc_event::PROC_EVENT_EXEC:
+            queued = {ProcEvent::Exec, event->event_data.exec.process_tgid};
+            break;
+        case proc_event::PROC_EVENT_EXIT:
+            if (event->event_data.exit.process_pid != event->event_data.exit.process_tgid) continue;
+            queued = {ProcEvent::Exit, event->event_data.exit.process_tgid};
+            exitedCount.fetch_add(1, std::memory_order_relaxed);
+            break;
+        default:
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        if (pending.size() < maxPending) {
+            pending.push_back(queued);
+        } else {
+            lost = true;
+        }
+    }
+    return ackError;
+}
+
+void ProcEventListener::run() {
+    std::vector<char> datagram(kDatagramBytes);
+    pollfd fds[2] = {{socketFd, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+    while (running.load(std::memory_order_relaxed)) {
+        int ready = ::poll(fds, 2, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents & POLLIN) break;
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        // Drain everything that is queued before polling again
+        for (;;) {
+            ssize_t n = ::recv(socketFd, datagram.data(), datagram.size(), MSG_DONTWAIT);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == ENOBUFS) {
+                    // The kernel dropped events for this socket
+                    std::lock_guard<std::mutex> lock(pendingMutex);
+                    lost = true;
+                    continue;
+                }
+                break;
+            }
+            handle(datagram.data(), static_cast<size_t>(n));
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Process lifecycle events from the kernel's netlink process connector
+// (NETLINK_CONNECTOR / CN_IDX_PROC). Only processes are reported: thread
+// creation and thread exit are filtered out.
+struct ProcEvent {
+    enum Type : uint8_t { Fork, Exec, Exit };
+    Type type;
+    int pid;
+};
+
+// Subscribes to the process connector and queues events on its own thread
+// so that bursts between two samples are not lost in the socket buffer.
+// Subscribing needs CAP_NET_ADMIN in the initial network namespace; start()
+// returns false otherwise and the caller falls back to scanning /proc.
+class ProcEventListener {
+public:
+    explicit ProcEventListener(size_t maxPending = 65536);
+    ~ProcEventListener();
+
+    ProcEventListener(const ProcEventListener&) = delete;
+    ProcEventListener& operator=(const ProcEventListener&) = delete;
+
+    // Subscribes and waits for the kernel to acknowledge, so a refused
+    // subscription is reported here rather than as silence later
+    bool start();
+    void stop();
+
+    // Moves the events queued since the last call into `out` (cleared
+    // first). Returns false if events were lost since the last call, either
+    // because the socket buffer or the queue overflowed; the caller must then
+    // resynchronise from /proc.
+    bool drain(std::vector<ProcEvent>& out);
+
+    // Totals since start(), exact as long as no events were lost
+    uint64_t spawned() const { return spawnedCount.load(std::memory_order_relaxed); }
+    uint64_t exited() const { return exitedCount.load(std::memory_order_relaxed); }
+
+private:
+    size_t maxPending;
+    int socketFd = -1;
+    int wakeFd = -1; // eventfd: stop() is pending
+    std::thread loop;
+    std::atomic<bool> running;
+
+    std::mutex pendingMutex;
+    std::vector<ProcEvent> pending;
+    bool lost = false;
+
+    std::atomic<uint64_t> spawnedCount;
+    std::atomic<uint64_t> exitedCount;
+
+    bool subscribe(bool listen);
+    void run();
+    // Parses one datagram; returns the acknowledgement error for a
+    // subscription ack, or -1 if there was none
+    int handle(const char* data, size_t length);
+};
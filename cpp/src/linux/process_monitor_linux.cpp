@@ -0,0 +1,470 @@
+#include "../process_monitor.h"
+#include "procfs.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+constexpr size_t kDefaultTopCapacity = 32;
+// Full /proc listings in event mode, to repair anything the events missed
+constexpr std::chrono::seconds kReconcileInterval(30);
+// Files per io_uring batch, and the most of a stat line that is read
+constexpr unsigned kBatchSize = 256;
+constexpr size_t kStatBufferSize = 1024;
+constexpr size_t kDetailFileLimit = 64 * 1024;
+constexpr size_t kCmdlineLimit = 4096;
+constexpr double kBytesPerMB = 1024.0 * 1024.0;
+// Fields that cost a file read per process, on top of /proc/<pid>/stat
+constexpr uint32_t kDetailFields = kProcessUid | kProcessContextSwitches | kProcessFds | kProcessIo |
+                                   kProcessPss | kProcessCmdline;
+
+// Ranks by CPU usage, then by resident memory so that idle hosts still show
+// the largest processes
+bool ranksHigher(double cpuA, double memA, double cpuB, double memB) {
+    if (cpuA != cpuB) return cpuA > cpuB;
+    return memA > memB;
+}
+
+// Value after "key" on the first line that starts with it ("Uid:\t0\t0...")
+uint64_t lineValue(const char* p, const char* end, const char* key) {
+    size_t keyLength = std::strlen(key);
+    for (; p < end; p = procfs::nextLine(p, end)) {
+        if (!procfs::startsWith(p, end, key)) continue;
+        uint64_t value = 0;
+        const char* q = p + keyLength;
+        while (q < end && (*q == ' ' || *q == '\t')) ++q;
+        procfs::parseU64(q, end, value);
+        return value;
+    }
+    return 0;
+}
+
+int64_t steadyNanoseconds(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+}
+
+ProcessMonitor::ProcessMonitor()
+    : initialized(false), procFd(-1), generation(0), topCapacity(kDefaultTopCapacity),
+      ticksPerSecond(100.0), pageSizeMB(4096.0 / (1024.0 * 1024.0)), batchedReads(false), readSyscalls(0),
+      eventTracking(true), lastSpawned(0), lastExited(0) {}
+
+ProcessMonitor::~ProcessMonitor() {
+    if (events) events->stop();
+    if (procFd >= 0) {
+        close(procFd);
+    }
+}
+
+bool ProcessMonitor::initialize() {
+    procFd = open((root + "/proc").c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (procFd < 0) return false;
+
+    long ticks = sysconf(_SC_CLK_TCK);
+    if (ticks > 0) ticksPerSecond = static_cast<double>(ticks);
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if (pageSize > 0) pageSizeMB = pageSize / (1024.0 * 1024.0);
+
+    if (batchedReads) {
+        uring = std::make_unique<UringReader>();
+        if (!uring->initialize(kBatchSize, kStatBufferSize)) uring.reset();
+    }
+
+    if (eventTracking && root.empty()) {
+        // Unprivileged or in a container: keep scanning
+        events = std::make_unique<ProcEventListener>();
+        if (!events->start()) events.reset();
+    }
+
+    lastUpdateTime = procfs::now();
+    initialized = true;
+    return true;
+}
+
+bool ProcessMonitor::readStat(int pid, Candidate& out, uint64_t& startTime, uint64_t& cpuTicks) {
+    char path[32];
+    snprintf(path, sizeof(path), "%d/stat", pid);
+    int fd = openat(procFd, path, O_RDONLY | O_CLOEXEC);
+    ++readSyscalls;
+    if (fd < 0) return false; // exited between readdir and open
+
+    char buffer[kStatBufferSize];
+    ssize_t n = read(fd, buffer, sizeof(buffer));
+    close(fd);
+    readSyscalls += 2;
+    if (n <= 0) return false;
+    return parseStat(buffer, static_cast<size_t>(n), pid, out, startTime, cpuTicks);
+}
+
+template <typename Sampled, typename Missing>
+void ProcessMonitor::readStats(Sampled sampled, Missing missing) {
+    size_t next = 0;
+    while (uring && next < batchPids.size()) {
+        unsigned count = static_cast<unsigned>(std::min<size_t>(uring->capacity(), batchPids.size() - next));
+        for (unsigned i = 0; i < count; ++i) {
+            char path[32];
+            snprintf(path, sizeof(path), "%d/stat", batchPids[next + i]);
+            uring->add(i, procFd, path);
+        }
+        uint64_t enters = uring->enterCount();
+        bool submitted = uring->submit(count);
+        readSyscalls += uring->enterCount() - enters;
+        if (!submitted) {
+            uring.reset(); // Read the rest, and from now on everything, synchronously
+            break;
+        }
+        for (unsigned i = 0; i < count; ++i) {
+            int pid = batchPids[next + i];
+            int length = uring->result(i);
+            Candidate candidate;
+            uint64_t startTime = 0;
+            uint64_t cpuTicks = 0;
+            if (length > 0 && parseStat(uring->data(i), static_cast<size_t>(length), pid, candidate,
+                                        startTime, cpuTicks)) {
+                sampled(pid, candidate, startTime, cpuTicks);
+            } else {
+                missing(pid);
+            }
+        }
+        next += count;
+    }
+
+    for (; next < batchPids.size(); ++next) {
+        int pid = batchPids[next];
+        Candidate candidate;
+        uint64_t startTime = 0;
+        uint64_t cpuTicks = 0;
+        if (readStat(pid, candidate, startTime, cpuTicks)) {
+            sampled(pid, candidate, startTime, cpuTicks);
+        } else {
+            missing(pid);
+        }
+    }
+}
+
+// Parses /proc/[pid]/stat. The comm field is parenthesised and may itself
+// contain spaces or ')', so numeric fields are located from the last ')'.
+bool ProcessMonitor::parseStat(const char* buffer, size_t n, int pid, Candidate& out,
+                               uint64_t& startTime, uint64_t& cpuTicks) {
+    const char* end = buffer + n;
+    const char* nameOpen = static_cast<const char*>(memchr(buffer, '(', n));
+    const char* nameClose = end;
+    while (nameClose > buffer && *(nameClose - 1) != ')') --nameClose;
+    if (!nameOpen || nameClose <= nameOpen + 1) return false;
+
+    size_t nameLength = static_cast<size_t>(nameClose - 1 - (nameOpen + 1));
+    if (nameLength >= sizeof(out.name)) nameLength = sizeof(out.name) - 1;
+    memcpy(out.name, nameOpen + 1, nameLength);
+    out.name[nameLength] = '\0';
+    out.pid = pid;
+
+    // Field 3 (state) follows ")"; utime/stime are fields 14/15,
+    // num_threads is 20, starttime is 22 and rss (pages) is 24.
+    const char* p = procfs::skipSpaces(nameClose, end);
+    out.state = p < end ? *p : '?';
+    p = procfs::skipToken(p, end);
+    uint64_t fields[21] = {};      // fields 4..24
+    for (int i = 0; i < 21; ++i) {
+        p = procfs::skipSpaces(p, end);
+        if (p < end && *p == '-') { // ppid/pgrp/tty may be -1
+            p = procfs::skipToken(p, end);
+            continue;
+        }
+        p = procfs::parseU64(p, end, fields[i]);
+    }
+
+    cpuTicks = fields[14 - 4] + fields[15 - 4];
+    out.threads = static_cast<int>(fields[20 - 4]);
+    startTime = fields[22 - 4];
+    out.memoryUsage = fields[24 - 4] * pageSizeMB;
+    out.cpuUsage = 0.0;
+    return true;
+}
+
+// Computes CPU usage against the previous sample of the same process and
+// records the new baseline
+void ProcessMonitor::account(Candidate& candidate, PidState& state, bool inserted, uint64_t startTime,
+                             uint64_t cpuTicks, double elapsedTicks) {
+    if (!inserted && state.startTime == startTime && cpuTicks >= state.cpuTicks && elapsedTicks > 0.0) {
+        candidate.cpuUsage = (cpuTicks - state.cpuTicks) / elapsedTicks * 100.0;
+    }
+    // A new PID, or a reused one (different start time), has no baseline yet
+    if (state.startTime != startTime) state.detailTime = 0;
+    state.startTime = startTime;
+    state.cpuTicks = cpuTicks;
+    state.generation = generation;
+    candidates.push_back(candidate);
+}
+
+// Lists /proc and samples every process, rebuilding the PID set
+void ProcessMonitor::scanAll(double elapsedTicks, uint64_t& appeared, uint64_t& vanished) {
+    batchPids.clear();
+    procfs::forEachEntry(procFd, direntBuffer, [&](const char* name, unsigned char) {
+        if (name[0] < '1' || name[0] > '9') return;
+        int pid = 0;
+        const char* c = name;
+        for (; *c >= '0' && *c <= '9'; ++c) pid = pid * 10 + (*c - '0');
+        if (*c == '\0') batchPids.push_back(pid);
+    });
+
+    readStats(
+        [&](int pid, Candidate& candidate, uint64_t startTime, uint64_t cpuTicks) {
+            bool inserted = false;
+            PidState& state = pidStates.findOrInsert(pid, inserted);
+            // A PID forked since the last scan but not yet sampled has no start time
+            if (inserted || (state.startTime != 0 && state.startTime != startTime)) ++appeared;
+            account(candidate, state, inserted, startTime, cpuTicks, elapsedTicks);
+        },
+        [](int) {}); // Exited between the listing and the read
+
+    // Drop PIDs that were not seen in this scan
+    uint32_t current = generation;
+    size_t before = pidStates.size();
+    pidStates.eraseIf([current](int, const PidState& state) { return state.generation != current; },
+                      staleScratch);
+    vanished += before - pidStates.size();
+}
+
+// Samples only the PIDs known from events, without listing /proc
+void ProcessMonitor::sampleTracked(double elapsedTicks) {
+    batchPids.clear();
+    pidStates.forEach([&](int pid, PidState&) { batchPids.push_back(pid); });
+
+    staleScratch.clear();
+    readStats(
+        [&](int pid, Candidate& candidate, uint64_t startTime, uint64_t cpuTicks) {
+            PidState* state = pidStates.find(pid);
+            account(candidate, *state, state->startTime == 0, startTime, cpuTicks, elapsedTicks);
+        },
+        [&](int pid) { staleScratch.push_back(pid); }); // Exit event still in flight
+    for (int pid : staleScratch) pidStates.erase(pid);
+}
+
+bool ProcessMonitor::readPidFile(int pid, const char* file, size_t& length) {
+    char path[48];
+    snprintf(path, sizeof(path), "%d/%s", pid, file);
+    int fd = openat(procFd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    if (detailBuffer.size() < 4096) detailBuffer.resize(4096);
+    length = 0;
+    for (;;) {
+        if (length == detailBuffer.size()) {
+            if (detailBuffer.size() >= kDetailFileLimit) break;
+            detailBuffer.resize(detailBuffer.size() * 2);
+        }
+        ssize_t n = read(fd, detailBuffer.data() + length, detailBuffer.size() - length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        length += static_cast<size_t>(n);
+    }
+    close(fd);
+    return length > 0;
+}
+
+void ProcessMonitor::collectDetails(ProcessInfo& proc, int64_t now) {
+    PidState* state = pidStates.find(proc.pid);
+    double seconds = state && state->detailTime > 0 && now > state->detailTime
+                         ? (now - state->detailTime) / 1e9 : 0.0;
+    size_t length = 0;
+    const char* begin = detailBuffer.data();
+
+    if ((fields & (kProcessUid | kProcessContextSwitches)) && readPidFile(proc.pid, "status", length)) {
+        begin = detailBuffer.data();
+        const char* end = begin + length;
+        if (fields & kProcessUid) {
+            proc.uid = static_cast<int>(lineValue(begin, end, "Uid:")); // Real UID
+            proc.fields |= kProcessUid;
+        }
+        if (fields & kProcessContextSwitches) {
+            uint64_t voluntary = lineValue(begin, end, "voluntary_ctxt_switches:");
+            uint64_t involuntary = lineValue(begin, end, "nonvoluntary_ctxt_switches:");
+            if (state) {
+                if (seconds > 0.0) {
+                    proc.voluntarySwitches = voluntary >= state->voluntarySwitches
+                                                 ? (voluntary - state->voluntarySwitches) / seconds : 0.0;
+                    proc.involuntarySwitches = involuntary >= state->involuntarySwitches
+                                                   ? (involuntary - state->involuntarySwitches) / seconds : 0.0;
+                }
+                state->voluntarySwitches = voluntary;
+                state->involuntarySwitches = involuntary;
+            }
+            proc.fields |= kProcessContextSwitches;
+        }
+    }
+
+    if (fields & kProcessFds) {
+        char path[32];
+        snprintf(path, sizeof(path), "%d/fd", proc.pid);
+        int fd = openat(procFd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd >= 0) {
+            int count = 0;
+            if (procfs::forEachEntry(fd, direntBuffer, [&](const char* name, unsigned char) {
+                    if (name[0] != '.') ++count;
+                })) {
+                proc.fdCount = count;
+                proc.fields |= kProcessFds;
+            }
+            close(fd);
+        }
+    }
+
+    // read_bytes/write_bytes: what actually reached the storage layer
+    if ((fields & kProcessIo) && readPidFile(proc.pid, "io", length)) {
+        begin = detailBuffer.data();
+        uint64_t readBytes = lineValue(begin, begin + length, "read_bytes:");
+        uint64_t writeBytes = lineValue(begin, begin + length, "write_bytes:");
+        if (state) {
+            if (seconds > 0.0) {
+                proc.ioReadSpeed = readBytes >= state->ioReadBytes
+                                       ? (readBytes - state->ioReadBytes) / kBytesPerMB / seconds : 0.0;
+                proc.ioWriteSpeed = writeBytes >= state->ioWriteBytes
+                                        ? (writeBytes - state->ioWriteBytes) / kBytesPerMB / seconds : 0.0;
+            }
+            state->ioReadBytes = readBytes;
+            state->ioWriteBytes = writeBytes;
+        }
+        proc.fields |= kProcessIo;
+    }
+
+    // smaps_rollup walks every mapping of the process in the kernel
+    if ((fields & kProcessPss) && readPidFile(proc.pid, "smaps_rollup", length)) {
+        begin = detailBuffer.data();
+        proc.pss = lineValue(begin, begin + length, "Pss:") / 1024.0;
+        proc.swap = lineValue(begin, begin + length, "Swap:") / 1024.0;
+        proc.fields |= kProcessPss;
+    }
+
+    // Arguments are NUL separated; kernel threads have none
+    if ((fields & kProcessCmdline) && readPidFile(proc.pid, "cmdline", length)) {
+        if (length > kCmdlineLimit) length = kCmdlineLimit;
+        while (length > 0 && detailBuffer[length - 1] == '\0') --length;
+        proc.cmdline.assign(detailBuffer.data(), length);
+        std::replace(proc.cmdline.begin(), proc.cmdline.end(), '\0', ' ');
+        proc.fields |= kProcessCmdline;
+    }
+
+    if (state && (fields & (kProcessContextSwitches | kProcessIo))) state->detailTime = now;
+}
+
+void ProcessMonitor::setFields(uint32_t requested) {
+    std::lock_guard<std::mutex> lock(configMutex);
+    requestedFields = requested & kProcessAllFields;
+}
+
+void ProcessMonitor::setWatched(const std::vector<int>& pids) {
+    std::lock_guard<std::mutex> lock(configMutex);
+    requestedWatched = pids;
+}
+
+void ProcessMonitor::update() {
+    if (!initialized) return;
+
+    {
+        std::lock_guard<std::mutex> lock(configMutex);
+        fields = requestedFields;
+        watchedPids = requestedWatched; // Same-size copy once steady
+    }
+
+    auto now = procfs::now();
+    double elapsedTicks = std::chrono::duration<double>(now - lastUpdateTime).count() * ticksPerSecond;
+    lastUpdateTime = now;
+
+    ++generation;
+    candidates.clear();
+
+    bool reconcile = true;
+    if (events) {
+        // Apply the PID changes since the last sample. A process that was
+        // forked and has already exited never reaches the table, but is
+        // still counted.
+        bool complete = events->drain(eventScratch);
+        for (const ProcEvent& event : eventScratch) {
+            if (event.type == ProcEvent::Fork) {
+                bool inserted = false;
+                pidStates.findOrInsert(event.pid, inserted);
+            } else if (event.type == ProcEvent::Exit) {
+                pidStates.erase(event.pid);
+            }
+        }
+        reconcile = !complete || now - lastReconcileTime >= kReconcileInterval;
+    }
+
+    uint64_t appeared = 0;
+    uint64_t vanished = 0;
+    if (reconcile) {
+        scanAll(elapsedTicks, appeared, vanished);
+        lastReconcileTime = now;
+    } else {
+        sampleTracked(elapsedTicks);
+    }
+
+    activity.total = static_cast<int>(pidStates.size());
+    activity.eventDriven = events != nullptr;
+    if (events) {
+        uint64_t spawned = events->spawned();
+        uint64_t exited = events->exited();
+        activity.spawned = spawned - lastSpawned;
+        activity.exited = exited - lastExited;
+        lastSpawned = spawned;
+        lastExited = exited;
+    } else {
+        // The first scan finds every process; that is not activity
+        bool first = generation == 1;
+        activity.spawned = first ? 0 : appeared;
+        activity.exited = first ? 0 : vanished;
+    }
+
+    // Top-K selection: partition around the K-th element, then order only K
+    auto higher = [](const Candidate& a, const Candidate& b) {
+        return ranksHigher(a.cpuUsage, a.memoryUsage, b.cpuUsage, b.memoryUsage);
+    };
+    size_t keep = std::min(topCapacity, candidates.size());
+    if (keep < candidates.size()) {
+        std::nth_element(candidates.begin(), candidates.begin() + keep, candidates.end(), higher);
+    }
+    std::sort(candidates.begin(), candidates.begin() + keep, higher);
+
+    int64_t nowNs = steadyNanoseconds(now);
+    auto fill = [&](ProcessInfo& proc, const Candidate& candidate) {
+        proc.name.assign(candidate.name);
+        proc.pid = candidate.pid;
+        proc.cpuUsage = candidate.cpuUsage;
+        proc.memoryUsage = candidate.memoryUsage;
+        proc.fields = fields & (kProcessThreads | kProcessState);
+        proc.threads = candidate.threads;
+        proc.state = candidate.state;
+        if (fields & kDetailFields) collectDetails(proc, nowNs);
+    };
+
+    processes.resize(keep);
+    for (size_t i = 0; i < keep; ++i) fill(processes[i], candidates[i]);
+
+    // Watched PIDs are few; a linear search of this sample is enough. A
+    // ranked one is copied: collecting its details again in the same tick
+    // would read the files twice and see no time pass for its rates.
+    watched.clear();
+    for (int pid : watchedPids) {
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            if (candidates[i].pid != pid) continue;
+            if (i < keep) {
+                watched.push_back(processes[i]);
+            } else {
+                watched.emplace_back();
+                fill(watched.back(), candidates[i]);
+            }
+            break;
+        }
+    }
+}
+
+std::vector<ProcessInfo> ProcessMonitor::getTopProcesses(int count) const {
+    std::vector<ProcessInfo> result;
+    size_t end = count < 0 ? 0 : static_cast<size_t>(count);
+    if (end > processes.size()) end = processes.size();
+    result.assign(processes.begin(), processes.begin() + end);
+    return result;
+}
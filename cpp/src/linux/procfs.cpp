@@ -0,0 +1,70 @@
+#include "procfs.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+
+namespace {
+constexpr size_t kInitialBufferSize = 4096;
+
+// Pinned steady_clock ticks; 0 when not pinned
+std::atomic<std::chrono::steady_clock::rep> pinnedTime{0};
+}
+
+namespace procfs {
+
+std::chrono::steady_clock::time_point now() {
+    auto pinned = pinnedTime.load(std::memory_order_relaxed);
+    if (pinned == 0) return std::chrono::steady_clock::now();
+    return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(pinned));
+}
+
+void pinNow(std::chrono::steady_clock::time_point time) {
+    pinnedTime.store(time.time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+} // namespace procfs
+
+ProcFile::ProcFile() : fd(-1), length(0) {}
+
+ProcFile::~ProcFile() {
+    close();
+}
+
+bool ProcFile::open(const char* path) {
+    close();
+    fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    if (buffer.empty()) buffer.resize(kInitialBufferSize);
+    length = 0;
+    return true;
+}
+
+void ProcFile::close() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    length = 0;
+}
+
+bool ProcFile::read() {
+    if (fd < 0) return false;
+
+    // procfs generates the content on each read from offset 0, so one pread
+    // returns a consistent view as long as the buffer is large enough.
+    // If it fills up completely, grow and retry.
+    for (;;) {
+        ssize_t n = ::pread(fd, buffer.data(), buffer.size(), 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            length = 0;
+            return false;
+        }
+        if (static_cast<size_t>(n) < buffer.size()) {
+            length = static_cast<size_t>(n);
+            return true;
+        }
+        buffer.resize(buffer.size() * 2);
+    }
+}
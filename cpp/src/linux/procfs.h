@@ -0,0 +1,114 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+// A procfs/sysfs file that stays open for the life of the collector and is
+// re-read from offset 0 with pread() into a buffer that is reused every tick.
+class ProcFile {
+public:
+    ProcFile();
+    ~ProcFile();
+
+    ProcFile(const ProcFile&) = delete;
+    ProcFile& operator=(const ProcFile&) = delete;
+
+    bool open(const char* path);
+    void close();
+    bool isOpen() const { return fd >= 0; }
+
+    // Reads the whole file. The buffer only grows when the file outgrows it,
+    // so steady-state reads do not allocate. Returns false on I/O error.
+    bool read();
+
+    const char* begin() const { return buffer.data(); }
+    const char* end() const { return buffer.data() + length; }
+    size_t size() const { return length; }
+
+private:
+    int fd;
+    std::vector<char> buffer;
+    size_t length;
+};
+
+// Allocation-free scanning helpers for the whitespace separated text that
+// procfs emits. All of them stop at `end` and never read past it.
+namespace procfs {
+
+// The time collectors compute their rates against: steady_clock, unless
+// replay has pinned it to the time a recorded tick was captured (see
+// capture.h), so replayed rates are the original host's however fast the
+// ticks are fed.
+std::chrono::steady_clock::time_point now();
+// Pins now() to `time`; a default-constructed time_point unpins it
+void pinNow(std::chrono::steady_clock::time_point time);
+
+inline const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    return p;
+}
+
+inline const char* skipToken(const char* p, const char* end) {
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\n') ++p;
+    return p;
+}
+
+inline const char* nextLine(const char* p, const char* end) {
+    while (p < end && *p != '\n') ++p;
+    return p < end ? p + 1 : end;
+}
+
+// Parses an unsigned decimal after optional leading blanks. Leaves `out`
+// untouched and returns `p` unchanged if no digit is found.
+inline const char* parseU64(const char* p, const char* end, uint64_t& out) {
+    const char* q = skipSpaces(p, end);
+    if (q >= end || *q < '0' || *q > '9') return p;
+    uint64_t value = 0;
+    while (q < end && *q >= '0' && *q <= '9') {
+        value = value * 10 + static_cast<uint64_t>(*q - '0');
+        ++q;
+    }
+    out = value;
+    return q;
+}
+
+inline bool startsWith(const char* p, const char* end, const char* prefix) {
+    while (*prefix) {
+        if (p >= end || *p != *prefix) return false;
+        ++p;
+        ++prefix;
+    }
+    return true;
+}
+
+// Calls `visit(name, type)` for every entry of the open directory `fd`,
+// from its start, using getdents64 into `buffer` (reused between calls)
+// instead of readdir()'s per-DIR allocation. `type` is d_type, DT_UNKNOWN
+// on filesystems that do not report it. Returns false on a read error.
+template <typename Visit>
+bool forEachEntry(int fd, std::vector<char>& buffer, Visit visit) {
+    if (buffer.size() < 32 * 1024) buffer.resize(32 * 1024);
+    if (::lseek(fd, 0, SEEK_SET) < 0) return false;
+    for (;;) {
+        long n = ::syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+        if (n < 0) return false;
+        if (n == 0) return true;
+        for (long offset = 0; offset < n;) {
+            // struct linux_dirent64: ino, off, reclen, type, name
+            const char* record = buffer.data() + offset;
+            unsigned short length;
+            std::memcpy(&length, record + offsetof(struct dirent64, d_reclen), sizeof(length));
+            unsigned char type = static_cast<unsigned char>(record[offsetof(struct dirent64, d_type)]);
+            visit(record + offsetof(struct dirent64, d_name), type);
+            offset += length;
+        }
+    }
+}
+
+} // namespace procfs
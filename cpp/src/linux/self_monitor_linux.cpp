@@ -0,0 +1,68 @@
+#include "../self_monitor.h"
+#include <sys/resource.h>
+#include <unistd.h>
+
+SelfMonitor::SelfMonitor()
+    : pageSizeMB(4096.0 / (1024.0 * 1024.0)), lastCpuSeconds(0.0), lastSyscalls(0), haveCounters(false) {}
+
+SelfMonitor::~SelfMonitor() = default;
+
+bool SelfMonitor::initialize() {
+    if (!statmFile.open("/proc/self/statm")) return false;
+    ioFile.open("/proc/self/io");
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if (pageSize > 0) pageSizeMB = pageSize / (1024.0 * 1024.0);
+    return true;
+}
+
+void SelfMonitor::readCounters(double& cpuSeconds, uint64_t& syscalls) {
+    rusage usage;
+    cpuSeconds = 0.0;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        cpuSeconds = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+                     (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    }
+
+    // syscr/syscw count read- and write-family calls (read, pread, readv,
+    // write, ...); opens, closes and getdents are not included
+    syscalls = 0;
+    if (!ioFile.isOpen() || !ioFile.read()) return;
+    const char* end = ioFile.end();
+    for (const char* p = ioFile.begin(); p < end; p = procfs::nextLine(p, end)) {
+        if (procfs::startsWith(p, end, "syscr:") || procfs::startsWith(p, end, "syscw:")) {
+            uint64_t value = 0;
+            procfs::parseU64(p + 6, end, value);
+            syscalls += value;
+        }
+    }
+}
+
+void SelfMonitor::update() {
+    // statm: size resident shared text lib data dt, in pages
+    if (statmFile.read()) {
+        const char* end = statmFile.end();
+        const char* p = procfs::skipToken(statmFile.begin(), end);
+        uint64_t resident = 0;
+        procfs::parseU64(p, end, resident);
+        info.rssMB = resident * pageSizeMB;
+    }
+
+    double cpuSeconds;
+    uint64_t syscalls;
+    readCounters(cpuSeconds, syscalls);
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - lastUpdateTime).count();
+    if (haveCounters && elapsed > 0.0) {
+        info.cpuUsage = cpuSeconds > lastCpuSeconds ? 100.0 * (cpuSeconds - lastCpuSeconds) / elapsed : 0.0;
+        info.syscalls = syscalls > lastSyscalls ? (syscalls - lastSyscalls) / elapsed : 0.0;
+    }
+    info.cpuSeconds = cpuSeconds;
+    lastCpuSeconds = cpuSeconds;
+    lastSyscalls = syscalls;
+    lastUpdateTime = now;
+    haveCounters = true;
+}
+
+SelfInfo SelfMonitor::getInfo() const {
+    return info;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Memory layout of the shared snapshot ring, shared by the writer
+// (ShmSnapshotRing) and the C reader library (include/monitor_shm.h).
+//
+//   Header                           one cache line
+//   slot 0 .. slotCount-1            slotStride bytes each:
+//     SlotHeader                     one cache line
+//     payload[slotBytes]             one NDJSON snapshot line (without '\n')
+//
+// The writer fills slots round-robin. Each slot has its own seqlock
+// sequence (odd while the slot is being written), so a reader can copy or
+// use a slot in place and then check that the sequence did not move.
+// `published` counts snapshots; the newest one is in slot
+// (published - 1) % slotCount. `dropped` counts snapshots larger than
+// slotBytes that the writer could not publish: while it grows, readers keep
+// seeing an older snapshot.
+namespace shm_layout {
+
+constexpr char kMagic[8] = {'M', 'C', 'S', 'H', 'M', 'R', 'N', 'G'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kMaxSlots = 256;
+constexpr uint32_t kFormatNDJSON = 1;
+
+struct alignas(64) Header {
+    char magic[8];                     // Written last by the writer on creation
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotBytes;                // Payload capacity of each slot
+    uint32_t format;                   // kFormatNDJSON
+    uint64_t slotStride;
+    uint64_t writerPid;
+    std::atomic<uint64_t> published;
+    std::atomic<uint32_t> futexWord;   // Low 32 bits of published, for waiters
+    std::atomic<uint32_t> waiters;     // Readers blocked in FUTEX_WAIT
+    std::atomic<uint64_t> dropped;     // Snapshots too large for a slot
+};
+
+static_assert(sizeof(Header) == 64, "the header is one cache line");
+
+struct alignas(64) SlotHeader {
+    std::atomic<uint64_t> sequence;    // Even when stable
+    std::atomic<uint64_t> counter;     // Value of `published` for this snapshot
+    std::atomic<uint32_t> length;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared atomics must be lock-free");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared atomics must be lock-free");
+
+inline uint64_t slotStride(uint32_t slotBytes) {
+    return (sizeof(SlotHeader) + slotBytes + 63) & ~uint64_t(63);
+}
+
+inline size_t mappingSize(uint32_t slotCount, uint32_t slotBytes) {
+    return sizeof(Header) + static_cast<size_t>(slotCount) * slotStride(slotBytes);
+}
+
+} // namespace shm_layout
@@ -0,0 +1,177 @@
+#include "monitor_shm.h"
+#include "shm_layout.h"
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+
+struct mc_shm_reader {
+    shm_layout::Header* header;
+    size_t mappedBytes;
+    bool writable; // Needed to register as a futex waiter
+};
+
+namespace {
+
+constexpr int kMaxRetries = 1000;
+
+shm_layout::SlotHeader* slotAt(const mc_shm_reader* reader, uint64_t index) {
+    uint8_t* base = reinterpret_cast<uint8_t*>(reader->header) + sizeof(shm_layout::Header);
+    return reinterpret_cast<shm_layout::SlotHeader*>(base + index * reader->header->slotStride);
+}
+
+const char* payloadOf(shm_layout::SlotHeader* slot) {
+    return reinterpret_cast<const char*>(slot) + sizeof(shm_layout::SlotHeader);
+}
+
+} // namespace
+
+extern "C" {
+
+mc_shm_reader* mc_shm_open(const char* name) {
+    if (!name) return nullptr;
+    bool writable = true;
+    int fd = ::shm_open(name, O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) {
+        writable = false;
+        fd = ::shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    }
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(shm_layout::Header)) {
+        ::close(fd);
+        return nullptr;
+    }
+    size_t bytes = static_cast<size_t>(st.st_size);
+    int protection = PROT_READ | (writable ? PROT_WRITE : 0);
+    void* map = ::mmap(nullptr, bytes, protection, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) return nullptr;
+
+    auto* header = static_cast<shm_layout::Header*>(map);
+    bool valid = std::memcmp(header->magic, shm_layout::kMagic, sizeof(header->magic)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    valid = valid && header->version == shm_layout::kVersion && header->format == shm_layout::kFormatNDJSON &&
+            header->slotCount > 0 && header->slotCount <= shm_layout::kMaxSlots &&
+            header->slotStride == shm_layout::slotStride(header->slotBytes) &&
+            shm_layout::mappingSize(header->slotCount, header->slotBytes) <= bytes;
+    if (!valid) {
+        ::munmap(map, bytes);
+        return nullptr;
+    }
+
+    return new mc_shm_reader{header, bytes, writable};
+}
+
+void mc_shm_close(mc_shm_reader* reader) {
+    if (!reader) return;
+    ::munmap(reader->header, reader->mappedBytes);
+    delete reader;
+}
+
+uint64_t mc_shm_published(const mc_shm_reader* reader) {
+    return reader->header->published.load(std::memory_order_acquire);
+}
+
+uint64_t mc_shm_dropped(const mc_shm_reader* reader) {
+    return reader->header->dropped.load(std::memory_order_relaxed);
+}
+
+int64_t mc_shm_writer_pid(const mc_shm_reader* reader) {
+    return static_cast<int64_t>(reader->header->writerPid);
+}
+
+int64_t mc_shm_read_latest(mc_shm_reader* reader, char* buffer, size_t capacity, uint64_t* counter) {
+    const shm_layout::Header* header = reader->header;
+    for (int attempt = 0; attempt < kMaxRetries; ++attempt) {
+        uint64_t published = header->published.load(std::memory_order_acquire);
+        if (published == 0) return 0;
+
+        shm_layout::SlotHeader* slot = slotAt(reader, (published - 1) % header->slotCount);
+        uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        if (sequence & 1) continue;
+        uint32_t length = slot->length.load(std::memory_order_relaxed);
+        uint64_t slotCounter = slot->counter.load(std::memory_order_relaxed);
+        if (length > header->slotBytes) continue;
+        if (length > capacity) return -static_cast<int64_t>(length);
+
+        std::memcpy(buffer, payloadOf(slot), length);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->sequence.load(std::memory_order_relaxed) != sequence) continue;
+
+        if (counter) *counter = slotCounter;
+        return static_cast<int64_t>(length);
+    }
+    return 0;
+}
+
+int mc_shm_peek_latest(mc_shm_reader* reader, const char** data, size_t* length, uint64_t* token) {
+    const shm_layout::Header* header = reader->header;
+    for (int attempt = 0; attempt < kMaxRetries; ++attempt) {
+        uint64_t published = header->published.load(std::memory_order_acquire);
+        if (published == 0) return 0;
+
+        uint64_t index = (published - 1) % header->slotCount;
+        shm_layout::SlotHeader* slot = slotAt(reader, index);
+        uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        if (sequence & 1) continue;
+        uint32_t slotLength = slot->length.load(std::memory_order_relaxed);
+        if (slotLength > header->slotBytes) continue;
+
+        *data = payloadOf(slot);
+        *length = slotLength;
+        *token = (sequence << 8) | index; // kMaxSlots fits in the low byte
+        return 1;
+    }
+    return 0;
+}
+
+int mc_shm_validate(const mc_shm_reader* reader, uint64_t token) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    shm_layout::SlotHeader* slot = slotAt(reader, token & 0xFF);
+    return slot->sequence.load(std::memory_order_relaxed) == (token >> 8) ? 1 : 0;
+}
+
+int mc_shm_wait(mc_shm_reader* reader, uint64_t after, int timeout_ms) {
+    using Clock = std::chrono::steady_clock;
+    shm_layout::Header* header = reader->header;
+    const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeout_ms < 0 ? 0 : timeout_ms);
+
+    for (;;) {
+        if (header->published.load(std::memory_order_acquire) > after) return 1;
+
+        Clock::duration remaining = deadline - Clock::now();
+        if (timeout_ms >= 0 && remaining <= Clock::duration::zero()) return 0;
+
+        if (!reader->writable) {
+            // Read-only mapping: cannot register as a waiter, so poll
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+
+        header->waiters.fetch_add(1, std::memory_order_seq_cst);
+        uint32_t expected = header->futexWord.load(std::memory_order_seq_cst);
+        if (header->published.load(std::memory_order_seq_cst) <= after) {
+            struct timespec timeout;
+            struct timespec* timeoutPtr = nullptr;
+            if (timeout_ms >= 0) {
+                auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count();
+                timeout.tv_sec = static_cast<time_t>(ns / 1000000000);
+                timeout.tv_nsec = static_cast<long>(ns % 1000000000);
+                timeoutPtr = &timeout;
+            }
+            ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&header->futexWord), FUTEX_WAIT, expected,
+                      timeoutPtr, nullptr, 0);
+        }
+        header->waiters.fetch_sub(1, std::memory_order_seq_cst);
+    }
+}
+
+} // extern "C"
@@ -0,0 +1,92 @@
+#include "shm_ring.h"
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+ShmSnapshotRing::~ShmSnapshotRing() {
+    if (!header) return;
+    ::munmap(header, mappedBytes);
+    ::shm_unlink(segmentName.c_str());
+}
+
+bool ShmSnapshotRing::create(const std::string& name, uint32_t slotCount, uint32_t slotBytes) {
+    if (header || name.empty() || slotCount == 0 || slotCount > shm_layout::kMaxSlots || slotBytes == 0) {
+        return false;
+    }
+
+    // A segment left by a writer that crashed is unlinked and recreated;
+    // readers still mapping it keep their stale view until they reattach
+    ::shm_unlink(name.c_str());
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    size_t bytes = shm_layout::mappingSize(slotCount, slotBytes);
+    void* map = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(bytes)) == 0) {
+        map = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        ::shm_unlink(name.c_str());
+        return false;
+    }
+
+    // The object starts zeroed, so every slot sequence is already even
+    auto* h = static_cast<shm_layout::Header*>(map);
+    h->version = shm_layout::kVersion;
+    h->slotCount = slotCount;
+    h->slotBytes = slotBytes;
+    h->format = shm_layout::kFormatNDJSON;
+    h->slotStride = shm_layout::slotStride(slotBytes);
+    h->writerPid = static_cast<uint64_t>(::getpid());
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(h->magic, shm_layout::kMagic, sizeof(h->magic));
+
+    segmentName = name;
+    header = h;
+    mappedBytes = bytes;
+    return true;
+}
+
+bool ShmSnapshotRing::publish(std::string_view snapshot) {
+    if (!header) return false;
+    if (snapshot.size() > header->slotBytes) {
+        header->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    uint64_t counter = header->published.load(std::memory_order_relaxed) + 1;
+    uint8_t* base = reinterpret_cast<uint8_t*>(header) + sizeof(shm_layout::Header);
+    uint8_t* slotBase = base + ((counter - 1) % header->slotCount) * header->slotStride;
+    auto* slot = reinterpret_cast<shm_layout::SlotHeader*>(slotBase);
+
+    uint64_t sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::memcpy(slotBase + sizeof(shm_layout::SlotHeader), snapshot.data(), snapshot.size());
+    slot->length.store(static_cast<uint32_t>(snapshot.size()), std::memory_order_relaxed);
+    slot->counter.store(counter, std::memory_order_relaxed);
+
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+    header->published.store(counter, std::memory_order_release);
+    header->futexWord.store(static_cast<uint32_t>(counter), std::memory_order_seq_cst);
+
+    if (header->waiters.load(std::memory_order_seq_cst) != 0) {
+        ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&header->futexWord), FUTEX_WAKE, INT_MAX,
+                  nullptr, nullptr, 0);
+    }
+    return true;
+}
+
+uint64_t ShmSnapshotRing::published() const {
+    return header ? header->published.load(std::memory_order_relaxed) : 0;
+}
+
+uint64_t ShmSnapshotRing::dropped() const {
+    return header ? header->dropped.load(std::memory_order_relaxed) : 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "shm_layout.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Writer side of the shared-memory snapshot ring (layout in shm_layout.h).
+// `monitor --shm NAME` publishes every output tick here so that any number
+// of local consumers (include/monitor_shm.h, python/monitor_shm.py) can
+// share one sampler. Readers never make a syscall to read; the writer makes
+// one futex wake per publish, and only while some reader is blocked waiting.
+class ShmSnapshotRing {
+public:
+    static constexpr uint32_t kDefaultSlotBytes = 256 * 1024;
+
+    ShmSnapshotRing() = default;
+    ~ShmSnapshotRing(); // Unlinks the segment
+
+    ShmSnapshotRing(const ShmSnapshotRing&) = delete;
+    ShmSnapshotRing& operator=(const ShmSnapshotRing&) = delete;
+
+    // Creates (or takes over a stale) POSIX shared-memory object `name`,
+    // e.g. "/monitor_core"
+    bool create(const std::string& name, uint32_t slotCount = 8, uint32_t slotBytes = kDefaultSlotBytes);
+
+    // Copies one snapshot into the next slot. False, and counted in the
+    // header's `dropped` for readers to see, if it does not fit.
+    bool publish(std::string_view snapshot);
+
+    uint64_t published() const;
+    uint64_t dropped() const;
+    uint32_t slotBytes() const { return header ? header->slotBytes : 0; }
+
+private:
+    std::string segmentName;
+    shm_layout::Header* header = nullptr;
+    size_t mappedBytes = 0;
+};
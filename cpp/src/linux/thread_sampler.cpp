@@ -0,0 +1,338 @@
+#include "thread_sampler.h"
+#include "procfs.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+namespace {
+constexpr int64_t kNanosPerSecond = 1000000000;
+constexpr int64_t kDiscoveryIntervalNs = 100000000; // Re-list task directories every 100 ms
+constexpr unsigned kMaxRate = 1000;
+constexpr size_t kMaxRingRecords = size_t(1) << 20;
+
+int64_t clockNs(clockid_t clock) {
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * kNanosPerSecond + ts.tv_nsec;
+}
+
+uint32_t saturate32(uint64_t value) {
+    return value > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(value);
+}
+
+uint16_t saturate16(uint64_t value) {
+    return value > UINT16_MAX ? UINT16_MAX : static_cast<uint16_t>(value);
+}
+
+// Nearest-rank percentile of ascending `values`
+double percentile(const std::vector<double>& values, double q) {
+    if (values.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(std::ceil(q * values.size()));
+    return values[rank > 0 ? rank - 1 : 0];
+}
+
+unsigned clampRate(unsigned rate) {
+    return std::min(std::max(rate, 1u), kMaxRate);
+}
+
+// Two seconds of records at the full rate for every thread slot
+size_t ringRecords(const ThreadSamplerOptions& options) {
+    size_t records = static_cast<size_t>(clampRate(options.rateHz)) * std::max<size_t>(options.maxThreads, 1) * 2;
+    return std::min(records, kMaxRingRecords);
+}
+}
+
+ThreadSampler::ThreadSampler(ThreadSamplerOptions options)
+    : config(std::move(options)), periodNs(kNanosPerSecond / clampRate(config.rateHz)),
+      ring(ringRecords(config)), running(false), ticks(0), missed(0), dropped(0), cpuTimeNs(0),
+      pinned(false) {}
+
+ThreadSampler::~ThreadSampler() {
+    stop();
+    for (Slot& slot : slots) releaseSlot(slot);
+    for (const Task& task : tasks) close(task.fd);
+}
+
+bool ThreadSampler::start() {
+    if (thread.joinable()) return false;
+
+    for (int pid : config.pids) {
+        char path[256];
+        snprintf(path, sizeof(path), "%s/proc/%d/task", config.root.c_str(), pid);
+        int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd >= 0) tasks.push_back({pid, fd});
+    }
+    if (tasks.empty()) return false;
+
+    // Everything the sampler thread touches is sized here
+    slots.assign(std::max<size_t>(config.maxThreads, 1), Slot());
+    direntBuffer.resize(64 * 1024);
+    discover();
+
+    lastCollectTime = clockNs(CLOCK_MONOTONIC);
+    running.store(true);
+    thread = std::thread([this] { run(); });
+    return true;
+}
+
+void ThreadSampler::stop() {
+    running.store(false);
+    if (thread.joinable()) thread.join();
+}
+
+void ThreadSampler::pin() {
+    pthread_setname_np(pthread_self(), "thread-sampler");
+
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+    int cpu = config.cpu;
+    for (int i = CPU_SETSIZE - 1; cpu < 0 && i >= 0; --i) {
+        if (CPU_ISSET(i, &allowed)) cpu = i;
+    }
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pinned.store(pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0);
+}
+
+void ThreadSampler::run() {
+    pin();
+
+    int64_t next = clockNs(CLOCK_MONOTONIC) + periodNs;
+    int64_t nextDiscovery = next + kDiscoveryIntervalNs;
+    while (running.load(std::memory_order_relaxed)) {
+        timespec deadline = {static_cast<time_t>(next / kNanosPerSecond), static_cast<long>(next % kNanosPerSecond)};
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {}
+        if (!running.load(std::memory_order_relaxed)) break;
+
+        int64_t now = clockNs(CLOCK_MONOTONIC);
+        if (now >= nextDiscovery) {
+            discover();
+            nextDiscovery = now + kDiscoveryIntervalNs;
+        }
+        for (Slot& slot : slots) {
+            if (slot.tid != 0) sampleSlot(slot, now);
+        }
+        ticks.fetch_add(1, std::memory_order_relaxed);
+        cpuTimeNs.store(static_cast<uint64_t>(clockNs(CLOCK_THREAD_CPUTIME_ID)), std::memory_order_relaxed);
+
+        // Stay on the grid; ticks that an overrun (or a stall) passed by are
+        // skipped rather than run back to back
+        next += periodNs;
+        int64_t after = clockNs(CLOCK_MONOTONIC);
+        if (after >= next) {
+            int64_t behind = (after - next) / periodNs + 1;
+            missed.fetch_add(static_cast<uint64_t>(behind), std::memory_order_relaxed);
+            next += behind * periodNs;
+        }
+    }
+}
+
+// Matches the task directories against the slots: new threads get a free
+// slot and a baseline sample, threads that are gone release theirs
+void ThreadSampler::discover() {
+    for (Slot& slot : slots) slot.seen = false;
+    int64_t now = clockNs(CLOCK_MONOTONIC);
+
+    for (const Task& task : tasks) {
+        procfs::forEachEntry(task.fd, direntBuffer, [&](const char* name, unsigned char) {
+            if (name[0] < '1' || name[0] > '9') return;
+            int tid = 0;
+            for (const char* c = name; *c >= '0' && *c <= '9'; ++c) tid = tid * 10 + (*c - '0');
+
+            Slot* freeSlot = nullptr;
+            for (Slot& slot : slots) {
+                if (slot.tid == tid) {
+                    slot.seen = true;
+                    return;
+                }
+                if (!freeSlot && slot.tid == 0) freeSlot = &slot;
+            }
+            if (!freeSlot) return; // maxThreads reached
+
+            Slot& slot = *freeSlot;
+            char path[32];
+            snprintf(path, sizeof(path), "%d/stat", tid);
+            slot.statFd = openat(task.fd, path, O_RDONLY | O_CLOEXEC);
+            snprintf(path, sizeof(path), "%d/schedstat", tid);
+            slot.schedstatFd = openat(task.fd, path, O_RDONLY | O_CLOEXEC);
+            slot.pid = task.pid;
+            slot.tid = tid;
+            slot.seen = true;
+            slot.time = now;
+            if (!readSlot(slot, slot.runNs, slot.waitNs, slot.switches, slot.cpu)) releaseSlot(slot);
+        });
+    }
+
+    for (Slot& slot : slots) {
+        if (slot.tid != 0 && !slot.seen) releaseSlot(slot);
+    }
+}
+
+// schedstat: "<run ns> <run-queue wait ns> <times scheduled in>"; stat
+// field 39 is the CPU the thread last ran on
+bool ThreadSampler::readSlot(Slot& slot, uint64_t& runNs, uint64_t& waitNs, uint64_t& switches, int& cpu) {
+    if (slot.statFd < 0 || slot.schedstatFd < 0) return false;
+
+    char buffer[1024];
+    ssize_t n = pread(slot.schedstatFd, buffer, sizeof(buffer), 0);
+    if (n <= 0) return false; // ESRCH once the thread has exited
+    const char* p = buffer;
+    const char* end = buffer + n;
+    p = procfs::parseU64(p, end, runNs);
+    p = procfs::parseU64(p, end, waitNs);
+    procfs::parseU64(p, end, switches);
+
+    n = pread(slot.statFd, buffer, sizeof(buffer), 0);
+    if (n <= 0) return false;
+    end = buffer + n;
+    p = end;
+    while (p > buffer && *(p - 1) != ')') --p; // comm may contain spaces
+    p = procfs::skipSpaces(p, end);
+    for (int field = 3; field < 39 && p < end; ++field) p = procfs::skipSpaces(procfs::skipToken(p, end), end);
+    uint64_t processor = 0;
+    procfs::parseU64(p, end, processor);
+    cpu = static_cast<int>(processor);
+    return true;
+}
+
+void ThreadSampler::sampleSlot(Slot& slot, int64_t now) {
+    uint64_t runNs = 0;
+    uint64_t waitNs = 0;
+    uint64_t switches = 0;
+    int cpu = -1;
+    if (!readSlot(slot, runNs, waitNs, switches, cpu)) {
+        releaseSlot(slot);
+        return;
+    }
+
+    Record record;
+    record.pid = slot.pid;
+    record.tid = slot.tid;
+    record.elapsedNs = saturate32(static_cast<uint64_t>(now - slot.time));
+    record.runNs = saturate32(runNs >= slot.runNs ? runNs - slot.runNs : 0);
+    record.waitNs = saturate32(waitNs >= slot.waitNs ? waitNs - slot.waitNs : 0);
+    record.switches = saturate16(switches >= slot.switches ? switches - slot.switches : 0);
+    record.migrations = slot.cpu >= 0 && cpu != slot.cpu ? 1 : 0;
+    if (!ring.push(record)) dropped.fetch_add(1, std::memory_order_relaxed);
+
+    slot.runNs = runNs;
+    slot.waitNs = waitNs;
+    slot.switches = switches;
+    slot.cpu = cpu;
+    slot.time = now;
+}
+
+void ThreadSampler::releaseSlot(Slot& slot) {
+    if (slot.statFd >= 0) close(slot.statFd);
+    if (slot.schedstatFd >= 0) close(slot.schedstatFd);
+    slot = Slot();
+}
+
+void ThreadSampler::collect(std::vector<ThreadStats>& threads, ThreadSamplerStats& stats) {
+    for (Accumulator& acc : accumulators) {
+        acc.active = false;
+        acc.cpu.clear();
+        acc.wait.clear();
+        acc.elapsedNs = acc.runNs = acc.switches = acc.migrations = 0;
+    }
+
+    ring.drain([&](const Record& record) {
+        auto it = accumulatorIndex.find(record.tid);
+        if (it == accumulatorIndex.end() || accumulators[it->second].pid != record.pid) {
+            Accumulator acc;
+            acc.pid = record.pid;
+            acc.tid = record.tid;
+            char path[256];
+            snprintf(path, sizeof(path), "%s/proc/%d/task/%d/comm", config.root.c_str(), record.pid,
+                     record.tid);
+            int fd = open(path, O_RDONLY | O_CLOEXEC);
+            if (fd >= 0) {
+                char name[64];
+                ssize_t n = read(fd, name, sizeof(name));
+                close(fd);
+                while (n > 0 && name[n - 1] == '\n') --n;
+                if (n > 0) acc.name.assign(name, static_cast<size_t>(n));
+            }
+            if (it == accumulatorIndex.end()) {
+                it = accumulatorIndex.emplace(record.tid, accumulators.size()).first;
+                accumulators.push_back(std::move(acc));
+            } else {
+                accumulators[it->second] = std::move(acc); // TID reused by another process
+            }
+        }
+
+        Accumulator& acc = accumulators[it->second];
+        acc.active = true;
+        // The kernel folds run and wait time into schedstat only at switches
+        // and ticks, so one sample can carry time from earlier periods
+        if (record.elapsedNs > 0) {
+            acc.cpu.push_back(std::min(100.0, 100.0 * record.runNs / record.elapsedNs));
+            acc.wait.push_back(std::min(100.0, 100.0 * record.waitNs / record.elapsedNs));
+        }
+        acc.elapsedNs += record.elapsedNs;
+        acc.runNs += record.runNs;
+        acc.switches += record.switches;
+        acc.migrations += record.migrations;
+    });
+
+    // Forget threads without records in this interval
+    accumulators.erase(std::remove_if(accumulators.begin(), accumulators.end(),
+                                      [](const Accumulator& acc) { return !acc.active; }),
+                       accumulators.end());
+    accumulatorIndex.clear();
+    for (size_t i = 0; i < accumulators.size(); ++i) accumulatorIndex.emplace(accumulators[i].tid, i);
+
+    threads.clear();
+    threads.reserve(accumulators.size());
+    for (Accumulator& acc : accumulators) {
+        std::sort(acc.cpu.begin(), acc.cpu.end());
+        std::sort(acc.wait.begin(), acc.wait.end());
+        double seconds = acc.elapsedNs / 1e9;
+
+        ThreadStats thread;
+        thread.pid = acc.pid;
+        thread.tid = acc.tid;
+        thread.name = acc.name;
+        thread.samples = acc.cpu.size();
+        thread.cpuUsage = acc.elapsedNs > 0 ? 100.0 * acc.runNs / acc.elapsedNs : 0.0;
+        thread.cpuP50 = percentile(acc.cpu, 0.50);
+        thread.cpuP95 = percentile(acc.cpu, 0.95);
+        thread.cpuP99 = percentile(acc.cpu, 0.99);
+        thread.cpuMax = acc.cpu.empty() ? 0.0 : acc.cpu.back();
+        thread.waitP50 = percentile(acc.wait, 0.50);
+        thread.waitP95 = percentile(acc.wait, 0.95);
+        thread.waitP99 = percentile(acc.wait, 0.99);
+        thread.waitMax = acc.wait.empty() ? 0.0 : acc.wait.back();
+        thread.contextSwitches = seconds > 0.0 ? acc.switches / seconds : 0.0;
+        thread.migrations = seconds > 0.0 ? acc.migrations / seconds : 0.0;
+        threads.push_back(std::move(thread));
+    }
+    std::sort(threads.begin(), threads.end(), [](const ThreadStats& a, const ThreadStats& b) {
+        return a.pid != b.pid ? a.pid < b.pid : a.tid < b.tid;
+    });
+
+    int64_t now = clockNs(CLOCK_MONOTONIC);
+    uint64_t tickCount = ticks.load(std::memory_order_relaxed);
+    uint64_t cpuTime = cpuTimeNs.load(std::memory_order_relaxed);
+    double elapsed = static_cast<double>(now - lastCollectTime);
+    stats.enabled = true;
+    stats.pinned = pinned.load(std::memory_order_relaxed);
+    stats.rate = elapsed > 0.0 ? (tickCount - lastTicks) * 1e9 / elapsed : 0.0;
+    stats.overhead = elapsed > 0.0 && cpuTime >= lastCpuTimeNs ? 100.0 * (cpuTime - lastCpuTimeNs) / elapsed : 0.0;
+    stats.dropped = dropped.load(std::memory_order_relaxed);
+    stats.missedTicks = missed.load(std::memory_order_relaxed);
+    lastTicks = tickCount;
+    lastCpuTimeNs = cpuTime;
+    lastCollectTime = now;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "../../include/system_monitor.h"
+#include "../spsc_ring.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct ThreadSamplerOptions {
+    std::vector<int> pids;
+    unsigned rateHz = 250;   // Clamped to 1..1000
+    int cpu = -1;            // CPU for the sampler thread; -1 picks the last one allowed
+    size_t maxThreads = 256; // Threads tracked across all PIDs
+    std::string root;        // Prefix for /proc; empty for the live host
+};
+
+// High-frequency scheduler sampling of the threads of a few processes.
+//
+// A dedicated thread, pinned to one CPU, wakes on a fixed grid and reads
+// /proc/<pid>/task/<tid>/schedstat (run and run-queue wait time in ns, and
+// times scheduled in) and stat (last CPU) of every thread. Files stay open
+// and are re-read with pread; the task directories are re-listed every
+// 100 ms to pick up new threads. Every tracked thread yields one record per
+// tick, holding the deltas since its previous tick, into a preallocated
+// SPSC ring. Nothing on that thread allocates after start().
+//
+// collect() runs on the caller's cadence (the monitor's, once per second),
+// drains the ring and turns the records into per-thread percentiles for the
+// interval. A full ring drops records, and the drops are reported.
+class ThreadSampler {
+public:
+    explicit ThreadSampler(ThreadSamplerOptions options);
+    ~ThreadSampler();
+
+    ThreadSampler(const ThreadSampler&) = delete;
+    ThreadSampler& operator=(const ThreadSampler&) = delete;
+
+    // False if none of the PIDs has a task directory
+    bool start();
+    void stop();
+
+    // Summaries of the interval since the previous call, by pid then tid
+    void collect(std::vector<ThreadStats>& threads, ThreadSamplerStats& stats);
+
+private:
+    // Deltas of one thread over one tick
+    struct Record {
+        int pid;
+        int tid;
+        uint32_t elapsedNs;
+        uint32_t runNs;
+        uint32_t waitNs;
+        uint16_t switches;
+        uint16_t migrations;
+    };
+
+    // Sampler-side state of one tracked thread
+    struct Slot {
+        int pid = 0;
+        int tid = 0; // 0: free
+        int statFd = -1;
+        int schedstatFd = -1;
+        bool seen = false; // In the latest task listing
+        uint64_t runNs = 0;
+        uint64_t waitNs = 0;
+        uint64_t switches = 0;
+        int cpu = -1;
+        int64_t time = 0;
+    };
+
+    struct Task {
+        int pid;
+        int fd; // /proc/<pid>/task
+    };
+
+    // Consumer-side accumulation of one thread
+    struct Accumulator {
+        int pid = 0;
+        int tid = 0;
+        std::string name;
+        bool active = false; // Had records in this interval
+        std::vector<double> cpu;
+        std::vector<double> wait;
+        uint64_t elapsedNs = 0;
+        uint64_t runNs = 0;
+        uint64_t switches = 0;
+        uint64_t migrations = 0;
+    };
+
+    ThreadSamplerOptions config;
+    int64_t periodNs;
+    std::vector<Task> tasks;
+    std::vector<Slot> slots;
+    std::vector<char> direntBuffer;
+    SpscRing<Record> ring;
+    std::thread thread;
+    std::atomic<bool> running;
+
+    // Written by the sampler thread, read by collect()
+    std::atomic<uint64_t> ticks;
+    std::atomic<uint64_t> missed;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> cpuTimeNs;
+    std::atomic<bool> pinned;
+
+    // collect() state
+    std::unordered_map<int, size_t> accumulatorIndex; // tid -> accumulators
+    std::vector<Accumulator> accumulators;
+    uint64_t lastTicks = 0;
+    uint64_t lastCpuTimeNs = 0;
+    int64_t lastCollectTime = 0;
+
+    void run();
+    void discover();
+    void sampleSlot(Slot& slot, int64_t now);
+    bool readSlot(Slot& slot, uint64_t& runNs, uint64_t& waitNs, uint64_t& switches, int& cpu);
+    void releaseSlot(Slot& slot);
+    void pin();
+};
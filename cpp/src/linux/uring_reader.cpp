@@ -0,0 +1,218 @@
+#include "uring_reader.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+// Submission entries per file: openat, read, close
+constexpr unsigned kOpsPerFile = 3;
+enum Op : uint64_t { kOpen, kRead, kClose };
+
+int ringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int ringRegister(int fd, unsigned opcode, const void* arg, unsigned count) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+}
+
+struct UringReader::Ring {
+    void* sqMap = MAP_FAILED;
+    size_t sqMapSize = 0;
+    void* cqMap = MAP_FAILED; // Same mapping as sqMap with IORING_FEAT_SINGLE_MMAP
+    size_t cqMapSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+};
+
+UringReader::UringReader()
+    : ringFd(-1), ring(nullptr), slots(0), slotSize(0), buffer(nullptr), bufferBytes(0), enters(0) {}
+
+UringReader::~UringReader() {
+    release();
+}
+
+void UringReader::release() {
+    if (ring) {
+        if (ring->sqes != MAP_FAILED) munmap(ring->sqes, ring->sqesSize);
+        if (ring->cqMap != MAP_FAILED && ring->cqMap != ring->sqMap) munmap(ring->cqMap, ring->cqMapSize);
+        if (ring->sqMap != MAP_FAILED) munmap(ring->sqMap, ring->sqMapSize);
+        delete ring;
+        ring = nullptr;
+    }
+    if (ringFd >= 0) {
+        close(ringFd); // Also drops the registered files and buffer
+        ringFd = -1;
+    }
+    if (buffer) {
+        munmap(buffer, bufferBytes);
+        buffer = nullptr;
+    }
+    slots = 0;
+}
+
+bool UringReader::initialize(unsigned capacity, size_t bufferSize) {
+    release();
+    if (capacity == 0 || bufferSize == 0) return false;
+
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ringFd = ringSetup(capacity * kOpsPerFile, &params);
+    if (ringFd < 0) return false; // ENOSYS, EPERM (seccomp, io_uring_disabled)
+
+    ring = new Ring();
+    ring->sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single && ring->cqMapSize > ring->sqMapSize) ring->sqMapSize = ring->cqMapSize;
+    ring->sqMap = mmap(nullptr, ring->sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                       IORING_OFF_SQ_RING);
+    if (ring->sqMap == MAP_FAILED) {
+        release();
+        return false;
+    }
+    ring->cqMap = single ? ring->sqMap
+                         : mmap(nullptr, ring->cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                ringFd, IORING_OFF_CQ_RING);
+    ring->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    ring->sqes = static_cast<io_uring_sqe*>(mmap(nullptr, ring->sqesSize, PROT_READ | PROT_WRITE,
+                                                 MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES));
+    if (ring->cqMap == MAP_FAILED || ring->sqes == MAP_FAILED) {
+        release();
+        return false;
+    }
+
+    char* sq = static_cast<char*>(ring->sqMap);
+    char* cq = static_cast<char*>(ring->cqMap);
+    ring->sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    ring->sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    ring->sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    ring->sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    ring->cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    ring->cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    ring->cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    ring->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // An empty (-1) descriptor table for the direct opens, and the read
+    // buffer pinned once instead of on every read
+    std::vector<int> sparse(capacity, -1);
+    if (ringRegister(ringFd, IORING_REGISTER_FILES, sparse.data(), capacity) < 0) {
+        release();
+        return false;
+    }
+    bufferBytes = capacity * bufferSize;
+    void* memory = mmap(nullptr, bufferBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        release();
+        return false;
+    }
+    buffer = static_cast<char*>(memory);
+    iovec vector = {buffer, bufferBytes};
+    if (ringRegister(ringFd, IORING_REGISTER_BUFFERS, &vector, 1) < 0) { // RLIMIT_MEMLOCK
+        release();
+        return false;
+    }
+
+    slots = capacity;
+    slotSize = bufferSize;
+    paths.assign(capacity * kPathSize, '\0');
+    dirFds.assign(capacity, AT_FDCWD);
+    results.assign(capacity, 0);
+
+    // Kernels before 5.15 accept all of the above but fail direct opens
+    add(0, AT_FDCWD, "/proc/self/stat");
+    if (!submit(1) || result(0) <= 0) {
+        release();
+        return false;
+    }
+    return true;
+}
+
+void UringReader::add(unsigned slot, int dirFd, const char* path) {
+    char* copy = &paths[slot * kPathSize];
+    std::strncpy(copy, path, kPathSize - 1);
+    copy[kPathSize - 1] = '\0';
+    dirFds[slot] = dirFd;
+}
+
+bool UringReader::submit(unsigned count) {
+    if (!ring || count > slots) return false;
+
+    unsigned tail = *ring->sqTail; // Only written by us
+    for (unsigned slot = 0; slot < count; ++slot) {
+        results[slot] = 0;
+        for (uint64_t op = kOpen; op <= kClose; ++op) {
+            unsigned index = tail & ring->sqMask;
+            io_uring_sqe* sqe = &ring->sqes[index];
+            std::memset(sqe, 0, sizeof(*sqe));
+            sqe->user_data = slot * kOpsPerFile + op;
+            if (op == kOpen) {
+                // A failed open (process gone) cancels the rest of the chain
+                sqe->opcode = IORING_OP_OPENAT;
+                sqe->fd = dirFds[slot];
+                sqe->addr = reinterpret_cast<uintptr_t>(&paths[slot * kPathSize]);
+                sqe->open_flags = O_RDONLY; // Direct descriptors are never inherited
+                sqe->file_index = slot + 1;
+                sqe->flags = IOSQE_IO_LINK;
+            } else if (op == kRead) {
+                // Hard link: a short read (the normal case) must still close
+                sqe->opcode = IORING_OP_READ_FIXED;
+                sqe->fd = static_cast<int>(slot);
+                sqe->addr = reinterpret_cast<uintptr_t>(buffer + slot * slotSize);
+                sqe->len = static_cast<unsigned>(slotSize);
+                sqe->buf_index = 0;
+                sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+            } else {
+                sqe->opcode = IORING_OP_CLOSE;
+                sqe->file_index = slot + 1;
+            }
+            ring->sqArray[index] = index;
+            ++tail;
+        }
+    }
+    __atomic_store_n(ring->sqTail, tail, __ATOMIC_RELEASE);
+
+    unsigned pending = count * kOpsPerFile;
+    while (pending > 0) {
+        unsigned toSubmit = tail - __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE);
+        int n = ringEnter(ringFd, toSubmit, pending, IORING_ENTER_GETEVENTS);
+        ++enters;
+        if (n < 0 && errno != EINTR) return false;
+
+        unsigned head = *ring->cqHead;
+        unsigned cqTail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+        for (; head != cqTail; ++head) {
+            const io_uring_cqe& cqe = ring->cqes[head & ring->cqMask];
+            unsigned slot = static_cast<unsigned>(cqe.user_data / kOpsPerFile);
+            uint64_t op = cqe.user_data % kOpsPerFile;
+            // The open's error wins over the read's -ECANCELED, in either order
+            if (op == kOpen && cqe.res < 0) {
+                results[slot] = cqe.res;
+            } else if (op == kRead && results[slot] >= 0) {
+                results[slot] = cqe.res;
+            }
+            --pending;
+        }
+        __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+    }
+    return true;
+}
@@ -1,24 +1,705 @@
 #include "../include/system_monitor.h"
+#include "wire_protocol.h"
+#include "json_writer.h"
+#include "metric_history.h"
+#include "rolling_stats.h"
+#include <algorithm>
 #include <iostream>
+#include <fstream>
 #include <thread>
 #include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#ifdef MONITOR_BACKEND_LINUX
+#include "linux/capture.h"
+#include "linux/http_server.h"
+#include "linux/metric_store.h"
+#include "linux/procfs.h"
+#include "linux/shm_ring.h"
+#include <sys/stat.h>
+#endif
+
+// Set by SIGINT/SIGTERM so the monitor shuts down cleanly (the metric store
+// flushes its partial batch on destruction)
+static volatile std::sig_atomic_t stopRequested = 0;
+
+static void requestStop(int) {
+    stopRequested = 1;
+}
+
+enum class OutputFormat {
+    Pretty, // Indented multi-line JSON (default)
+    NDJSON, // One compact JSON document per line
+    Binary, // Framed, delta-encoded stream (see wire_protocol.h)
+    None    // No stdout output (with --http)
+};
+
+// Comma separated, as parsePositiveList() reads it
+static std::string formatList(const std::vector<int>& values) {
+    std::string list;
+    for (int value : values) {
+        if (!list.empty()) list += ',';
+        list += std::to_string(value);
+    }
+    return list;
+}
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--interval MS] [--format pretty|ndjson|binary|none] [--store DIR]\n"
+              << "       " << std::string(std::strlen(program), ' ') << " [--http PORT [--history]] [--web DIR] [--shm NAME [--shm-slot-bytes N]]\n"
+              << "       " << std::string(std::strlen(program), ' ') << " [--cgroups] [--cgroup-root DIR]\n"
+              << "       " << std::string(std::strlen(program), ' ') << " [--process-fields LIST] [--watch PID,...] [--io-uring]\n"
+              << "       " << std::string(std::strlen(program), ' ') << " [--sample-threads PID,...] [--sample-rate HZ]\n"
+              << "       " << std::string(std::strlen(program), ' ') << " [--stats] [--stats-windows SECONDS,...] [--anomalies]\n"
+              << "       " << std::string(std::strlen(program), ' ') << " [--alert RULE]... [--alert-file FILE]\n"
+              << "       " << std::string(std::strlen(program), ' ') << " [--replay FILE [--replay-dir DIR]]\n"
+              << "       " << program << " --record FILE [--ticks N] [--interval MS]\n"
+              << "       " << program << " --store DIR --query SERIES [--since SECONDS]\n"
+              << "  --interval MS     Output period in milliseconds (default 1000)\n"
+              << "  --format FORMAT   pretty (multi-line JSON, default), ndjson (one line per sample)\n"
+              << "                    binary (delta-encoded frames, see python/monitor_wire.py) or none\n"
+              << "  --http PORT       Serve the dashboard and a WebSocket feed at /ws on PORT\n"
+              << "  --history         Keep an hour of 1 s, a day of 10 s and a week of 1 min history of CPU,\n"
+              << "                    memory, network and disk throughput, served at /api/history\n"
+              << "  --web DIR         Dashboard files for --http (default: the repository's web/)\n"
+              << "  --shm NAME        Publish samples to the shared-memory ring NAME (e.g. /monitor_core)\n"
+              << "  --shm-slot-bytes N\n"
+              << "                    Largest sample the ring can hold (default 262144); larger ones are\n"
+              << "                    dropped and counted\n"
+              << "  --cgroups         Report CPU, memory, I/O and pressure of every cgroup v2 group\n"
+              << "  --cgroup-root DIR Cgroup hierarchy for --cgroups (default: the cgroup2 mount)\n"
+              << "  --process-fields LIST\n"
+              << "                    Extra fields of the top processes and watched PIDs, comma separated:\n"
+              << "                    threads, state, uid, switches, fds, io, pss, cmdline or all\n"
+              << "  --watch PID,...   Always report these processes, whatever their rank\n"
+              << "  --io-uring        Read per-process files in io_uring batches (Linux 5.15+)\n"
+              << "  --sample-threads PID,...\n"
+              << "                    Sample every thread of these processes at --sample-rate on a\n"
+              << "                    pinned thread and report per-thread percentiles each second\n"
+              << "  --sample-rate HZ  Thread sampling rate, 1 to 1000 (default 250)\n"
+              << "  --stats           Report rolling percentiles, mean and standard deviation of CPU,\n"
+              << "                    memory, network and disk metrics over sliding windows\n"
+              << "  --stats-windows SECONDS,...\n"
+              << "                    Window lengths for --stats (default " << formatList(RollingStats::defaultWindows())
+              << ")\n"
+              << "  --anomalies       Flag spikes, level shifts and departures from the time-of-day\n"
+              << "                    baseline in every host, core, disk, interface and top-process metric\n"
+              << "  --alert RULE      Report when a metric crosses a threshold, e.g. \"cpu.usage > 90 for 10s\"\n"
+              << "                    or \"disk.*.free < 5GB clear 8GB\"; may be repeated\n"
+              << "  --alert-file FILE Alert rules, one per line (# starts a comment)\n"
+              << "  --record FILE     Capture the /proc, /sys and cgroup files the collectors read, every\n"
+              << "                    --interval for --ticks ticks (default 60), into FILE and exit\n"
+              << "  --replay FILE     Read a capture instead of the host, one sample per recorded tick\n"
+              << "                    at full speed, then exit\n"
+              << "  --replay-dir DIR  Where --replay writes the tree (default: a temporary directory)\n"
+              << "  --store DIR       Also persist every metric once per second in DIR\n"
+              << "  --query SERIES    Print the stored samples of SERIES (e.g. cpu.usage) as NDJSON\n"
+              << "  --since SECONDS   Range of --query, back from now (default 3600)\n";
+}
+
+// "threads,io,..." to a ProcessField mask; false on an unknown name
+static bool parseProcessFields(const char* list, uint32_t& mask) {
+    static const struct {
+        const char* name;
+        uint32_t bits;
+    } kNames[] = {
+        {"threads", kProcessThreads}, {"state", kProcessState}, {"uid", kProcessUid},
+        {"switches", kProcessContextSwitches}, {"fds", kProcessFds}, {"io", kProcessIo},
+        {"pss", kProcessPss}, {"cmdline", kProcessCmdline}, {"all", kProcessAllFields},
+    };
+    mask = 0;
+    for (const char* p = list; *p;) {
+        const char* comma = std::strchr(p, ',');
+        size_t length = comma ? static_cast<size_t>(comma - p) : std::strlen(p);
+        bool known = false;
+        for (const auto& entry : kNames) {
+            if (std::strlen(entry.name) == length && std::strncmp(entry.name, p, length) == 0) {
+                mask |= entry.bits;
+                known = true;
+            }
+        }
+        if (!known) return false;
+        p += comma ? length + 1 : length;
+    }
+    return true;
+}
+
+// "1,42,..." to numbers (PIDs, seconds); false unless every entry is positive
+static bool parsePositiveList(const char* list, std::vector<int>& values) {
+    values.clear();
+    for (const char* p = list; *p;) {
+        char* end = nullptr;
+        long value = std::strtol(p, &end, 10);
+        if (end == p || value <= 0 || (*end != ',' && *end != '\0')) return false;
+        values.push_back(static_cast<int>(value));
+        p = *end == ',' ? end + 1 : end;
+    }
+    return !values.empty();
+}
+
+// Prints the points of one stored series, one JSON object per line
+static int queryStore(const std::string& directory, const std::string& series, long sinceSeconds) {
+#ifdef MONITOR_BACKEND_LINUX
+    StoreOptions options;
+    options.directory = directory;
+    MetricStore store(options);
+
+    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::vector<StorePoint> points;
+    if (!store.query(series, now - sinceSeconds * 1000, now, points)) {
+        std::cerr << "No series '" << series << "' in " << directory << std::endl;
+        return 1;
+    }
+
+    std::string line;
+    for (const StorePoint& point : points) {
+        line.clear();
+        JsonWriter json(line);
+        json.beginObject();
+        json.field("timestampMs", point.timestampMs);
+        json.field("value", point.value);
+        json.endObject();
+        line += '\n';
+        std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
+    }
+    std::cout.flush();
+    return 0;
+#else
+    (void)directory;
+    (void)series;
+    (void)sinceSeconds;
+    std::cerr << "The metric store is not available on this platform" << std::endl;
+    return 1;
+#endif
+}
+
+// Appends the rules of an alert file: one per line, blank lines and
+// comments skipped
+static bool readAlertFile(const std::string& path, std::vector<std::string>& rules) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.resize(comment);
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        rules.push_back(line);
+    }
+    return true;
+}
+
+// Records `ticks` ticks of the collectors' files, `interval` apart
+static int recordCapture(const std::string& path, long ticks, std::chrono::milliseconds interval) {
+#ifdef MONITOR_BACKEND_LINUX
+    CaptureRecorder recorder;
+    if (!recorder.open(path)) {
+        std::cerr << "Failed to create " << path << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+    auto next = std::chrono::steady_clock::now();
+    for (long tick = 0; tick < ticks && !stopRequested; ++tick) {
+        std::this_thread::sleep_until(next);
+        next += interval;
+        if (!recorder.recordTick()) {
+            std::cerr << "Failed to write " << path << std::endl;
+            return 1;
+        }
+    }
+    if (!recorder.close()) {
+        std::cerr << "Failed to write " << path << std::endl;
+        return 1;
+    }
+
+    const CaptureStats& stats = recorder.stats();
+    std::cerr << "Recorded " << stats.ticks << " ticks of " << stats.files << " files: "
+              << stats.rawBytes / 1024 << " KB read, " << stats.bytes / 1024 << " KB written" << std::endl;
+    return 0;
+#else
+    (void)path;
+    (void)ticks;
+    (void)interval;
+    std::cerr << "Recording is not available on this platform" << std::endl;
+    return 1;
+#endif
+}
+
+#ifdef MONITOR_BACKEND_LINUX
+// The dashboard directory when --web is not given: web/ next to the
+// working directory or up to two levels above it (cpp/build)
+static std::string findWebRoot() {
+    const char* candidates[] = {"web", "../web", "../../web"};
+    for (const char* candidate : candidates) {
+        struct stat st;
+        std::string index = std::string(candidate) + "/index.html";
+        if (::stat(index.c_str(), &st) == 0) return candidate;
+    }
+    return "web";
+}
+
+// Value of `name` in a query string such as "metric=cpu.usage&since=60",
+// with %XX escapes and '+' decoded
+static std::string queryParameter(const std::string& query, const char* name) {
+    auto hex = [](char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    size_t length = std::strlen(name);
+    for (size_t begin = 0; begin < query.size();) {
+        size_t end = query.find('&', begin);
+        if (end == std::string::npos) end = query.size();
+        if (end - begin > length && query.compare(begin, length, name) == 0 && query[begin + length] == '=') {
+            std::string value;
+            for (size_t i = begin + length + 1; i < end; ++i) {
+                if (query[i] == '+') {
+                    value += ' ';
+                } else if (query[i] == '%' && i + 2 < end && hex(query[i + 1]) >= 0 && hex(query[i + 2]) >= 0) {
+                    value += static_cast<char>(hex(query[i + 1]) * 16 + hex(query[i + 2]));
+                    i += 2;
+                } else {
+                    value += query[i];
+                }
+            }
+            return value;
+        }
+        begin = end + 1;
+    }
+    return std::string();
+}
+
+// A history series by its SnapshotMetrics name; disks are kept by their
+// position in the snapshot
+static bool historySeries(const std::string& name, const Snapshot& snapshot, HistoryMetric& metric,
+                          size_t& index) {
+    index = 0;
+    if (name == "cpu.usage") {
+        metric = HistoryMetric::CpuTotal;
+    } else if (name == "memory.usagePercent") {
+        metric = HistoryMetric::MemoryUsage;
+    } else if (name == "network.downloadSpeed") {
+        metric = HistoryMetric::NetworkDown;
+    } else if (name == "network.uploadSpeed") {
+        metric = HistoryMetric::NetworkUp;
+    } else if (name.compare(0, 9, "cpu.core.") == 0) {
+        char* end = nullptr;
+        long core = std::strtol(name.c_str() + 9, &end, 10);
+        if (end == name.c_str() + 9 || *end != '\0' || core < 0) return false;
+        metric = HistoryMetric::CpuCore;
+        index = static_cast<size_t>(core);
+    } else if (name.compare(0, 5, "disk.") == 0) {
+        size_t dot = name.rfind('.');
+        std::string field = name.substr(dot + 1);
+        if (field == "readSpeed") metric = HistoryMetric::DiskRead;
+        else if (field == "writeSpeed") metric = HistoryMetric::DiskWrite;
+        else return false;
+        std::string disk = name.substr(5, dot > 5 ? dot - 5 : 0);
+        const std::vector<DiskInfo>& disks = *snapshot.disks;
+        while (index < disks.size() && disks[index].name != disk) ++index;
+        if (index == disks.size()) return false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// GET /api/history?metric=SERIES[&since=SECONDS]: the min/avg/max points
+// of one series over the last SECONDS (default 3600), from the finest tier
+// that reaches that far back
+static bool historyResponse(const SystemMonitor& monitor, const std::string& query, std::string& body) {
+    const MetricHistory* history = monitor.history();
+    std::shared_ptr<const Snapshot> snapshot = monitor.snapshot();
+    std::string name = queryParameter(query, "metric");
+    HistoryMetric metric;
+    size_t index;
+    if (!history || history->tiers().empty() || !snapshot || !historySeries(name, *snapshot, metric, index)) {
+        return false;
+    }
+
+    // Nothing is kept past the coarsest tier, so longer spans are clamped
+    // to it before they can overflow in milliseconds
+    const HistoryTier& coarsest = history->tiers().back();
+    int64_t retentionSeconds = coarsest.resolutionMs * static_cast<int64_t>(coarsest.capacity) / 1000 + 1;
+    long since = std::strtol(queryParameter(query, "since").c_str(), nullptr, 10);
+    if (since <= 0) since = 3600;
+    int64_t sinceMs = std::min<int64_t>(since, retentionSeconds) * 1000;
+    int64_t now = snapshot->timestampMs;
+    std::vector<HistoryPoint> points;
+    int tier = history->query(metric, index, now - sinceMs, now, points);
+    if (tier < 0) return false;
+
+    JsonWriter json(body);
+    json.beginObject();
+    json.field("metric", name);
+    json.field("resolutionMs", history->tiers()[static_cast<size_t>(tier)].resolutionMs);
+    json.key("points");
+    json.beginArray();
+    for (const HistoryPoint& point : points) {
+        json.beginObject();
+        json.field("timestampMs", point.timestampMs);
+        json.field("min", static_cast<double>(point.min));
+        json.field("avg", static_cast<double>(point.avg));
+        json.field("max", static_cast<double>(point.max));
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+    return true;
+}
+#endif
+
+int main(int argc, char** argv) {
+    std::chrono::milliseconds outputInterval(1000);
+    OutputFormat format = OutputFormat::Pretty;
+    std::string storeDirectory;
+    std::string querySeries;
+    long sinceSeconds = 3600;
+    long httpPort = 0;
+    std::string webRoot;
+    bool history = false;
+    std::string shmName;
+    long shmSlotBytes = 0; // Default slot size
+    bool cgroups = false;
+    std::string cgroupRoot;
+    uint32_t processFields = 0;
+    std::vector<int> watchedPids;
+    bool batchedReads = false;
+    std::vector<int> sampledPids;
+    long sampleRate = 250;
+    bool stats = false;
+    std::vector<int> statsWindows = RollingStats::defaultWindows();
+    bool anomalies = false;
+    std::vector<std::string> alertRules;
+    std::string recordPath;
+    long recordTicks = 60;
+    std::string replayPath;
+    std::string replayDirectory;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+            long value = std::strtol(argv[++i], nullptr, 10);
+            if (value <= 0) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            outputInterval = std::chrono::milliseconds(value);
+        } else if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (std::strcmp(name, "pretty") == 0) {
+                format = OutputFormat::Pretty;
+            } else if (std::strcmp(name, "ndjson") == 0) {
+                format = OutputFormat::NDJSON;
+            } else if (std::strcmp(name, "binary") == 0) {
+                format = OutputFormat::Binary;
+            } else if (std::strcmp(name, "none") == 0) {
+                format = OutputFormat::None;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--store") == 0 && i + 1 < argc) {
+            storeDirectory = argv[++i];
+        } else if (std::strcmp(argv[i], "--history") == 0) {
+            history = true;
+        } else if (std::strcmp(argv[i], "--http") == 0 && i + 1 < argc) {
+            httpPort = std::strtol(argv[++i], nullptr, 10);
+            if (httpPort <= 0 || httpPort > 65535) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--web") == 0 && i + 1 < argc) {
+            webRoot = argv[++i];
+        } else if (std::strcmp(argv[i], "--shm") == 0 && i + 1 < argc) {
+            shmName = argv[++i];
+        } else if (std::strcmp(argv[i], "--shm-slot-bytes") == 0 && i + 1 < argc) {
+            shmSlotBytes = std::strtol(argv[++i], nullptr, 10);
+            if (shmSlotBytes <= 0 || shmSlotBytes > (1L << 30)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--cgroups") == 0) {
+            cgroups = true;
+        } else if (std::strcmp(argv[i], "--cgroup-root") == 0 && i + 1 < argc) {
+            cgroups = true;
+            cgroupRoot = argv[++i];
+        } else if (std::strcmp(argv[i], "--process-fields") == 0 && i + 1 < argc) {
+            if (!parseProcessFields(argv[++i], processFields)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--watch") == 0 && i + 1 < argc) {
+            if (!parsePositiveList(argv[++i], watchedPids)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--sample-threads") == 0 && i + 1 < argc) {
+            if (!parsePositiveList(argv[++i], sampledPids)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--sample-rate") == 0 && i + 1 < argc) {
+            sampleRate = std::strtol(argv[++i], nullptr, 10);
+            if (sampleRate < 1 || sampleRate > 1000) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--stats") == 0) {
+            stats = true;
+        } else if (std::strcmp(argv[i], "--stats-windows") == 0 && i + 1 < argc) {
+            stats = true;
+            if (!parsePositiveList(argv[++i], statsWindows)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--anomalies") == 0) {
+            anomalies = true;
+        } else if (std::strcmp(argv[i], "--alert") == 0 && i + 1 < argc) {
+            alertRules.push_back(argv[++i]);
+        } else if (std::strcmp(argv[i], "--alert-file") == 0 && i + 1 < argc) {
+            const char* path = argv[++i];
+            if (!readAlertFile(path, alertRules)) {
+                std::cerr << "Failed to read " << path << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            recordTicks = std::strtol(argv[++i], nullptr, 10);
+            if (recordTicks <= 0) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--replay-dir") == 0 && i + 1 < argc) {
+            replayDirectory = argv[++i];
+        } else if (std::strcmp(argv[i], "--io-uring") == 0) {
+            batchedReads = true;
+        } else if (std::strcmp(argv[i], "--query") == 0 && i + 1 < argc) {
+            querySeries = argv[++i];
+        } else if (std::strcmp(argv[i], "--since") == 0 && i + 1 < argc) {
+            sinceSeconds = std::strtol(argv[++i], nullptr, 10);
+            if (sinceSeconds <= 0) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!querySeries.empty()) {
+        if (storeDirectory.empty()) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return queryStore(storeDirectory, querySeries, sinceSeconds);
+    }
+
+    if (!recordPath.empty()) {
+        return recordCapture(recordPath, recordTicks, outputInterval);
+    }
 
-int main() {
     SystemMonitor monitor;
-    
+    monitor.setBatchedProcessReads(batchedReads);
+
+#ifdef MONITOR_BACKEND_LINUX
+    // Replay: collectors read the capture's tree, and their clock is the
+    // one the host had when each tick was recorded
+    std::unique_ptr<CaptureReplayer> replayer;
+    if (!replayPath.empty()) {
+        // Thread sampling needs the live scheduler
+        if (!sampledPids.empty()) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        replayer = std::make_unique<CaptureReplayer>();
+        if (!replayer->open(replayPath, replayDirectory) || !replayer->nextTick()) {
+            std::cerr << "Failed to replay " << replayPath << std::endl;
+            return 1;
+        }
+        procfs::pinNow(replayer->tickTime());
+        monitor.setRoot(replayer->root());
+    }
+#else
+    if (!replayPath.empty()) {
+        std::cerr << "--replay is not available on this platform" << std::endl;
+        return 1;
+    }
+#endif
+
     if (!monitor.initialize()) {
         std::cerr << "Failed to initialize system monitor" << std::endl;
         return 1;
     }
 
-    // Initial update
+    // The history is only read through the HTTP server
+    if (history && httpPort <= 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (history && !monitor.enableHistory()) {
+        std::cerr << "Failed to enable history" << std::endl;
+        return 1;
+    }
+
+    if (!storeDirectory.empty() && !monitor.enableStore(storeDirectory)) {
+        std::cerr << "Failed to open metric store in " << storeDirectory << std::endl;
+        return 1;
+    }
+
+    if (cgroups && !monitor.enableCgroups(cgroupRoot)) {
+        std::cerr << "No cgroup v2 hierarchy" << (cgroupRoot.empty() ? std::string() : " in " + cgroupRoot)
+                  << std::endl;
+        return 1;
+    }
+
+    if (!sampledPids.empty() && !monitor.enableThreadSampler(sampledPids, static_cast<unsigned>(sampleRate))) {
+        std::cerr << "Failed to start the thread sampler (no such process?)" << std::endl;
+        return 1;
+    }
+
+    if (stats && !monitor.enableStats(statsWindows)) {
+        std::cerr << "Failed to enable rolling statistics" << std::endl;
+        return 1;
+    }
+
+    if (anomalies && !monitor.enableAnomalyDetection()) {
+        std::cerr << "Failed to enable anomaly detection" << std::endl;
+        return 1;
+    }
+
+    std::string alertError;
+    if (!alertRules.empty() && !monitor.enableAlerts(alertRules, &alertError)) {
+        std::cerr << "Invalid alert " << alertError << std::endl;
+        return 1;
+    }
+
+    monitor.setProcessFields(processFields);
+    monitor.setWatchedProcesses(watchedPids);
+
+#ifdef MONITOR_BACKEND_LINUX
+    bool replaying = replayer != nullptr;
+#else
+    bool replaying = false;
+#endif
+
+    // Initial update, then let every collector sample on its own cadence
+    // (a replay samples once per tick instead)
     monitor.update();
+    if (!replaying && !monitor.start()) {
+        std::cerr << "Failed to start sampling" << std::endl;
+        return 1;
+    }
+
+#ifdef MONITOR_BACKEND_LINUX
+    std::unique_ptr<HttpServer> server;
+    if (httpPort > 0) {
+        HttpServerOptions options;
+        options.port = static_cast<uint16_t>(httpPort);
+        options.webRoot = webRoot.empty() ? findWebRoot() : webRoot;
+        if (history) {
+            options.api = [&monitor](const std::string& path, const std::string& query, std::string& body) {
+                return path == "/api/history" && historyResponse(monitor, query, body);
+            };
+        }
+        server = std::make_unique<HttpServer>(options);
+        if (!server->start()) {
+            std::cerr << "Failed to listen on port " << httpPort << std::endl;
+            return 1;
+        }
+        std::cerr << "Dashboard at http://localhost:" << server->port() << "/" << std::endl;
+    }
+
+    std::unique_ptr<ShmSnapshotRing> ring;
+    if (!shmName.empty()) {
+        ring = std::make_unique<ShmSnapshotRing>();
+        if (!ring->create(shmName, 8,
+                          shmSlotBytes > 0 ? static_cast<uint32_t>(shmSlotBytes) : ShmSnapshotRing::kDefaultSlotBytes)) {
+            std::cerr << "Failed to create shared-memory ring " << shmName << std::endl;
+            return 1;
+        }
+    }
+#else
+    if (httpPort > 0 || !shmName.empty()) {
+        std::cerr << "--http and --shm are not available on this platform" << std::endl;
+        return 1;
+    }
+#endif
+
+#ifdef _WIN32
+    if (format == OutputFormat::Binary) {
+        _setmode(_fileno(stdout), _O_BINARY);
+    }
+#endif
+
+    // Main loop - output on absolute deadlines so the period does not drift
+    std::string json;  // NDJSON line, shared by stdout and the HTTP server
+    std::string frame; // Binary encoder output
+    WireEncoder encoder;
+    auto nextOutput = std::chrono::steady_clock::now() + outputInterval;
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+    while (!stopRequested) {
+        if (replaying) {
+#ifdef MONITOR_BACKEND_LINUX
+            // Full speed: one sample per recorded tick
+            if (!replayer->nextTick()) break;
+            procfs::pinNow(replayer->tickTime());
+            monitor.update();
+#endif
+        } else {
+            std::this_thread::sleep_until(nextOutput);
+            if (stopRequested) break;
+            nextOutput += outputInterval;
+        }
+#ifdef MONITOR_BACKEND_LINUX
+        bool serving = server != nullptr || ring != nullptr;
+#else
+        bool serving = false;
+#endif
+        if (format == OutputFormat::NDJSON || serving) {
+            monitor.toNDJSON(json);
+        }
+
+        if (format == OutputFormat::NDJSON) {
+            std::cout.write(json.data(), static_cast<std::streamsize>(json.size()));
+            std::cout.flush();
+        } else if (format == OutputFormat::Binary) {
+            frame.clear();
+            encoder.encode(*monitor.snapshot(), frame);
+            std::cout.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+            std::cout.flush();
+        } else if (format == OutputFormat::Pretty) {
+            std::cout << monitor.toJSON() << std::endl;
+        }
 
-    // Main loop - output JSON every second
-    while (true) {
-        monitor.update();
-        std::cout << monitor.toJSON() << std::endl;
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+#ifdef MONITOR_BACKEND_LINUX
+        // One serialization for every consumer; messages omit the newline
+        if (serving) {
+            std::string_view message(json.data(), json.size() - 1);
+            if (server) server->broadcast(message);
+            if (ring && !ring->publish(message) && ring->dropped() == 1) {
+                // Readers see the count too; say once why their data is stale
+                std::cerr << "Sample of " << message.size() << " bytes does not fit the shared-memory slots ("
+                          << ring->slotBytes() << " bytes) and was dropped; raise --shm-slot-bytes" << std::endl;
+            }
+        }
+#endif
     }
 
     return 0;
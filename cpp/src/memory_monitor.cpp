@@ -3,9 +3,43 @@
 
 #pragma comment(lib, "psapi.lib")
 
-MemoryMonitor::MemoryMonitor() : initialized(false) {}
+namespace {
+constexpr double kBytesPerMB = 1024.0 * 1024.0;
+
+void addCounter(PDH_HQUERY query, const char* path, PDH_HCOUNTER& counter) {
+    if (PdhAddEnglishCounterA(query, path, 0, &counter) != ERROR_SUCCESS) counter = nullptr;
+}
+
+double counterValue(PDH_HCOUNTER counter) {
+    PDH_FMT_COUNTERVALUE value;
+    if (!counter || PdhGetFormattedCounterValue(counter, PDH_FMT_DOUBLE, nullptr, &value) != ERROR_SUCCESS) {
+        return 0.0;
+    }
+    return value.doubleValue;
+}
+}
+
+MemoryMonitor::MemoryMonitor()
+    : query(nullptr), pageFaultsCounter(nullptr), pageReadsCounter(nullptr), pagesInputCounter(nullptr),
+      pagesOutputCounter(nullptr), initialized(false) {}
+
+MemoryMonitor::~MemoryMonitor() {
+    if (query) {
+        PdhCloseQuery(query);
+    }
+}
 
 bool MemoryMonitor::initialize() {
+    // Paging rates are optional
+    if (PdhOpenQuery(nullptr, 0, &query) == ERROR_SUCCESS) {
+        addCounter(query, "\\Memory\\Page Faults/sec", pageFaultsCounter);
+        addCounter(query, "\\Memory\\Page Reads/sec", pageReadsCounter);
+        addCounter(query, "\\Memory\\Pages Input/sec", pagesInputCounter);
+        addCounter(query, "\\Memory\\Pages Output/sec", pagesOutputCounter);
+        PdhCollectQueryData(query);
+    } else {
+        query = nullptr;
+    }
     initialized = true;
     return true;
 }
@@ -18,10 +52,31 @@ void MemoryMonitor::update() {
     GlobalMemoryStatusEx(&memStatus);
 
     // Convert bytes to MB
-    info.total = memStatus.ullTotalPhys / (1024.0 * 1024.0);
-    info.free = memStatus.ullAvailPhys / (1024.0 * 1024.0);
+    info.total = memStatus.ullTotalPhys / kBytesPerMB;
+    info.free = memStatus.ullAvailPhys / kBytesPerMB;
     info.used = info.total - info.free;
     info.usagePercent = (info.used / info.total) * 100.0;
+
+    // The commit limit is physical memory plus the page files
+    PERFORMANCE_INFORMATION perf;
+    perf.cb = sizeof(perf);
+    if (GetPerformanceInfo(&perf, sizeof(perf))) {
+        double pageMB = perf.PageSize / kBytesPerMB;
+        info.cached = perf.SystemCache * pageMB;
+        info.slab = perf.KernelTotal * pageMB;
+        info.slabReclaimable = perf.KernelPaged * pageMB;
+        size_t pageFile = perf.CommitLimit > perf.PhysicalTotal ? perf.CommitLimit - perf.PhysicalTotal : 0;
+        size_t overcommit = perf.CommitTotal > perf.PhysicalTotal ? perf.CommitTotal - perf.PhysicalTotal : 0;
+        info.swapTotal = pageFile * pageMB;
+        info.swapUsed = (overcommit < pageFile ? overcommit : pageFile) * pageMB;
+    }
+
+    if (query && PdhCollectQueryData(query) == ERROR_SUCCESS) {
+        info.pageFaults = counterValue(pageFaultsCounter);
+        info.majorFaults = counterValue(pageReadsCounter);
+        info.swapIn = counterValue(pagesInputCounter);
+        info.swapOut = counterValue(pagesOutputCounter);
+    }
 }
 
 MemoryInfo MemoryMonitor::getInfo() const {
@@ -1,16 +1,56 @@
 #pragma once
 
 #include "../include/system_monitor.h"
+#include "platform.h"
+
+#ifdef MONITOR_BACKEND_LINUX
+#include "linux/procfs.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#else
 #include <windows.h>
+#include <pdh.h>
+#endif
 
 class MemoryMonitor {
 public:
     MemoryMonitor();
+    ~MemoryMonitor();
     bool initialize();
     void update();
     MemoryInfo getInfo() const;
 
+#ifdef MONITOR_BACKEND_LINUX
+    // Prefix for every /proc path: a captured or synthetic tree laid out
+    // like / (see linux/capture.h). Empty for the live host. Call before
+    // initialize().
+    void setRoot(const std::string& prefix) { root = prefix; }
+#endif
+
 private:
+#ifdef MONITOR_BACKEND_LINUX
+    // Cumulative /proc/vmstat counters behind the per-second rates
+    enum Rate { PageFaults, MajorFaults, SwapIn, SwapOut, PagesScanned, PagesReclaimed, AllocStalls, kRates };
+
+    std::string root;
+    ProcFile meminfoFile;
+    ProcFile vmstatFile;
+    ProcFile pressureFile; // Not open when the kernel has no PSI
+    uint64_t lastCounters[kRates] = {};
+    std::chrono::steady_clock::time_point lastVmstatTime;
+    bool haveCounters = false;
+
+    bool readMeminfo();
+    void readVmstat();
+    void readPressure();
+#else
+    PDH_HQUERY query;
+    PDH_HCOUNTER pageFaultsCounter;
+    PDH_HCOUNTER pageReadsCounter;
+    PDH_HCOUNTER pagesInputCounter;
+    PDH_HCOUNTER pagesOutputCounter;
+#endif
     MemoryInfo info;
     bool initialized;
 };
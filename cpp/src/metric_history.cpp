@@ -0,0 +1,223 @@
+#include "metric_history.h"
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace {
+// Fixed series before the per-core and per-disk blocks
+constexpr size_t kFixedSeries = 4;
+
+int64_t floorDiv(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+}
+
+std::vector<HistoryTier> MetricHistory::defaultTiers() {
+    return {
+        {1000, 3600},     // 1 s for an hour
+        {10000, 8640},    // 10 s for a day
+        {60000, 10080},   // 1 min for a week
+    };
+}
+
+MetricHistory::MetricHistory(size_t coreCount, size_t maxDisks, std::vector<HistoryTier> tiers)
+    : coreCount(coreCount), maxDisks(maxDisks), seriesTotal(kFixedSeries + coreCount + 2 * maxDisks),
+      tierConfig(std::move(tiers)), scratch(seriesTotal), latestMs(std::numeric_limits<int64_t>::min()),
+      sequence(0) {
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    for (HistoryTier& config : tierConfig) {
+        if (config.resolutionMs <= 0) config.resolutionMs = 1000;
+        if (config.capacity == 0) config.capacity = 1;
+
+        Tier tier;
+        tier.config = config;
+        size_t cells = config.capacity * seriesTotal;
+        tier.buckets.reset(new std::atomic<int64_t>[config.capacity]);
+        tier.counts.reset(new std::atomic<uint32_t>[config.capacity]);
+        tier.mins.reset(new std::atomic<float>[cells]);
+        tier.avgs.reset(new std::atomic<float>[cells]);
+        tier.maxs.reset(new std::atomic<float>[cells]);
+        for (size_t i = 0; i < config.capacity; ++i) {
+            tier.buckets[i].store(-1, std::memory_order_relaxed);
+            tier.counts[i].store(0, std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < cells; ++i) {
+            tier.mins[i].store(nan, std::memory_order_relaxed);
+            tier.avgs[i].store(nan, std::memory_order_relaxed);
+            tier.maxs[i].store(nan, std::memory_order_relaxed);
+        }
+        tierData.push_back(std::move(tier));
+    }
+}
+
+size_t MetricHistory::memoryBytes() const {
+    size_t total = 0;
+    for (const HistoryTier& config : tierConfig) {
+        total += config.capacity * (sizeof(int64_t) + sizeof(uint32_t));
+        total += config.capacity * seriesTotal * 3 * sizeof(float);
+    }
+    return total;
+}
+
+long MetricHistory::seriesIndex(HistoryMetric metric, size_t index) const {
+    switch (metric) {
+    case HistoryMetric::CpuTotal: return 0;
+    case HistoryMetric::MemoryUsage: return 1;
+    case HistoryMetric::NetworkDown: return 2;
+    case HistoryMetric::NetworkUp: return 3;
+    case HistoryMetric::CpuCore:
+        return index < coreCount ? static_cast<long>(kFixedSeries + index) : -1;
+    case HistoryMetric::DiskRead:
+        return index < maxDisks ? static_cast<long>(kFixedSeries + coreCount + index) : -1;
+    case HistoryMetric::DiskWrite:
+        return index < maxDisks ? static_cast<long>(kFixedSeries + coreCount + maxDisks + index) : -1;
+    }
+    return -1;
+}
+
+void MetricHistory::record(const Snapshot& snapshot) {
+    if (tierData.empty()) return;
+    const int64_t timestampMs = snapshot.timestampMs;
+    const int64_t rawResolution = tierConfig.front().resolutionMs;
+    int64_t latest = latestMs.load(std::memory_order_relaxed);
+    if (latest != std::numeric_limits<int64_t>::min() &&
+        floorDiv(timestampMs, rawResolution) < floorDiv(latest, rawResolution)) {
+        return;
+    }
+
+    // Gather this sample's values; NaN marks a series with no value
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    scratch.assign(seriesTotal, nan);
+    scratch[0] = static_cast<float>(snapshot.cpu->totalUsage);
+    scratch[1] = static_cast<float>(snapshot.memory->usagePercent);
+    scratch[2] = static_cast<float>(snapshot.network->downloadSpeed);
+    scratch[3] = static_cast<float>(snapshot.network->uploadSpeed);
+    for (size_t i = 0; i < coreCount && i < snapshot.cpu->coreUsage.size(); ++i) {
+        scratch[kFixedSeries + i] = static_cast<float>(snapshot.cpu->coreUsage[i]);
+    }
+    const std::vector<DiskInfo>& disks = *snapshot.disks;
+    for (size_t i = 0; i < maxDisks && i < disks.size(); ++i) {
+        scratch[kFixedSeries + coreCount + i] = static_cast<float>(disks[i].readSpeed);
+        scratch[kFixedSeries + coreCount + maxDisks + i] = static_cast<float>(disks[i].writeSpeed);
+    }
+
+    uint64_t seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (timestampMs > latest) latestMs.store(timestampMs, std::memory_order_relaxed);
+
+    for (Tier& tier : tierData) {
+        const size_t capacity = tier.config.capacity;
+        int64_t bucket = floorDiv(timestampMs, tier.config.resolutionMs);
+        size_t slot = static_cast<size_t>(bucket % static_cast<int64_t>(capacity));
+
+        // Entering a new bucket recycles the oldest slot of the ring
+        if (tier.buckets[slot].load(std::memory_order_relaxed) != bucket) {
+            tier.buckets[slot].store(bucket, std::memory_order_relaxed);
+            tier.counts[slot].store(0, std::memory_order_relaxed);
+            for (size_t s = 0; s < seriesTotal; ++s) {
+                size_t cell = s * capacity + slot;
+                tier.mins[cell].store(nan, std::memory_order_relaxed);
+                tier.avgs[cell].store(nan, std::memory_order_relaxed);
+                tier.maxs[cell].store(nan, std::memory_order_relaxed);
+            }
+        }
+
+        // Running min/max/mean. The sample count is shared by all series,
+        // so a series that skipped samples in this bucket gets an
+        // approximate mean.
+        uint32_t count = tier.counts[slot].load(std::memory_order_relaxed) + 1;
+        tier.counts[slot].store(count, std::memory_order_relaxed);
+        for (size_t s = 0; s < seriesTotal; ++s) {
+            float value = scratch[s];
+            if (std::isnan(value)) continue;
+
+            size_t cell = s * capacity + slot;
+            float avg = tier.avgs[cell].load(std::memory_order_relaxed);
+            if (std::isnan(avg)) {
+                tier.mins[cell].store(value, std::memory_order_relaxed);
+                tier.avgs[cell].store(value, std::memory_order_relaxed);
+                tier.maxs[cell].store(value, std::memory_order_relaxed);
+                continue;
+            }
+            if (value < tier.mins[cell].load(std::memory_order_relaxed)) {
+                tier.mins[cell].store(value, std::memory_order_relaxed);
+            }
+            if (value > tier.maxs[cell].load(std::memory_order_relaxed)) {
+                tier.maxs[cell].store(value, std::memory_order_relaxed);
+            }
+            tier.avgs[cell].store(avg + (value - avg) / static_cast<float>(count), std::memory_order_relaxed);
+        }
+    }
+
+    sequence.store(seq + 2, std::memory_order_release);
+}
+
+bool MetricHistory::copyRange(size_t series, const Tier& tier, int64_t fromMs, int64_t toMs,
+                              std::vector<HistoryPoint>& out) const {
+    const int64_t resolution = tier.config.resolutionMs;
+    const int64_t capacity = static_cast<int64_t>(tier.config.capacity);
+
+    for (;;) {
+        uint64_t seq = sequence.load(std::memory_order_acquire);
+        if (seq & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        out.clear();
+        int64_t latest = latestMs.load(std::memory_order_relaxed);
+        if (latest == std::numeric_limits<int64_t>::min()) return true;
+        int64_t newest = floorDiv(latest, resolution);
+        int64_t first = floorDiv(fromMs, resolution);
+        int64_t last = floorDiv(toMs, resolution);
+        if (first < newest - capacity + 1) first = newest - capacity + 1;
+        if (last > newest) last = newest;
+
+        for (int64_t bucket = first; bucket <= last; ++bucket) {
+            size_t slot = static_cast<size_t>(((bucket % capacity) + capacity) % capacity);
+            if (tier.buckets[slot].load(std::memory_order_relaxed) != bucket) continue;
+
+            size_t cell = series * tier.config.capacity + slot;
+            float avg = tier.avgs[cell].load(std::memory_order_relaxed);
+            if (std::isnan(avg)) continue;
+            out.push_back({bucket * resolution, tier.mins[cell].load(std::memory_order_relaxed), avg,
+                           tier.maxs[cell].load(std::memory_order_relaxed)});
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == seq) return true;
+    }
+}
+
+bool MetricHistory::queryTier(HistoryMetric metric, size_t index, size_t tier, int64_t fromMs, int64_t toMs,
+                              std::vector<HistoryPoint>& out) const {
+    out.clear();
+    long series = seriesIndex(metric, index);
+    if (series < 0 || tier >= tierData.size() || fromMs > toMs) return false;
+    return copyRange(static_cast<size_t>(series), tierData[tier], fromMs, toMs, out);
+}
+
+int MetricHistory::query(HistoryMetric metric, size_t index, int64_t fromMs, int64_t toMs,
+                         std::vector<HistoryPoint>& out) const {
+    out.clear();
+    long series = seriesIndex(metric, index);
+    if (series < 0 || tierData.empty()) return -1;
+
+    // The finest tier whose retention reaches back to fromMs; with nothing
+    // recorded yet every tier is empty
+    int64_t latest = latestMs.load(std::memory_order_relaxed);
+    if (latest == std::numeric_limits<int64_t>::min()) return 0;
+    size_t chosen = tierData.size() - 1;
+    for (size_t i = 0; i < tierData.size(); ++i) {
+        const HistoryTier& config = tierData[i].config;
+        if (fromMs > latest - config.resolutionMs * static_cast<int64_t>(config.capacity)) {
+            chosen = i;
+            break;
+        }
+    }
+    queryTier(metric, index, chosen, fromMs, toMs, out);
+    return static_cast<int>(chosen);
+}
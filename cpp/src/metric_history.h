@@ -0,0 +1,99 @@
+#pragma once
+
+#include "../include/system_monitor.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Metrics kept in history. Per-core and per-disk metrics take an index.
+enum class HistoryMetric {
+    CpuTotal,
+    CpuCore,
+    MemoryUsage,  // usagePercent
+    NetworkDown,  // MB/s
+    NetworkUp,    // MB/s
+    DiskRead,     // MB/s, by position in Snapshot::disks
+    DiskWrite
+};
+
+struct HistoryPoint {
+    int64_t timestampMs; // Start of the bucket
+    float min;
+    float avg;
+    float max;
+};
+
+// One retention tier: buckets of `resolutionMs`, `capacity` of them
+struct HistoryTier {
+    int64_t resolutionMs;
+    size_t capacity;
+};
+
+// In-process, fixed-size time-series store for the dashboard metrics.
+//
+// Every series has one ring per tier (by default raw 1 s for an hour, 10 s
+// for a day and 1 min for a week). Rollups are maintained incrementally:
+// each record() folds the sample into the current bucket of every tier, so
+// there is no background compaction. All memory is allocated in the
+// constructor; memoryBytes() reports it.
+//
+// There is a single writer (the sampler). Readers use a sequence lock and
+// retry if a record() overlapped their copy, so queries never block the
+// sampler and the sampler never waits for queries.
+class MetricHistory {
+public:
+    static std::vector<HistoryTier> defaultTiers();
+
+    MetricHistory(size_t coreCount, size_t maxDisks, std::vector<HistoryTier> tiers = defaultTiers());
+
+    MetricHistory(const MetricHistory&) = delete;
+    MetricHistory& operator=(const MetricHistory&) = delete;
+
+    // Folds one snapshot into every tier. Samples older than the latest
+    // recorded bucket of the finest tier are ignored, as is everything
+    // when there are no tiers.
+    void record(const Snapshot& snapshot);
+
+    // Points of `metric` in [fromMs, toMs], oldest first, from the finest
+    // tier whose retention still covers `fromMs`. Replaces `out`'s contents
+    // and returns the tier used (0 before anything is recorded), or -1 if
+    // the series does not exist or there are no tiers.
+    int query(HistoryMetric metric, size_t index, int64_t fromMs, int64_t toMs,
+              std::vector<HistoryPoint>& out) const;
+
+    // Same, from an explicit tier
+    bool queryTier(HistoryMetric metric, size_t index, size_t tier, int64_t fromMs, int64_t toMs,
+                   std::vector<HistoryPoint>& out) const;
+
+    size_t seriesCount() const { return seriesTotal; }
+    size_t memoryBytes() const;
+    const std::vector<HistoryTier>& tiers() const { return tierConfig; }
+
+private:
+    struct Tier {
+        HistoryTier config;
+        // Bucket number held by each slot, -1 when empty; shared by all series
+        std::unique_ptr<std::atomic<int64_t>[]> buckets;
+        std::unique_ptr<std::atomic<uint32_t>[]> counts;
+        // [series][slot] min/avg/max
+        std::unique_ptr<std::atomic<float>[]> mins;
+        std::unique_ptr<std::atomic<float>[]> avgs;
+        std::unique_ptr<std::atomic<float>[]> maxs;
+    };
+
+    size_t coreCount;
+    size_t maxDisks;
+    size_t seriesTotal;
+    std::vector<HistoryTier> tierConfig;
+    std::vector<Tier> tierData;
+    std::vector<float> scratch; // values of the snapshot being recorded
+    std::atomic<int64_t> latestMs; // timestamp of the newest record
+    std::atomic<uint64_t> sequence;
+
+    long seriesIndex(HistoryMetric metric, size_t index) const;
+    bool copyRange(size_t series, const Tier& tier, int64_t fromMs, int64_t toMs,
+                   std::vector<HistoryPoint>& out) const;
+};
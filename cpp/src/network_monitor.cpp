@@ -17,36 +17,67 @@ bool NetworkMonitor::initialize() {
 void NetworkMonitor::update() {
     if (!initialized) return;
 
-    MIB_IF_ROW2 ifRow;
-    ZeroMemory(&ifRow, sizeof(ifRow));
-    
-    // Get primary network interface (simplified - would iterate all interfaces in production)
     PMIB_IF_TABLE2 pIfTable;
     if (GetIfTable2(&pIfTable) == NO_ERROR) {
         ULONG64 totalReceived = 0;
         ULONG64 totalSent = 0;
-        
+
+        DWORD currentTime = GetTickCount();
+        DWORD timeDelta = currentTime - lastUpdateTime;
+        double timeDeltaSeconds = timeDelta / 1000.0;
+        bool haveInterval = timeDelta > 0 && lastUpdateTime > 0;
+
+        std::vector<InterfaceInfo> interfaces;
+        std::vector<ULONG64> receivedOctets;
+        std::vector<ULONG64> sentOctets;
+        std::vector<ULONG64> receivedPackets;
+        std::vector<ULONG64> sentPackets;
         for (ULONG i = 0; i < pIfTable->NumEntries; ++i) {
+            const MIB_IF_ROW2& row = pIfTable->Table[i];
             // Skip loopback and non-active interfaces
-            if (pIfTable->Table[i].Type == IF_TYPE_ETHERNET_CSMACD || 
-                pIfTable->Table[i].Type == IF_TYPE_IEEE80211) {
-                if (pIfTable->Table[i].OperStatus == IfOperStatusUp) {
-                    totalReceived += pIfTable->Table[i].InOctets;
-                    totalSent += pIfTable->Table[i].OutOctets;
-                }
+            if (row.Type != IF_TYPE_ETHERNET_CSMACD && row.Type != IF_TYPE_IEEE80211) continue;
+            if (row.OperStatus != IfOperStatusUp) continue;
+
+            totalReceived += row.InOctets;
+            totalSent += row.OutOctets;
+
+            InterfaceInfo iface;
+            char name[256];
+            int length = WideCharToMultiByte(CP_UTF8, 0, row.Alias, -1, name, sizeof(name), nullptr, nullptr);
+            iface.name = length > 1 ? std::string(name, length - 1) : std::to_string(row.InterfaceIndex);
+            iface.rxErrors = row.InErrors;
+            iface.txErrors = row.OutErrors;
+            iface.rxDropped = row.InDiscards;
+            iface.txDropped = row.OutDiscards;
+
+            ULONG64 rxPackets = row.InUcastPkts + row.InNUcastPkts;
+            ULONG64 txPackets = row.OutUcastPkts + row.OutNUcastPkts;
+            for (size_t j = 0; haveInterval && j < info.interfaces.size(); ++j) {
+                if (info.interfaces[j].name != iface.name) continue;
+                iface.downloadSpeed = ((row.InOctets - lastReceivedOctets[j]) / (1024.0 * 1024.0)) / timeDeltaSeconds;
+                iface.uploadSpeed = ((row.OutOctets - lastSentOctets[j]) / (1024.0 * 1024.0)) / timeDeltaSeconds;
+                iface.rxPackets = (rxPackets - lastReceivedPackets[j]) / timeDeltaSeconds;
+                iface.txPackets = (txPackets - lastSentPackets[j]) / timeDeltaSeconds;
+                break;
             }
+            interfaces.push_back(std::move(iface));
+            receivedOctets.push_back(row.InOctets);
+            sentOctets.push_back(row.OutOctets);
+            receivedPackets.push_back(rxPackets);
+            sentPackets.push_back(txPackets);
         }
 
-        DWORD currentTime = GetTickCount();
-        DWORD timeDelta = currentTime - lastUpdateTime;
-        
-        if (timeDelta > 0 && lastUpdateTime > 0) {
+        if (haveInterval) {
             // Calculate speed in MB/s
-            double timeDeltaSeconds = timeDelta / 1000.0;
             info.downloadSpeed = ((totalReceived - lastBytesReceived) / (1024.0 * 1024.0)) / timeDeltaSeconds;
             info.uploadSpeed = ((totalSent - lastBytesSent) / (1024.0 * 1024.0)) / timeDeltaSeconds;
         }
 
+        info.interfaces = std::move(interfaces);
+        lastReceivedOctets = std::move(receivedOctets);
+        lastSentOctets = std::move(sentOctets);
+        lastReceivedPackets = std::move(receivedPackets);
+        lastSentPackets = std::move(sentPackets);
         lastBytesReceived = totalReceived;
         lastBytesSent = totalSent;
         lastUpdateTime = currentTime;
@@ -54,16 +85,23 @@ void NetworkMonitor::update() {
         FreeMibTable(pIfTable);
     }
 
-    // Get active connections count (simplified)
-    MIB_TCPTABLE_OWNER_PID* pTcpTable = nullptr;
-    DWORD dwSize = 0;
-    if (GetExtendedTcpTable(nullptr, &dwSize, TRUE, AF_INET, TCP_TABLE_OWNER_PID_ALL, 0) == ERROR_INSUFFICIENT_BUFFER) {
-        pTcpTable = (MIB_TCPTABLE_OWNER_PID*)malloc(dwSize);
-        if (GetExtendedTcpTable(pTcpTable, &dwSize, TRUE, AF_INET, TCP_TABLE_OWNER_PID_ALL, 0) == NO_ERROR) {
-            info.activeConnections = pTcpTable->dwNumEntries;
+    // Connection counts from the stack's own statistics rather than a copy
+    // of the whole TCP table
+    SocketStats& sockets = info.sockets;
+    sockets = SocketStats();
+    const ULONG families[] = {AF_INET, AF_INET6};
+    for (ULONG family : families) {
+        MIB_TCPSTATS tcpStats;
+        if (GetTcpStatisticsEx(&tcpStats, family) == NO_ERROR) {
+            sockets.tcp += static_cast<int>(tcpStats.dwNumConns);
+            sockets.established += static_cast<int>(tcpStats.dwCurrEstab);
+        }
+        MIB_UDPSTATS udpStats;
+        if (GetUdpStatisticsEx(&udpStats, family) == NO_ERROR) {
+            sockets.udp += static_cast<int>(udpStats.dwNumAddrs);
         }
-        if (pTcpTable) free(pTcpTable);
     }
+    info.activeConnections = sockets.tcp;
 }
 
 NetworkInfo NetworkMonitor::getInfo() const {
@@ -1,6 +1,14 @@
 #pragma once
 
 #include "../include/system_monitor.h"
+#include "platform.h"
+
+#ifdef MONITOR_BACKEND_LINUX
+#include "linux/procfs.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#else
 // winsock2.h must come before windows.h
 #include <winsock2.h>
 #include <ws2tcpip.h>
@@ -10,6 +18,7 @@
 #endif
 #include <iphlpapi.h>
 #include <netioapi.h>
+#endif
 
 class NetworkMonitor {
 public:
@@ -19,10 +28,58 @@ public:
     void update();
     NetworkInfo getInfo() const;
 
+#ifdef MONITOR_BACKEND_LINUX
+    // Prefix for every /proc path: a captured or synthetic tree laid out
+    // like / (see linux/capture.h). Empty for the live host; with a prefix
+    // socket states come only from sockstat, as netlink would see this
+    // host. Call before initialize().
+    void setRoot(const std::string& prefix) { root = prefix; }
+#endif
+
 private:
     NetworkInfo info;
     bool initialized;
+#ifdef MONITOR_BACKEND_LINUX
+    // Cumulative /proc/net/dev counters of one interface
+    struct InterfaceCounters {
+        uint64_t rxBytes = 0;
+        uint64_t rxPackets = 0;
+        uint64_t rxErrors = 0;
+        uint64_t rxDropped = 0;
+        uint64_t txBytes = 0;
+        uint64_t txPackets = 0;
+        uint64_t txErrors = 0;
+        uint64_t txDropped = 0;
+    };
+
+    std::string root;
+    ProcFile netDevFile;
+    ProcFile sockstatFile;
+    ProcFile sockstat6File;
+    // Indexed like info.interfaces
+    std::vector<InterfaceCounters> lastCounters;
+    std::vector<InterfaceCounters> currentCounters;
+    std::chrono::steady_clock::time_point lastUpdateTime;
+
+    int diagSocket; // NETLINK_SOCK_DIAG, -1 if unavailable
+    uint32_t diagSequence;
+    uint32_t diagQueries; // Bit per family/protocol dump the kernel supports
+    std::vector<char> diagBuffer;
+    std::chrono::steady_clock::time_point lastStateTime;
+
+    bool readInterfaces();
+    void rebuildInterfaces();
+    void readSockstat();
+    int countStates(uint8_t family, uint8_t protocol, uint32_t stateMask, int* counts);
+    void updateSocketStates();
+#else
     ULONG64 lastBytesReceived;
     ULONG64 lastBytesSent;
     DWORD lastUpdateTime;
+    // Indexed like info.interfaces
+    std::vector<ULONG64> lastReceivedOctets;
+    std::vector<ULONG64> lastSentOctets;
+    std::vector<ULONG64> lastReceivedPackets;
+    std::vector<ULONG64> lastSentPackets;
+#endif
 };
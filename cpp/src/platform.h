@@ -0,0 +1,11 @@
+#pragma once
+
+// Collector backend selection. CMake sets one of these from MONITOR_BACKEND;
+// builds that bypass CMake (build.bat, manual g++/cl) fall back to the host OS.
+#if !defined(MONITOR_BACKEND_WINDOWS) && !defined(MONITOR_BACKEND_LINUX)
+    #if defined(_WIN32)
+        #define MONITOR_BACKEND_WINDOWS 1
+    #else
+        #define MONITOR_BACKEND_LINUX 1
+    #endif
+#endif
@@ -15,6 +15,12 @@ void ProcessMonitor::update() {
     if (!initialized) return;
 
     processes.clear();
+    {
+        std::lock_guard<std::mutex> lock(configMutex);
+        fields = requestedFields;
+        watchedPids = requestedWatched;
+    }
+    double seconds = (GetTickCount() - lastUpdateTime) / 1000.0;
 
     HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
     if (hSnapshot == INVALID_HANDLE_VALUE) return;
@@ -36,6 +42,10 @@ void ProcessMonitor::update() {
                 processName[MAX_PATH - 1] = '\0';
             #endif
             proc.name = processName;
+            if (fields & kProcessThreads) {
+                proc.threads = static_cast<int>(pe32.cntThreads);
+                proc.fields |= kProcessThreads;
+            }
 
             // Get CPU and memory usage
             HANDLE hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, proc.pid);
@@ -67,6 +77,28 @@ void ProcessMonitor::update() {
                     lastProcessTimes[proc.pid] = totalTime;
                 }
 
+                DWORD handles = 0;
+                if ((fields & kProcessFds) && GetProcessHandleCount(hProcess, &handles)) {
+                    proc.fdCount = static_cast<int>(handles);
+                    proc.fields |= kProcessFds;
+                }
+
+                // Includes non-disk I/O (pipes, sockets); Windows does not
+                // split it out per process
+                IO_COUNTERS io;
+                if ((fields & kProcessIo) && GetProcessIoCounters(hProcess, &io)) {
+                    auto last = lastIoCounters.find(proc.pid);
+                    if (last != lastIoCounters.end() && seconds > 0.0) {
+                        const double bytesPerMB = 1024.0 * 1024.0;
+                        if (io.ReadTransferCount >= last->second.read)
+                            proc.ioReadSpeed = (io.ReadTransferCount - last->second.read) / bytesPerMB / seconds;
+                        if (io.WriteTransferCount >= last->second.write)
+                            proc.ioWriteSpeed = (io.WriteTransferCount - last->second.write) / bytesPerMB / seconds;
+                    }
+                    lastIoCounters[proc.pid] = {io.ReadTransferCount, io.WriteTransferCount};
+                    proc.fields |= kProcessIo;
+                }
+
                 CloseHandle(hProcess);
             }
 
@@ -77,11 +109,58 @@ void ProcessMonitor::update() {
     CloseHandle(hSnapshot);
     lastUpdateTime = GetTickCount();
 
+    // Activity is the difference between two snapshots, so processes that
+    // start and end within one interval are not seen
+    std::vector<DWORD> pids;
+    pids.reserve(processes.size());
+    for (const ProcessInfo& proc : processes) pids.push_back(static_cast<DWORD>(proc.pid));
+    std::sort(pids.begin(), pids.end());
+    size_t common = 0;
+    for (size_t i = 0, j = 0; i < pids.size() && j < lastPids.size();) {
+        if (pids[i] < lastPids[j]) ++i;
+        else if (lastPids[j] < pids[i]) ++j;
+        else { ++common; ++i; ++j; }
+    }
+    bool first = lastPids.empty();
+    activity.total = static_cast<int>(pids.size());
+    activity.spawned = first ? 0 : pids.size() - common;
+    activity.exited = first ? 0 : lastPids.size() - common;
+    activity.eventDriven = false;
+    for (auto it = lastProcessTimes.begin(); it != lastProcessTimes.end();) {
+        if (std::binary_search(pids.begin(), pids.end(), it->first)) ++it;
+        else it = lastProcessTimes.erase(it);
+    }
+    for (auto it = lastIoCounters.begin(); it != lastIoCounters.end();) {
+        if (std::binary_search(pids.begin(), pids.end(), it->first)) ++it;
+        else it = lastIoCounters.erase(it);
+    }
+    lastPids.swap(pids);
+
     // Sort by CPU usage
     std::sort(processes.begin(), processes.end(), 
               [](const ProcessInfo& a, const ProcessInfo& b) {
                   return a.cpuUsage > b.cpuUsage;
               });
+
+    watched.clear();
+    for (int pid : watchedPids) {
+        for (const ProcessInfo& proc : processes) {
+            if (proc.pid == pid) {
+                watched.push_back(proc);
+                break;
+            }
+        }
+    }
+}
+
+void ProcessMonitor::setFields(uint32_t requested) {
+    std::lock_guard<std::mutex> lock(configMutex);
+    requestedFields = requested & kProcessAllFields;
+}
+
+void ProcessMonitor::setWatched(const std::vector<int>& pids) {
+    std::lock_guard<std::mutex> lock(configMutex);
+    requestedWatched = pids;
 }
 
 std::vector<ProcessInfo> ProcessMonitor::getTopProcesses(int count) const {
@@ -1,21 +1,153 @@
 #pragma once
 
 #include "../include/system_monitor.h"
+#include "platform.h"
+#include <mutex>
+#include <vector>
+
+#ifdef MONITOR_BACKEND_LINUX
+#include "linux/pid_table.h"
+#include "linux/proc_events.h"
+#include "linux/uring_reader.h"
+#include <chrono>
+#include <memory>
+#include <cstdint>
+#include <string>
+#else
 #include <windows.h>
 #include <psapi.h>
-#include <vector>
 #include <map>
+#endif
 
 class ProcessMonitor {
 public:
     ProcessMonitor();
+#ifdef MONITOR_BACKEND_LINUX
+    ~ProcessMonitor();
+#endif
     bool initialize();
     void update();
     std::vector<ProcessInfo> getTopProcesses(int count) const;
+    ProcessActivity getActivity() const { return activity; }
+
+    // Optional fields (ProcessField mask) for the ranked and watched
+    // processes, and PIDs to report whatever their rank. Both may be called
+    // from any thread and apply from the next update().
+    void setFields(uint32_t fields);
+    void setWatched(const std::vector<int>& pids);
+    // Live watched processes, in the order they were given
+    std::vector<ProcessInfo> getWatchedProcesses() const { return watched; }
+
+#ifdef MONITOR_BACKEND_LINUX
+    // Number of processes retained per scan (ranked by CPU, then memory)
+    void setTopCapacity(size_t capacity) { topCapacity = capacity; }
+    // Track processes through kernel fork/exec/exit events when the process
+    // connector is available (the default). Call before initialize().
+    void setEventTracking(bool enabled) { eventTracking = enabled; }
+    bool isEventDriven() const { return events != nullptr; }
+    // Read /proc/<pid>/stat in batches through io_uring (see
+    // linux/uring_reader.h). Falls back to open/read/close per process when
+    // io_uring is unavailable. Call before initialize().
+    void setBatchedReads(bool enabled) { batchedReads = enabled; }
+    bool isBatched() const { return uring != nullptr; }
+    // Prefix for /proc: a captured or synthetic tree laid out like / (see
+    // linux/capture.h). Empty for the live host; with a prefix, process
+    // events are not used. Call before initialize().
+    void setRoot(const std::string& prefix) { root = prefix; }
+    // Syscalls spent reading stat files so far: open, read and close per
+    // process, or one io_uring_enter() per batch
+    uint64_t getReadSyscalls() const { return readSyscalls; }
+#endif
 
 private:
     std::vector<ProcessInfo> processes;
+    std::vector<ProcessInfo> watched;
+    ProcessActivity activity;
     bool initialized;
+
+    std::mutex configMutex; // Guards the two requested* members
+    uint32_t requestedFields = 0;
+    std::vector<int> requestedWatched;
+    uint32_t fields = 0; // Copies taken at the start of update()
+    std::vector<int> watchedPids;
+#ifdef MONITOR_BACKEND_LINUX
+    // Per-PID state carried between scans
+    struct PidState {
+        uint64_t startTime = 0;   // clock ticks since boot; detects PID reuse
+        uint64_t cpuTicks = 0;    // utime + stime at the last scan
+        uint32_t generation = 0;  // last scan that saw this PID
+        // Counters from the last detailed sample, kept only for processes
+        // whose rates are requested; detailTime 0 means no baseline
+        int64_t detailTime = 0;   // steady clock, ns
+        uint64_t ioReadBytes = 0;
+        uint64_t ioWriteBytes = 0;
+        uint64_t voluntarySwitches = 0;
+        uint64_t involuntarySwitches = 0;
+    };
+
+    // One scanned process; names stay in a fixed buffer until the process
+    // makes it into the top set
+    struct Candidate {
+        int pid;
+        double cpuUsage;
+        double memoryUsage;
+        int threads;
+        char state;
+        char name[16];
+    };
+
+    std::string root;
+    int procFd; // /proc, for openat() and getdents64
+    std::vector<char> direntBuffer;
+    std::vector<char> detailBuffer;
+    PidTable<PidState> pidStates;
+    std::vector<Candidate> candidates;
+    std::vector<int> staleScratch;
+    uint32_t generation;
+    size_t topCapacity;
+    double ticksPerSecond;
+    double pageSizeMB;
+    std::chrono::steady_clock::time_point lastUpdateTime;
+
+    bool batchedReads;
+    std::unique_ptr<UringReader> uring;
+    std::vector<int> batchPids;
+    uint64_t readSyscalls;
+
+    // Event mode: the PID set follows fork/exit events and /proc is only
+    // listed to reconcile, periodically or after events were lost
+    bool eventTracking;
+    std::unique_ptr<ProcEventListener> events;
+    std::vector<ProcEvent> eventScratch;
+    std::chrono::steady_clock::time_point lastReconcileTime;
+    uint64_t lastSpawned;
+    uint64_t lastExited;
+
+    bool parseStat(const char* buffer, size_t length, int pid, Candidate& out,
+                   uint64_t& startTime, uint64_t& cpuTicks);
+    bool readStat(int pid, Candidate& out, uint64_t& startTime, uint64_t& cpuTicks);
+    // Reads the stat file of every PID in batchPids and calls
+    // sampled(pid, candidate, startTime, cpuTicks) or missing(pid)
+    template <typename Sampled, typename Missing>
+    void readStats(Sampled sampled, Missing missing);
+    void account(Candidate& candidate, PidState& state, bool inserted, uint64_t startTime,
+                 uint64_t cpuTicks, double elapsedTicks);
+    void scanAll(double elapsedTicks, uint64_t& appeared, uint64_t& vanished);
+    void sampleTracked(double elapsedTicks);
+    // Reads /proc/<pid>/<file> into detailBuffer; false if it is gone or
+    // not readable
+    bool readPidFile(int pid, const char* file, size_t& length);
+    // Fills the optional fields other than threads and state
+    void collectDetails(ProcessInfo& proc, int64_t now);
+#else
+    struct IoCounters {
+        ULONG64 read = 0;
+        ULONG64 write = 0;
+    };
+    std::map<DWORD, IoCounters> lastIoCounters;
+
     std::map<DWORD, ULONG64> lastProcessTimes;
+    std::vector<DWORD> lastPids; // Sorted
     DWORD lastUpdateTime;
+#endif
 };
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+// Publishes immutable objects to any number of concurrent readers.
+//
+// The current object lives behind a single atomic pointer. publish() swaps
+// in a new one; readers take a shared_ptr copy of whatever is current. The
+// only race is between a reader dereferencing the pointer and the writer
+// freeing it, and that is closed with two-epoch RCU: readers announce
+// themselves in the counter for the current epoch for the few nanoseconds
+// it takes to copy the shared_ptr, and the writer flips the epoch after the
+// swap and waits for the old epoch's counter to drain before freeing the
+// old holder. Readers never block, never retry more than once per
+// concurrent publish and never allocate; only the writer waits.
+//
+// publish() must be called by one thread at a time.
+template <typename T>
+class RcuPublisher {
+public:
+    RcuPublisher() : current(nullptr), epoch(0) {
+        readers[0].store(0);
+        readers[1].store(0);
+    }
+
+    ~RcuPublisher() {
+        delete current.load();
+    }
+
+    RcuPublisher(const RcuPublisher&) = delete;
+    RcuPublisher& operator=(const RcuPublisher&) = delete;
+
+    std::shared_ptr<const T> acquire() const {
+        for (;;) {
+            uint64_t e = epoch.load();
+            std::atomic<uint64_t>& counter = readers[e & 1];
+            counter.fetch_add(1);
+            if (epoch.load() == e) {
+                Holder* holder = current.load();
+                std::shared_ptr<const T> result = holder ? holder->value : nullptr;
+                counter.fetch_sub(1, std::memory_order_release);
+                return result;
+            }
+            // The writer flipped the epoch between our two loads; re-register
+            counter.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    void publish(std::shared_ptr<const T> next) {
+        Holder* fresh = new Holder{std::move(next)};
+        Holder* old = current.exchange(fresh);
+
+        uint64_t e = epoch.load(std::memory_order_relaxed);
+        epoch.store(e + 1);
+        while (readers[e & 1].load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+        delete old;
+    }
+
+private:
+    struct Holder {
+        std::shared_ptr<const T> value;
+    };
+
+    std::atomic<Holder*> current;
+    std::atomic<uint64_t> epoch;
+    mutable std::atomic<uint64_t> readers[2];
+};
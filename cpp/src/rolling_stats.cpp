@@ -0,0 +1,289 @@
+#include "rolling_stats.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+// Bucket 0 holds everything up to kMinValue; bucket i > 0 holds
+// (kMinValue * kGamma^(i-1), kMinValue * kGamma^i]. Reporting the point
+// 2 * kGamma / (1 + kGamma) into a bucket is within (kGamma - 1) / (kGamma + 1),
+// 4.8%, of any value in it. The last bucket also takes everything above
+// its range (about 70,000).
+constexpr double kMinValue = 1e-3;
+constexpr double kGamma = 1.1;
+
+const double kNoMin = std::numeric_limits<double>::infinity();
+const double kNoMax = -std::numeric_limits<double>::infinity();
+
+struct BucketTable {
+    double value[RollingStats::kBuckets];
+    double logGamma;
+
+    BucketTable() : logGamma(std::log(kGamma)) {
+        value[0] = 0.0;
+        for (size_t i = 1; i < RollingStats::kBuckets; ++i) {
+            value[i] = kMinValue * std::pow(kGamma, static_cast<double>(i - 1)) * 2.0 * kGamma / (1.0 + kGamma);
+        }
+    }
+};
+
+const BucketTable& bucketTable() {
+    static const BucketTable table;
+    return table;
+}
+
+uint16_t bucketOf(double value) {
+    if (!(value > kMinValue)) return 0;
+    double index = std::ceil(std::log(value / kMinValue) / bucketTable().logGamma);
+    if (index >= static_cast<double>(RollingStats::kBuckets - 1)) return RollingStats::kBuckets - 1;
+    return static_cast<uint16_t>(std::max(index, 1.0));
+}
+
+int64_t floorDiv(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+size_t slotOf(int64_t pane) {
+    int64_t slot = pane % static_cast<int64_t>(RollingStats::kPanes);
+    return static_cast<size_t>(slot < 0 ? slot + static_cast<int64_t>(RollingStats::kPanes) : slot);
+}
+
+// Moves the per-series rows of `old` to their new series index; `from`
+// gives the old index of every new series, -1 for a new one
+template <typename T>
+std::vector<T> remap(const std::vector<T>& old, size_t rows, size_t oldSeries, const std::vector<long>& from,
+                     size_t width, T fill) {
+    size_t newSeries = from.size();
+    std::vector<T> out(rows * newSeries * width, fill);
+    for (size_t row = 0; row < rows; ++row) {
+        for (size_t s = 0; s < newSeries; ++s) {
+            if (from[s] < 0) continue;
+            const T* source = old.data() + (row * oldSeries + static_cast<size_t>(from[s])) * width;
+            std::copy(source, source + width, out.data() + (row * newSeries + s) * width);
+        }
+    }
+    return out;
+}
+}
+
+std::vector<int> RollingStats::defaultWindows() {
+    return {60, 300, 3600};
+}
+
+RollingStats::RollingStats(std::vector<int> seconds) : windowSeconds(std::move(seconds)) {
+    for (int& length : windowSeconds) {
+        if (length <= 0) length = 60;
+        Window window;
+        window.paneMs = std::max<int64_t>(1, static_cast<int64_t>(length) * 1000 / static_cast<int64_t>(kPanes));
+        windows.push_back(std::move(window));
+    }
+    bucketTable();
+}
+
+size_t RollingStats::memoryBytes() const {
+    size_t total = 0;
+    for (const Window& window : windows) {
+        total += window.counts.size() * sizeof(uint32_t);
+        total += (window.sums.size() + window.squares.size() + window.minima.size() + window.maxima.size()) *
+                 sizeof(double);
+        total += window.histograms.size() * sizeof(uint16_t);
+        total += window.total.size() * sizeof(uint32_t);
+    }
+    return total;
+}
+
+bool RollingStats::sameLayout(const Snapshot& snapshot) const {
+    if (!initialized || snapshot.cpu->coreUsage.size() != coreCount) return false;
+    const std::vector<DiskInfo>& disks = *snapshot.disks;
+    if (disks.size() != diskNames.size()) return false;
+    for (size_t i = 0; i < diskNames.size(); ++i) {
+        if (disks[i].name != diskNames[i]) return false;
+    }
+    return true;
+}
+
+// New core or disk set: lay the series out again, carrying over the
+// history of every series that still exists
+void RollingStats::rebuild(const Snapshot& snapshot) {
+    coreCount = snapshot.cpu->coreUsage.size();
+    diskNames.clear();
+    for (const DiskInfo& disk : *snapshot.disks) diskNames.push_back(disk.name);
+
+    std::vector<std::string> rebuilt = {"cpu.usage", "memory.usagePercent", "network.downloadSpeed",
+                                        "network.uploadSpeed"};
+    for (size_t i = 0; i < coreCount; ++i) rebuilt.push_back("cpu.core." + std::to_string(i));
+    for (const std::string& disk : diskNames) {
+        rebuilt.push_back("disk." + disk + ".readSpeed");
+        rebuilt.push_back("disk." + disk + ".writeSpeed");
+    }
+
+    std::vector<long> from(rebuilt.size(), -1);
+    for (size_t s = 0; s < rebuilt.size(); ++s) {
+        auto found = std::find(names.begin(), names.end(), rebuilt[s]);
+        if (found != names.end()) from[s] = static_cast<long>(found - names.begin());
+    }
+
+    size_t oldSeries = names.size();
+    for (Window& window : windows) {
+        window.counts = remap<uint32_t>(window.counts, kPanes, oldSeries, from, 1, 0);
+        window.sums = remap<double>(window.sums, kPanes, oldSeries, from, 1, 0.0);
+        window.squares = remap<double>(window.squares, kPanes, oldSeries, from, 1, 0.0);
+        window.minima = remap<double>(window.minima, kPanes, oldSeries, from, 1, kNoMin);
+        window.maxima = remap<double>(window.maxima, kPanes, oldSeries, from, 1, kNoMax);
+        window.histograms = remap<uint16_t>(window.histograms, kPanes, oldSeries, from, kBuckets, 0);
+        window.total = remap<uint32_t>(window.total, 1, oldSeries, from, kBuckets, 0);
+    }
+
+    names = std::move(rebuilt);
+    values.assign(names.size(), 0.0);
+    buckets.assign(names.size(), 0);
+    initialized = true;
+}
+
+// Subtracts the slot's histogram from the window's and empties the slot
+void RollingStats::clearSlot(Window& window, size_t slot) {
+    const size_t series = names.size();
+    const size_t cells = series * kBuckets;
+    uint16_t* histogram = window.histograms.data() + slot * cells;
+    uint32_t* total = window.total.data();
+    for (size_t i = 0; i < cells; ++i) total[i] -= histogram[i];
+    std::fill(histogram, histogram + cells, 0);
+
+    std::fill_n(window.counts.begin() + slot * series, series, 0u);
+    std::fill_n(window.sums.begin() + slot * series, series, 0.0);
+    std::fill_n(window.squares.begin() + slot * series, series, 0.0);
+    std::fill_n(window.minima.begin() + slot * series, series, kNoMin);
+    std::fill_n(window.maxima.begin() + slot * series, series, kNoMax);
+}
+
+// Recycles the slots of every pane between the window's newest and `pane`
+void RollingStats::advance(Window& window, int64_t pane) {
+    int64_t steps = pane - window.pane;
+    if (steps >= static_cast<int64_t>(kPanes)) {
+        std::fill(window.counts.begin(), window.counts.end(), 0u);
+        std::fill(window.sums.begin(), window.sums.end(), 0.0);
+        std::fill(window.squares.begin(), window.squares.end(), 0.0);
+        std::fill(window.minima.begin(), window.minima.end(), kNoMin);
+        std::fill(window.maxima.begin(), window.maxima.end(), kNoMax);
+        std::fill(window.histograms.begin(), window.histograms.end(), 0);
+        std::fill(window.total.begin(), window.total.end(), 0u);
+    } else {
+        for (int64_t step = 1; step <= steps; ++step) clearSlot(window, slotOf(window.pane + step));
+    }
+    window.pane = pane;
+}
+
+void RollingStats::record(const Snapshot& snapshot, int64_t timeMs) {
+    if (!sameLayout(snapshot)) rebuild(snapshot);
+
+    double* out = values.data();
+    *out++ = snapshot.cpu->totalUsage;
+    *out++ = snapshot.memory->usagePercent;
+    *out++ = snapshot.network->downloadSpeed;
+    *out++ = snapshot.network->uploadSpeed;
+    for (double usage : snapshot.cpu->coreUsage) *out++ = usage;
+    for (const DiskInfo& disk : *snapshot.disks) {
+        *out++ = disk.readSpeed;
+        *out++ = disk.writeSpeed;
+    }
+    const size_t series = names.size();
+    for (size_t s = 0; s < series; ++s) buckets[s] = bucketOf(values[s]);
+
+    for (Window& window : windows) {
+        int64_t pane = floorDiv(timeMs, window.paneMs);
+        if (!window.started) {
+            window.pane = pane;
+            window.started = true;
+        } else if (pane > window.pane) {
+            advance(window, pane);
+        }
+
+        size_t slot = slotOf(window.pane);
+        uint32_t* counts = window.counts.data() + slot * series;
+        double* sums = window.sums.data() + slot * series;
+        double* squares = window.squares.data() + slot * series;
+        double* minima = window.minima.data() + slot * series;
+        double* maxima = window.maxima.data() + slot * series;
+        uint16_t* histograms = window.histograms.data() + slot * series * kBuckets;
+        for (size_t s = 0; s < series; ++s) {
+            double value = values[s];
+            if (!std::isfinite(value)) continue;
+            ++counts[s];
+            sums[s] += value;
+            squares[s] += value * value;
+            minima[s] = std::min(minima[s], value);
+            maxima[s] = std::max(maxima[s], value);
+            // A pane saturates rather than wraps; its percentiles then lag
+            uint16_t& cell = histograms[s * kBuckets + buckets[s]];
+            if (cell != UINT16_MAX) {
+                ++cell;
+                ++window.total[s * kBuckets + buckets[s]];
+            }
+        }
+    }
+}
+
+void RollingStats::summarize(RollingStatsInfo& out) {
+    const BucketTable& table = bucketTable();
+    const size_t series = names.size();
+    out.windows = windowSeconds;
+    out.metrics.resize(series);
+    for (size_t s = 0; s < series; ++s) {
+        out.metrics[s].name = names[s];
+        out.metrics[s].windows.resize(windows.size());
+    }
+
+    for (size_t w = 0; w < windows.size(); ++w) {
+        const Window& window = windows[w];
+        mergedCounts.assign(series, 0);
+        mergedSums.assign(series, 0.0);
+        mergedSquares.assign(series, 0.0);
+        mergedMinima.assign(series, kNoMin);
+        mergedMaxima.assign(series, kNoMax);
+        for (size_t slot = 0; slot < kPanes; ++slot) {
+            const uint32_t* counts = window.counts.data() + slot * series;
+            const double* sums = window.sums.data() + slot * series;
+            const double* squares = window.squares.data() + slot * series;
+            const double* minima = window.minima.data() + slot * series;
+            const double* maxima = window.maxima.data() + slot * series;
+            for (size_t s = 0; s < series; ++s) {
+                mergedCounts[s] += counts[s];
+                mergedSums[s] += sums[s];
+                mergedSquares[s] += squares[s];
+                mergedMinima[s] = std::min(mergedMinima[s], minima[s]);
+                mergedMaxima[s] = std::max(mergedMaxima[s], maxima[s]);
+            }
+        }
+
+        for (size_t s = 0; s < series; ++s) {
+            WindowStats& stats = out.metrics[s].windows[w];
+            stats = WindowStats();
+            uint32_t count = mergedCounts[s];
+            if (count == 0) continue;
+            stats.count = count;
+            stats.mean = mergedSums[s] / count;
+            stats.stddev = std::sqrt(std::max(0.0, mergedSquares[s] / count - stats.mean * stats.mean));
+            stats.max = mergedMaxima[s];
+
+            // Only the buckets between the window's min and max can be filled
+            const uint32_t* histogram = window.total.data() + s * kBuckets;
+            size_t first = bucketOf(mergedMinima[s]);
+            size_t last = bucketOf(mergedMaxima[s]);
+            uint64_t filled = 0;
+            for (size_t b = first; b <= last; ++b) filled += histogram[b];
+            const uint64_t ranks[] = {(filled + 1) / 2, (filled * 95 + 99) / 100, (filled * 99 + 99) / 100};
+            double* targets[] = {&stats.p50, &stats.p95, &stats.p99};
+            size_t next = 0;
+            uint64_t seen = 0;
+            for (size_t b = first; b <= last && next < 3; ++b) {
+                seen += histogram[b];
+                while (next < 3 && seen > 0 && seen >= ranks[next]) {
+                    // A bucket's representative value can fall outside the
+                    // samples it holds; a constant series reports itself
+                    *targets[next++] = std::min(std::max(table.value[b], mergedMinima[s]), stats.max);
+                }
+            }
+        }
+    }
+}
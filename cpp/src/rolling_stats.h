@@ -0,0 +1,86 @@
+#pragma once
+
+#include "../include/system_monitor.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Rolling p50/p95/p99/max, mean and standard deviation of the main host
+// metrics over a few sliding windows (1 min, 5 min and 1 h by default):
+//
+//   cpu.usage, cpu.core.N, memory.usagePercent, network.downloadSpeed,
+//   network.uploadSpeed, disk.<name>.readSpeed, disk.<name>.writeSpeed
+//
+// Each window is a ring of kPanes panes of window / kPanes, and covers the
+// panes in the ring, so it slides one pane at a time. Per series, a pane
+// keeps the count, sum, sum of squares, min and max of its samples and a
+// log-bucketed histogram (DDSketch-style, within 5% of the value); the
+// window also keeps the running sum of its panes' histograms. A sample is
+// O(1) per series. Recycling a pane subtracts its histogram from the running
+// one, and summarize() merges the pane scalars: both are flat passes over
+// [series] or [series][bucket] arrays that the compiler vectorizes, so
+// hundreds of cores stay cheap.
+//
+// Storage is allocated when the series layout is set (first sample, core
+// or disk set changed) and does not grow with time; series that survive a
+// layout change keep their history. Single-threaded: record() and
+// summarize() run on the same task.
+class RollingStats {
+public:
+    static constexpr size_t kPanes = 12;
+    static constexpr size_t kBuckets = 192;
+
+    static std::vector<int> defaultWindows(); // Seconds
+
+    explicit RollingStats(std::vector<int> windowSeconds = defaultWindows());
+
+    RollingStats(const RollingStats&) = delete;
+    RollingStats& operator=(const RollingStats&) = delete;
+
+    // Adds the snapshot's values at `timeMs`, on any clock that does not go
+    // backwards. Samples older than the current pane of a window count
+    // towards that pane.
+    void record(const Snapshot& snapshot, int64_t timeMs);
+
+    // Statistics of every series over every window as of the last record()
+    void summarize(RollingStatsInfo& out);
+
+    size_t seriesCount() const { return names.size(); }
+    size_t memoryBytes() const;
+
+private:
+    struct Window {
+        int64_t paneMs = 0;
+        int64_t pane = 0;  // Pane number of the newest slot
+        bool started = false;
+        std::vector<uint32_t> counts;     // [slot][series]
+        std::vector<double> sums;         // [slot][series]
+        std::vector<double> squares;      // [slot][series]
+        std::vector<double> minima;       // [slot][series]
+        std::vector<double> maxima;       // [slot][series]
+        std::vector<uint16_t> histograms; // [slot][series][bucket]
+        std::vector<uint32_t> total;      // [series][bucket], sum over the slots
+    };
+
+    std::vector<int> windowSeconds;
+    std::vector<Window> windows;
+    std::vector<std::string> names;
+    std::vector<double> values; // This sample, parallel to `names`
+    size_t coreCount = 0;
+    std::vector<std::string> diskNames;
+    bool initialized = false;
+
+    std::vector<uint16_t> buckets; // Histogram bucket of each value
+    // Merge scratch for summarize()
+    std::vector<uint32_t> mergedCounts;
+    std::vector<double> mergedSums;
+    std::vector<double> mergedSquares;
+    std::vector<double> mergedMinima;
+    std::vector<double> mergedMaxima;
+
+    bool sameLayout(const Snapshot& snapshot) const;
+    void rebuild(const Snapshot& snapshot);
+    void advance(Window& window, int64_t pane);
+    void clearSlot(Window& window, size_t slot);
+};
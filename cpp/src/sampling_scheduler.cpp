@@ -0,0 +1,140 @@
+#include "sampling_scheduler.h"
+#include <algorithm>
+
+SamplingScheduler::SamplingScheduler(size_t workerCount)
+    : workerCount(workerCount > 0 ? workerCount : 1) {}
+
+SamplingScheduler::~SamplingScheduler() {
+    stop();
+}
+
+void SamplingScheduler::addTask(const std::string& name, Clock::duration interval, std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) return;
+
+    Task entry;
+    entry.name = name;
+    entry.interval = interval > Clock::duration::zero() ? interval : std::chrono::milliseconds(1);
+    entry.fn = std::move(task);
+    tasks.push_back(std::move(entry));
+}
+
+bool SamplingScheduler::setInterval(const std::string& name, Clock::duration interval) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running || interval <= Clock::duration::zero()) return false;
+
+    for (Task& task : tasks) {
+        if (task.name == name) {
+            task.interval = interval;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SamplingScheduler::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running || tasks.empty()) return false;
+
+    auto now = Clock::now();
+    for (Task& task : tasks) {
+        task.deadline = now + task.interval;
+        task.pending = false;
+    }
+    ready.assign(tasks.size(), 0);
+    readyHead = 0;
+    readyCount = 0;
+    stopping = false;
+
+    size_t poolSize = std::min(workerCount, tasks.size());
+    for (size_t i = 0; i < poolSize; ++i) {
+        workers.emplace_back(&SamplingScheduler::workerLoop, this);
+    }
+    timerThread = std::thread(&SamplingScheduler::timerLoop, this);
+    running = true;
+    return true;
+}
+
+void SamplingScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) return;
+        stopping = true;
+    }
+    timerCv.notify_all();
+    workCv.notify_all();
+
+    timerThread.join();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    running = false;
+}
+
+std::vector<SamplingScheduler::TaskStats> SamplingScheduler::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<TaskStats> result;
+    result.reserve(tasks.size());
+    for (const Task& task : tasks) {
+        result.push_back({task.name, task.interval, task.runs, task.skipped, task.lateness->summarize()});
+    }
+    return result;
+}
+
+void SamplingScheduler::timerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (!stopping) {
+        auto now = Clock::now();
+        Clock::time_point nextWake = Clock::time_point::max();
+
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            Task& task = tasks[i];
+            if (task.deadline <= now) {
+                if (task.pending) {
+                    ++task.skipped; // still running from an earlier tick
+                } else {
+                    task.pending = true;
+                    task.due = task.deadline;
+                    ready[(readyHead + readyCount) % ready.size()] = i;
+                    ++readyCount;
+                    workCv.notify_one();
+                }
+
+                // Advance along the original grid to the first future deadline;
+                // any whole periods slept through are counted as skipped.
+                auto periodsBehind = (now - task.deadline) / task.interval;
+                task.skipped += static_cast<uint64_t>(periodsBehind);
+                task.deadline += (periodsBehind + 1) * task.interval;
+            }
+            nextWake = std::min(nextWake, task.deadline);
+        }
+
+        timerCv.wait_until(lock, nextWake, [this] { return stopping; });
+    }
+}
+
+void SamplingScheduler::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    for (;;) {
+        workCv.wait(lock, [this] { return stopping || readyCount > 0; });
+        if (stopping) return;
+
+        size_t index = ready[readyHead];
+        readyHead = (readyHead + 1) % ready.size();
+        --readyCount;
+        tasks[index].lateness->record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - tasks[index].due).count());
+
+        lock.unlock();
+        tasks[index].fn();
+        lock.lock();
+
+        tasks[index].pending = false;
+        ++tasks[index].runs;
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "latency_histogram.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Runs periodic tasks on a small worker pool, each on its own cadence.
+// Deadlines are absolute points on a fixed grid (start + k * interval), so
+// timing jitter never accumulates into drift. A task is never queued twice:
+// if it is still running when its next deadline passes, that tick is skipped
+// and counted instead of piling up behind it, and it only ever occupies one
+// worker. Tasks do share the workers, though: while every worker is busy
+// with a slow task, the others wait in the ready queue. How long each task
+// waited past its deadline is recorded, so that jitter shows up in stats().
+class SamplingScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct TaskStats {
+        std::string name;
+        Clock::duration interval;
+        uint64_t runs;
+        uint64_t skipped;
+        LatencyHistogram::Summary lateness; // Deadline to start of each run
+    };
+
+    explicit SamplingScheduler(size_t workerCount = 3);
+    ~SamplingScheduler();
+
+    SamplingScheduler(const SamplingScheduler&) = delete;
+    SamplingScheduler& operator=(const SamplingScheduler&) = delete;
+
+    // Tasks and intervals can only be changed while stopped
+    void addTask(const std::string& name, Clock::duration interval, std::function<void()> task);
+    bool setInterval(const std::string& name, Clock::duration interval);
+
+    bool start();
+    void stop();
+    bool isRunning() const { return running; }
+
+    std::vector<TaskStats> stats() const;
+
+private:
+    struct Task {
+        std::string name;
+        Clock::duration interval;
+        std::function<void()> fn;
+        Clock::time_point deadline;
+        Clock::time_point due; // Deadline of the queued run
+        bool pending = false; // queued or running
+        uint64_t runs = 0;
+        uint64_t skipped = 0;
+        // Recorded under the mutex, so there is one writer at a time
+        std::unique_ptr<LatencyHistogram> lateness = std::make_unique<LatencyHistogram>();
+    };
+
+    std::vector<Task> tasks;
+    size_t workerCount;
+
+    // Ready queue as a fixed ring: each task is in it at most once
+    std::vector<size_t> ready;
+    size_t readyHead = 0;
+    size_t readyCount = 0;
+
+    mutable std::mutex mutex;
+    std::condition_variable timerCv;
+    std::condition_variable workCv;
+    std::thread timerThread;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+    std::atomic<bool> running{false}; // Written under mutex, read without it by isRunning()
+
+    void timerLoop();
+    void workerLoop();
+};
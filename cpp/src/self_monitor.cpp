@@ -0,0 +1,65 @@
+#include "self_monitor.h"
+#include <psapi.h>
+
+#pragma comment(lib, "psapi.lib")
+
+namespace {
+constexpr double kBytesPerMB = 1024.0 * 1024.0;
+
+double fileTimeSeconds(const FILETIME& time) {
+    ULARGE_INTEGER value;
+    value.LowPart = time.dwLowDateTime;
+    value.HighPart = time.dwHighDateTime;
+    return value.QuadPart / 1e7; // 100 ns units
+}
+}
+
+SelfMonitor::SelfMonitor()
+    : process(GetCurrentProcess()), lastCpuSeconds(0.0), lastSyscalls(0), haveCounters(false) {}
+
+SelfMonitor::~SelfMonitor() = default;
+
+bool SelfMonitor::initialize() {
+    return true;
+}
+
+void SelfMonitor::readCounters(double& cpuSeconds, uint64_t& syscalls) {
+    FILETIME creation, exitTime, kernel, user;
+    cpuSeconds = 0.0;
+    if (GetProcessTimes(process, &creation, &exitTime, &kernel, &user)) {
+        cpuSeconds = fileTimeSeconds(kernel) + fileTimeSeconds(user);
+    }
+
+    // Read, write and other (device control, ...) I/O operations
+    IO_COUNTERS io;
+    syscalls = 0;
+    if (GetProcessIoCounters(process, &io)) {
+        syscalls = io.ReadOperationCount + io.WriteOperationCount + io.OtherOperationCount;
+    }
+}
+
+void SelfMonitor::update() {
+    PROCESS_MEMORY_COUNTERS memory;
+    if (GetProcessMemoryInfo(process, &memory, sizeof(memory))) {
+        info.rssMB = memory.WorkingSetSize / kBytesPerMB;
+    }
+
+    double cpuSeconds;
+    uint64_t syscalls;
+    readCounters(cpuSeconds, syscalls);
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - lastUpdateTime).count();
+    if (haveCounters && elapsed > 0.0) {
+        info.cpuUsage = cpuSeconds > lastCpuSeconds ? 100.0 * (cpuSeconds - lastCpuSeconds) / elapsed : 0.0;
+        info.syscalls = syscalls > lastSyscalls ? (syscalls - lastSyscalls) / elapsed : 0.0;
+    }
+    info.cpuSeconds = cpuSeconds;
+    lastCpuSeconds = cpuSeconds;
+    lastSyscalls = syscalls;
+    lastUpdateTime = now;
+    haveCounters = true;
+}
+
+SelfInfo SelfMonitor::getInfo() const {
+    return info;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "../include/system_monitor.h"
+#include "platform.h"
+#include <chrono>
+#include <cstdint>
+
+#ifdef MONITOR_BACKEND_LINUX
+#include "linux/procfs.h"
+#else
+#include <windows.h>
+#endif
+
+// The monitor process's own CPU time, resident set and syscall rate.
+// Collector timings are kept by SystemMonitor and merged in there.
+class SelfMonitor {
+public:
+    SelfMonitor();
+    ~SelfMonitor();
+    bool initialize();
+    void update();
+    SelfInfo getInfo() const;
+
+private:
+#ifdef MONITOR_BACKEND_LINUX
+    ProcFile statmFile;
+    ProcFile ioFile; // Not open without task I/O accounting
+    double pageSizeMB;
+#else
+    HANDLE process;
+#endif
+    double lastCpuSeconds;
+    uint64_t lastSyscalls;
+    std::chrono::steady_clock::time_point lastUpdateTime;
+    bool haveCounters;
+    SelfInfo info;
+
+    // Process CPU seconds and cumulative syscall count
+    void readCounters(double& cpuSeconds, uint64_t& syscalls);
+};
@@ -0,0 +1,772 @@
+#include "snapshot_json.h"
+#include "json_writer.h"
+#include <sstream>
+#include <iomanip>
+
+// Simple JSON string escaper for safe output
+static std::string escapeJson(const std::string& input) {
+    std::string out;
+    out.reserve(input.size() + 8);
+    for (char c : input) {
+        switch (c) {
+        case '\"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            // Only escape control chars; leave UTF-8 bytes as-is
+            if (static_cast<unsigned char>(c) < 0x20) {
+                // Skip other control characters
+                continue;
+            }
+            out += c;
+        }
+    }
+    return out;
+}
+
+// One-line CPUTimes object for the pretty printer
+static void writeTimes(std::ostringstream& json, const CPUTimes& times) {
+    json << "{\"user\": " << times.user << ", \"nice\": " << times.nice << ", \"system\": " << times.system
+         << ", \"idle\": " << times.idle << ", \"iowait\": " << times.iowait << ", \"irq\": " << times.irq
+         << ", \"softirq\": " << times.softirq << ", \"steal\": " << times.steal << "}";
+}
+
+// One process object; optional fields only when their ProcessField bit is set
+static void writeProcess(std::ostringstream& json, const ProcessInfo& proc) {
+    json << "    {\n";
+    json << "      \"name\": \"" << escapeJson(proc.name) << "\",\n";
+    json << "      \"pid\": " << proc.pid << ",\n";
+    json << "      \"cpuUsage\": " << proc.cpuUsage << ",\n";
+    if (proc.fields & kProcessThreads) json << "      \"threads\": " << proc.threads << ",\n";
+    if (proc.fields & kProcessState) json << "      \"state\": \"" << escapeJson(std::string(1, proc.state)) << "\",\n";
+    if (proc.fields & kProcessUid) json << "      \"uid\": " << proc.uid << ",\n";
+    if (proc.fields & kProcessContextSwitches) {
+        json << "      \"voluntarySwitches\": " << proc.voluntarySwitches << ",\n";
+        json << "      \"involuntarySwitches\": " << proc.involuntarySwitches << ",\n";
+    }
+    if (proc.fields & kProcessFds) json << "      \"fdCount\": " << proc.fdCount << ",\n";
+    if (proc.fields & kProcessIo) {
+        json << "      \"ioReadSpeed\": " << proc.ioReadSpeed << ",\n";
+        json << "      \"ioWriteSpeed\": " << proc.ioWriteSpeed << ",\n";
+    }
+    if (proc.fields & kProcessPss) {
+        json << "      \"pss\": " << proc.pss << ",\n";
+        json << "      \"swap\": " << proc.swap << ",\n";
+    }
+    if (proc.fields & kProcessCmdline) json << "      \"cmdline\": \"" << escapeJson(proc.cmdline) << "\",\n";
+    json << "      \"memoryUsage\": " << proc.memoryUsage << "\n";
+    json << "    }";
+}
+
+static void writeProcess(JsonWriter& json, const ProcessInfo& proc) {
+    json.beginObject();
+    json.field("name", proc.name);
+    json.field("pid", proc.pid);
+    json.field("cpuUsage", proc.cpuUsage);
+    json.field("memoryUsage", proc.memoryUsage);
+    if (proc.fields & kProcessThreads) json.field("threads", proc.threads);
+    if (proc.fields & kProcessState) json.field("state", std::string_view(&proc.state, 1));
+    if (proc.fields & kProcessUid) json.field("uid", proc.uid);
+    if (proc.fields & kProcessContextSwitches) {
+        json.field("voluntarySwitches", proc.voluntarySwitches);
+        json.field("involuntarySwitches", proc.involuntarySwitches);
+    }
+    if (proc.fields & kProcessFds) json.field("fdCount", proc.fdCount);
+    if (proc.fields & kProcessIo) {
+        json.field("ioReadSpeed", proc.ioReadSpeed);
+        json.field("ioWriteSpeed", proc.ioWriteSpeed);
+    }
+    if (proc.fields & kProcessPss) {
+        json.field("pss", proc.pss);
+        json.field("swap", proc.swap);
+    }
+    if (proc.fields & kProcessCmdline) json.field("cmdline", proc.cmdline);
+    json.endObject();
+}
+
+static void writeTimes(JsonWriter& json, const CPUTimes& times) {
+    json.beginObject();
+    json.field("user", times.user);
+    json.field("nice", times.nice);
+    json.field("system", times.system);
+    json.field("idle", times.idle);
+    json.field("iowait", times.iowait);
+    json.field("irq", times.irq);
+    json.field("softirq", times.softirq);
+    json.field("steal", times.steal);
+    json.endObject();
+}
+
+std::string formatSnapshotJSON(const Snapshot& snapshot, size_t maxProcesses) {
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(2);
+
+    json << "{\n";
+    
+    // CPU
+    const CPUInfo& cpu = *snapshot.cpu;
+    json << "  \"cpu\": {\n";
+    json << "    \"usage\": " << cpu.totalUsage << ",\n";
+    json << "    \"cores\": " << cpu.coreCount << ",\n";
+    json << "    \"frequency\": " << cpu.frequency << ",\n";
+    json << "    \"coreUsage\": [";
+    for (size_t i = 0; i < cpu.coreUsage.size(); ++i) {
+        if (i > 0) json << ", ";
+        json << cpu.coreUsage[i];
+    }
+    json << "],\n";
+    json << "    \"times\": ";
+    writeTimes(json, cpu.times);
+    json << ",\n";
+    json << "    \"coreTimes\": [\n";
+    for (size_t i = 0; i < cpu.coreTimes.size(); ++i) {
+        json << "      ";
+        writeTimes(json, cpu.coreTimes[i]);
+        if (i < cpu.coreTimes.size() - 1) json << ",";
+        json << "\n";
+    }
+    json << "    ],\n";
+    json << "    \"coreFrequency\": [";
+    for (size_t i = 0; i < cpu.coreFrequency.size(); ++i) {
+        if (i > 0) json << ", ";
+        json << cpu.coreFrequency[i];
+    }
+    json << "]\n";
+    json << "  },\n";
+
+    // GPU
+    const GPUInfo& gpu = *snapshot.gpu;
+    json << "  \"gpu\": {\n";
+    json << "    \"name\": \"" << escapeJson(gpu.name) << "\",\n";
+    json << "    \"usage\": " << gpu.usage << ",\n";
+    json << "    \"memoryUsed\": " << gpu.memoryUsed << ",\n";
+    json << "    \"memoryTotal\": " << gpu.memoryTotal << ",\n";
+    json << "    \"temperature\": " << gpu.temperature << "\n";
+    json << "  },\n";
+
+    // Memory
+    const MemoryInfo& mem = *snapshot.memory;
+    json << "  \"memory\": {\n";
+    json << "    \"total\": " << mem.total << ",\n";
+    json << "    \"used\": " << mem.used << ",\n";
+    json << "    \"free\": " << mem.free << ",\n";
+    json << "    \"usagePercent\": " << mem.usagePercent << ",\n";
+    json << "    \"cached\": " << mem.cached << ",\n";
+    json << "    \"buffers\": " << mem.buffers << ",\n";
+    json << "    \"slab\": " << mem.slab << ",\n";
+    json << "    \"slabReclaimable\": " << mem.slabReclaimable << ",\n";
+    json << "    \"shmem\": " << mem.shmem << ",\n";
+    json << "    \"swapTotal\": " << mem.swapTotal << ",\n";
+    json << "    \"swapUsed\": " << mem.swapUsed << ",\n";
+    json << "    \"dirty\": " << mem.dirty << ",\n";
+    json << "    \"writeback\": " << mem.writeback << ",\n";
+    json << "    \"hugePagesTotal\": " << mem.hugePagesTotal << ",\n";
+    json << "    \"hugePagesUsed\": " << mem.hugePagesUsed << ",\n";
+    json << "    \"pageFaults\": " << mem.pageFaults << ",\n";
+    json << "    \"majorFaults\": " << mem.majorFaults << ",\n";
+    json << "    \"swapIn\": " << mem.swapIn << ",\n";
+    json << "    \"swapOut\": " << mem.swapOut << ",\n";
+    json << "    \"pagesScanned\": " << mem.pagesScanned << ",\n";
+    json << "    \"pagesReclaimed\": " << mem.pagesReclaimed << ",\n";
+    json << "    \"allocStalls\": " << mem.allocStalls << ",\n";
+    json << "    \"oomKills\": " << mem.oomKills << ",\n";
+    const MemoryPressure& pressure = mem.pressure;
+    json << "    \"pressure\": {\n";
+    json << "      \"some10\": " << pressure.some10 << ",\n";
+    json << "      \"some60\": " << pressure.some60 << ",\n";
+    json << "      \"some300\": " << pressure.some300 << ",\n";
+    json << "      \"full10\": " << pressure.full10 << ",\n";
+    json << "      \"full60\": " << pressure.full60 << ",\n";
+    json << "      \"full300\": " << pressure.full300 << ",\n";
+    json << "      \"available\": " << (pressure.available ? "true" : "false") << "\n";
+    json << "    }\n";
+    json << "  },\n";
+
+    // Disk
+    const std::vector<DiskInfo>& disks = *snapshot.disks;
+    json << "  \"disks\": [\n";
+    for (size_t i = 0; i < disks.size(); ++i) {
+        json << "    {\n";
+        json << "      \"name\": \"" << escapeJson(disks[i].name) << "\",\n";
+        json << "      \"mountPoint\": \"" << escapeJson(disks[i].mountPoint) << "\",\n";
+        json << "      \"total\": " << disks[i].total << ",\n";
+        json << "      \"used\": " << disks[i].used << ",\n";
+        json << "      \"free\": " << disks[i].free << ",\n";
+        json << "      \"readSpeed\": " << disks[i].readSpeed << ",\n";
+        json << "      \"writeSpeed\": " << disks[i].writeSpeed << ",\n";
+        json << "      \"readIops\": " << disks[i].readIops << ",\n";
+        json << "      \"writeIops\": " << disks[i].writeIops << ",\n";
+        json << "      \"queueDepth\": " << disks[i].queueDepth << ",\n";
+        json << "      \"latency\": " << disks[i].latency << "\n";
+        json << "    }";
+        if (i < disks.size() - 1) json << ",";
+        json << "\n";
+    }
+    json << "  ],\n";
+
+    // Network
+    const NetworkInfo& net = *snapshot.network;
+    json << "  \"network\": {\n";
+    json << "    \"downloadSpeed\": " << net.downloadSpeed << ",\n";
+    json << "    \"uploadSpeed\": " << net.uploadSpeed << ",\n";
+    json << "    \"activeConnections\": " << net.activeConnections << ",\n";
+    const SocketStats& sockets = net.sockets;
+    json << "    \"sockets\": {\n";
+    json << "      \"tcp\": " << sockets.tcp << ",\n";
+    json << "      \"tcpTimeWait\": " << sockets.tcpTimeWait << ",\n";
+    json << "      \"tcpOrphan\": " << sockets.tcpOrphan << ",\n";
+    json << "      \"udp\": " << sockets.udp << ",\n";
+    json << "      \"established\": " << sockets.established << ",\n";
+    json << "      \"synSent\": " << sockets.synSent << ",\n";
+    json << "      \"synRecv\": " << sockets.synRecv << ",\n";
+    json << "      \"finWait1\": " << sockets.finWait1 << ",\n";
+    json << "      \"finWait2\": " << sockets.finWait2 << ",\n";
+    json << "      \"closeWait\": " << sockets.closeWait << ",\n";
+    json << "      \"lastAck\": " << sockets.lastAck << ",\n";
+    json << "      \"listen\": " << sockets.listen << ",\n";
+    json << "      \"closing\": " << sockets.closing << ",\n";
+    json << "      \"closed\": " << sockets.closed << ",\n";
+    json << "      \"udpConnected\": " << sockets.udpConnected << "\n";
+    json << "    },\n";
+    const std::vector<InterfaceInfo>& interfaces = net.interfaces;
+    json << "    \"interfaces\": [\n";
+    for (size_t i = 0; i < interfaces.size(); ++i) {
+        json << "      {\n";
+        json << "        \"name\": \"" << escapeJson(interfaces[i].name) << "\",\n";
+        json << "        \"downloadSpeed\": " << interfaces[i].downloadSpeed << ",\n";
+        json << "        \"uploadSpeed\": " << interfaces[i].uploadSpeed << ",\n";
+        json << "        \"rxPackets\": " << interfaces[i].rxPackets << ",\n";
+        json << "        \"txPackets\": " << interfaces[i].txPackets << ",\n";
+        json << "        \"rxErrors\": " << interfaces[i].rxErrors << ",\n";
+        json << "        \"txErrors\": " << interfaces[i].txErrors << ",\n";
+        json << "        \"rxDropped\": " << interfaces[i].rxDropped << ",\n";
+        json << "        \"txDropped\": " << interfaces[i].txDropped << "\n";
+        json << "      }";
+        if (i < interfaces.size() - 1) json << ",";
+        json << "\n";
+    }
+    json << "    ]\n";
+    json << "  },\n";
+
+    // Processes
+    const ProcessActivity& activity = *snapshot.processActivity;
+    json << "  \"processActivity\": {\n";
+    json << "    \"total\": " << activity.total << ",\n";
+    json << "    \"spawned\": " << activity.spawned << ",\n";
+    json << "    \"exited\": " << activity.exited << ",\n";
+    json << "    \"eventDriven\": " << (activity.eventDriven ? "true" : "false") << "\n";
+    json << "  },\n";
+    const std::vector<ProcessInfo>& processes = *snapshot.processes;
+    size_t processCount = processes.size() < maxProcesses ? processes.size() : maxProcesses;
+    json << "  \"processes\": [\n";
+    for (size_t i = 0; i < processCount; ++i) {
+        writeProcess(json, processes[i]);
+        if (i < processCount - 1) json << ",";
+        json << "\n";
+    }
+    json << "  ],\n";
+    const std::vector<ProcessInfo>& watched = *snapshot.watchedProcesses;
+    json << "  \"watchedProcesses\": [\n";
+    for (size_t i = 0; i < watched.size(); ++i) {
+        writeProcess(json, watched[i]);
+        if (i < watched.size() - 1) json << ",";
+        json << "\n";
+    }
+    json << "  ],\n";
+
+    // cgroups: pre-order, each entry names its parent's index
+    const std::vector<CgroupInfo>& cgroups = *snapshot.cgroups;
+    json << "  \"cgroups\": [\n";
+    for (size_t i = 0; i < cgroups.size(); ++i) {
+        json << "    {\n";
+        json << "      \"path\": \"" << escapeJson(cgroups[i].path) << "\",\n";
+        json << "      \"parent\": " << cgroups[i].parent << ",\n";
+        json << "      \"cpuUsage\": " << cgroups[i].cpuUsage << ",\n";
+        json << "      \"cpuThrottled\": " << cgroups[i].cpuThrottled << ",\n";
+        json << "      \"memoryCurrent\": " << cgroups[i].memoryCurrent << ",\n";
+        json << "      \"memoryAnon\": " << cgroups[i].memoryAnon << ",\n";
+        json << "      \"memoryFile\": " << cgroups[i].memoryFile << ",\n";
+        json << "      \"ioReadSpeed\": " << cgroups[i].ioReadSpeed << ",\n";
+        json << "      \"ioWriteSpeed\": " << cgroups[i].ioWriteSpeed << ",\n";
+        json << "      \"ioReadIops\": " << cgroups[i].ioReadIops << ",\n";
+        json << "      \"ioWriteIops\": " << cgroups[i].ioWriteIops << ",\n";
+        json << "      \"cpuPressure\": " << cgroups[i].cpuPressure << ",\n";
+        json << "      \"memoryPressure\": " << cgroups[i].memoryPressure << ",\n";
+        json << "      \"memoryPressureFull\": " << cgroups[i].memoryPressureFull << ",\n";
+        json << "      \"ioPressure\": " << cgroups[i].ioPressure << ",\n";
+        json << "      \"ioPressureFull\": " << cgroups[i].ioPressureFull << "\n";
+        json << "    }";
+        if (i < cgroups.size() - 1) json << ",";
+        json << "\n";
+    }
+    json << "  ],\n";
+
+    // Thread sampler: per-thread summaries of the last interval
+    const ThreadSamplerStats& sampler = *snapshot.threadSampler;
+    json << "  \"threadSampler\": {\n";
+    json << "    \"enabled\": " << (sampler.enabled ? "true" : "false") << ",\n";
+    json << "    \"pinned\": " << (sampler.pinned ? "true" : "false") << ",\n";
+    json << "    \"rate\": " << sampler.rate << ",\n";
+    json << "    \"overhead\": " << sampler.overhead << ",\n";
+    json << "    \"dropped\": " << sampler.dropped << ",\n";
+    json << "    \"missedTicks\": " << sampler.missedTicks << "\n";
+    json << "  },\n";
+    const std::vector<ThreadStats>& threads = *snapshot.threads;
+    json << "  \"threads\": [\n";
+    for (size_t i = 0; i < threads.size(); ++i) {
+        const ThreadStats& thread = threads[i];
+        json << "    {\n";
+        json << "      \"pid\": " << thread.pid << ",\n";
+        json << "      \"tid\": " << thread.tid << ",\n";
+        json << "      \"name\": \"" << escapeJson(thread.name) << "\",\n";
+        json << "      \"samples\": " << thread.samples << ",\n";
+        json << "      \"cpuUsage\": " << thread.cpuUsage << ",\n";
+        json << "      \"cpu\": {\"p50\": " << thread.cpuP50 << ", \"p95\": " << thread.cpuP95
+             << ", \"p99\": " << thread.cpuP99 << ", \"max\": " << thread.cpuMax << "},\n";
+        json << "      \"wait\": {\"p50\": " << thread.waitP50 << ", \"p95\": " << thread.waitP95
+             << ", \"p99\": " << thread.waitP99 << ", \"max\": " << thread.waitMax << "},\n";
+        json << "      \"contextSwitches\": " << thread.contextSwitches << ",\n";
+        json << "      \"migrations\": " << thread.migrations << "\n";
+        json << "    }";
+        if (i < threads.size() - 1) json << ",";
+        json << "\n";
+    }
+    json << "  ],\n";
+
+    // Rolling statistics: one entry per window of every metric
+    const RollingStatsInfo& stats = *snapshot.stats;
+    json << "  \"stats\": {\n";
+    json << "    \"windows\": [";
+    for (size_t i = 0; i < stats.windows.size(); ++i) {
+        if (i > 0) json << ", ";
+        json << stats.windows[i];
+    }
+    json << "],\n";
+    json << "    \"metrics\": [\n";
+    for (size_t i = 0; i < stats.metrics.size(); ++i) {
+        const MetricStats& metric = stats.metrics[i];
+        json << "      {\"name\": \"" << escapeJson(metric.name) << "\", \"windows\": [";
+        for (size_t w = 0; w < metric.windows.size(); ++w) {
+            const WindowStats& window = metric.windows[w];
+            if (w > 0) json << ", ";
+            json << "{\"count\": " << window.count << ", \"mean\": " << window.mean
+                 << ", \"stddev\": " << window.stddev << ", \"p50\": " << window.p50 << ", \"p95\": " << window.p95
+                 << ", \"p99\": " << window.p99 << ", \"max\": " << window.max << "}";
+        }
+        json << "]}";
+        if (i < stats.metrics.size() - 1) json << ",";
+        json << "\n";
+    }
+    json << "    ]\n";
+    json << "  },\n";
+
+    // Series the anomaly detectors flag in this sample
+    const AnomalyInfo& anomalies = *snapshot.anomalies;
+    json << "  \"anomalies\": {\n";
+    json << "    \"series\": " << anomalies.series << ",\n";
+    json << "    \"flagged\": [\n";
+    for (size_t i = 0; i < anomalies.flagged.size(); ++i) {
+        const MetricAnomaly& anomaly = anomalies.flagged[i];
+        json << "      {\"metric\": \"" << escapeJson(anomaly.metric) << "\", \"detector\": \""
+             << escapeJson(anomaly.detector) << "\", \"value\": " << anomaly.value
+             << ", \"expected\": " << anomaly.expected << ", \"score\": " << anomaly.score
+             << ", \"sinceMs\": " << anomaly.sinceMs << "}";
+        if (i < anomalies.flagged.size() - 1) json << ",";
+        json << "\n";
+    }
+    json << "    ]\n";
+    json << "  },\n";
+
+    // Alert rules firing now, and the latest transitions
+    const AlertsInfo& alerts = *snapshot.alerts;
+    json << "  \"alerts\": {\n";
+    json << "    \"active\": [\n";
+    for (size_t i = 0; i < alerts.active.size(); ++i) {
+        const ActiveAlert& alert = alerts.active[i];
+        json << "      {\"rule\": \"" << escapeJson(alert.rule) << "\", \"target\": \"" << escapeJson(alert.target)
+             << "\", \"value\": " << alert.value << ", \"sinceMs\": " << alert.sinceMs << "}";
+        if (i < alerts.active.size() - 1) json << ",";
+        json << "\n";
+    }
+    json << "    ],\n";
+    json << "    \"events\": [\n";
+    for (size_t i = 0; i < alerts.events.size(); ++i) {
+        const AlertEvent& event = alerts.events[i];
+        json << "      {\"sequence\": " << event.sequence << ", \"timestampMs\": " << event.timestampMs
+             << ", \"firing\": " << (event.firing ? "true" : "false") << ", \"rule\": \"" << escapeJson(event.rule)
+             << "\", \"target\": \"" << escapeJson(event.target) << "\", \"value\": " << event.value << "}";
+        if (i < alerts.events.size() - 1) json << ",";
+        json << "\n";
+    }
+    json << "    ]\n";
+    json << "  },\n";
+
+    // The monitor's own cost
+    const SelfInfo& self = *snapshot.self;
+    json << "  \"self\": {\n";
+    json << "    \"cpuUsage\": " << self.cpuUsage << ",\n";
+    json << "    \"cpuSeconds\": " << self.cpuSeconds << ",\n";
+    json << "    \"rssMB\": " << self.rssMB << ",\n";
+    json << "    \"syscalls\": " << self.syscalls << ",\n";
+    json << "    \"collectors\": [\n";
+    for (size_t i = 0; i < self.collectors.size(); ++i) {
+        const CollectorTiming& timing = self.collectors[i];
+        json << "      {\"name\": \"" << escapeJson(timing.name) << "\", \"samples\": " << timing.samples
+             << ", \"skipped\": " << timing.skipped << ", \"lastUs\": " << timing.lastUs
+             << ", \"meanUs\": " << timing.meanUs << ", \"p50Us\": " << timing.p50Us
+             << ", \"p95Us\": " << timing.p95Us << ", \"p99Us\": " << timing.p99Us
+             << ", \"maxUs\": " << timing.maxUs << ", \"lateP99Us\": " << timing.lateP99Us
+             << ", \"lateMaxUs\": " << timing.lateMaxUs << "}";
+        if (i < self.collectors.size() - 1) json << ",";
+        json << "\n";
+    }
+    json << "    ]\n";
+    json << "  }\n";
+
+    json << "}\n";
+    return json.str();
+}
+
+void writeSnapshotNDJSON(const Snapshot& snapshot, std::string& out, size_t maxProcesses) {
+    out.clear();
+    JsonWriter json(out);
+
+    json.beginObject();
+
+    // CPU
+    const CPUInfo& cpu = *snapshot.cpu;
+    json.key("cpu");
+    json.beginObject();
+    json.field("usage", cpu.totalUsage);
+    json.field("cores", cpu.coreCount);
+    json.field("frequency", cpu.frequency);
+    json.key("coreUsage");
+    json.beginArray();
+    for (double usage : cpu.coreUsage) json.value(usage);
+    json.endArray();
+    json.key("times");
+    writeTimes(json, cpu.times);
+    json.key("coreTimes");
+    json.beginArray();
+    for (const CPUTimes& times : cpu.coreTimes) writeTimes(json, times);
+    json.endArray();
+    json.key("coreFrequency");
+    json.beginArray();
+    for (double mhz : cpu.coreFrequency) json.value(mhz);
+    json.endArray();
+    json.endObject();
+
+    // GPU
+    const GPUInfo& gpu = *snapshot.gpu;
+    json.key("gpu");
+    json.beginObject();
+    json.field("name", gpu.name);
+    json.field("usage", gpu.usage);
+    json.field("memoryUsed", gpu.memoryUsed);
+    json.field("memoryTotal", gpu.memoryTotal);
+    json.field("temperature", gpu.temperature);
+    json.endObject();
+
+    // Memory
+    const MemoryInfo& mem = *snapshot.memory;
+    json.key("memory");
+    json.beginObject();
+    json.field("total", mem.total);
+    json.field("used", mem.used);
+    json.field("free", mem.free);
+    json.field("usagePercent", mem.usagePercent);
+    json.field("cached", mem.cached);
+    json.field("buffers", mem.buffers);
+    json.field("slab", mem.slab);
+    json.field("slabReclaimable", mem.slabReclaimable);
+    json.field("shmem", mem.shmem);
+    json.field("swapTotal", mem.swapTotal);
+    json.field("swapUsed", mem.swapUsed);
+    json.field("dirty", mem.dirty);
+    json.field("writeback", mem.writeback);
+    json.field("hugePagesTotal", mem.hugePagesTotal);
+    json.field("hugePagesUsed", mem.hugePagesUsed);
+    json.field("pageFaults", mem.pageFaults);
+    json.field("majorFaults", mem.majorFaults);
+    json.field("swapIn", mem.swapIn);
+    json.field("swapOut", mem.swapOut);
+    json.field("pagesScanned", mem.pagesScanned);
+    json.field("pagesReclaimed", mem.pagesReclaimed);
+    json.field("allocStalls", mem.allocStalls);
+    json.field("oomKills", mem.oomKills);
+    json.key("pressure");
+    json.beginObject();
+    json.field("some10", mem.pressure.some10);
+    json.field("some60", mem.pressure.some60);
+    json.field("some300", mem.pressure.some300);
+    json.field("full10", mem.pressure.full10);
+    json.field("full60", mem.pressure.full60);
+    json.field("full300", mem.pressure.full300);
+    json.field("available", mem.pressure.available);
+    json.endObject();
+    json.endObject();
+
+    // Disk
+    json.key("disks");
+    json.beginArray();
+    for (const DiskInfo& disk : *snapshot.disks) {
+        json.beginObject();
+        json.field("name", disk.name);
+        json.field("mountPoint", disk.mountPoint);
+        json.field("total", disk.total);
+        json.field("used", disk.used);
+        json.field("free", disk.free);
+        json.field("readSpeed", disk.readSpeed);
+        json.field("writeSpeed", disk.writeSpeed);
+        json.field("readIops", disk.readIops);
+        json.field("writeIops", disk.writeIops);
+        json.field("queueDepth", disk.queueDepth);
+        json.field("latency", disk.latency);
+        json.endObject();
+    }
+    json.endArray();
+
+    // Network
+    const NetworkInfo& net = *snapshot.network;
+    json.key("network");
+    json.beginObject();
+    json.field("downloadSpeed", net.downloadSpeed);
+    json.field("uploadSpeed", net.uploadSpeed);
+    json.field("activeConnections", net.activeConnections);
+    const SocketStats& sockets = net.sockets;
+    json.key("sockets");
+    json.beginObject();
+    json.field("tcp", sockets.tcp);
+    json.field("tcpTimeWait", sockets.tcpTimeWait);
+    json.field("tcpOrphan", sockets.tcpOrphan);
+    json.field("udp", sockets.udp);
+    json.field("established", sockets.established);
+    json.field("synSent", sockets.synSent);
+    json.field("synRecv", sockets.synRecv);
+    json.field("finWait1", sockets.finWait1);
+    json.field("finWait2", sockets.finWait2);
+    json.field("closeWait", sockets.closeWait);
+    json.field("lastAck", sockets.lastAck);
+    json.field("listen", sockets.listen);
+    json.field("closing", sockets.closing);
+    json.field("closed", sockets.closed);
+    json.field("udpConnected", sockets.udpConnected);
+    json.endObject();
+    json.key("interfaces");
+    json.beginArray();
+    for (const InterfaceInfo& iface : net.interfaces) {
+        json.beginObject();
+        json.field("name", iface.name);
+        json.field("downloadSpeed", iface.downloadSpeed);
+        json.field("uploadSpeed", iface.uploadSpeed);
+        json.field("rxPackets", iface.rxPackets);
+        json.field("txPackets", iface.txPackets);
+        json.field("rxErrors", iface.rxErrors);
+        json.field("txErrors", iface.txErrors);
+        json.field("rxDropped", iface.rxDropped);
+        json.field("txDropped", iface.txDropped);
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+
+    // Processes
+    const ProcessActivity& activity = *snapshot.processActivity;
+    json.key("processActivity");
+    json.beginObject();
+    json.field("total", activity.total);
+    json.field("spawned", activity.spawned);
+    json.field("exited", activity.exited);
+    json.field("eventDriven", activity.eventDriven);
+    json.endObject();
+
+    const std::vector<ProcessInfo>& processes = *snapshot.processes;
+    size_t processCount = processes.size() < maxProcesses ? processes.size() : maxProcesses;
+    json.key("processes");
+    json.beginArray();
+    for (size_t i = 0; i < processCount; ++i) writeProcess(json, processes[i]);
+    json.endArray();
+    json.key("watchedProcesses");
+    json.beginArray();
+    for (const ProcessInfo& proc : *snapshot.watchedProcesses) writeProcess(json, proc);
+    json.endArray();
+
+    // cgroups: pre-order, each entry names its parent's index
+    json.key("cgroups");
+    json.beginArray();
+    for (const CgroupInfo& group : *snapshot.cgroups) {
+        json.beginObject();
+        json.field("path", group.path);
+        json.field("parent", group.parent);
+        json.field("cpuUsage", group.cpuUsage);
+        json.field("cpuThrottled", group.cpuThrottled);
+        json.field("memoryCurrent", group.memoryCurrent);
+        json.field("memoryAnon", group.memoryAnon);
+        json.field("memoryFile", group.memoryFile);
+        json.field("ioReadSpeed", group.ioReadSpeed);
+        json.field("ioWriteSpeed", group.ioWriteSpeed);
+        json.field("ioReadIops", group.ioReadIops);
+        json.field("ioWriteIops", group.ioWriteIops);
+        json.field("cpuPressure", group.cpuPressure);
+        json.field("memoryPressure", group.memoryPressure);
+        json.field("memoryPressureFull", group.memoryPressureFull);
+        json.field("ioPressure", group.ioPressure);
+        json.field("ioPressureFull", group.ioPressureFull);
+        json.endObject();
+    }
+    json.endArray();
+
+    // Thread sampler: per-thread summaries of the last interval
+    const ThreadSamplerStats& sampler = *snapshot.threadSampler;
+    json.key("threadSampler");
+    json.beginObject();
+    json.field("enabled", sampler.enabled);
+    json.field("pinned", sampler.pinned);
+    json.field("rate", sampler.rate);
+    json.field("overhead", sampler.overhead);
+    json.field("dropped", sampler.dropped);
+    json.field("missedTicks", sampler.missedTicks);
+    json.endObject();
+    json.key("threads");
+    json.beginArray();
+    for (const ThreadStats& thread : *snapshot.threads) {
+        json.beginObject();
+        json.field("pid", thread.pid);
+        json.field("tid", thread.tid);
+        json.field("name", thread.name);
+        json.field("samples", thread.samples);
+        json.field("cpuUsage", thread.cpuUsage);
+        json.key("cpu");
+        json.beginObject();
+        json.field("p50", thread.cpuP50);
+        json.field("p95", thread.cpuP95);
+        json.field("p99", thread.cpuP99);
+        json.field("max", thread.cpuMax);
+        json.endObject();
+        json.key("wait");
+        json.beginObject();
+        json.field("p50", thread.waitP50);
+        json.field("p95", thread.waitP95);
+        json.field("p99", thread.waitP99);
+        json.field("max", thread.waitMax);
+        json.endObject();
+        json.field("contextSwitches", thread.contextSwitches);
+        json.field("migrations", thread.migrations);
+        json.endObject();
+    }
+    json.endArray();
+
+    // Rolling statistics: one entry per window of every metric
+    json.key("stats");
+    json.beginObject();
+    json.key("windows");
+    json.beginArray();
+    for (int window : snapshot.stats->windows) json.value(window);
+    json.endArray();
+    json.key("metrics");
+    json.beginArray();
+    for (const MetricStats& metric : snapshot.stats->metrics) {
+        json.beginObject();
+        json.field("name", metric.name);
+        json.key("windows");
+        json.beginArray();
+        for (const WindowStats& window : metric.windows) {
+            json.beginObject();
+            json.field("count", window.count);
+            json.field("mean", window.mean);
+            json.field("stddev", window.stddev);
+            json.field("p50", window.p50);
+            json.field("p95", window.p95);
+            json.field("p99", window.p99);
+            json.field("max", window.max);
+            json.endObject();
+        }
+        json.endArray();
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+
+    // Series the anomaly detectors flag in this sample
+    json.key("anomalies");
+    json.beginObject();
+    json.field("series", snapshot.anomalies->series);
+    json.key("flagged");
+    json.beginArray();
+    for (const MetricAnomaly& anomaly : snapshot.anomalies->flagged) {
+        json.beginObject();
+        json.field("metric", anomaly.metric);
+        json.field("detector", anomaly.detector);
+        json.field("value", anomaly.value);
+        json.field("expected", anomaly.expected);
+        json.field("score", anomaly.score);
+        json.field("sinceMs", anomaly.sinceMs);
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+
+    // Alert rules firing now, and the latest transitions
+    json.key("alerts");
+    json.beginObject();
+    json.key("active");
+    json.beginArray();
+    for (const ActiveAlert& alert : snapshot.alerts->active) {
+        json.beginObject();
+        json.field("rule", alert.rule);
+        json.field("target", alert.target);
+        json.field("value", alert.value);
+        json.field("sinceMs", alert.sinceMs);
+        json.endObject();
+    }
+    json.endArray();
+    json.key("events");
+    json.beginArray();
+    for (const AlertEvent& event : snapshot.alerts->events) {
+        json.beginObject();
+        json.field("sequence", event.sequence);
+        json.field("timestampMs", event.timestampMs);
+        json.field("firing", event.firing);
+        json.field("rule", event.rule);
+        json.field("target", event.target);
+        json.field("value", event.value);
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+
+    // The monitor's own cost
+    const SelfInfo& self = *snapshot.self;
+    json.key("self");
+    json.beginObject();
+    json.field("cpuUsage", self.cpuUsage);
+    json.field("cpuSeconds", self.cpuSeconds);
+    json.field("rssMB", self.rssMB);
+    json.field("syscalls", self.syscalls);
+    json.key("collectors");
+    json.beginArray();
+    for (const CollectorTiming& timing : self.collectors) {
+        json.beginObject();
+        json.field("name", timing.name);
+        json.field("samples", timing.samples);
+        json.field("skipped", timing.skipped);
+        json.field("lastUs", timing.lastUs);
+        json.field("meanUs", timing.meanUs);
+        json.field("p50Us", timing.p50Us);
+        json.field("p95Us", timing.p95Us);
+        json.field("p99Us", timing.p99Us);
+        json.field("maxUs", timing.maxUs);
+        json.field("lateP99Us", timing.lateP99Us);
+        json.field("lateMaxUs", timing.lateMaxUs);
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+
+    json.endObject();
+    out += '\n';
+}
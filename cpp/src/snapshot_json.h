@@ -0,0 +1,18 @@
+#pragma once
+
+#include "../include/system_monitor.h"
+#include <cstddef>
+#include <string>
+
+// Number of processes included in serialized snapshots
+constexpr size_t kSnapshotJsonProcesses = 10;
+
+// Multi-line, indented JSON built with an ostringstream (the original
+// output format of `monitor`)
+std::string formatSnapshotJSON(const Snapshot& snapshot, size_t maxProcesses = kSnapshotJsonProcesses);
+
+// The same document as one compact NDJSON line terminated by '\n'. `out` is
+// overwritten but its capacity is reused, so repeated calls with the same
+// buffer do not allocate once it has grown to the document size.
+void writeSnapshotNDJSON(const Snapshot& snapshot, std::string& out,
+                         size_t maxProcesses = kSnapshotJsonProcesses);
@@ -0,0 +1,149 @@
+#include "snapshot_metrics.h"
+#include <limits>
+
+namespace {
+const double kNoData = std::numeric_limits<double>::quiet_NaN();
+
+constexpr MetricUnit kPlain = MetricUnit::Plain;
+constexpr MetricUnit kMegabytes = MetricUnit::Megabytes;
+constexpr MetricUnit kGigabytes = MetricUnit::Gigabytes;
+
+double count(uint64_t value) {
+    return static_cast<double>(value);
+}
+}
+
+const std::vector<MetricField<Snapshot>>& SnapshotMetrics::hostFields() {
+    using C = Collector;
+    static const std::vector<MetricField<Snapshot>> fields = {
+        {"cpu.usage", C::CPU, kPlain, false, [](const Snapshot& s) { return s.cpu->totalUsage; }},
+        {"cpu.frequency", C::CPU, kPlain, false, [](const Snapshot& s) { return s.cpu->frequency; }},
+        {"cpu.user", C::CPU, kPlain, false, [](const Snapshot& s) { return s.cpu->times.user; }},
+        {"cpu.system", C::CPU, kPlain, false, [](const Snapshot& s) { return s.cpu->times.system; }},
+        {"cpu.iowait", C::CPU, kPlain, false, [](const Snapshot& s) { return s.cpu->times.iowait; }},
+        {"cpu.irq", C::CPU, kPlain, false, [](const Snapshot& s) { return s.cpu->times.irq; }},
+        {"cpu.softirq", C::CPU, kPlain, false, [](const Snapshot& s) { return s.cpu->times.softirq; }},
+        {"cpu.steal", C::CPU, kPlain, false, [](const Snapshot& s) { return s.cpu->times.steal; }},
+        {"gpu.usage", C::GPU, kPlain, false, [](const Snapshot& s) { return s.gpu->usage; }},
+        {"gpu.memoryUsed", C::GPU, kMegabytes, false, [](const Snapshot& s) { return s.gpu->memoryUsed; }},
+        {"gpu.temperature", C::GPU, kPlain, false, [](const Snapshot& s) { return s.gpu->temperature; }},
+        {"memory.used", C::Memory, kMegabytes, false, [](const Snapshot& s) { return s.memory->used; }},
+        {"memory.free", C::Memory, kMegabytes, false, [](const Snapshot& s) { return s.memory->free; }},
+        {"memory.usagePercent", C::Memory, kPlain, false, [](const Snapshot& s) { return s.memory->usagePercent; }},
+        {"memory.cached", C::Memory, kMegabytes, false, [](const Snapshot& s) { return s.memory->cached; }},
+        {"memory.swapUsed", C::Memory, kMegabytes, false, [](const Snapshot& s) { return s.memory->swapUsed; }},
+        {"memory.dirty", C::Memory, kMegabytes, false, [](const Snapshot& s) { return s.memory->dirty; }},
+        {"memory.majorFaults", C::Memory, kPlain, false, [](const Snapshot& s) { return s.memory->majorFaults; }},
+        {"memory.swapIn", C::Memory, kPlain, false, [](const Snapshot& s) { return s.memory->swapIn; }},
+        {"memory.swapOut", C::Memory, kPlain, false, [](const Snapshot& s) { return s.memory->swapOut; }},
+        {"memory.pagesReclaimed", C::Memory, kPlain, false, [](const Snapshot& s) { return s.memory->pagesReclaimed; }},
+        {"memory.allocStalls", C::Memory, kPlain, false, [](const Snapshot& s) { return s.memory->allocStalls; }},
+        {"memory.oomKills", C::Memory, kPlain, true, [](const Snapshot& s) { return count(s.memory->oomKills); }},
+        {"memory.pressure.some10", C::Memory, kPlain, false,
+         [](const Snapshot& s) { return s.memory->pressure.some10; }},
+        {"memory.pressure.full10", C::Memory, kPlain, false,
+         [](const Snapshot& s) { return s.memory->pressure.full10; }},
+        {"network.downloadSpeed", C::Network, kMegabytes, false,
+         [](const Snapshot& s) { return s.network->downloadSpeed; }},
+        {"network.uploadSpeed", C::Network, kMegabytes, false, [](const Snapshot& s) { return s.network->uploadSpeed; }},
+        {"network.activeConnections", C::Network, kPlain, false,
+         [](const Snapshot& s) { return count(s.network->activeConnections); }},
+        {"network.sockets.tcp", C::Network, kPlain, false, [](const Snapshot& s) { return count(s.network->sockets.tcp); }},
+        {"network.sockets.tcpTimeWait", C::Network, kPlain, false,
+         [](const Snapshot& s) { return count(s.network->sockets.tcpTimeWait); }},
+        {"network.sockets.udp", C::Network, kPlain, false, [](const Snapshot& s) { return count(s.network->sockets.udp); }},
+        {"network.sockets.established", C::Network, kPlain, false,
+         [](const Snapshot& s) { return count(s.network->sockets.established); }},
+        {"network.sockets.synRecv", C::Network, kPlain, false,
+         [](const Snapshot& s) { return count(s.network->sockets.synRecv); }},
+        {"network.sockets.closeWait", C::Network, kPlain, false,
+         [](const Snapshot& s) { return count(s.network->sockets.closeWait); }},
+        {"process.total", C::Process, kPlain, false, [](const Snapshot& s) { return count(s.processActivity->total); }},
+        {"process.spawned", C::Process, kPlain, false,
+         [](const Snapshot& s) { return count(s.processActivity->spawned); }},
+        {"process.exited", C::Process, kPlain, false, [](const Snapshot& s) { return count(s.processActivity->exited); }},
+    };
+    return fields;
+}
+
+const std::vector<MetricField<DiskInfo>>& SnapshotMetrics::diskFields() {
+    const Collector disk = Collector::Disk;
+    static const std::vector<MetricField<DiskInfo>> fields = {
+        // Capacity is unknown (not zero) for a disk that is not mounted
+        {"used", disk, kGigabytes, false, [](const DiskInfo& d) { return d.total > 0.0 ? d.used : kNoData; }},
+        {"free", disk, kGigabytes, false, [](const DiskInfo& d) { return d.total > 0.0 ? d.free : kNoData; }},
+        {"readSpeed", disk, kMegabytes, false, [](const DiskInfo& d) { return d.readSpeed; }},
+        {"writeSpeed", disk, kMegabytes, false, [](const DiskInfo& d) { return d.writeSpeed; }},
+        {"readIops", disk, kPlain, false, [](const DiskInfo& d) { return d.readIops; }},
+        {"writeIops", disk, kPlain, false, [](const DiskInfo& d) { return d.writeIops; }},
+        {"queueDepth", disk, kPlain, false, [](const DiskInfo& d) { return d.queueDepth; }},
+        {"latency", disk, kPlain, false, [](const DiskInfo& d) { return d.latency; }},
+    };
+    return fields;
+}
+
+const std::vector<MetricField<InterfaceInfo>>& SnapshotMetrics::interfaceFields() {
+    const Collector network = Collector::Network;
+    static const std::vector<MetricField<InterfaceInfo>> fields = {
+        {"downloadSpeed", network, kMegabytes, false, [](const InterfaceInfo& i) { return i.downloadSpeed; }},
+        {"uploadSpeed", network, kMegabytes, false, [](const InterfaceInfo& i) { return i.uploadSpeed; }},
+        {"rxPackets", network, kPlain, false, [](const InterfaceInfo& i) { return i.rxPackets; }},
+        {"txPackets", network, kPlain, false, [](const InterfaceInfo& i) { return i.txPackets; }},
+        {"rxErrors", network, kPlain, true, [](const InterfaceInfo& i) { return count(i.rxErrors); }},
+        {"txErrors", network, kPlain, true, [](const InterfaceInfo& i) { return count(i.txErrors); }},
+        {"rxDropped", network, kPlain, true, [](const InterfaceInfo& i) { return count(i.rxDropped); }},
+        {"txDropped", network, kPlain, true, [](const InterfaceInfo& i) { return count(i.txDropped); }},
+    };
+    return fields;
+}
+
+bool SnapshotMetrics::sameLayout(const Snapshot& snapshot) const {
+    if (!initialized || snapshot.cpu->coreUsage.size() != coreCount) return false;
+    const std::vector<DiskInfo>& disks = *snapshot.disks;
+    if (disks.size() != diskNames.size()) return false;
+    for (size_t i = 0; i < diskNames.size(); ++i) {
+        if (disks[i].name != diskNames[i]) return false;
+    }
+    const std::vector<InterfaceInfo>& interfaces = snapshot.network->interfaces;
+    if (interfaces.size() != interfaceNames.size()) return false;
+    for (size_t i = 0; i < interfaceNames.size(); ++i) {
+        if (interfaces[i].name != interfaceNames[i]) return false;
+    }
+    return true;
+}
+
+void SnapshotMetrics::rebuildNames(const Snapshot& snapshot) {
+    coreCount = snapshot.cpu->coreUsage.size();
+    diskNames.clear();
+    for (const DiskInfo& disk : *snapshot.disks) diskNames.push_back(disk.name);
+    interfaceNames.clear();
+    for (const InterfaceInfo& iface : snapshot.network->interfaces) interfaceNames.push_back(iface.name);
+
+    seriesNames.clear();
+    for (const auto& field : hostFields()) seriesNames.emplace_back(field.name);
+    for (size_t i = 0; i < coreCount; ++i) seriesNames.push_back("cpu.core." + std::to_string(i));
+    for (const std::string& disk : diskNames) {
+        for (const auto& field : diskFields()) seriesNames.push_back("disk." + disk + "." + field.name);
+    }
+    for (const std::string& iface : interfaceNames) {
+        for (const auto& field : interfaceFields()) seriesNames.push_back("network." + iface + "." + field.name);
+    }
+    seriesValues.resize(seriesNames.size());
+    initialized = true;
+}
+
+bool SnapshotMetrics::update(const Snapshot& snapshot) {
+    bool changed = !sameLayout(snapshot);
+    if (changed) rebuildNames(snapshot);
+
+    double* out = seriesValues.data();
+    for (const auto& field : hostFields()) *out++ = field.read(snapshot);
+    for (double usage : snapshot.cpu->coreUsage) *out++ = usage;
+    for (const DiskInfo& disk : *snapshot.disks) {
+        for (const auto& field : diskFields()) *out++ = field.read(disk);
+    }
+    for (const InterfaceInfo& iface : snapshot.network->interfaces) {
+        for (const auto& field : interfaceFields()) *out++ = field.read(iface);
+    }
+    return changed;
+}
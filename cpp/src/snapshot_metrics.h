@@ -0,0 +1,62 @@
+#pragma once
+
+#include "../include/system_monitor.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Unit of a series, for consumers that convert sizes given by a user
+enum class MetricUnit : uint8_t {
+    Plain,     // Percent, count, per second, MHz, degrees
+    Megabytes, // MB, or MB/s for speeds
+    Gigabytes,
+};
+
+// How one series is read. Host series read the Snapshot; disk and
+// interface series read one DiskInfo or InterfaceInfo and are named
+// "disk.<name>.<field>" and "network.<name>.<field>".
+template <typename Source>
+struct MetricField {
+    const char* name; // Full name for host series, <field> otherwise
+    Collector collector; // The collector whose sample changes it
+    MetricUnit unit;
+    bool cumulative; // A total since boot or since the device appeared, not a rate
+    double (*read)(const Source&);
+};
+
+// Flat view of the numeric host metrics in a Snapshot as named series
+// ("cpu.usage", "cpu.core.3", "disk.sda.readSpeed", ...), for consumers
+// that store or analyse metrics column by column. Processes are not
+// included: the ranked list changes membership from sample to sample.
+//
+// The series layout follows the snapshot's shape (core count, disk
+// names). update() only rebuilds names() when that shape changes, so the
+// steady state does not allocate.
+class SnapshotMetrics {
+public:
+    // The series before the per-core ones, then those of each disk and
+    // interface. Alert rules look their metrics up here too.
+    static const std::vector<MetricField<Snapshot>>& hostFields();
+    static const std::vector<MetricField<DiskInfo>>& diskFields();
+    static const std::vector<MetricField<InterfaceInfo>>& interfaceFields();
+
+    // Extracts the values of `snapshot`. Returns true if the layout changed
+    // (including on the first call); names() and values() stay parallel.
+    bool update(const Snapshot& snapshot);
+
+    const std::vector<std::string>& names() const { return seriesNames; }
+    const std::vector<double>& values() const { return seriesValues; }
+    size_t size() const { return seriesValues.size(); }
+
+private:
+    std::vector<std::string> seriesNames;
+    std::vector<double> seriesValues;
+    size_t coreCount = 0;
+    std::vector<std::string> diskNames;
+    std::vector<std::string> interfaceNames;
+    bool initialized = false;
+
+    bool sameLayout(const Snapshot& snapshot) const;
+    void rebuildNames(const Snapshot& snapshot);
+};
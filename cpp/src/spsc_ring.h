@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded single-producer, single-consumer queue over storage allocated once
+// in the constructor. push() and drain() are wait-free and never allocate.
+// The two indices live on separate cache lines; the producer keeps a cached
+// copy of the head and only reads the shared one when the ring looks full,
+// and the consumer reads the tail once per drain.
+template <typename T>
+class SpscRing {
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size *= 2;
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t capacity() const { return slots.size(); }
+
+    // Producer only. False, dropping `value`, when the ring is full.
+    bool push(const T& value) {
+        size_t tail = producer.tail.load(std::memory_order_relaxed);
+        if (tail - producer.cachedHead == slots.size()) {
+            producer.cachedHead = consumer.head.load(std::memory_order_acquire);
+            if (tail - producer.cachedHead == slots.size()) return false;
+        }
+        slots[tail & mask] = value;
+        producer.tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Calls `visit(const T&)` for everything queued so far
+    // and returns how many entries that was.
+    template <typename Visit>
+    size_t drain(Visit visit) {
+        size_t head = consumer.head.load(std::memory_order_relaxed);
+        size_t count = producer.tail.load(std::memory_order_acquire) - head;
+        for (size_t i = 0; i < count; ++i) visit(slots[(head + i) & mask]);
+        consumer.head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    std::vector<T> slots;
+    size_t mask;
+
+    struct alignas(64) Producer {
+        std::atomic<size_t> tail{0};
+        size_t cachedHead = 0;
+    } producer;
+    struct alignas(64) Consumer {
+        std::atomic<size_t> head{0};
+    } consumer;
+};
@@ -5,32 +5,59 @@
 #include "disk_monitor.h"
 #include "network_monitor.h"
 #include "process_monitor.h"
-#include <sstream>
-#include <iomanip>
-
-// Simple JSON string escaper for safe output
-static std::string escapeJson(const std::string& input) {
-    std::string out;
-    out.reserve(input.size() + 8);
-    for (char c : input) {
-        switch (c) {
-        case '\"': out += "\\\""; break;
-        case '\\': out += "\\\\"; break;
-        case '\b': out += "\\b"; break;
-        case '\f': out += "\\f"; break;
-        case '\n': out += "\\n"; break;
-        case '\r': out += "\\r"; break;
-        case '\t': out += "\\t"; break;
-        default:
-            // Only escape control chars; leave UTF-8 bytes as-is
-            if (static_cast<unsigned char>(c) < 0x20) {
-                // Skip other control characters
-                continue;
-            }
-            out += c;
-        }
+#include "self_monitor.h"
+#include "latency_histogram.h"
+#include "sampling_scheduler.h"
+#include "rcu_publisher.h"
+#include "snapshot_json.h"
+#include "metric_history.h"
+#include "rolling_stats.h"
+#include "anomaly_detector.h"
+#include "alert_engine.h"
+#ifdef MONITOR_BACKEND_LINUX
+#include "linux/metric_store.h"
+#include "linux/procfs.h"
+#include "linux/cgroup_monitor.h"
+#include "linux/thread_sampler.h"
+#endif
+#include <mutex>
+
+namespace {
+// Processes cached per sample; getTopProcesses() slices this
+constexpr int kCachedProcesses = 32;
+
+// Timed scheduler tasks: the six collectors in Collector order, then the
+// optional ones
+enum TimedTask { kCgroupTask = 6, kThreadsTask, kStatsTask, kAlertsTask, kAnomalyTask, kTimedTasks };
+
+// Milliseconds on the collectors' clock, which a replay pins to the
+// recorded time of each tick
+int64_t collectorMillis() {
+#ifdef MONITOR_BACKEND_LINUX
+    auto now = procfs::now();
+#else
+    auto now = std::chrono::steady_clock::now();
+#endif
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+}
+
+const char* collectorName(Collector collector) {
+    switch (collector) {
+    case Collector::CPU: return "cpu";
+    case Collector::GPU: return "gpu";
+    case Collector::Memory: return "memory";
+    case Collector::Disk: return "disk";
+    case Collector::Network: return "network";
+    case Collector::Process: return "process";
     }
-    return out;
+    return "";
+}
+
+// A new snapshot section holding `value`
+template <typename T>
+std::shared_ptr<const T> section(T value) {
+    return std::make_shared<const T>(std::move(value));
+}
 }
 
 class SystemMonitor::Impl {
@@ -41,13 +68,254 @@ public:
     DiskMonitor diskMonitor;
     NetworkMonitor networkMonitor;
     ProcessMonitor processMonitor;
+    SelfMonitor selfMonitor;
+
+    SamplingScheduler scheduler;
+    // Latency of every sample since start, each written only by its task
+    LatencyHistogram timings[kTimedTasks];
+
+    // Readers acquire the current snapshot lock-free. Collectors update their
+    // own monitor concurrently, then take publishMutex (writers only) to
+    // derive the next snapshot from the previous one and publish it.
+    RcuPublisher<Snapshot> publisher;
+    std::mutex publishMutex;
+    std::shared_ptr<const Snapshot> latest = std::make_shared<Snapshot>();
 
+    std::unique_ptr<MetricHistory> history;
+    std::unique_ptr<RollingStats> rollingStats;
+    std::unique_ptr<AnomalyDetector> anomalyDetector;
+    std::unique_ptr<AlertEngine> alerts; // Evaluated under publishMutex
+#ifdef MONITOR_BACKEND_LINUX
+    std::unique_ptr<MetricStore> store;
+    std::unique_ptr<CgroupMonitor> cgroupMonitor;
+    std::unique_ptr<ThreadSampler> threadSampler;
+#endif
+
+    std::string root; // Host prefix for the optional collectors
     bool initialized = false;
+
+    void sample(Collector collector);
+    void sampleSelf();
+    void sampleStats();
+    void sampleAnomalies();
+#ifdef MONITOR_BACKEND_LINUX
+    void sampleCgroups();
+    void sampleThreads();
+#endif
+
+    template <typename Mutate>
+    void publish(Mutate mutate);
+    // publish(), then the alert rules that read `collector` on the result
+    template <typename Mutate>
+    void publishSample(Collector collector, Mutate mutate);
 };
 
-SystemMonitor::SystemMonitor() : pImpl(std::make_unique<Impl>()) {}
+template <typename Mutate>
+void SystemMonitor::Impl::publish(Mutate mutate) {
+    std::lock_guard<std::mutex> lock(publishMutex);
+    auto next = std::make_shared<Snapshot>(*latest);
+    mutate(*next);
+    next->version = latest->version + 1;
+    next->timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    latest = next;
+    publisher.publish(std::move(next));
+}
+
+template <typename Mutate>
+void SystemMonitor::Impl::publishSample(Collector collector, Mutate mutate) {
+    if (!alerts) {
+        publish(mutate);
+        return;
+    }
+    publish([&](Snapshot& snap) {
+        mutate(snap);
+        int64_t begin = monotonicNanos();
+        int64_t unixMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        if (alerts->evaluate(collector, snap, collectorMillis(), unixMs)) snap.alerts = section(alerts->info());
+        timings[kAlertsTask].record(monotonicNanos() - begin);
+    });
+}
+
+void SystemMonitor::Impl::sample(Collector collector) {
+    int64_t begin = monotonicNanos();
+    switch (collector) {
+    case Collector::CPU: {
+        cpuMonitor.update();
+        CPUInfo info = cpuMonitor.getInfo();
+        publishSample(collector, [&](Snapshot& snap) { snap.cpu = section(std::move(info)); });
+        break;
+    }
+    case Collector::GPU: {
+        gpuMonitor.update();
+        GPUInfo info = gpuMonitor.getInfo();
+        publishSample(collector, [&](Snapshot& snap) { snap.gpu = section(std::move(info)); });
+        break;
+    }
+    case Collector::Memory: {
+        memoryMonitor.update();
+        MemoryInfo info = memoryMonitor.getInfo();
+        publishSample(collector, [&](Snapshot& snap) { snap.memory = section(std::move(info)); });
+        break;
+    }
+    case Collector::Disk: {
+        diskMonitor.update();
+        std::vector<DiskInfo> info = diskMonitor.getInfo();
+        publishSample(collector, [&](Snapshot& snap) { snap.disks = section(std::move(info)); });
+        break;
+    }
+    case Collector::Network: {
+        networkMonitor.update();
+        NetworkInfo info = networkMonitor.getInfo();
+        publishSample(collector, [&](Snapshot& snap) { snap.network = section(std::move(info)); });
+        break;
+    }
+    case Collector::Process: {
+        processMonitor.update();
+        std::vector<ProcessInfo> info = processMonitor.getTopProcesses(kCachedProcesses);
+        std::vector<ProcessInfo> watched = processMonitor.getWatchedProcesses();
+        ProcessActivity activity = processMonitor.getActivity();
+        publishSample(collector, [&](Snapshot& snap) {
+            snap.processes = section(std::move(info));
+            snap.watchedProcesses = section(std::move(watched));
+            snap.processActivity = section(std::move(activity));
+        });
+        break;
+    }
+    }
+    timings[static_cast<size_t>(collector)].record(monotonicNanos() - begin);
+}
 
-SystemMonitor::~SystemMonitor() = default;
+void SystemMonitor::Impl::sampleSelf() {
+    selfMonitor.update();
+    SelfInfo info = selfMonitor.getInfo();
+
+    std::vector<SamplingScheduler::TaskStats> tasks = scheduler.stats();
+    auto addTiming = [&](size_t task, const char* name) {
+        LatencyHistogram::Summary summary = timings[task].summarize();
+        CollectorTiming timing;
+        timing.name = name;
+        timing.samples = summary.count;
+        for (const auto& stats : tasks) {
+            if (stats.name != name) continue;
+            timing.skipped = stats.skipped;
+            timing.lateP99Us = stats.lateness.p99Ns / 1000.0;
+            timing.lateMaxUs = stats.lateness.maxNs / 1000.0;
+        }
+        timing.lastUs = summary.lastNs / 1000.0;
+        timing.meanUs = summary.meanNs / 1000.0;
+        timing.p50Us = summary.p50Ns / 1000.0;
+        timing.p95Us = summary.p95Ns / 1000.0;
+        timing.p99Us = summary.p99Ns / 1000.0;
+        timing.maxUs = summary.maxNs / 1000.0;
+        info.collectors.push_back(std::move(timing));
+    };
+    for (size_t task = 0; task < kCgroupTask; ++task) {
+        addTiming(task, collectorName(static_cast<Collector>(task)));
+    }
+#ifdef MONITOR_BACKEND_LINUX
+    if (cgroupMonitor) addTiming(kCgroupTask, "cgroup");
+    if (threadSampler) addTiming(kThreadsTask, "threads");
+#endif
+    if (rollingStats) addTiming(kStatsTask, "stats");
+    if (anomalyDetector) addTiming(kAnomalyTask, "anomalies");
+    if (alerts) addTiming(kAlertsTask, "alerts");
+
+    publish([&](Snapshot& snap) { snap.self = section(std::move(info)); });
+}
+
+void SystemMonitor::Impl::sampleStats() {
+    int64_t begin = monotonicNanos();
+    rollingStats->record(*publisher.acquire(), collectorMillis());
+    RollingStatsInfo info;
+    rollingStats->summarize(info);
+    publish([&](Snapshot& snap) { snap.stats = section(std::move(info)); });
+    timings[kStatsTask].record(monotonicNanos() - begin);
+}
+
+void SystemMonitor::Impl::sampleAnomalies() {
+    int64_t begin = monotonicNanos();
+    anomalyDetector->record(*publisher.acquire(), collectorMillis());
+    AnomalyInfo info;
+    anomalyDetector->report(info);
+    publish([&](Snapshot& snap) { snap.anomalies = section(std::move(info)); });
+    timings[kAnomalyTask].record(monotonicNanos() - begin);
+}
+
+#ifdef MONITOR_BACKEND_LINUX
+void SystemMonitor::Impl::sampleCgroups() {
+    int64_t begin = monotonicNanos();
+    cgroupMonitor->update();
+    std::vector<CgroupInfo> info = cgroupMonitor->getInfo();
+    publish([&](Snapshot& snap) { snap.cgroups = section(std::move(info)); });
+    timings[kCgroupTask].record(monotonicNanos() - begin);
+}
+
+void SystemMonitor::Impl::sampleThreads() {
+    int64_t begin = monotonicNanos();
+    std::vector<ThreadStats> threads;
+    ThreadSamplerStats stats;
+    threadSampler->collect(threads, stats);
+    publish([&](Snapshot& snap) {
+        snap.threads = section(std::move(threads));
+        snap.threadSampler = section(std::move(stats));
+    });
+    timings[kThreadsTask].record(monotonicNanos() - begin);
+}
+#endif
+
+SystemMonitor::SystemMonitor() : pImpl(std::make_unique<Impl>()) {
+    // Default cadences: cheap counters fast, scans and capacity slow
+    using std::chrono::milliseconds;
+    const std::pair<Collector, milliseconds> defaults[] = {
+        {Collector::CPU, milliseconds(250)},
+        {Collector::Memory, milliseconds(250)},
+        {Collector::Network, milliseconds(1000)},
+        {Collector::GPU, milliseconds(2000)},
+        {Collector::Process, milliseconds(2000)},
+#ifdef MONITOR_BACKEND_LINUX
+        // I/O counters; capacity is refreshed on its own slower cadence
+        {Collector::Disk, milliseconds(1000)},
+#else
+        {Collector::Disk, milliseconds(30000)},
+#endif
+    };
+    Impl* impl = pImpl.get();
+    for (const auto& entry : defaults) {
+        Collector collector = entry.first;
+        impl->scheduler.addTask(collectorName(collector), entry.second,
+                                [impl, collector] { impl->sample(collector); });
+    }
+    impl->scheduler.addTask("self", milliseconds(1000), [impl] { impl->sampleSelf(); });
+
+    pImpl->publisher.publish(pImpl->latest);
+}
+
+SystemMonitor::~SystemMonitor() {
+    stop();
+}
+
+void SystemMonitor::setRoot(const std::string& prefix) {
+#ifdef MONITOR_BACKEND_LINUX
+    pImpl->root = prefix;
+    pImpl->cpuMonitor.setRoot(prefix);
+    pImpl->memoryMonitor.setRoot(prefix);
+    pImpl->diskMonitor.setRoot(prefix);
+    pImpl->networkMonitor.setRoot(prefix);
+    pImpl->processMonitor.setRoot(prefix);
+#else
+    (void)prefix;
+#endif
+}
+
+void SystemMonitor::setBatchedProcessReads(bool enabled) {
+#ifdef MONITOR_BACKEND_LINUX
+    pImpl->processMonitor.setBatchedReads(enabled);
+#else
+    (void)enabled;
+#endif
+}
 
 bool SystemMonitor::initialize() {
     if (!pImpl->cpuMonitor.initialize()) return false;
@@ -56,126 +324,213 @@ bool SystemMonitor::initialize() {
     if (!pImpl->diskMonitor.initialize()) return false;
     if (!pImpl->networkMonitor.initialize()) return false;
     if (!pImpl->processMonitor.initialize()) return false;
+    if (!pImpl->selfMonitor.initialize()) return false;
 
     pImpl->initialized = true;
     return true;
 }
 
 void SystemMonitor::update() {
-    if (!pImpl->initialized) return;
+    if (!pImpl->initialized || pImpl->scheduler.isRunning()) return;
 
-    pImpl->cpuMonitor.update();
-    pImpl->gpuMonitor.update();
-    pImpl->memoryMonitor.update();
-    pImpl->diskMonitor.update();
-    pImpl->networkMonitor.update();
-    pImpl->processMonitor.update();
+    pImpl->sample(Collector::CPU);
+    pImpl->sample(Collector::GPU);
+    pImpl->sample(Collector::Memory);
+    pImpl->sample(Collector::Disk);
+    pImpl->sample(Collector::Network);
+    pImpl->sample(Collector::Process);
+#ifdef MONITOR_BACKEND_LINUX
+    if (pImpl->cgroupMonitor) pImpl->sampleCgroups();
+    if (pImpl->threadSampler) pImpl->sampleThreads();
+#endif
+    if (pImpl->rollingStats) pImpl->sampleStats();
+    if (pImpl->anomalyDetector) pImpl->sampleAnomalies();
+    pImpl->sampleSelf();
+
+    if (pImpl->history) {
+        pImpl->history->record(*pImpl->publisher.acquire());
+    }
+#ifdef MONITOR_BACKEND_LINUX
+    if (pImpl->store) {
+        pImpl->store->append(*pImpl->publisher.acquire());
+    }
+#endif
+}
+
+bool SystemMonitor::setSamplingInterval(Collector collector, std::chrono::milliseconds interval) {
+    return pImpl->scheduler.setInterval(collectorName(collector), interval);
+}
+
+bool SystemMonitor::start() {
+    if (!pImpl->initialized) return false;
+    return pImpl->scheduler.start();
+}
+
+void SystemMonitor::stop() {
+    pImpl->scheduler.stop();
+}
+
+bool SystemMonitor::enableHistory(size_t maxDisks) {
+    if (!pImpl->initialized || pImpl->history || pImpl->scheduler.isRunning()) return false;
+
+    size_t cores = static_cast<size_t>(pImpl->cpuMonitor.getInfo().coreCount);
+    pImpl->history = std::make_unique<MetricHistory>(cores, maxDisks);
+
+    Impl* impl = pImpl.get();
+    impl->scheduler.addTask("history", std::chrono::milliseconds(1000),
+                            [impl] { impl->history->record(*impl->publisher.acquire()); });
+    return true;
+}
+
+const MetricHistory* SystemMonitor::history() const {
+    return pImpl->history.get();
+}
+
+bool SystemMonitor::enableStore(const std::string& directory) {
+#ifdef MONITOR_BACKEND_LINUX
+    if (!pImpl->initialized || pImpl->store || pImpl->scheduler.isRunning()) return false;
+
+    StoreOptions options;
+    options.directory = directory;
+    auto store = std::make_unique<MetricStore>(options);
+    if (!store->open()) return false;
+    pImpl->store = std::move(store);
+
+    Impl* impl = pImpl.get();
+    impl->scheduler.addTask("store", std::chrono::milliseconds(1000),
+                            [impl] { impl->store->append(*impl->publisher.acquire()); });
+    return true;
+#else
+    (void)directory;
+    return false;
+#endif
+}
+
+const MetricStore* SystemMonitor::store() const {
+#ifdef MONITOR_BACKEND_LINUX
+    return pImpl->store.get();
+#else
+    return nullptr;
+#endif
+}
+
+bool SystemMonitor::enableCgroups(const std::string& root) {
+#ifdef MONITOR_BACKEND_LINUX
+    if (!pImpl->initialized || pImpl->cgroupMonitor || pImpl->scheduler.isRunning()) return false;
+
+    CgroupOptions options;
+    options.root = root;
+    options.prefix = pImpl->root;
+    auto monitor = std::make_unique<CgroupMonitor>(options);
+    if (!monitor->initialize()) return false;
+    pImpl->cgroupMonitor = std::move(monitor);
+
+    Impl* impl = pImpl.get();
+    impl->scheduler.addTask("cgroup", std::chrono::milliseconds(2000), [impl] { impl->sampleCgroups(); });
+    return true;
+#else
+    (void)root;
+    return false;
+#endif
+}
+
+bool SystemMonitor::enableThreadSampler(const std::vector<int>& pids, unsigned rateHz) {
+#ifdef MONITOR_BACKEND_LINUX
+    if (!pImpl->initialized || pImpl->threadSampler || pImpl->scheduler.isRunning()) return false;
+
+    ThreadSamplerOptions options;
+    options.pids = pids;
+    options.rateHz = rateHz;
+    options.root = pImpl->root;
+    auto sampler = std::make_unique<ThreadSampler>(options);
+    if (!sampler->start()) return false;
+    pImpl->threadSampler = std::move(sampler);
+
+    Impl* impl = pImpl.get();
+    impl->scheduler.addTask("threads", std::chrono::milliseconds(1000), [impl] { impl->sampleThreads(); });
+    return true;
+#else
+    (void)pids;
+    (void)rateHz;
+    return false;
+#endif
+}
+
+bool SystemMonitor::enableStats(const std::vector<int>& windowSeconds) {
+    if (!pImpl->initialized || pImpl->rollingStats || pImpl->scheduler.isRunning()) return false;
+    pImpl->rollingStats =
+        std::make_unique<RollingStats>(windowSeconds.empty() ? RollingStats::defaultWindows() : windowSeconds);
+    Impl* impl = pImpl.get();
+    impl->scheduler.addTask("stats", std::chrono::milliseconds(1000), [impl] { impl->sampleStats(); });
+    return true;
+}
+
+bool SystemMonitor::enableAnomalyDetection() {
+    if (!pImpl->initialized || pImpl->anomalyDetector || pImpl->scheduler.isRunning()) return false;
+
+    pImpl->anomalyDetector = std::make_unique<AnomalyDetector>();
+    Impl* impl = pImpl.get();
+    impl->scheduler.addTask("anomalies", std::chrono::milliseconds(1000), [impl] { impl->sampleAnomalies(); });
+    return true;
+}
+
+bool SystemMonitor::enableAlerts(const std::vector<std::string>& rules, std::string* error) {
+    if (!pImpl->initialized || pImpl->alerts || pImpl->scheduler.isRunning()) return false;
+
+    auto engine = std::make_unique<AlertEngine>();
+    std::string reason;
+    if (!engine->compile(rules, reason)) {
+        if (error) *error = reason;
+        return false;
+    }
+    pImpl->alerts = std::move(engine);
+    return true;
+}
+
+void SystemMonitor::setProcessFields(uint32_t fields) {
+    pImpl->processMonitor.setFields(fields);
+}
+
+void SystemMonitor::setWatchedProcesses(const std::vector<int>& pids) {
+    pImpl->processMonitor.setWatched(pids);
+}
+
+std::shared_ptr<const Snapshot> SystemMonitor::snapshot() const {
+    return pImpl->publisher.acquire();
 }
 
 CPUInfo SystemMonitor::getCPUInfo() const {
-    return pImpl->cpuMonitor.getInfo();
+    return *snapshot()->cpu;
 }
 
 GPUInfo SystemMonitor::getGPUInfo() const {
-    return pImpl->gpuMonitor.getInfo();
+    return *snapshot()->gpu;
 }
 
 MemoryInfo SystemMonitor::getMemoryInfo() const {
-    return pImpl->memoryMonitor.getInfo();
+    return *snapshot()->memory;
 }
 
 std::vector<DiskInfo> SystemMonitor::getDiskInfo() const {
-    return pImpl->diskMonitor.getInfo();
+    return *snapshot()->disks;
 }
 
 NetworkInfo SystemMonitor::getNetworkInfo() const {
-    return pImpl->networkMonitor.getInfo();
+    return *snapshot()->network;
 }
 
 std::vector<ProcessInfo> SystemMonitor::getTopProcesses(int count) const {
-    return pImpl->processMonitor.getTopProcesses(count);
+    auto snap = snapshot();
+    size_t end = count < 0 ? 0 : static_cast<size_t>(count);
+    const std::vector<ProcessInfo>& processes = *snap->processes;
+    if (end > processes.size()) end = processes.size();
+    return std::vector<ProcessInfo>(processes.begin(), processes.begin() + end);
 }
 
 std::string SystemMonitor::toJSON() const {
-    std::ostringstream json;
-    json << std::fixed << std::setprecision(2);
-
-    json << "{\n";
-    
-    // CPU
-    auto cpu = getCPUInfo();
-    json << "  \"cpu\": {\n";
-    json << "    \"usage\": " << cpu.totalUsage << ",\n";
-    json << "    \"cores\": " << cpu.coreCount << ",\n";
-    json << "    \"frequency\": " << cpu.frequency << ",\n";
-    json << "    \"coreUsage\": [";
-    for (size_t i = 0; i < cpu.coreUsage.size(); ++i) {
-        if (i > 0) json << ", ";
-        json << cpu.coreUsage[i];
-    }
-    json << "]\n";
-    json << "  },\n";
-
-    // GPU
-    auto gpu = getGPUInfo();
-    json << "  \"gpu\": {\n";
-    json << "    \"name\": \"" << escapeJson(gpu.name) << "\",\n";
-    json << "    \"usage\": " << gpu.usage << ",\n";
-    json << "    \"memoryUsed\": " << gpu.memoryUsed << ",\n";
-    json << "    \"memoryTotal\": " << gpu.memoryTotal << ",\n";
-    json << "    \"temperature\": " << gpu.temperature << "\n";
-    json << "  },\n";
-
-    // Memory
-    auto mem = getMemoryInfo();
-    json << "  \"memory\": {\n";
-    json << "    \"total\": " << mem.total << ",\n";
-    json << "    \"used\": " << mem.used << ",\n";
-    json << "    \"free\": " << mem.free << ",\n";
-    json << "    \"usagePercent\": " << mem.usagePercent << "\n";
-    json << "  },\n";
-
-    // Disk
-    auto disks = getDiskInfo();
-    json << "  \"disks\": [\n";
-    for (size_t i = 0; i < disks.size(); ++i) {
-        json << "    {\n";
-        json << "      \"name\": \"" << escapeJson(disks[i].name) << "\",\n";
-        json << "      \"mountPoint\": \"" << escapeJson(disks[i].mountPoint) << "\",\n";
-        json << "      \"total\": " << disks[i].total << ",\n";
-        json << "      \"used\": " << disks[i].used << ",\n";
-        json << "      \"free\": " << disks[i].free << ",\n";
-        json << "      \"readSpeed\": " << disks[i].readSpeed << ",\n";
-        json << "      \"writeSpeed\": " << disks[i].writeSpeed << "\n";
-        json << "    }";
-        if (i < disks.size() - 1) json << ",";
-        json << "\n";
-    }
-    json << "  ],\n";
-
-    // Network
-    auto net = getNetworkInfo();
-    json << "  \"network\": {\n";
-    json << "    \"downloadSpeed\": " << net.downloadSpeed << ",\n";
-    json << "    \"uploadSpeed\": " << net.uploadSpeed << ",\n";
-    json << "    \"activeConnections\": " << net.activeConnections << "\n";
-    json << "  },\n";
-
-    // Processes
-    auto processes = getTopProcesses(10);
-    json << "  \"processes\": [\n";
-    for (size_t i = 0; i < processes.size(); ++i) {
-        json << "    {\n";
-        json << "      \"name\": \"" << escapeJson(processes[i].name) << "\",\n";
-        json << "      \"pid\": " << processes[i].pid << ",\n";
-        json << "      \"cpuUsage\": " << processes[i].cpuUsage << ",\n";
-        json << "      \"memoryUsage\": " << processes[i].memoryUsage << "\n";
-        json << "    }";
-        if (i < processes.size() - 1) json << ",";
-        json << "\n";
-    }
-    json << "  ]\n";
+    return formatSnapshotJSON(*snapshot());
+}
 
-    json << "}\n";
-    return json.str();
+void SystemMonitor::toNDJSON(std::string& out) const {
+    writeSnapshotNDJSON(*snapshot(), out);
 }
@@ -0,0 +1,754 @@
+#include "wire_protocol.h"
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+void putZigzag(std::string& out, int64_t value) {
+    putVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+// Opens a frame and returns the offset of its length prefix
+size_t beginFrame(std::string& out, char type) {
+    size_t start = out.size();
+    out.append(4, '\0');
+    out += type;
+    return start;
+}
+
+void endFrame(std::string& out, size_t start) {
+    uint32_t length = static_cast<uint32_t>(out.size() - start - 4);
+    for (int i = 0; i < 4; ++i) {
+        out[start + i] = static_cast<char>((length >> (8 * i)) & 0xFF);
+    }
+}
+
+int64_t fixed2(double value) {
+    if (!std::isfinite(value)) return 0;
+    return static_cast<int64_t>(std::llround(value * 100.0));
+}
+
+bool getVarint(const char*& at, const char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && at < end; shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(*at++);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (byte < 0x80) return true;
+    }
+    return false;
+}
+
+bool getZigzag(const char*& at, const char* end, int64_t& value) {
+    uint64_t raw = 0;
+    if (!getVarint(at, end, raw)) return false;
+    value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+    return true;
+}
+
+// Walks the flattened fields in the order flatten() wrote them. Reading past
+// the end yields zeros and clears ok(), so loops driven by schema counts stop
+// on a keyframe that is too short for them.
+class FieldReader {
+public:
+    FieldReader(const std::vector<int64_t>& fields, const std::unordered_map<uint64_t, std::string>& strings)
+        : fields(fields), strings(strings) {}
+
+    int64_t next() { return at < fields.size() ? fields[at++] : (++at, 0); }
+    double fixed() { return next() / 100.0; }
+    std::string text() {
+        auto it = strings.find(static_cast<uint64_t>(next()));
+        return it != strings.end() ? it->second : std::string();
+    }
+    bool ok() const { return at <= fields.size(); }
+    bool complete() const { return at == fields.size(); }
+
+private:
+    const std::vector<int64_t>& fields;
+    const std::unordered_map<uint64_t, std::string>& strings;
+    size_t at = 0;
+};
+
+void readProcess(FieldReader& in, ProcessInfo& proc) {
+    proc.name = in.text();
+    proc.pid = static_cast<int>(in.next());
+    proc.cpuUsage = in.fixed();
+    proc.memoryUsage = in.fixed();
+    proc.fields = static_cast<uint32_t>(in.next());
+    proc.threads = static_cast<int>(in.next());
+    proc.state = static_cast<char>(in.next());
+    proc.uid = static_cast<int>(in.next());
+    proc.voluntarySwitches = in.fixed();
+    proc.involuntarySwitches = in.fixed();
+    proc.fdCount = static_cast<int>(in.next());
+    proc.ioReadSpeed = in.fixed();
+    proc.ioWriteSpeed = in.fixed();
+    proc.pss = in.fixed();
+    proc.swap = in.fixed();
+    proc.cmdline = in.text();
+}
+
+} // namespace
+
+WireEncoder::WireEncoder(size_t maxProcesses, uint32_t keyframeInterval, size_t maxDictionarySize)
+    : maxProcesses(maxProcesses), keyframeInterval(keyframeInterval > 0 ? keyframeInterval : 1),
+      maxDictionarySize(maxDictionarySize) {
+    reset();
+}
+
+void WireEncoder::reset() {
+    started = false;
+    sinceKeyframe = 0;
+    cores = disks = processes = interfaces = cgroups = watched = threads = collectors = 0;
+    statWindows = statMetrics = 0;
+    anomalies = activeAlerts = alertEvents = 0;
+    previous.clear();
+    current.clear();
+    dictionary.clear();
+    newStrings.clear();
+    strings.clear();
+}
+
+int64_t WireEncoder::intern(const std::string& value) {
+    auto it = dictionary.find(value);
+    if (it != dictionary.end()) return it->second;
+
+    uint32_t id = static_cast<uint32_t>(strings.size());
+    auto inserted = dictionary.emplace(value, id).first;
+    strings.push_back(&inserted->first);
+    newStrings.push_back(id);
+    return id;
+}
+
+void WireEncoder::flattenProcess(const ProcessInfo& proc) {
+    current.push_back(intern(proc.name));
+    current.push_back(proc.pid);
+    current.push_back(fixed2(proc.cpuUsage));
+    current.push_back(fixed2(proc.memoryUsage));
+    current.push_back(proc.fields);
+    current.push_back(proc.threads);
+    current.push_back(static_cast<unsigned char>(proc.state));
+    current.push_back(proc.uid);
+    current.push_back(fixed2(proc.voluntarySwitches));
+    current.push_back(fixed2(proc.involuntarySwitches));
+    current.push_back(proc.fdCount);
+    current.push_back(fixed2(proc.ioReadSpeed));
+    current.push_back(fixed2(proc.ioWriteSpeed));
+    current.push_back(fixed2(proc.pss));
+    current.push_back(fixed2(proc.swap));
+    current.push_back(intern(proc.cmdline));
+}
+
+void WireEncoder::flatten(const Snapshot& snapshot) {
+    current.clear();
+    current.push_back(static_cast<int64_t>(snapshot.version));
+    current.push_back(snapshot.timestampMs);
+
+    const CPUInfo& cpu = *snapshot.cpu;
+    current.push_back(fixed2(cpu.totalUsage));
+    current.push_back(cpu.coreCount);
+    current.push_back(fixed2(cpu.frequency));
+    for (double usage : cpu.coreUsage) current.push_back(fixed2(usage));
+    auto pushTimes = [this](const CPUTimes& times) {
+        const double values[] = {times.user, times.nice, times.system, times.idle,
+                                 times.iowait, times.irq, times.softirq, times.steal};
+        for (double value : values) current.push_back(fixed2(value));
+    };
+    pushTimes(cpu.times);
+    for (size_t i = 0; i < cpu.coreUsage.size(); ++i) {
+        pushTimes(i < cpu.coreTimes.size() ? cpu.coreTimes[i] : CPUTimes());
+    }
+    for (size_t i = 0; i < cpu.coreUsage.size(); ++i) {
+        current.push_back(fixed2(i < cpu.coreFrequency.size() ? cpu.coreFrequency[i] : 0.0));
+    }
+
+    const GPUInfo& gpu = *snapshot.gpu;
+    current.push_back(intern(gpu.name));
+    current.push_back(fixed2(gpu.usage));
+    current.push_back(fixed2(gpu.memoryUsed));
+    current.push_back(fixed2(gpu.memoryTotal));
+    current.push_back(fixed2(gpu.temperature));
+
+    const MemoryInfo& mem = *snapshot.memory;
+    current.push_back(fixed2(mem.total));
+    current.push_back(fixed2(mem.used));
+    current.push_back(fixed2(mem.free));
+    current.push_back(fixed2(mem.usagePercent));
+    const double memoryFields[] = {mem.cached, mem.buffers, mem.slab, mem.slabReclaimable, mem.shmem,
+                                   mem.swapTotal, mem.swapUsed, mem.dirty, mem.writeback, mem.hugePagesTotal,
+                                   mem.hugePagesUsed, mem.pageFaults, mem.majorFaults, mem.swapIn, mem.swapOut,
+                                   mem.pagesScanned, mem.pagesReclaimed, mem.allocStalls};
+    for (double value : memoryFields) current.push_back(fixed2(value));
+    current.push_back(static_cast<int64_t>(mem.oomKills));
+    const MemoryPressure& pressure = mem.pressure;
+    const double pressureFields[] = {pressure.some10, pressure.some60, pressure.some300,
+                                     pressure.full10, pressure.full60, pressure.full300};
+    for (double value : pressureFields) current.push_back(fixed2(value));
+    current.push_back(pressure.available ? 1 : 0);
+
+    for (const DiskInfo& disk : *snapshot.disks) {
+        current.push_back(intern(disk.name));
+        current.push_back(intern(disk.mountPoint));
+        current.push_back(fixed2(disk.total));
+        current.push_back(fixed2(disk.used));
+        current.push_back(fixed2(disk.free));
+        current.push_back(fixed2(disk.readSpeed));
+        current.push_back(fixed2(disk.writeSpeed));
+        current.push_back(fixed2(disk.readIops));
+        current.push_back(fixed2(disk.writeIops));
+        current.push_back(fixed2(disk.queueDepth));
+        current.push_back(fixed2(disk.latency));
+    }
+
+    const NetworkInfo& net = *snapshot.network;
+    current.push_back(fixed2(net.downloadSpeed));
+    current.push_back(fixed2(net.uploadSpeed));
+    current.push_back(net.activeConnections);
+    const SocketStats& sockets = net.sockets;
+    const int socketFields[] = {sockets.tcp, sockets.tcpTimeWait, sockets.tcpOrphan, sockets.udp,
+                                sockets.established, sockets.synSent, sockets.synRecv, sockets.finWait1,
+                                sockets.finWait2, sockets.closeWait, sockets.lastAck, sockets.listen,
+                                sockets.closing, sockets.closed, sockets.udpConnected};
+    for (int value : socketFields) current.push_back(value);
+    for (const InterfaceInfo& iface : net.interfaces) {
+        current.push_back(intern(iface.name));
+        current.push_back(fixed2(iface.downloadSpeed));
+        current.push_back(fixed2(iface.uploadSpeed));
+        current.push_back(fixed2(iface.rxPackets));
+        current.push_back(fixed2(iface.txPackets));
+        current.push_back(static_cast<int64_t>(iface.rxErrors));
+        current.push_back(static_cast<int64_t>(iface.txErrors));
+        current.push_back(static_cast<int64_t>(iface.rxDropped));
+        current.push_back(static_cast<int64_t>(iface.txDropped));
+    }
+
+    const ProcessActivity& activity = *snapshot.processActivity;
+    current.push_back(activity.total);
+    current.push_back(static_cast<int64_t>(activity.spawned));
+    current.push_back(static_cast<int64_t>(activity.exited));
+    current.push_back(activity.eventDriven ? 1 : 0);
+
+    const std::vector<ProcessInfo>& processes = *snapshot.processes;
+    size_t processCount = processes.size() < maxProcesses ? processes.size() : maxProcesses;
+    for (size_t i = 0; i < processCount; ++i) flattenProcess(processes[i]);
+    for (const ProcessInfo& proc : *snapshot.watchedProcesses) flattenProcess(proc);
+
+    for (const CgroupInfo& group : *snapshot.cgroups) {
+        current.push_back(intern(group.path));
+        current.push_back(group.parent);
+        const double values[] = {group.cpuUsage, group.cpuThrottled, group.memoryCurrent, group.memoryAnon,
+                                 group.memoryFile, group.ioReadSpeed, group.ioWriteSpeed, group.ioReadIops,
+                                 group.ioWriteIops, group.cpuPressure, group.memoryPressure,
+                                 group.memoryPressureFull, group.ioPressure, group.ioPressureFull};
+        for (double value : values) current.push_back(fixed2(value));
+    }
+
+    const ThreadSamplerStats& sampler = *snapshot.threadSampler;
+    current.push_back(sampler.enabled ? 1 : 0);
+    current.push_back(sampler.pinned ? 1 : 0);
+    current.push_back(fixed2(sampler.rate));
+    current.push_back(fixed2(sampler.overhead));
+    current.push_back(static_cast<int64_t>(sampler.dropped));
+    current.push_back(static_cast<int64_t>(sampler.missedTicks));
+    for (const ThreadStats& thread : *snapshot.threads) {
+        current.push_back(thread.pid);
+        current.push_back(thread.tid);
+        current.push_back(intern(thread.name));
+        current.push_back(static_cast<int64_t>(thread.samples));
+        const double values[] = {thread.cpuUsage, thread.cpuP50, thread.cpuP95, thread.cpuP99, thread.cpuMax,
+                                 thread.waitP50, thread.waitP95, thread.waitP99, thread.waitMax,
+                                 thread.contextSwitches, thread.migrations};
+        for (double value : values) current.push_back(fixed2(value));
+    }
+
+    const SelfInfo& self = *snapshot.self;
+    current.push_back(fixed2(self.cpuUsage));
+    current.push_back(fixed2(self.cpuSeconds));
+    current.push_back(fixed2(self.rssMB));
+    current.push_back(fixed2(self.syscalls));
+    for (const CollectorTiming& timing : self.collectors) {
+        current.push_back(intern(timing.name));
+        current.push_back(static_cast<int64_t>(timing.samples));
+        current.push_back(static_cast<int64_t>(timing.skipped));
+        const double values[] = {timing.lastUs, timing.meanUs, timing.p50Us, timing.p95Us, timing.p99Us,
+                                 timing.maxUs, timing.lateP99Us, timing.lateMaxUs};
+        for (double value : values) current.push_back(fixed2(value));
+    }
+
+    const RollingStatsInfo& stats = *snapshot.stats;
+    for (int window : stats.windows) current.push_back(window);
+    for (const MetricStats& metric : stats.metrics) {
+        current.push_back(intern(metric.name));
+        for (size_t w = 0; w < stats.windows.size(); ++w) {
+            const WindowStats& window = w < metric.windows.size() ? metric.windows[w] : WindowStats();
+            current.push_back(static_cast<int64_t>(window.count));
+            const double values[] = {window.mean, window.stddev, window.p50, window.p95, window.p99, window.max};
+            for (double value : values) current.push_back(fixed2(value));
+        }
+    }
+
+    current.push_back(static_cast<int64_t>(snapshot.anomalies->series));
+    for (const MetricAnomaly& anomaly : snapshot.anomalies->flagged) {
+        current.push_back(intern(anomaly.metric));
+        current.push_back(intern(anomaly.detector));
+        current.push_back(fixed2(anomaly.value));
+        current.push_back(fixed2(anomaly.expected));
+        current.push_back(fixed2(anomaly.score));
+        current.push_back(anomaly.sinceMs);
+    }
+
+    for (const ActiveAlert& alert : snapshot.alerts->active) {
+        current.push_back(intern(alert.rule));
+        current.push_back(intern(alert.target));
+        current.push_back(fixed2(alert.value));
+        current.push_back(alert.sinceMs);
+    }
+    for (const AlertEvent& event : snapshot.alerts->events) {
+        current.push_back(static_cast<int64_t>(event.sequence));
+        current.push_back(event.timestampMs);
+        current.push_back(event.firing ? 1 : 0);
+        current.push_back(intern(event.rule));
+        current.push_back(intern(event.target));
+        current.push_back(fixed2(event.value));
+    }
+}
+
+void WireEncoder::writeSchema(std::string& out) {
+    size_t frame = beginFrame(out, 'S');
+    putVarint(out, cores);
+    putVarint(out, disks);
+    putVarint(out, processes);
+    putVarint(out, interfaces);
+    putVarint(out, cgroups);
+    putVarint(out, watched);
+    putVarint(out, threads);
+    putVarint(out, collectors);
+    putVarint(out, statWindows);
+    putVarint(out, statMetrics);
+    putVarint(out, anomalies);
+    putVarint(out, activeAlerts);
+    putVarint(out, alertEvents);
+    endFrame(out, frame);
+}
+
+void WireEncoder::writeDictionary(std::string& out, const std::vector<uint32_t>& ids) {
+    size_t frame = beginFrame(out, 'D');
+    putVarint(out, ids.size());
+    for (uint32_t id : ids) {
+        const std::string& value = *strings[id];
+        putVarint(out, id);
+        putVarint(out, value.size());
+        out.append(value);
+    }
+    endFrame(out, frame);
+}
+
+void WireEncoder::writeKeyframe(std::string& out) {
+    size_t frame = beginFrame(out, 'K');
+    putVarint(out, current.size());
+    for (int64_t value : current) putZigzag(out, value);
+    endFrame(out, frame);
+    sinceKeyframe = 0;
+}
+
+void WireEncoder::writeTick(std::string& out) {
+    size_t changed = 0;
+    for (size_t i = 0; i < current.size(); ++i) {
+        if (current[i] != previous[i]) ++changed;
+    }
+
+    size_t frame = beginFrame(out, 'T');
+    putVarint(out, changed);
+    size_t last = static_cast<size_t>(-1);
+    for (size_t i = 0; i < current.size(); ++i) {
+        if (current[i] == previous[i]) continue;
+        putVarint(out, i - last);
+        putZigzag(out, current[i] - previous[i]);
+        last = i;
+    }
+    endFrame(out, frame);
+    ++sinceKeyframe;
+}
+
+void WireEncoder::encode(const Snapshot& snapshot, std::string& out) {
+    if (!started) {
+        size_t frame = beginFrame(out, 'H');
+        out.append("MCWP");
+        out += static_cast<char>(kProtocolVersion);
+        endFrame(out, frame);
+    }
+
+    size_t processCount = snapshot.processes->size() < maxProcesses ? snapshot.processes->size() : maxProcesses;
+    bool layoutChanged = !started || snapshot.cpu->coreUsage.size() != cores ||
+                         snapshot.disks->size() != disks || processCount != processes ||
+                         snapshot.network->interfaces.size() != interfaces ||
+                         snapshot.cgroups->size() != cgroups ||
+                         snapshot.watchedProcesses->size() != watched ||
+                         snapshot.threads->size() != threads ||
+                         snapshot.self->collectors.size() != collectors ||
+                         snapshot.stats->windows.size() != statWindows ||
+                         snapshot.stats->metrics.size() != statMetrics ||
+                         snapshot.anomalies->flagged.size() != anomalies ||
+                         snapshot.alerts->active.size() != activeAlerts ||
+                         snapshot.alerts->events.size() != alertEvents;
+
+    newStrings.clear();
+    flatten(snapshot);
+
+    if (layoutChanged || dictionary.size() > maxDictionarySize) {
+        // New layout or too many retired strings: start over with a fresh
+        // dictionary holding only what this snapshot uses
+        dictionary.clear();
+        strings.clear();
+        newStrings.clear();
+        flatten(snapshot);
+
+        cores = snapshot.cpu->coreUsage.size();
+        disks = snapshot.disks->size();
+        processes = processCount;
+        interfaces = snapshot.network->interfaces.size();
+        cgroups = snapshot.cgroups->size();
+        watched = snapshot.watchedProcesses->size();
+        threads = snapshot.threads->size();
+        collectors = snapshot.self->collectors.size();
+        statWindows = snapshot.stats->windows.size();
+        statMetrics = snapshot.stats->metrics.size();
+        anomalies = snapshot.anomalies->flagged.size();
+        activeAlerts = snapshot.alerts->active.size();
+        alertEvents = snapshot.alerts->events.size();
+        writeSchema(out);
+        writeDictionary(out, newStrings);
+        writeKeyframe(out);
+        started = true;
+    } else {
+        if (!newStrings.empty()) writeDictionary(out, newStrings);
+        if (sinceKeyframe + 1 >= keyframeInterval) {
+            writeKeyframe(out);
+        } else {
+            writeTick(out);
+        }
+    }
+
+    previous.swap(current);
+}
+
+WireDecoder::WireDecoder() {
+    reset();
+}
+
+void WireDecoder::reset() {
+    pending.clear();
+    failed = false;
+    haveKeyframe = false;
+    cores = disks = processes = interfaces = cgroups = watched = threads = collectors = 0;
+    statWindows = statMetrics = 0;
+    anomalies = activeAlerts = alertEvents = 0;
+    fields.clear();
+    strings.clear();
+}
+
+bool WireDecoder::feed(const char* data, size_t size, std::vector<Snapshot>& out) {
+    if (failed) return false;
+    pending.append(data, size);
+
+    size_t offset = 0;
+    while (pending.size() - offset >= 4) {
+        uint32_t length = 0;
+        for (int i = 0; i < 4; ++i) {
+            length |= static_cast<uint32_t>(static_cast<uint8_t>(pending[offset + i])) << (8 * i);
+        }
+        if (pending.size() - offset - 4 < length) break;
+        const char* begin = pending.data() + offset + 4;
+        if (length == 0 || !frame(begin[0], begin + 1, begin + length, out)) {
+            failed = true;
+            return false;
+        }
+        offset += 4 + static_cast<size_t>(length);
+    }
+    pending.erase(0, offset);
+    return true;
+}
+
+bool WireDecoder::frame(char type, const char* payload, const char* end, std::vector<Snapshot>& out) {
+    const char* at = payload;
+    switch (type) {
+    case 'H':
+        return end - at == 5 && std::memcmp(at, "MCWP", 4) == 0 &&
+               static_cast<uint8_t>(at[4]) == WireEncoder::kProtocolVersion;
+
+    case 'S': {
+        size_t* const counts[] = {&cores, &disks, &processes, &interfaces, &cgroups, &watched, &threads,
+                                  &collectors, &statWindows, &statMetrics, &anomalies, &activeAlerts,
+                                  &alertEvents};
+        for (size_t* count : counts) {
+            uint64_t value = 0;
+            if (!getVarint(at, end, value)) return false;
+            *count = static_cast<size_t>(value);
+        }
+        strings.clear();
+        haveKeyframe = false;
+        return true;
+    }
+
+    case 'D': {
+        uint64_t count = 0;
+        if (!getVarint(at, end, count)) return false;
+        for (uint64_t i = 0; i < count; ++i) {
+            uint64_t id = 0;
+            uint64_t length = 0;
+            if (!getVarint(at, end, id) || !getVarint(at, end, length)) return false;
+            if (length > static_cast<uint64_t>(end - at)) return false;
+            strings[id].assign(at, static_cast<size_t>(length));
+            at += length;
+        }
+        return true;
+    }
+
+    case 'K': {
+        uint64_t count = 0;
+        if (!getVarint(at, end, count) || count > static_cast<uint64_t>(end - at)) return false;
+        fields.resize(static_cast<size_t>(count));
+        for (int64_t& value : fields) {
+            if (!getZigzag(at, end, value)) return false;
+        }
+        haveKeyframe = true;
+        break;
+    }
+
+    case 'T': {
+        uint64_t count = 0;
+        if (!haveKeyframe || !getVarint(at, end, count)) return false;
+        size_t index = static_cast<size_t>(-1);
+        for (uint64_t i = 0; i < count; ++i) {
+            uint64_t gap = 0;
+            int64_t delta = 0;
+            if (!getVarint(at, end, gap) || !getZigzag(at, end, delta)) return false;
+            index += static_cast<size_t>(gap);
+            if (index >= fields.size()) return false;
+            fields[index] = static_cast<int64_t>(static_cast<uint64_t>(fields[index]) + static_cast<uint64_t>(delta));
+        }
+        break;
+    }
+
+    default:
+        return false;
+    }
+
+    Snapshot snapshot;
+    if (!rebuild(snapshot)) return false;
+    out.push_back(std::move(snapshot));
+    return true;
+}
+
+bool WireDecoder::rebuild(Snapshot& snapshot) const {
+    FieldReader in(fields, strings);
+    snapshot.version = static_cast<uint64_t>(in.next());
+    snapshot.timestampMs = in.next();
+
+    CPUInfo& cpu = editSection(snapshot.cpu);
+    cpu.totalUsage = in.fixed();
+    cpu.coreCount = static_cast<int>(in.next());
+    cpu.frequency = in.fixed();
+    for (size_t i = 0; i < cores && in.ok(); ++i) cpu.coreUsage.push_back(in.fixed());
+    auto readTimes = [&in](CPUTimes& times) {
+        double* const values[] = {&times.user, &times.nice, &times.system, &times.idle,
+                                  &times.iowait, &times.irq, &times.softirq, &times.steal};
+        for (double* value : values) *value = in.fixed();
+    };
+    readTimes(cpu.times);
+    cpu.coreTimes.resize(cpu.coreUsage.size());
+    for (CPUTimes& times : cpu.coreTimes) readTimes(times);
+    for (size_t i = 0; i < cpu.coreUsage.size(); ++i) cpu.coreFrequency.push_back(in.fixed());
+
+    GPUInfo& gpu = editSection(snapshot.gpu);
+    gpu.name = in.text();
+    gpu.usage = in.fixed();
+    gpu.memoryUsed = in.fixed();
+    gpu.memoryTotal = in.fixed();
+    gpu.temperature = in.fixed();
+
+    MemoryInfo& mem = editSection(snapshot.memory);
+    mem.total = in.fixed();
+    mem.used = in.fixed();
+    mem.free = in.fixed();
+    mem.usagePercent = in.fixed();
+    double* const memoryFields[] = {&mem.cached, &mem.buffers, &mem.slab, &mem.slabReclaimable, &mem.shmem,
+                                    &mem.swapTotal, &mem.swapUsed, &mem.dirty, &mem.writeback,
+                                    &mem.hugePagesTotal, &mem.hugePagesUsed, &mem.pageFaults,
+                                    &mem.majorFaults, &mem.swapIn, &mem.swapOut, &mem.pagesScanned,
+                                    &mem.pagesReclaimed, &mem.allocStalls};
+    for (double* value : memoryFields) *value = in.fixed();
+    mem.oomKills = static_cast<uint64_t>(in.next());
+    MemoryPressure& pressure = mem.pressure;
+    double* const pressureFields[] = {&pressure.some10, &pressure.some60, &pressure.some300,
+                                      &pressure.full10, &pressure.full60, &pressure.full300};
+    for (double* value : pressureFields) *value = in.fixed();
+    pressure.available = in.next() != 0;
+
+    std::vector<DiskInfo>& diskList = editSection(snapshot.disks);
+    for (size_t i = 0; i < disks && in.ok(); ++i) {
+        DiskInfo disk;
+        disk.name = in.text();
+        disk.mountPoint = in.text();
+        disk.total = in.fixed();
+        disk.used = in.fixed();
+        disk.free = in.fixed();
+        disk.readSpeed = in.fixed();
+        disk.writeSpeed = in.fixed();
+        disk.readIops = in.fixed();
+        disk.writeIops = in.fixed();
+        disk.queueDepth = in.fixed();
+        disk.latency = in.fixed();
+        diskList.push_back(std::move(disk));
+    }
+
+    NetworkInfo& net = editSection(snapshot.network);
+    net.downloadSpeed = in.fixed();
+    net.uploadSpeed = in.fixed();
+    net.activeConnections = static_cast<int>(in.next());
+    SocketStats& sockets = net.sockets;
+    int* const socketFields[] = {&sockets.tcp, &sockets.tcpTimeWait, &sockets.tcpOrphan, &sockets.udp,
+                                 &sockets.established, &sockets.synSent, &sockets.synRecv, &sockets.finWait1,
+                                 &sockets.finWait2, &sockets.closeWait, &sockets.lastAck, &sockets.listen,
+                                 &sockets.closing, &sockets.closed, &sockets.udpConnected};
+    for (int* value : socketFields) *value = static_cast<int>(in.next());
+    for (size_t i = 0; i < interfaces && in.ok(); ++i) {
+        InterfaceInfo iface;
+        iface.name = in.text();
+        iface.downloadSpeed = in.fixed();
+        iface.uploadSpeed = in.fixed();
+        iface.rxPackets = in.fixed();
+        iface.txPackets = in.fixed();
+        iface.rxErrors = static_cast<uint64_t>(in.next());
+        iface.txErrors = static_cast<uint64_t>(in.next());
+        iface.rxDropped = static_cast<uint64_t>(in.next());
+        iface.txDropped = static_cast<uint64_t>(in.next());
+        net.interfaces.push_back(std::move(iface));
+    }
+
+    ProcessActivity& activity = editSection(snapshot.processActivity);
+    activity.total = static_cast<int>(in.next());
+    activity.spawned = static_cast<uint64_t>(in.next());
+    activity.exited = static_cast<uint64_t>(in.next());
+    activity.eventDriven = in.next() != 0;
+
+    std::vector<ProcessInfo>& processList = editSection(snapshot.processes);
+    for (size_t i = 0; i < processes && in.ok(); ++i) {
+        processList.emplace_back();
+        readProcess(in, processList.back());
+    }
+    std::vector<ProcessInfo>& watchedList = editSection(snapshot.watchedProcesses);
+    for (size_t i = 0; i < watched && in.ok(); ++i) {
+        watchedList.emplace_back();
+        readProcess(in, watchedList.back());
+    }
+
+    std::vector<CgroupInfo>& groups = editSection(snapshot.cgroups);
+    for (size_t i = 0; i < cgroups && in.ok(); ++i) {
+        CgroupInfo group;
+        group.path = in.text();
+        group.parent = static_cast<int>(in.next());
+        double* const values[] = {&group.cpuUsage, &group.cpuThrottled, &group.memoryCurrent, &group.memoryAnon,
+                                  &group.memoryFile, &group.ioReadSpeed, &group.ioWriteSpeed, &group.ioReadIops,
+                                  &group.ioWriteIops, &group.cpuPressure, &group.memoryPressure,
+                                  &group.memoryPressureFull, &group.ioPressure, &group.ioPressureFull};
+        for (double* value : values) *value = in.fixed();
+        groups.push_back(std::move(group));
+    }
+
+    ThreadSamplerStats& sampler = editSection(snapshot.threadSampler);
+    sampler.enabled = in.next() != 0;
+    sampler.pinned = in.next() != 0;
+    sampler.rate = in.fixed();
+    sampler.overhead = in.fixed();
+    sampler.dropped = static_cast<uint64_t>(in.next());
+    sampler.missedTicks = static_cast<uint64_t>(in.next());
+    std::vector<ThreadStats>& threadList = editSection(snapshot.threads);
+    for (size_t i = 0; i < threads && in.ok(); ++i) {
+        ThreadStats thread;
+        thread.pid = static_cast<int>(in.next());
+        thread.tid = static_cast<int>(in.next());
+        thread.name = in.text();
+        thread.samples = static_cast<uint64_t>(in.next());
+        double* const values[] = {&thread.cpuUsage, &thread.cpuP50, &thread.cpuP95, &thread.cpuP99,
+                                  &thread.cpuMax, &thread.waitP50, &thread.waitP95, &thread.waitP99,
+                                  &thread.waitMax, &thread.contextSwitches, &thread.migrations};
+        for (double* value : values) *value = in.fixed();
+        threadList.push_back(std::move(thread));
+    }
+
+    SelfInfo& self = editSection(snapshot.self);
+    self.cpuUsage = in.fixed();
+    self.cpuSeconds = in.fixed();
+    self.rssMB = in.fixed();
+    self.syscalls = in.fixed();
+    for (size_t i = 0; i < collectors && in.ok(); ++i) {
+        CollectorTiming timing;
+        timing.name = in.text();
+        timing.samples = static_cast<uint64_t>(in.next());
+        timing.skipped = static_cast<uint64_t>(in.next());
+        double* const values[] = {&timing.lastUs, &timing.meanUs, &timing.p50Us, &timing.p95Us, &timing.p99Us,
+                                  &timing.maxUs, &timing.lateP99Us, &timing.lateMaxUs};
+        for (double* value : values) *value = in.fixed();
+        self.collectors.push_back(std::move(timing));
+    }
+
+    RollingStatsInfo& stats = editSection(snapshot.stats);
+    for (size_t i = 0; i < statWindows && in.ok(); ++i) stats.windows.push_back(static_cast<int>(in.next()));
+    for (size_t i = 0; i < statMetrics && in.ok(); ++i) {
+        MetricStats metric;
+        metric.name = in.text();
+        for (size_t w = 0; w < stats.windows.size() && in.ok(); ++w) {
+            WindowStats window;
+            window.count = static_cast<uint64_t>(in.next());
+            double* const values[] = {&window.mean, &window.stddev, &window.p50, &window.p95, &window.p99,
+                                      &window.max};
+            for (double* value : values) *value = in.fixed();
+            metric.windows.push_back(window);
+        }
+        stats.metrics.push_back(std::move(metric));
+    }
+
+    AnomalyInfo& anomalyInfo = editSection(snapshot.anomalies);
+    anomalyInfo.series = static_cast<uint64_t>(in.next());
+    for (size_t i = 0; i < anomalies && in.ok(); ++i) {
+        MetricAnomaly anomaly;
+        anomaly.metric = in.text();
+        anomaly.detector = in.text();
+        anomaly.value = in.fixed();
+        anomaly.expected = in.fixed();
+        anomaly.score = in.fixed();
+        anomaly.sinceMs = in.next();
+        anomalyInfo.flagged.push_back(std::move(anomaly));
+    }
+
+    AlertsInfo& alerts = editSection(snapshot.alerts);
+    for (size_t i = 0; i < activeAlerts && in.ok(); ++i) {
+        ActiveAlert alert;
+        alert.rule = in.text();
+        alert.target = in.text();
+        alert.value = in.fixed();
+        alert.sinceMs = in.next();
+        alerts.active.push_back(std::move(alert));
+    }
+    for (size_t i = 0; i < alertEvents && in.ok(); ++i) {
+        AlertEvent event;
+        event.sequence = static_cast<uint64_t>(in.next());
+        event.timestampMs = in.next();
+        event.firing = in.next() != 0;
+        event.rule = in.text();
+        event.target = in.text();
+        event.value = in.fixed();
+        alerts.events.push_back(std::move(event));
+    }
+
+    // The keyframe must hold exactly the fields the schema describes
+    return in.complete();
+}
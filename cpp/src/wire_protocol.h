@@ -0,0 +1,174 @@
+#pragma once
+
+#include "../include/system_monitor.h"
+#include "snapshot_json.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Binary, delta-encoded snapshot stream (`monitor --format binary`).
+//
+// Every frame is   u32 length (little endian, covers type + payload)
+//                  u8  type
+//                  payload
+//
+// A snapshot is flattened into a vector of int64 fields. Fractional values
+// are fixed point with two decimals (value * 100, the precision of the JSON
+// output) and strings are replaced by dictionary ids. Field order:
+//
+//   version, timestampMs,
+//   cpu:        usage, cores, frequency, coreUsage[cores],
+//               times: user, nice, system, idle, iowait, irq, softirq, steal,
+//               coreTimes[cores] (same eight), coreFrequency[cores]
+//   gpu:        name, usage, memoryUsed, memoryTotal, temperature
+//   memory:     total, used, free, usagePercent, cached, buffers, slab,
+//               slabReclaimable, shmem, swapTotal, swapUsed, dirty, writeback,
+//               hugePagesTotal, hugePagesUsed, pageFaults, majorFaults, swapIn,
+//               swapOut, pagesScanned, pagesReclaimed, allocStalls,
+//               oomKills (integer),
+//               pressure: some10, some60, some300, full10, full60, full300,
+//                 available (integer)
+//   disks[n]:   name, mountPoint, total, used, free, readSpeed, writeSpeed,
+//               readIops, writeIops, queueDepth, latency
+//   network:    downloadSpeed, uploadSpeed, activeConnections,
+//               sockets: tcp, tcpTimeWait, tcpOrphan, udp, established,
+//                 synSent, synRecv, finWait1, finWait2, closeWait, lastAck,
+//                 listen, closing, closed, udpConnected (integers)
+//   interfaces[n]: name, downloadSpeed, uploadSpeed, rxPackets, txPackets,
+//               rxErrors, txErrors, rxDropped, txDropped (last four integers)
+//   processActivity: total, spawned, exited, eventDriven (integers)
+//   processes[n]: name, pid, cpuUsage, memoryUsage, fields (ProcessField
+//               mask), threads, state (character code), uid, voluntarySwitches,
+//               involuntarySwitches, fdCount, ioReadSpeed, ioWriteSpeed, pss,
+//               swap, cmdline. Fields whose bit is clear are zero.
+//   watchedProcesses[n]: same fields as processes
+//   cgroups[n]: path, parent (integer), cpuUsage, cpuThrottled, memoryCurrent,
+//               memoryAnon, memoryFile, ioReadSpeed, ioWriteSpeed, ioReadIops,
+//               ioWriteIops, cpuPressure, memoryPressure, memoryPressureFull,
+//               ioPressure, ioPressureFull
+//   threadSampler: enabled, pinned (integers), rate, overhead, dropped,
+//               missedTicks (integers)
+//   threads[n]: pid, tid (integers), name, samples (integer), cpuUsage,
+//               cpuP50, cpuP95, cpuP99, cpuMax, waitP50, waitP95, waitP99,
+//               waitMax, contextSwitches, migrations
+//   self:       cpuUsage, cpuSeconds, rssMB, syscalls
+//   self.collectors[n]: name, samples, skipped (integers), lastUs, meanUs,
+//               p50Us, p95Us, p99Us, maxUs, lateP99Us, lateMaxUs
+//   stats.windows[w]: window length in seconds (integer)
+//   stats.metrics[n]: name, then for each window: count (integer), mean,
+//               stddev, p50, p95, p99, max
+//   anomalies:  series (integer)
+//   anomalies.flagged[n]: metric, detector, value, expected, score, sinceMs
+//               (integer)
+//   alerts.active[n]: rule, target, value, sinceMs (integer)
+//   alerts.events[n]: sequence, timestampMs, firing (integers), rule, target,
+//               value
+//
+// Frame types:
+//   'H' hello       "MCWP", u8 protocol version. First frame of a stream.
+//   'S' schema      varint cores, disks, processes, interfaces, cgroups,
+//                   watched, threads, collectors, statWindows, statMetrics,
+//                   anomalies, activeAlerts, alertEvents. Fixes the field layout and
+//                   clears the string dictionary. Followed by 'D' and 'K'.
+//   'D' dictionary  varint count, then count x (varint id, varint length, bytes)
+//   'K' keyframe    varint fieldCount, then zigzag varint of every field
+//   'T' tick        varint changedCount, then changedCount x (varint gap,
+//                   zigzag varint delta). `gap` is the distance from the
+//                   previous changed index (the first is relative to -1);
+//                   `delta` is the change against the previous snapshot.
+//
+// Strings first seen in a tick are sent in a 'D' frame before that tick.
+// A keyframe is also sent every `keyframeInterval` snapshots.
+class WireEncoder {
+public:
+    static constexpr uint8_t kProtocolVersion = 14;
+
+    explicit WireEncoder(size_t maxProcesses = kSnapshotJsonProcesses,
+                         uint32_t keyframeInterval = 600,
+                         size_t maxDictionarySize = 4096);
+
+    // Appends the frames for `snapshot` to `out`. The caller owns `out` and
+    // typically clears it between calls to reuse its capacity.
+    void encode(const Snapshot& snapshot, std::string& out);
+
+    // Forgets all state; the next encode() starts a new stream with 'H'
+    void reset();
+
+private:
+    size_t maxProcesses;
+    uint32_t keyframeInterval;
+    size_t maxDictionarySize;
+
+    bool started;
+    uint32_t sinceKeyframe;
+    size_t cores;
+    size_t disks;
+    size_t processes;
+    size_t interfaces;
+    size_t cgroups;
+    size_t watched;
+    size_t threads;
+    size_t collectors;
+    size_t statWindows;
+    size_t statMetrics;
+    size_t anomalies;
+    size_t activeAlerts;
+    size_t alertEvents;
+
+    std::vector<int64_t> previous;
+    std::vector<int64_t> current;
+    std::unordered_map<std::string, uint32_t> dictionary;
+    std::vector<uint32_t> newStrings; // ids not yet sent
+    std::vector<const std::string*> strings; // id -> string, valid until the next schema
+
+    int64_t intern(const std::string& value);
+    void flatten(const Snapshot& snapshot);
+    void flattenProcess(const ProcessInfo& proc);
+    void writeSchema(std::string& out);
+    void writeDictionary(std::string& out, const std::vector<uint32_t>& ids);
+    void writeKeyframe(std::string& out);
+    void writeTick(std::string& out);
+};
+
+// Reads the stream written by WireEncoder back into snapshots; the C++
+// counterpart of python/monitor_wire.py. Fractional values come back with
+// the two decimals they were sent with, and every process field is set
+// whatever its bit in `fields`.
+class WireDecoder {
+public:
+    WireDecoder();
+
+    // Consumes `size` bytes of the stream, which may end mid-frame, and
+    // appends the snapshots it completes to `out`. Returns false on a
+    // malformed frame or another protocol version; every later call then
+    // fails too until reset().
+    bool feed(const char* data, size_t size, std::vector<Snapshot>& out);
+
+    void reset();
+
+private:
+    std::string pending; // Bytes of the frame not yet complete
+    bool failed;
+    bool haveKeyframe;
+    size_t cores;
+    size_t disks;
+    size_t processes;
+    size_t interfaces;
+    size_t cgroups;
+    size_t watched;
+    size_t threads;
+    size_t collectors;
+    size_t statWindows;
+    size_t statMetrics;
+    size_t anomalies;
+    size_t activeAlerts;
+    size_t alertEvents;
+
+    std::vector<int64_t> fields;
+    std::unordered_map<uint64_t, std::string> strings;
+
+    bool frame(char type, const char* payload, const char* end, std::vector<Snapshot>& out);
+    bool rebuild(Snapshot& snapshot) const;
+};
@@ -0,0 +1,242 @@
+#include "test.h"
+#include "alert_engine.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string rejection(const std::string& rule) {
+    std::string error;
+    return AlertEngine::validate(rule, error) ? std::string() : error;
+}
+
+bool compiles(AlertEngine& engine, const std::vector<std::string>& rules) {
+    std::string error;
+    return engine.compile(rules, error);
+}
+
+Snapshot cores(std::vector<double> usage) {
+    Snapshot snapshot;
+    CPUInfo& cpu = editSection(snapshot.cpu);
+    cpu.coreUsage = std::move(usage);
+    cpu.coreTimes.resize(cpu.coreUsage.size());
+    return snapshot;
+}
+
+ProcessInfo process(int pid, const char* name, double cpu, double memoryMb) {
+    ProcessInfo info;
+    info.pid = pid;
+    info.name = name;
+    info.cpuUsage = cpu;
+    info.memoryUsage = memoryMb;
+    return info;
+}
+
+} // namespace
+
+MONITOR_TEST(alerts, AcceptsMetricNames) {
+    const char* const rules[] = {
+        "cpu.usage > 90 for 10s clear 80",
+        "cpu.core.* >= 99",
+        "cpu.core.3.iowait > 5",
+        "memory.usagePercent > 95",
+        "memory.oomKills > 0",
+        "disk.*.free < 5GB",
+        "disk.nvme0n1.usedPercent > 90 clear 85",
+        "network.eth0.100.rxErrors > 0",
+        "process.python3.11.cpuUsage > 50",
+        "process.1234.memoryUsage > 1G for 1m",
+    };
+    for (const char* rule : rules) CHECK_EQ(rejection(rule), std::string());
+}
+
+MONITOR_TEST(alerts, RejectsMalformedRules) {
+    CHECK_EQ(rejection("gpu.bogus > 1"), std::string("unknown metric 'gpu.bogus'"));
+    CHECK_EQ(rejection("disk.sda.bogus > 1"), std::string("unknown field 'bogus' of disk"));
+    CHECK_EQ(rejection("cpu.core.x > 1"), std::string("a core is selected by index, got 'x'"));
+    CHECK_EQ(rejection("cpu.usage = 1"), std::string("expected >, >=, < or <= after cpu.usage"));
+    CHECK_EQ(rejection("cpu.usage > 5GB"), std::string("'GB' on a metric that is not a size or speed"));
+    CHECK_EQ(rejection("cpu.usage > 90 for soon"), std::string("expected a duration such as 10s"));
+    CHECK_EQ(rejection("cpu.usage > 90 clear 95"), std::string("clear level must not be above the threshold"));
+    CHECK_EQ(rejection("disk.*.free < 5GB clear 4GB"),
+             std::string("clear level must not be below the threshold"));
+    CHECK(!rejection("cpu.usage > 90 extra").empty());
+
+    // A bad rule names its line and keeps the previous rules
+    AlertEngine engine;
+    REQUIRE(compiles(engine, {"cpu.usage > 90"}));
+    std::string error;
+    CHECK(!engine.compile({"cpu.usage > 90", "cpu.usage >"}, error));
+    CHECK_EQ(error.substr(0, 8), std::string("rule 2: "));
+    CHECK_EQ(engine.ruleCount(), size_t(1));
+}
+
+MONITOR_TEST(alerts, FiresAfterForDuration) {
+    AlertEngine engine;
+    REQUIRE(compiles(engine, {"cpu.usage > 90 for 1s"}));
+    Snapshot snapshot;
+    CPUInfo& cpu = editSection(snapshot.cpu);
+    cpu.totalUsage = 95.0;
+
+    CHECK(!engine.evaluate(Collector::CPU, snapshot, 0, 0));
+    CHECK(!engine.evaluate(Collector::CPU, snapshot, 500, 500));
+    CHECK(engine.info().active.empty());
+    CHECK(engine.evaluate(Collector::CPU, snapshot, 1000, 1000));
+    REQUIRE(engine.info().active.size() == 1);
+    CHECK_EQ(engine.info().active[0].rule, std::string("cpu.usage > 90 for 1s"));
+    CHECK_EQ(engine.info().active[0].sinceMs, int64_t(1000));
+
+    // A dip below the threshold restarts the wait
+    AlertEngine again;
+    REQUIRE(compiles(again, {"cpu.usage > 90 for 1s"}));
+    again.evaluate(Collector::CPU, snapshot, 0, 0);
+    cpu.totalUsage = 50.0;
+    again.evaluate(Collector::CPU, snapshot, 500, 500);
+    cpu.totalUsage = 95.0;
+    again.evaluate(Collector::CPU, snapshot, 1000, 1000);
+    CHECK(again.info().active.empty());
+    again.evaluate(Collector::CPU, snapshot, 2000, 2000);
+    CHECK_EQ(again.info().active.size(), size_t(1));
+}
+
+MONITOR_TEST(alerts, ResolvesPastClearLevel) {
+    AlertEngine engine;
+    REQUIRE(compiles(engine, {"cpu.core.* > 90 clear 80"}));
+    Snapshot snapshot = cores({95.0, 10.0});
+    CPUInfo& cpu = editSection(snapshot.cpu);
+
+    CHECK(engine.evaluate(Collector::CPU, snapshot, 0, 0));
+    REQUIRE(engine.info().active.size() == 1);
+    CHECK_EQ(engine.info().active[0].target, std::string("0"));
+
+    // Between the clear level and the threshold it keeps firing
+    cpu.coreUsage[0] = 85.0;
+    CHECK(!engine.evaluate(Collector::CPU, snapshot, 250, 250));
+    CHECK_EQ(engine.info().active.size(), size_t(1));
+
+    cpu.coreUsage[0] = 75.0;
+    CHECK(engine.evaluate(Collector::CPU, snapshot, 500, 500));
+    CHECK(engine.info().active.empty());
+    REQUIRE(engine.info().events.size() == 2);
+    CHECK(engine.info().events[0].firing);
+    CHECK(!engine.info().events[1].firing);
+    CHECK_EQ(engine.info().events[1].sequence, uint64_t(2));
+    CHECK_EQ(engine.info().events[1].value, 75.0);
+}
+
+MONITOR_TEST(alerts, GroupedThresholdsFireIndependently) {
+    AlertEngine engine;
+    REQUIRE(compiles(engine, {"cpu.core.* > 95", "cpu.core.* > 50", "cpu.core.* > 70 for 1s"}));
+    Snapshot snapshot = cores({80.0, 20.0, 60.0});
+    CPUInfo& cpu = editSection(snapshot.cpu);
+
+    engine.evaluate(Collector::CPU, snapshot, 0, 0);
+    const std::vector<ActiveAlert>& active = engine.info().active;
+    REQUIRE(active.size() == 2);
+    CHECK_EQ(active[0].rule + " " + active[0].target, std::string("cpu.core.* > 50 0"));
+    CHECK_EQ(active[1].rule + " " + active[1].target, std::string("cpu.core.* > 50 2"));
+
+    engine.evaluate(Collector::CPU, snapshot, 1000, 1000);
+    REQUIRE(active.size() == 3);
+    CHECK_EQ(active[2].rule + " " + active[2].target, std::string("cpu.core.* > 70 for 1s 0"));
+
+    // Core 0 drops under every threshold; the firing checks resolve together
+    cpu.coreUsage[0] = 10.0;
+    engine.evaluate(Collector::CPU, snapshot, 2000, 2000);
+    REQUIRE(active.size() == 1);
+    CHECK_EQ(active[0].target, std::string("2"));
+}
+
+MONITOR_TEST(alerts, ResolvesTargetsThatDisappear) {
+    AlertEngine engine;
+    REQUIRE(compiles(engine, {"process.*.cpuUsage > 50", "disk.*.usedPercent > 90"}));
+
+    Snapshot snapshot;
+    std::vector<ProcessInfo>& processes = editSection(snapshot.processes);
+    std::vector<DiskInfo>& disks = editSection(snapshot.disks);
+    processes = {process(10, "busy", 90.0, 10.0), process(11, "idle", 1.0, 10.0)};
+    engine.evaluate(Collector::Process, snapshot, 0, 0);
+    REQUIRE(engine.info().active.size() == 1);
+    CHECK_EQ(engine.info().active[0].target, std::string("10"));
+
+    processes.erase(processes.begin());
+    CHECK(engine.evaluate(Collector::Process, snapshot, 2000, 2000));
+    CHECK(engine.info().active.empty());
+    REQUIRE(!engine.info().events.empty());
+    CHECK(!engine.info().events.back().firing);
+    CHECK_EQ(engine.info().events.back().target, std::string("10"));
+
+    DiskInfo disk;
+    disk.name = "sdb";
+    disk.total = 100.0;
+    disk.used = 95.0;
+    disk.free = 5.0;
+    disks = {disk};
+    engine.evaluate(Collector::Disk, snapshot, 3000, 3000);
+    CHECK_EQ(engine.info().active.size(), size_t(1));
+    disks.clear();
+    engine.evaluate(Collector::Disk, snapshot, 4000, 4000);
+    CHECK(engine.info().active.empty());
+}
+
+MONITOR_TEST(alerts, SelectsProcessesByNameOrPid) {
+    AlertEngine engine;
+    REQUIRE(compiles(engine, {"process.nginx.cpuUsage > 50", "process.12.memoryUsage > 1G"}));
+
+    Snapshot snapshot;
+    std::vector<ProcessInfo>& processes = editSection(snapshot.processes);
+    processes = {process(11, "nginx", 60.0, 100.0), process(12, "postgres", 60.0, 1000.0),
+                 process(13, "nginx", 10.0, 2000.0)};
+    engine.evaluate(Collector::Process, snapshot, 0, 0);
+    REQUIRE(engine.info().active.size() == 1);
+    CHECK_EQ(engine.info().active[0].target, std::string("11"));
+
+    // 1G is 1024 MB
+    processes[1].memoryUsage = 1100.0;
+    engine.evaluate(Collector::Process, snapshot, 2000, 2000);
+    REQUIRE(engine.info().active.size() == 2);
+    CHECK_EQ(engine.info().active[1].target, std::string("12"));
+}
+
+MONITOR_TEST(alerts, ComparesCountersAsRates) {
+    AlertEngine engine;
+    REQUIRE(compiles(engine, {"network.*.rxErrors > 2"}));
+
+    Snapshot snapshot;
+    NetworkInfo& network = editSection(snapshot.network);
+    network.interfaces.resize(1);
+    network.interfaces[0].name = "eth0";
+    network.interfaces[0].rxErrors = 1000;
+
+    // A large total alone is not a rate
+    engine.evaluate(Collector::Network, snapshot, 0, 0);
+    CHECK(engine.info().active.empty());
+
+    network.interfaces[0].rxErrors = 1009;
+    engine.evaluate(Collector::Network, snapshot, 1000, 1000);
+    REQUIRE(engine.info().active.size() == 1);
+    CHECK_NEAR(engine.info().active[0].value, 9.0, 1e-9);
+
+    network.interfaces[0].rxErrors = 1010;
+    engine.evaluate(Collector::Network, snapshot, 2000, 2000);
+    CHECK(engine.info().active.empty());
+}
+
+MONITOR_TEST(alerts, DiskWithoutCapacityHasNoData) {
+    AlertEngine engine;
+    REQUIRE(compiles(engine, {"disk.*.free < 512MB", "disk.*.usedPercent < 200"}));
+
+    Snapshot snapshot;
+    std::vector<DiskInfo>& disks = editSection(snapshot.disks);
+    disks.resize(2);
+    disks[0].name = "sda"; // Unmounted: no capacity
+    disks[1].name = "sdb";
+    disks[1].total = 10.0;
+    disks[1].free = 0.4;
+    disks[1].used = 9.6;
+
+    engine.evaluate(Collector::Disk, snapshot, 0, 0);
+    const std::vector<ActiveAlert>& active = engine.info().active;
+    REQUIRE(active.size() == 2);
+    for (const ActiveAlert& alert : active) CHECK_EQ(alert.target, std::string("sdb"));
+}
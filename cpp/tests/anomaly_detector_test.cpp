@@ -0,0 +1,117 @@
+#include "test.h"
+#include "anomaly_detector.h"
+#include <random>
+#include <string>
+
+namespace {
+
+constexpr int64_t kStartMs = 1700000000000LL;
+
+// A quiet host: every metric noisy around a steady level
+struct NoisyHost {
+    std::mt19937 random{42};
+    std::normal_distribution<double> noise{0.0, 1.0};
+    std::poisson_distribution<int> connections{30};
+
+    Snapshot sample(int64_t unixMs) {
+        Snapshot snapshot;
+        snapshot.timestampMs = unixMs;
+        CPUInfo& cpu = editSection(snapshot.cpu);
+        MemoryInfo& memory = editSection(snapshot.memory);
+        NetworkInfo& network = editSection(snapshot.network);
+        std::vector<ProcessInfo>& processes = editSection(snapshot.processes);
+        cpu.totalUsage = 50.0 + 3.0 * noise(random);
+        cpu.times.user = 10.0 + noise(random);
+        cpu.coreUsage.resize(8);
+        for (double& core : cpu.coreUsage) core = 40.0 + 5.0 * noise(random);
+        memory.used = 8000.0 + 20.0 * noise(random);
+        memory.usagePercent = memory.used / 160.0;
+        network.activeConnections = connections(random);
+        network.downloadSpeed = 2.0 + 0.2 * noise(random);
+        processes.resize(2);
+        for (size_t p = 0; p < processes.size(); ++p) {
+            processes[p].pid = static_cast<int>(100 + p);
+            processes[p].name = "worker";
+            processes[p].cpuUsage = 20.0 + 2.0 * noise(random);
+            processes[p].memoryUsage = 300.0 + noise(random);
+        }
+        return snapshot;
+    }
+};
+
+// Snapshot as it looks on the first sample, before any rate has a delta
+Snapshot firstSample(Snapshot snapshot) {
+    CPUInfo& cpu = editSection(snapshot.cpu);
+    NetworkInfo& network = editSection(snapshot.network);
+    std::vector<ProcessInfo>& processes = editSection(snapshot.processes);
+    cpu.totalUsage = cpu.times.user = 0.0;
+    std::fill(cpu.coreUsage.begin(), cpu.coreUsage.end(), 0.0);
+    network.downloadSpeed = 0.0;
+    for (ProcessInfo& proc : processes) proc.cpuUsage = 0.0;
+    return snapshot;
+}
+
+} // namespace
+
+MONITOR_TEST(anomalies, SteadyNoiseRaisesNoFlags) {
+    AnomalyDetector detector;
+    NoisyHost host;
+    detector.record(firstSample(host.sample(kStartMs)), 0);
+
+    size_t flagged = 0;
+    std::string first;
+    AnomalyInfo info;
+    for (int64_t second = 1; second <= 3600; ++second) {
+        detector.record(host.sample(kStartMs + second * 1000), second * 1000);
+        detector.report(info);
+        if (!info.flagged.empty() && first.empty()) {
+            first = info.flagged[0].metric + " " + info.flagged[0].detector + " at " + std::to_string(second);
+        }
+        flagged += info.flagged.size();
+    }
+    CHECK_EQ(flagged, size_t(0));
+    CHECK_EQ(first, std::string());
+    CHECK(info.series > 0);
+}
+
+MONITOR_TEST(anomalies, FlagsSpikeOnlyAfterWarmup) {
+    AnomalyDetector detector;
+    NoisyHost host;
+    AnomalyInfo info;
+    auto spikeFlagged = [&](int64_t second) {
+        Snapshot snapshot = host.sample(kStartMs + second * 1000);
+        editSection(snapshot.cpu).totalUsage = 100.0;
+        detector.record(snapshot, second * 1000);
+        detector.report(info);
+        for (const MetricAnomaly& anomaly : info.flagged) {
+            if (anomaly.metric == "cpu.usage" && anomaly.detector == std::string("zscore")) return true;
+        }
+        return false;
+    };
+
+    int64_t second = 0;
+    for (; second < 120; ++second) detector.record(host.sample(kStartMs + second * 1000), second * 1000);
+    CHECK(!spikeFlagged(second++));
+
+    for (; second < 700; ++second) detector.record(host.sample(kStartMs + second * 1000), second * 1000);
+    CHECK(spikeFlagged(second));
+    REQUIRE(!info.flagged.empty());
+    CHECK_NEAR(info.flagged[0].expected, 50.0, 1.0);
+}
+
+MONITOR_TEST(anomalies, WallClockStepKeepsWarmup) {
+    AnomalyDetector detector;
+    NoisyHost host;
+    AnomalyInfo info;
+    // The wall clock jumps two days ahead after ten samples; the monotonic
+    // clock that record() is given keeps ticking one second per sample
+    auto unixMs = [](int64_t second) { return kStartMs + second * 1000 + (second >= 10 ? 2 * 86400000LL : 0); };
+    int64_t second = 0;
+    for (; second < 120; ++second) detector.record(host.sample(unixMs(second)), second * 1000);
+
+    Snapshot snapshot = host.sample(unixMs(second));
+    editSection(snapshot.cpu).totalUsage = 100.0;
+    detector.record(snapshot, second * 1000);
+    detector.report(info);
+    CHECK(info.flagged.empty());
+}
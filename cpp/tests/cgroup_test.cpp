@@ -0,0 +1,294 @@
+#include "test.h"
+#include "linux/cgroup_monitor.h"
+#include "linux/procfs.h"
+#include "temp_tree.h"
+#include <chrono>
+#include <string>
+
+namespace {
+
+using std::chrono::seconds;
+
+// Collector rates are taken against procfs::now(); pinning it makes them exact
+struct PinnedClock {
+    std::chrono::steady_clock::time_point time{seconds(1000)};
+    PinnedClock() { procfs::pinNow(time); }
+    ~PinnedClock() { procfs::pinNow(std::chrono::steady_clock::time_point()); }
+    void advance(seconds step) {
+        time += step;
+        procfs::pinNow(time);
+    }
+};
+
+struct Counters {
+    uint64_t cpuUsec = 0;
+    uint64_t throttledUsec = 0;
+    uint64_t readBytes = 0; // Split over two devices
+    uint64_t writeBytes = 0;
+    uint64_t readOps = 0;
+    uint64_t writeOps = 0;
+    uint64_t cpuSome = 0;
+    uint64_t memorySome = 0;
+    uint64_t memoryFull = 0;
+    uint64_t ioSome = 0;
+    uint64_t ioFull = 0;
+};
+
+std::string pressure(uint64_t some, uint64_t full) {
+    return "some avg10=0.00 avg60=0.00 avg300=0.00 total=" + std::to_string(some) +
+           "\nfull avg10=0.00 avg60=0.00 avg300=0.00 total=" + std::to_string(full) + "\n";
+}
+
+void writeGroup(const TempTree& tree, const std::string& group, const Counters& c) {
+    std::string dir = group.empty() ? std::string() : group + "/";
+    tree.write(dir + "cpu.stat", "usage_usec " + std::to_string(c.cpuUsec) + "\nuser_usec 0\nsystem_usec 0\n" +
+                                     "nr_periods 0\nnr_throttled 0\nthrottled_usec " +
+                                     std::to_string(c.throttledUsec) + "\n");
+    tree.write(dir + "memory.current", "104857600\n");
+    tree.write(dir + "memory.stat", "anon 52428800\nfile 31457280\nanon_thp 0\nfile_mapped 0\n");
+    tree.write(dir + "io.stat",
+               "8:0 rbytes=" + std::to_string(c.readBytes / 2) + " wbytes=" + std::to_string(c.writeBytes / 2) +
+                   " rios=" + std::to_string(c.readOps / 2) + " wios=" + std::to_string(c.writeOps / 2) +
+                   " dbytes=0 dios=0\n259:0 rbytes=" + std::to_string(c.readBytes - c.readBytes / 2) +
+                   " wbytes=" + std::to_string(c.writeBytes - c.writeBytes / 2) +
+                   " rios=" + std::to_string(c.readOps - c.readOps / 2) +
+                   " wios=" + std::to_string(c.writeOps - c.writeOps / 2) + " dbytes=0 dios=0\n");
+    tree.write(dir + "cpu.pressure", pressure(c.cpuSome, 0));
+    tree.write(dir + "memory.pressure", pressure(c.memorySome, c.memoryFull));
+    tree.write(dir + "io.pressure", pressure(c.ioSome, c.ioFull));
+}
+
+const CgroupInfo* find(const std::vector<CgroupInfo>& info, const std::string& path) {
+    for (const CgroupInfo& group : info) {
+        if (group.path == path) return &group;
+    }
+    return nullptr;
+}
+
+CgroupOptions fixtureOptions(const TempTree& tree) {
+    CgroupOptions options;
+    options.root = tree.path();
+    options.rescanInterval = seconds(3600); // Only inotify, unless a case asks for a rescan
+    return options;
+}
+
+} // namespace
+
+MONITOR_TEST(cgroup, ParsesCountersIntoRates) {
+    TempTree tree("monitor_cgroup_test");
+    REQUIRE(!tree.path().empty());
+    PinnedClock clock;
+    writeGroup(tree, "", Counters());
+    writeGroup(tree, "system.slice", Counters());
+
+    CgroupMonitor monitor(fixtureOptions(tree));
+    REQUIRE(monitor.initialize());
+    monitor.update();
+    // The first sample only sets the baseline
+    std::vector<CgroupInfo> info = monitor.getInfo();
+    const CgroupInfo* first = find(info, "/system.slice");
+    REQUIRE(first);
+    CHECK_EQ(first->cpuUsage, 0.0);
+    CHECK_EQ(first->ioReadSpeed, 0.0);
+
+    Counters next;
+    next.cpuUsec = 1500000;      // 1.5 CPU seconds in 2 s
+    next.throttledUsec = 200000;
+    next.readBytes = 4 * 1024 * 1024;
+    next.writeBytes = 2 * 1024 * 1024;
+    next.readOps = 101;
+    next.writeOps = 51;
+    next.cpuSome = 500000;
+    next.memorySome = 100000;
+    next.memoryFull = 40000;
+    next.ioSome = 1000000;
+    next.ioFull = 600000;
+    writeGroup(tree, "system.slice", next);
+    clock.advance(seconds(2));
+    monitor.update();
+
+    info = monitor.getInfo();
+    const CgroupInfo* group = find(info, "/system.slice");
+    REQUIRE(group);
+    CHECK_NEAR(group->cpuUsage, 75.0, 1e-9);
+    CHECK_NEAR(group->cpuThrottled, 10.0, 1e-9);
+    CHECK_NEAR(group->memoryCurrent, 100.0, 1e-9);
+    CHECK_NEAR(group->memoryAnon, 50.0, 1e-9);
+    CHECK_NEAR(group->memoryFile, 30.0, 1e-9);
+    CHECK_NEAR(group->ioReadSpeed, 2.0, 1e-9); // Both devices summed
+    CHECK_NEAR(group->ioWriteSpeed, 1.0, 1e-9);
+    CHECK_NEAR(group->ioReadIops, 50.5, 1e-9);
+    CHECK_NEAR(group->ioWriteIops, 25.5, 1e-9);
+    CHECK_NEAR(group->cpuPressure, 25.0, 1e-9);
+    CHECK_NEAR(group->memoryPressure, 5.0, 1e-9);
+    CHECK_NEAR(group->memoryPressureFull, 2.0, 1e-9);
+    CHECK_NEAR(group->ioPressure, 50.0, 1e-9);
+    CHECK_NEAR(group->ioPressureFull, 30.0, 1e-9);
+
+    // The root did not move
+    const CgroupInfo* root = find(info, "/");
+    REQUIRE(root);
+    CHECK_EQ(root->cpuUsage, 0.0);
+    CHECK_EQ(root->parent, -1);
+}
+
+MONITOR_TEST(cgroup, ReadsFilesLargerThanTheBuffer) {
+    TempTree tree("monitor_cgroup_test");
+    REQUIRE(!tree.path().empty());
+    writeGroup(tree, "", Counters());
+
+    // Past the 16 KiB read buffer, with the wanted keys at the end
+    std::string stat;
+    for (int i = 0; stat.size() < 40 * 1024; ++i) stat += "padding_" + std::to_string(i) + " 0\n";
+    stat += "anon 52428800\nfile 31457280\n";
+    tree.write("memory.stat", stat);
+
+    CgroupMonitor monitor(fixtureOptions(tree));
+    REQUIRE(monitor.initialize());
+    monitor.update();
+    std::vector<CgroupInfo> info = monitor.getInfo();
+    REQUIRE(info.size() == 1);
+    CHECK_NEAR(info[0].memoryAnon, 50.0, 1e-9);
+    CHECK_NEAR(info[0].memoryFile, 30.0, 1e-9);
+    CHECK_NEAR(info[0].memoryCurrent, 100.0, 1e-9);
+}
+
+MONITOR_TEST(cgroup, CounterResetGivesZeroNotWraparound) {
+    TempTree tree("monitor_cgroup_test");
+    REQUIRE(!tree.path().empty());
+    PinnedClock clock;
+    Counters high;
+    high.cpuUsec = 9000000;
+    high.readBytes = 1 << 30;
+    writeGroup(tree, "", high);
+
+    CgroupMonitor monitor(fixtureOptions(tree));
+    REQUIRE(monitor.initialize());
+    monitor.update();
+    writeGroup(tree, "", Counters());
+    clock.advance(seconds(1));
+    monitor.update();
+
+    std::vector<CgroupInfo> info = monitor.getInfo();
+    REQUIRE(info.size() == 1);
+    CHECK_EQ(info[0].cpuUsage, 0.0);
+    CHECK_EQ(info[0].ioReadSpeed, 0.0);
+}
+
+MONITOR_TEST(cgroup, ListsParentsFirstInPathOrder) {
+    TempTree tree("monitor_cgroup_test");
+    REQUIRE(!tree.path().empty());
+    for (const char* group : {"", "user.slice", "system.slice", "system.slice/sshd.service",
+                              "system.slice/cron.service"}) {
+        writeGroup(tree, group, Counters());
+    }
+
+    CgroupMonitor monitor(fixtureOptions(tree));
+    REQUIRE(monitor.initialize());
+    monitor.update();
+    std::vector<CgroupInfo> info = monitor.getInfo();
+    REQUIRE(info.size() == 5);
+    const char* const expected[] = {"/", "/system.slice", "/system.slice/cron.service",
+                                    "/system.slice/sshd.service", "/user.slice"};
+    const int parents[] = {-1, 0, 1, 1, 0};
+    for (size_t i = 0; i < info.size(); ++i) {
+        CHECK_EQ(info[i].path, std::string(expected[i]));
+        CHECK_EQ(info[i].parent, parents[i]);
+    }
+}
+
+MONITOR_TEST(cgroup, FollowsCreatedAndRemovedGroups) {
+    TempTree tree("monitor_cgroup_test");
+    REQUIRE(!tree.path().empty());
+    writeGroup(tree, "", Counters());
+
+    CgroupMonitor monitor(fixtureOptions(tree));
+    REQUIRE(monitor.initialize());
+    CHECK_EQ(monitor.groupCount(), size_t(1));
+
+    // Created after the walk: reported by inotify, subtree included
+    tree.makeDirectory("machine.slice");
+    writeGroup(tree, "machine.slice", Counters());
+    monitor.update();
+    tree.makeDirectory("machine.slice/vm1.scope");
+    monitor.update();
+    CHECK_EQ(monitor.groupCount(), size_t(3));
+    CHECK(find(monitor.getInfo(), "/machine.slice/vm1.scope") != nullptr);
+
+    tree.remove("machine.slice");
+    monitor.update();
+    CHECK_EQ(monitor.groupCount(), size_t(1));
+    CHECK_EQ(monitor.getInfo().size(), size_t(1));
+
+    // A freed slot is reused cleanly
+    tree.makeDirectory("other.slice");
+    monitor.update();
+    std::vector<CgroupInfo> info = monitor.getInfo();
+    REQUIRE(info.size() == 2);
+    CHECK_EQ(info[1].path, std::string("/other.slice"));
+    CHECK_EQ(info[1].memoryCurrent, 0.0);
+}
+
+MONITOR_TEST(cgroup, RescanPicksUpLateControllerFiles) {
+    TempTree tree("monitor_cgroup_test");
+    REQUIRE(!tree.path().empty());
+    PinnedClock clock;
+    tree.write("app.slice/cpu.stat", "usage_usec 0\nthrottled_usec 0\n");
+
+    CgroupOptions options = fixtureOptions(tree);
+    options.rescanInterval = seconds(60);
+    CgroupMonitor monitor(options);
+    REQUIRE(monitor.initialize());
+    monitor.update();
+
+    // The memory controller is enabled later; nothing reports the new file
+    tree.write("app.slice/memory.current", "209715200\n");
+    clock.advance(seconds(1));
+    monitor.update();
+    std::vector<CgroupInfo> info = monitor.getInfo();
+    const CgroupInfo* group = find(info, "/app.slice");
+    REQUIRE(group);
+    CHECK_EQ(group->memoryCurrent, 0.0);
+
+    clock.advance(seconds(60));
+    monitor.update();
+    info = monitor.getInfo();
+    group = find(info, "/app.slice");
+    REQUIRE(group);
+    CHECK_NEAR(group->memoryCurrent, 200.0, 1e-9);
+}
+
+MONITOR_TEST(cgroup, StopsAtMaxGroups) {
+    TempTree tree("monitor_cgroup_test");
+    REQUIRE(!tree.path().empty());
+    for (const char* group : {"a", "b", "c", "d"}) tree.makeDirectory(group);
+
+    CgroupOptions options = fixtureOptions(tree);
+    options.maxGroups = 3;
+    CgroupMonitor monitor(options);
+    REQUIRE(monitor.initialize());
+    CHECK_EQ(monitor.groupCount(), size_t(3));
+    std::vector<CgroupInfo> info = monitor.getInfo();
+    REQUIRE(info.size() == 3);
+
+    // Room again once a tracked group goes away
+    tree.remove(info[1].path.substr(1));
+    monitor.update();
+    tree.makeDirectory("e");
+    monitor.update();
+    CHECK_EQ(monitor.groupCount(), size_t(3));
+    CHECK(find(monitor.getInfo(), "/e") != nullptr);
+}
+
+MONITOR_TEST(cgroup, FindsCgroup2MountInMountinfo) {
+    TempTree tree("monitor_cgroup_test");
+    REQUIRE(!tree.path().empty());
+    tree.write("proc/self/mountinfo",
+               "22 1 0:21 / /proc rw,nosuid shared:12 - proc proc rw\n"
+               "25 1 0:23 / /sys/fs/cgroup/unified rw,nosuid shared:4 - cgroup2 cgroup2 rw\n"
+               "26 1 0:24 / /sys/fs/cgroup/cpu rw,nosuid shared:5 - cgroup cgroup rw,cpu\n");
+    CHECK_EQ(CgroupMonitor::findCgroup2Root(tree.path()), tree.path() + "/sys/fs/cgroup/unified");
+
+    tree.write("proc/self/mountinfo", "22 1 0:21 / /proc rw,nosuid shared:12 - proc proc rw\n");
+    CHECK_EQ(CgroupMonitor::findCgroup2Root(tree.path()), std::string());
+}
@@ -0,0 +1,117 @@
+#include "test.h"
+#include "gorilla_codec.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+bool sameBits(double a, double b) {
+    uint64_t x, y;
+    std::memcpy(&x, &a, sizeof(x));
+    std::memcpy(&y, &b, sizeof(y));
+    return x == y;
+}
+
+void checkTimestamps(const std::vector<int64_t>& timestamps) {
+    std::vector<uint8_t> encoded;
+    gorilla::encodeTimestamps(timestamps.data(), timestamps.size(), encoded);
+    std::vector<int64_t> decoded(timestamps.size());
+    CHECK(gorilla::decodeTimestamps(encoded.data(), encoded.size(), decoded.size(), decoded.data()));
+    CHECK(decoded == timestamps);
+}
+
+void checkValues(const std::vector<double>& values) {
+    std::vector<uint8_t> encoded;
+    gorilla::encodeValues(values.data(), values.size(), encoded);
+    std::vector<double> decoded(values.size());
+    CHECK(gorilla::decodeValues(encoded.data(), encoded.size(), decoded.size(), decoded.data()));
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (!sameBits(decoded[i], values[i])) {
+            CHECK_EQ(decoded[i], values[i]);
+            return;
+        }
+    }
+}
+
+} // namespace
+
+MONITOR_TEST(gorilla, TimestampsRoundTrip) {
+    checkTimestamps({1700000000000});
+
+    std::vector<int64_t> steady;
+    for (int64_t i = 0; i < 1000; ++i) steady.push_back(1700000000000 + i * 1000);
+    checkTimestamps(steady);
+
+    // Jitter, gaps of every bucket size, a clock step back, extremes
+    std::mt19937_64 random(42);
+    std::vector<int64_t> irregular = {0};
+    const int64_t gaps[] = {1, 63, 64, 255, 256, 2047, 2048, 1 << 20, int64_t(1) << 40, -5000};
+    for (int i = 0; i < 2000; ++i) {
+        int64_t gap = i % 7 == 0 ? gaps[i / 7 % 10] : 1000 + static_cast<int64_t>(random() % 21) - 10;
+        irregular.push_back(irregular.back() + gap);
+    }
+    checkTimestamps(irregular);
+    checkTimestamps({std::numeric_limits<int64_t>::min() / 4, 0, std::numeric_limits<int64_t>::max() / 4});
+}
+
+MONITOR_TEST(gorilla, SteadyPeriodCostsOneBitPerSample) {
+    std::vector<int64_t> steady;
+    for (int64_t i = 0; i < 4096; ++i) steady.push_back(1700000000000 + i * 1000);
+    std::vector<uint8_t> encoded;
+    gorilla::encodeTimestamps(steady.data(), steady.size(), encoded);
+    CHECK(encoded.size() <= 8 + 8 + 4096 / 8 + 8);
+}
+
+MONITOR_TEST(gorilla, ValuesRoundTripBitExact) {
+    checkValues({42.5});
+    checkValues(std::vector<double>(500, 3.25)); // Repeats: one bit each
+
+    const double specials[] = {0.0, -0.0, 1.0, -1.0, std::numeric_limits<double>::quiet_NaN(),
+                               std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(),
+                               std::numeric_limits<double>::denorm_min(), std::numeric_limits<double>::max(),
+                               std::numeric_limits<double>::lowest(), 1e-300, 12345.6789};
+    std::vector<double> mixed;
+    for (int round = 0; round < 3; ++round) {
+        for (double value : specials) mixed.push_back(value);
+    }
+    checkValues(mixed);
+
+    // Slowly varying gauge and full-entropy values
+    std::mt19937_64 random(7);
+    std::normal_distribution<double> noise(0.0, 0.5);
+    std::vector<double> gauge;
+    std::vector<double> noisy;
+    for (int i = 0; i < 5000; ++i) {
+        gauge.push_back(std::round((40.0 + 10.0 * std::sin(i / 100.0) + noise(random)) * 10.0) / 10.0);
+        uint64_t bits = random();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        noisy.push_back(value);
+    }
+    checkValues(gauge);
+    checkValues(noisy);
+}
+
+MONITOR_TEST(gorilla, TruncatedInputIsRejected) {
+    std::vector<double> values;
+    std::vector<int64_t> timestamps;
+    for (int i = 0; i < 100; ++i) {
+        values.push_back(i * 1.37);
+        timestamps.push_back(1700000000000 + i * 997);
+    }
+    std::vector<uint8_t> encodedValues;
+    std::vector<uint8_t> encodedTimestamps;
+    gorilla::encodeValues(values.data(), values.size(), encodedValues);
+    gorilla::encodeTimestamps(timestamps.data(), timestamps.size(), encodedTimestamps);
+
+    std::vector<double> decodedValues(values.size());
+    std::vector<int64_t> decodedTimestamps(timestamps.size());
+    CHECK(!gorilla::decodeValues(encodedValues.data(), encodedValues.size() / 2, values.size(), decodedValues.data()));
+    CHECK(!gorilla::decodeTimestamps(encodedTimestamps.data(), encodedTimestamps.size() / 2, timestamps.size(),
+                                     decodedTimestamps.data()));
+    CHECK(!gorilla::decodeValues(encodedValues.data(), 0, 1, decodedValues.data()));
+}
@@ -0,0 +1,238 @@
+#include "test.h"
+#include "linux/metric_store.h"
+#include "temp_tree.h"
+#include <chrono>
+#include <cstdio>
+#include <dirent.h>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+namespace {
+
+constexpr int64_t kHourMs = 3600 * 1000LL;
+constexpr int64_t kDayMs = 24 * kHourMs;
+
+int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+Snapshot sample(int64_t timestampMs, double usage, size_t cores = 2) {
+    Snapshot snapshot;
+    snapshot.timestampMs = timestampMs;
+    CPUInfo& cpu = editSection(snapshot.cpu);
+    cpu.totalUsage = usage;
+    cpu.coreUsage.assign(cores, usage / 2);
+    editSection(snapshot.memory).usagePercent = 100.0 - usage;
+    return snapshot;
+}
+
+StoreOptions options(const TempTree& tree) {
+    StoreOptions options;
+    options.directory = tree.path() + "/store";
+    options.batchSamples = 10;
+    options.segmentCapacityBytes = 1 << 20;
+    return options;
+}
+
+// Store files whose names start with `prefix` ("seg-", "day-", ...)
+std::vector<std::string> files(const std::string& directory, const char* prefix) {
+    std::vector<std::string> names;
+    DIR* dir = ::opendir(directory.c_str());
+    if (!dir) return names;
+    while (struct dirent* entry = ::readdir(dir)) {
+        if (std::string(entry->d_name).rfind(prefix, 0) == 0) names.push_back(directory + "/" + entry->d_name);
+    }
+    ::closedir(dir);
+    return names;
+}
+
+long fileSize(const std::string& path) {
+    struct stat st;
+    return ::stat(path.c_str(), &st) == 0 ? static_cast<long>(st.st_size) : -1;
+}
+
+std::vector<StorePoint> query(const MetricStore& store, const std::string& series) {
+    std::vector<StorePoint> points;
+    store.query(series, 0, nowMs() + kDayMs, points);
+    return points;
+}
+
+} // namespace
+
+MONITOR_TEST(store, RoundTripsEverySample) {
+    TempTree tree("monitor_store_test");
+    REQUIRE(!tree.path().empty());
+    const int64_t start = nowMs() - kHourMs;
+    {
+        MetricStore store(options(tree));
+        REQUIRE(store.open());
+        for (int i = 0; i < 25; ++i) store.append(sample(start + i * 1000, i * 3.5));
+        store.append(sample(start + 24 * 1000, 99.0)); // Not newer: ignored
+        store.flush();
+
+        // Readable while the writer holds the segment open
+        std::vector<StorePoint> points = query(store, "cpu.usage");
+        REQUIRE(points.size() == 25);
+        for (int i = 0; i < 25; ++i) {
+            CHECK_EQ(points[i].timestampMs, start + i * 1000);
+            CHECK_EQ(points[i].value, i * 3.5);
+        }
+    }
+
+    MetricStore reader(options(tree));
+    std::vector<StorePoint> points = query(reader, "cpu.core.1");
+    REQUIRE(points.size() == 25);
+    CHECK_EQ(points[10].value, 17.5);
+
+    std::vector<StorePoint> range;
+    CHECK(reader.query("memory.usagePercent", start + 5000, start + 7000, range));
+    REQUIRE(range.size() == 3);
+    CHECK_EQ(range[0].value, 100.0 - 17.5);
+    CHECK(!reader.query("no.such.series", 0, nowMs(), range));
+}
+
+MONITOR_TEST(store, NewLayoutStartsNewSegment) {
+    TempTree tree("monitor_store_test");
+    REQUIRE(!tree.path().empty());
+    const int64_t start = nowMs() - kHourMs;
+    MetricStore store(options(tree));
+    REQUIRE(store.open());
+    for (int i = 0; i < 5; ++i) store.append(sample(start + i * 1000, 10.0, 2));
+    for (int i = 5; i < 10; ++i) store.append(sample(start + i * 1000, 20.0, 4)); // Cores came online
+    store.flush();
+
+    CHECK_EQ(files(options(tree).directory, "seg-").size(), size_t(2));
+    CHECK_EQ(query(store, "cpu.usage").size(), size_t(10));
+    CHECK_EQ(query(store, "cpu.core.3").size(), size_t(5));
+    std::vector<std::string> names = store.seriesNames();
+    REQUIRE(!names.empty());
+    CHECK_EQ(names.back(), std::string("cpu.core.3"));
+}
+
+MONITOR_TEST(store, RecoveryDropsTornAndCorruptBlocks) {
+    TempTree tree("monitor_store_test");
+    REQUIRE(!tree.path().empty());
+    const std::string directory = options(tree).directory;
+    const int64_t start = nowMs() - kHourMs;
+    {
+        MetricStore store(options(tree));
+        REQUIRE(store.open());
+        for (int i = 0; i < 30; ++i) store.append(sample(start + i * 1000, i));
+    }
+    std::vector<std::string> segments = files(directory, "seg-");
+    REQUIRE(segments.size() == 1);
+    // A sealed segment ends with one zeroed block header
+    const long intact = fileSize(segments[0]);
+
+    // A crash mid-block leaves a partial block after the last one, and an
+    // interrupted compaction leaves a .tmp file
+    {
+        std::fstream file(segments[0], std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(intact - 32);
+        file << std::string(100, '\x5a');
+    }
+    std::ofstream(directory + "/day-00000000000000000001.tmp") << "partial";
+    {
+        MetricStore store(options(tree));
+        REQUIRE(store.open());
+        // Not shrunk under a reader that may map it; the torn header is zeroed
+        CHECK_EQ(fileSize(segments[0]), intact + 68);
+        CHECK(files(directory, "day-").empty());
+        CHECK_EQ(query(store, "cpu.usage").size(), size_t(30));
+
+        // And appending carries on after the recovered data
+        for (int i = 30; i < 40; ++i) store.append(sample(start + i * 1000, i));
+    }
+    MetricStore reader(options(tree));
+    std::vector<StorePoint> points = query(reader, "cpu.usage");
+    REQUIRE(points.size() == 40);
+    CHECK_EQ(points[39].value, 39.0);
+
+    // A flipped bit in the last block of a file: that block is cut off, the
+    // earlier ones are kept
+    segments = files(directory, "seg-");
+    REQUIRE(segments.size() == 2);
+    const std::string& last = fileSize(segments[0]) < fileSize(segments[1]) ? segments[0] : segments[1];
+    {
+        std::fstream file(last, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(fileSize(last) - 32 - 40);
+        file.put('\xff');
+    }
+    {
+        MetricStore store(options(tree));
+        REQUIRE(store.open());
+        CHECK_EQ(query(store, "cpu.usage").size(), size_t(30));
+    }
+}
+
+MONITOR_TEST(store, ReaderStopsAtTornBlock) {
+    TempTree tree("monitor_store_test");
+    REQUIRE(!tree.path().empty());
+    const int64_t start = nowMs() - kHourMs;
+    {
+        MetricStore store(options(tree));
+        REQUIRE(store.open());
+        for (int i = 0; i < 30; ++i) store.append(sample(start + i * 1000, i));
+    }
+    std::vector<std::string> segments = files(options(tree).directory, "seg-");
+    REQUIRE(segments.size() == 1);
+
+    // As a reader in another process may see a block the writer is still
+    // filling: it is decoded only if its CRC matches
+    {
+        std::fstream file(segments[0], std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(fileSize(segments[0]) - 32 - 40);
+        file.put('\xff');
+    }
+    MetricStore reader(options(tree));
+    std::vector<StorePoint> points = query(reader, "cpu.usage");
+    REQUIRE(points.size() == 20);
+    CHECK_EQ(points[19].value, 19.0);
+}
+
+MONITOR_TEST(store, CompactsFinishedDaysAndAppliesRetention) {
+    TempTree tree("monitor_store_test");
+    REQUIRE(!tree.path().empty());
+    StoreOptions config = options(tree);
+    config.segmentDurationMs = kHourMs;
+    const int64_t dayStart = (nowMs() / kDayMs - 2) * kDayMs;
+    {
+        MetricStore store(config);
+        REQUIRE(store.open());
+        // One block per hour, three hours: three segments
+        for (int i = 0; i < 30; ++i) store.append(sample(dayStart + i * 6 * 60 * 1000, i));
+        store.flush();
+        CHECK_EQ(files(config.directory, "seg-").size(), size_t(3));
+
+        // The next segment is opened today, so the old day is merged
+        store.append(sample(nowMs(), 50.0));
+        store.flush();
+        CHECK_EQ(files(config.directory, "day-").size(), size_t(1));
+        CHECK_EQ(files(config.directory, "seg-").size(), size_t(1));
+
+        std::vector<StorePoint> points = query(store, "cpu.usage");
+        REQUIRE(points.size() == 31);
+        CHECK_EQ(points[0].timestampMs, dayStart);
+        CHECK_EQ(points[29].value, 29.0);
+        CHECK_EQ(points[30].value, 50.0);
+    }
+
+    // Two days is past a one-day retention: the merged day goes on open
+    config.retentionMs = kDayMs;
+    MetricStore store(config);
+    REQUIRE(store.open());
+    CHECK(files(config.directory, "day-").empty());
+    CHECK_EQ(query(store, "cpu.usage").size(), size_t(1));
+}
+
+MONITOR_TEST(store, OneWriterPerDirectory) {
+    TempTree tree("monitor_store_test");
+    REQUIRE(!tree.path().empty());
+    MetricStore first(options(tree));
+    REQUIRE(first.open());
+    MetricStore second(options(tree));
+    CHECK(!second.open());
+}
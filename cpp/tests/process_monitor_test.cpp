@@ -0,0 +1,167 @@
+#include "test.h"
+#include "process_monitor.h"
+#include "linux/pid_table.h"
+#include "linux/procfs.h"
+#include "temp_tree.h"
+#include <chrono>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using std::chrono::seconds;
+
+// CPU shares are taken against procfs::now(); pinning it makes them exact
+struct PinnedClock {
+    std::chrono::steady_clock::time_point time{seconds(1000)};
+    PinnedClock() { procfs::pinNow(time); }
+    ~PinnedClock() { procfs::pinNow(std::chrono::steady_clock::time_point()); }
+    void advance(seconds step) {
+        time += step;
+        procfs::pinNow(time);
+    }
+};
+
+// Every live entry of `table` matches `reference`, and nothing else is found
+bool matches(PidTable<int>& table, const std::map<int, int>& reference, int maxPid) {
+    if (table.size() != reference.size()) return false;
+    for (int pid = 1; pid <= maxPid; ++pid) {
+        const int* value = table.find(pid);
+        auto it = reference.find(pid);
+        if ((value != nullptr) != (it != reference.end())) return false;
+        if (value && *value != it->second) return false;
+    }
+    size_t visited = 0;
+    table.forEach([&](int pid, int& value) {
+        auto it = reference.find(pid);
+        if (it != reference.end() && it->second == value) ++visited;
+    });
+    return visited == reference.size();
+}
+
+// /proc/<pid>/stat with the fields the collector reads: utime (14),
+// num_threads (20), starttime (22) and rss (24, pages)
+void writeStat(const TempTree& tree, int pid, const std::string& name, uint64_t utime, uint64_t rssPages) {
+    tree.write("proc/" + std::to_string(pid) + "/stat",
+               std::to_string(pid) + " (" + name + ") S 1 1 1 0 -1 4194560 1200 0 0 0 " +
+               std::to_string(utime) + " 0 0 0 20 0 1 0 " + std::to_string(1000 + pid) +
+               " 104857600 " + std::to_string(rssPages) + " 18446744073709551615\n");
+}
+
+} // namespace
+
+MONITOR_TEST(processes, PidTableSurvivesChurnAcrossGrowth) {
+    PidTable<int> table(16);
+    std::map<int, int> reference;
+    const size_t initialCapacity = table.capacity();
+
+    // Past half full the table grows, rehashing every probe run; 200 entries
+    // from 16 slots takes several doublings
+    for (int pid = 1; pid <= 200; ++pid) {
+        bool inserted = false;
+        table.findOrInsert(pid, inserted) = pid * 10;
+        CHECK(inserted);
+        reference[pid] = pid * 10;
+    }
+    CHECK(table.capacity() > initialCapacity);
+    CHECK(table.capacity() >= 2 * table.size());
+    CHECK(matches(table, reference, 400));
+
+    // Erasing from the middle of probe runs must keep later entries reachable
+    for (int pid = 1; pid <= 200; pid += 2) {
+        table.erase(pid);
+        reference.erase(pid);
+    }
+    table.erase(999); // Absent: no effect
+    CHECK(matches(table, reference, 400));
+
+    bool inserted = true;
+    CHECK_EQ(table.findOrInsert(2, inserted), 20);
+    CHECK(!inserted);
+
+    // Random churn through further growth, checked against the reference map
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> pids(1, 400);
+    for (int step = 0; step < 5000; ++step) {
+        int pid = pids(random);
+        if (random() % 3 == 0) {
+            table.erase(pid);
+            reference.erase(pid);
+        } else {
+            table.findOrInsert(pid, inserted) = step;
+            reference[pid] = step;
+        }
+    }
+    CHECK(matches(table, reference, 400));
+
+    // eraseIf drops exactly the matching entries
+    std::vector<int> scratch;
+    table.eraseIf([](int pid, const int&) { return pid % 3 == 0; }, scratch);
+    for (auto it = reference.begin(); it != reference.end();) {
+        it = it->first % 3 == 0 ? reference.erase(it) : std::next(it);
+    }
+    CHECK(matches(table, reference, 400));
+}
+
+MONITOR_TEST(processes, TopProcessesRankByCpuThenMemory) {
+    TempTree tree("monitor_process_test");
+    REQUIRE(!tree.path().empty());
+    PinnedClock clock;
+
+    // pid, CPU ticks over the interval, RSS pages
+    struct Fixture {
+        int pid;
+        uint64_t ticks;
+        uint64_t rss;
+    };
+    const Fixture fixtures[] = {
+        {101, 50, 100},  // Busiest
+        {102, 20, 100},  // Three tied on CPU, ordered by memory
+        {103, 20, 300},
+        {104, 20, 200},
+        {105, 5, 50},    // Tied on both at the cut-off: any one of three
+        {106, 5, 50},
+        {107, 5, 50},
+        {108, 0, 5000},  // Idle, however large
+    };
+    for (const Fixture& fixture : fixtures) {
+        writeStat(tree, fixture.pid, "p" + std::to_string(fixture.pid), 0, fixture.rss);
+    }
+
+    ProcessMonitor monitor;
+    monitor.setRoot(tree.path());
+    monitor.setEventTracking(false);
+    monitor.setBatchedReads(false);
+    monitor.setTopCapacity(5);
+    REQUIRE(monitor.initialize());
+    monitor.update(); // Baseline
+
+    for (const Fixture& fixture : fixtures) {
+        writeStat(tree, fixture.pid, "p" + std::to_string(fixture.pid), fixture.ticks, fixture.rss);
+    }
+    clock.advance(seconds(1));
+    monitor.update();
+
+    std::vector<ProcessInfo> top = monitor.getTopProcesses(10);
+    REQUIRE(top.size() == 5);
+    const double tickPercent = 100.0 / sysconf(_SC_CLK_TCK);
+    CHECK_EQ(top[0].pid, 101);
+    CHECK_NEAR(top[0].cpuUsage, 50 * tickPercent, 1e-9);
+    CHECK_EQ(top[1].pid, 103);
+    CHECK_EQ(top[2].pid, 104);
+    CHECK_EQ(top[3].pid, 102);
+    CHECK_NEAR(top[3].cpuUsage, 20 * tickPercent, 1e-9);
+    CHECK(top[1].memoryUsage > top[2].memoryUsage && top[2].memoryUsage > top[3].memoryUsage);
+    CHECK(top[4].pid >= 105 && top[4].pid <= 107);
+    CHECK_NEAR(top[4].cpuUsage, 5 * tickPercent, 1e-9);
+    CHECK_EQ(top[4].name, "p" + std::to_string(top[4].pid));
+
+    // Fewer requested than kept: the highest ranked
+    std::vector<ProcessInfo> two = monitor.getTopProcesses(2);
+    REQUIRE(two.size() == 2);
+    CHECK_EQ(two[1].pid, 103);
+}
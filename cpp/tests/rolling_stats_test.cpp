@@ -0,0 +1,171 @@
+#include "test.h"
+#include "rolling_stats.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+Snapshot sample(double usage, size_t cores = 2) {
+    Snapshot snapshot;
+    CPUInfo& cpu = editSection(snapshot.cpu);
+    cpu.totalUsage = usage;
+    cpu.coreUsage.assign(cores, usage);
+    return snapshot;
+}
+
+const WindowStats* find(const RollingStatsInfo& info, const std::string& name, size_t window = 0) {
+    for (const MetricStats& metric : info.metrics) {
+        if (metric.name == name) return window < metric.windows.size() ? &metric.windows[window] : nullptr;
+    }
+    return nullptr;
+}
+
+// Nearest-rank percentile of `values`
+double exactPercentile(std::vector<double> values, double percent) {
+    std::sort(values.begin(), values.end());
+    size_t rank = static_cast<size_t>(std::ceil(percent / 100.0 * values.size()));
+    return values[std::max<size_t>(rank, 1) - 1];
+}
+
+void checkAccuracy(const std::vector<double>& values) {
+    RollingStats stats({60});
+    for (size_t i = 0; i < values.size(); ++i) stats.record(sample(values[i]), static_cast<int64_t>(i) * 10);
+    RollingStatsInfo info;
+    stats.summarize(info);
+    const WindowStats* cpu = find(info, "cpu.usage");
+    REQUIRE(cpu);
+
+    double sum = 0.0;
+    for (double value : values) sum += value;
+    double mean = sum / values.size();
+    double squares = 0.0;
+    for (double value : values) squares += (value - mean) * (value - mean);
+    CHECK_EQ(cpu->count, values.size());
+    CHECK_NEAR(cpu->mean, mean, 1e-9 * std::fabs(mean) + 1e-12);
+    CHECK_NEAR(cpu->stddev, std::sqrt(squares / values.size()), 1e-6 * std::sqrt(squares / values.size()) + 1e-9);
+    CHECK_EQ(cpu->max, *std::max_element(values.begin(), values.end()));
+
+    const double percents[] = {50.0, 95.0, 99.0};
+    const double reported[] = {cpu->p50, cpu->p95, cpu->p99};
+    for (size_t i = 0; i < 3; ++i) {
+        double exact = exactPercentile(values, percents[i]);
+        CHECK_NEAR(reported[i], exact, 0.05 * exact);
+    }
+}
+
+} // namespace
+
+MONITOR_TEST(stats, PercentilesWithinFivePercent) {
+    std::mt19937 random(1);
+    std::vector<double> uniform;
+    for (int i = 1; i <= 1000; ++i) uniform.push_back(i / 10.0);
+    std::shuffle(uniform.begin(), uniform.end(), random);
+    checkAccuracy(uniform);
+
+    // Heavy tail, as network and disk speeds are
+    std::lognormal_distribution<double> tail(2.0, 1.5);
+    std::vector<double> skewed;
+    for (int i = 0; i < 5000; ++i) skewed.push_back(tail(random));
+    checkAccuracy(skewed);
+}
+
+MONITOR_TEST(stats, ConstantSeriesReportsItself) {
+    RollingStats stats({60});
+    for (int i = 0; i < 100; ++i) stats.record(sample(37.0), i * 100);
+    RollingStatsInfo info;
+    stats.summarize(info);
+    const WindowStats* cpu = find(info, "cpu.usage");
+    REQUIRE(cpu);
+    CHECK_EQ(cpu->p50, 37.0);
+    CHECK_EQ(cpu->p99, 37.0);
+    CHECK_EQ(cpu->stddev, 0.0);
+
+    // Zero sits in the lowest bucket, and is still reported as zero
+    const WindowStats* memory = find(info, "memory.usagePercent");
+    REQUIRE(memory);
+    CHECK_EQ(memory->p95, 0.0);
+}
+
+MONITOR_TEST(stats, OldestPaneExpires) {
+    // 60 s window: twelve 5 s panes
+    RollingStats stats({60});
+    RollingStatsInfo info;
+    for (int64_t t = 0; t < 5000; t += 500) stats.record(sample(100.0), t);
+    for (int64_t t = 5000; t < 60000; t += 500) stats.record(sample(1.0), t);
+    stats.summarize(info);
+    const WindowStats* cpu = find(info, "cpu.usage");
+    REQUIRE(cpu);
+    CHECK_EQ(cpu->count, uint64_t(120));
+    CHECK_EQ(cpu->max, 100.0);
+
+    // The window now starts at 5 s: the spike is gone
+    stats.record(sample(1.0), 60000);
+    stats.summarize(info);
+    cpu = find(info, "cpu.usage");
+    REQUIRE(cpu);
+    CHECK_EQ(cpu->count, uint64_t(111));
+    CHECK_EQ(cpu->max, 1.0);
+    CHECK_EQ(cpu->p99, 1.0);
+
+    // After a gap longer than the window only the new sample is left
+    stats.record(sample(5.0), 600000);
+    stats.summarize(info);
+    cpu = find(info, "cpu.usage");
+    REQUIRE(cpu);
+    CHECK_EQ(cpu->count, uint64_t(1));
+    CHECK_EQ(cpu->mean, 5.0);
+}
+
+MONITOR_TEST(stats, WindowsSlideIndependently) {
+    RollingStats stats(RollingStats::defaultWindows());
+    for (int64_t t = 0; t < 600000; t += 1000) stats.record(sample(t < 300000 ? 90.0 : 10.0), t);
+    RollingStatsInfo info;
+    stats.summarize(info);
+    REQUIRE(info.windows == RollingStats::defaultWindows());
+
+    const WindowStats* minute = find(info, "cpu.usage", 0);
+    const WindowStats* fiveMinutes = find(info, "cpu.usage", 1);
+    const WindowStats* hour = find(info, "cpu.usage", 2);
+    REQUIRE(minute && fiveMinutes && hour);
+    CHECK_EQ(minute->count, uint64_t(60));
+    CHECK_EQ(minute->max, 10.0);
+    CHECK_EQ(fiveMinutes->max, 10.0);
+    CHECK_EQ(hour->count, uint64_t(600));
+    CHECK_EQ(hour->max, 90.0);
+    CHECK_NEAR(hour->mean, 50.0, 1e-9);
+}
+
+MONITOR_TEST(stats, LayoutChangeKeepsSurvivingSeries) {
+    RollingStats stats({60});
+    for (int i = 0; i < 10; ++i) stats.record(sample(20.0, 2), i * 1000);
+    for (int i = 10; i < 15; ++i) stats.record(sample(40.0, 4), i * 1000);
+    CHECK_EQ(stats.seriesCount(), size_t(4 + 4));
+
+    RollingStatsInfo info;
+    stats.summarize(info);
+    const WindowStats* kept = find(info, "cpu.core.1");
+    const WindowStats* added = find(info, "cpu.core.3");
+    REQUIRE(kept && added);
+    CHECK_EQ(kept->count, uint64_t(15));
+    CHECK_NEAR(kept->mean, (10 * 20.0 + 5 * 40.0) / 15, 1e-9);
+    CHECK_EQ(added->count, uint64_t(5));
+}
+
+MONITOR_TEST(stats, SkipsNonFiniteValues) {
+    RollingStats stats({60});
+    stats.record(sample(10.0), 0);
+    stats.record(sample(std::numeric_limits<double>::quiet_NaN()), 1000);
+    stats.record(sample(std::numeric_limits<double>::infinity()), 2000);
+    stats.record(sample(30.0), 3000);
+    RollingStatsInfo info;
+    stats.summarize(info);
+    const WindowStats* cpu = find(info, "cpu.usage");
+    REQUIRE(cpu);
+    CHECK_EQ(cpu->count, uint64_t(2));
+    CHECK_EQ(cpu->mean, 20.0);
+    CHECK_EQ(cpu->max, 30.0);
+}
@@ -0,0 +1,108 @@
+#include "test.h"
+#include "linux/shm_ring.h"
+#include "monitor_shm.h"
+#include <chrono>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+// A segment name of its own, so parallel test runs do not share a ring
+std::string segmentName() {
+    return "/monitor_shm_test_" + std::to_string(::getpid());
+}
+
+std::string readLatest(mc_shm_reader* reader, uint64_t& counter) {
+    char buffer[256];
+    int64_t length = mc_shm_read_latest(reader, buffer, sizeof(buffer), &counter);
+    return length > 0 ? std::string(buffer, static_cast<size_t>(length)) : std::string();
+}
+
+} // namespace
+
+MONITOR_TEST(shm, ReadersSeeTheNewestSlotAfterWrapping) {
+    ShmSnapshotRing ring;
+    REQUIRE(ring.create(segmentName(), 4, 64));
+    mc_shm_reader* reader = mc_shm_open(segmentName().c_str());
+    REQUIRE(reader != nullptr);
+
+    uint64_t counter = 0;
+    char buffer[64];
+    CHECK_EQ(mc_shm_read_latest(reader, buffer, sizeof(buffer), &counter), int64_t(0));
+
+    // Ten publishes over four slots: the ring wraps twice and the newest is
+    // in slot (10 - 1) % 4, not the last one written in slot order
+    for (int i = 1; i <= 10; ++i) CHECK(ring.publish("snapshot-" + std::to_string(i)));
+    CHECK_EQ(ring.published(), uint64_t(10));
+    CHECK_EQ(mc_shm_published(reader), uint64_t(10));
+    CHECK_EQ(readLatest(reader, counter), std::string("snapshot-10"));
+    CHECK_EQ(counter, uint64_t(10));
+
+    // Too small a buffer reports the length needed
+    CHECK_EQ(mc_shm_read_latest(reader, buffer, 4, nullptr), int64_t(-11));
+
+    // A zero-copy view stays valid until its slot is reused, which takes
+    // slotCount more publishes
+    const char* data = nullptr;
+    size_t length = 0;
+    uint64_t token = 0;
+    REQUIRE(mc_shm_peek_latest(reader, &data, &length, &token) == 1);
+    CHECK_EQ(std::string(data, length), std::string("snapshot-10"));
+    for (int i = 11; i <= 13; ++i) ring.publish("snapshot-" + std::to_string(i));
+    CHECK_EQ(mc_shm_validate(reader, token), 1);
+    ring.publish("snapshot-14");
+    CHECK_EQ(mc_shm_validate(reader, token), 0);
+    CHECK_EQ(readLatest(reader, counter), std::string("snapshot-14"));
+
+    mc_shm_close(reader);
+}
+
+MONITOR_TEST(shm, OversizedSnapshotsAreDropped) {
+    ShmSnapshotRing ring;
+    REQUIRE(ring.create(segmentName(), 2, 64));
+    mc_shm_reader* reader = mc_shm_open(segmentName().c_str());
+    REQUIRE(reader != nullptr);
+
+    CHECK(ring.publish(std::string(64, 'a'))); // Exactly one slot
+    CHECK(!ring.publish(std::string(65, 'b')));
+    CHECK(!ring.publish(std::string(1000, 'c')));
+    CHECK_EQ(ring.dropped(), uint64_t(2));
+    CHECK_EQ(mc_shm_dropped(reader), uint64_t(2));
+
+    // Dropped snapshots take no slot: the last one that fit is still newest
+    CHECK_EQ(ring.published(), uint64_t(1));
+    uint64_t counter = 0;
+    CHECK_EQ(readLatest(reader, counter), std::string(64, 'a'));
+    CHECK_EQ(counter, uint64_t(1));
+
+    mc_shm_close(reader);
+}
+
+MONITOR_TEST(shm, PublishWakesBlockedReaders) {
+    using Clock = std::chrono::steady_clock;
+    ShmSnapshotRing ring;
+    REQUIRE(ring.create(segmentName(), 4, 64));
+    mc_shm_reader* reader = mc_shm_open(segmentName().c_str());
+    REQUIRE(reader != nullptr);
+    CHECK_EQ(mc_shm_wait(reader, 0, 0), 0);
+
+    // The reader sleeps on the futex; without a wake it would only see the
+    // publish when its ten-second timeout expires
+    int woken = -1;
+    Clock::duration waited{};
+    std::thread waiter([&] {
+        Clock::time_point start = Clock::now();
+        woken = mc_shm_wait(reader, 0, 10000);
+        waited = Clock::now() - start;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ring.publish("snapshot-1");
+    waiter.join();
+
+    CHECK_EQ(woken, 1);
+    CHECK(waited < std::chrono::seconds(5));
+    CHECK_EQ(mc_shm_wait(reader, 0, 0), 1);
+
+    mc_shm_close(reader);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <sstream>
+#include <string>
+
+// Minimal test harness for monitor_tests. Cases register themselves with
+// MONITOR_TEST under a suite name, which is also the CTest test that runs
+// them. A failed CHECK is reported and the case goes on; a failed REQUIRE
+// also returns from it.
+namespace test {
+
+using Case = void (*)();
+
+struct Registration {
+    Registration(const char* suite, const char* name, Case run);
+};
+
+// Records a failure of the running case
+void fail(const char* file, int line, const std::string& message);
+
+template <typename A, typename B>
+std::string describe(const char* expression, const A& actual, const B& expected) {
+    std::ostringstream out;
+    out << expression << " (got " << actual << ", expected " << expected << ")";
+    return out.str();
+}
+
+} // namespace test
+
+#define MONITOR_TEST(suite, name)                                               \
+    static void suite##_##name();                                               \
+    static test::Registration suite##_##name##_registration(#suite, #name,      \
+                                                            suite##_##name);    \
+    static void suite##_##name()
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) test::fail(__FILE__, __LINE__, #condition);           \
+    } while (0)
+
+#define REQUIRE(condition)                                                      \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            test::fail(__FILE__, __LINE__, #condition);                         \
+            return;                                                             \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                              \
+    do {                                                                        \
+        const auto& actualValue = (actual);                                     \
+        const auto& expectedValue = (expected);                                 \
+        if (!(actualValue == expectedValue)) {                                  \
+            test::fail(__FILE__, __LINE__,                                      \
+                       test::describe(#actual, actualValue, expectedValue));    \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                 \
+    do {                                                                        \
+        double actualValue = (actual);                                          \
+        double expectedValue = (expected);                                      \
+        if (!(actualValue >= expectedValue - (tolerance) &&                     \
+              actualValue <= expectedValue + (tolerance))) {                    \
+            test::fail(__FILE__, __LINE__,                                      \
+                       test::describe(#actual, actualValue, expectedValue));    \
+        }                                                                       \
+    } while (0)
@@ -0,0 +1,52 @@
+#include "test.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace test {
+
+namespace {
+struct CaseEntry {
+    const char* suite;
+    const char* name;
+    Case run;
+};
+
+std::vector<CaseEntry>& registry() {
+    static std::vector<CaseEntry> cases;
+    return cases;
+}
+
+int caseFailures = 0;
+}
+
+Registration::Registration(const char* suite, const char* name, Case run) {
+    registry().push_back({suite, name, run});
+}
+
+void fail(const char* file, int line, const std::string& message) {
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, message.c_str());
+    ++caseFailures;
+}
+
+} // namespace test
+
+// monitor_tests [SUITE...]: runs every case, or those of the named suites
+int main(int argc, char** argv) {
+    int run = 0;
+    int failed = 0;
+    for (const auto& entry : test::registry()) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc && !selected; ++i) selected = std::strcmp(argv[i], entry.suite) == 0;
+        if (!selected) continue;
+
+        test::caseFailures = 0;
+        entry.run();
+        ++run;
+        if (test::caseFailures > 0) ++failed;
+        std::printf("%-6s %s.%s\n", test::caseFailures > 0 ? "FAIL" : "ok", entry.suite, entry.name);
+        std::fflush(stdout);
+    }
+    std::printf("%d of %d cases passed\n", run - failed, run);
+    return failed > 0 || run == 0 ? 1 : 0;
+}
@@ -0,0 +1,273 @@
+#include "test.h"
+#include "wire_protocol.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+// Every section populated, with values the two-decimal fixed point carries
+// exactly
+Snapshot fullSnapshot() {
+    Snapshot snapshot;
+    snapshot.version = 42;
+    snapshot.timestampMs = 1760000000123;
+
+    CPUInfo& cpu = editSection(snapshot.cpu);
+    cpu.totalUsage = 37.25;
+    cpu.coreCount = 2;
+    cpu.frequency = 2400.5;
+    cpu.coreUsage = {12.5, 62.0};
+    cpu.times.user = 20.25;
+    cpu.times.idle = 70.5;
+    cpu.times.steal = 0.01;
+    cpu.coreTimes.resize(2);
+    cpu.coreTimes[1].system = 9.75;
+    cpu.coreFrequency = {2400.0, 2401.0};
+
+    GPUInfo& gpu = editSection(snapshot.gpu);
+    gpu.name = "Test GPU";
+    gpu.usage = 5.5;
+    gpu.memoryTotal = 8192.0;
+    gpu.temperature = 41.0;
+
+    MemoryInfo& mem = editSection(snapshot.memory);
+    mem.total = 16000.0;
+    mem.used = 4000.25;
+    mem.free = 11999.75;
+    mem.usagePercent = 25.0;
+    mem.slabReclaimable = 120.5;
+    mem.allocStalls = 3.0;
+    mem.oomKills = 2;
+    mem.pressure.full300 = 0.75;
+    mem.pressure.available = true;
+
+    DiskInfo disk;
+    disk.name = "sda";
+    disk.mountPoint = "/";
+    disk.total = 512.0;
+    disk.latency = 1.25;
+    editSection(snapshot.disks).push_back(disk);
+
+    NetworkInfo& net = editSection(snapshot.network);
+    net.downloadSpeed = 1.5;
+    net.activeConnections = 17;
+    net.sockets.tcp = 30;
+    net.sockets.udpConnected = 4;
+    InterfaceInfo iface;
+    iface.name = "eth0";
+    iface.rxPackets = 100.5;
+    iface.txDropped = 9;
+    net.interfaces.push_back(iface);
+
+    ProcessActivity& activity = editSection(snapshot.processActivity);
+    activity.total = 250;
+    activity.spawned = 3;
+    activity.exited = 1;
+    activity.eventDriven = true;
+
+    ProcessInfo proc;
+    proc.name = "server";
+    proc.pid = 1234;
+    proc.cpuUsage = 88.5;
+    proc.memoryUsage = 512.25;
+    proc.fields = kProcessAllFields;
+    proc.threads = 12;
+    proc.state = 'R';
+    proc.uid = 1000;
+    proc.fdCount = 64;
+    proc.ioWriteSpeed = 2.5;
+    proc.involuntarySwitches = 10.0;
+    proc.pss = 400.0;
+    proc.cmdline = "server --port 80";
+    std::vector<ProcessInfo>& processes = editSection(snapshot.processes);
+    processes.push_back(proc);
+    proc.name = "idle";
+    proc.pid = 1;
+    proc.cpuUsage = 0.0;
+    proc.fields = 0;
+    proc.cmdline.clear();
+    processes.push_back(proc);
+    proc.name = "watched";
+    proc.pid = 777;
+    editSection(snapshot.watchedProcesses).push_back(proc);
+
+    CgroupInfo group;
+    group.path = "/";
+    group.cpuUsage = 150.0;
+    group.ioPressureFull = 0.5;
+    editSection(snapshot.cgroups).push_back(group);
+
+    ThreadSamplerStats& sampler = editSection(snapshot.threadSampler);
+    sampler.enabled = true;
+    sampler.rate = 250.0;
+    sampler.dropped = 5;
+    ThreadStats thread;
+    thread.pid = 1234;
+    thread.tid = 1240;
+    thread.name = "worker";
+    thread.samples = 250;
+    thread.waitP99 = 12.5;
+    thread.migrations = 0.25;
+    editSection(snapshot.threads).push_back(thread);
+
+    SelfInfo& self = editSection(snapshot.self);
+    self.cpuUsage = 0.5;
+    self.rssMB = 12.75;
+    CollectorTiming timing;
+    timing.name = "cpu";
+    timing.samples = 600;
+    timing.skipped = 1;
+    timing.p99Us = 120.5;
+    timing.lateMaxUs = 300.0;
+    self.collectors.push_back(timing);
+
+    RollingStatsInfo& stats = editSection(snapshot.stats);
+    stats.windows = {60, 300};
+    MetricStats metric;
+    metric.name = "cpu.usage";
+    metric.windows.resize(2);
+    metric.windows[0].count = 60;
+    metric.windows[1].p95 = 80.5;
+    stats.metrics.push_back(metric);
+
+    AnomalyInfo& anomalies = editSection(snapshot.anomalies);
+    anomalies.series = 40;
+    MetricAnomaly anomaly;
+    anomaly.metric = "disk.sda.latency";
+    anomaly.detector = "zscore";
+    anomaly.value = 9.5;
+    anomaly.expected = 1.25;
+    anomaly.score = -4.5;
+    anomaly.sinceMs = 1759999999000;
+    anomalies.flagged.push_back(anomaly);
+
+    AlertsInfo& alerts = editSection(snapshot.alerts);
+    ActiveAlert alert;
+    alert.rule = "cpu.usage > 30";
+    alert.value = 37.25;
+    alert.sinceMs = 1759999998000;
+    alerts.active.push_back(alert);
+    AlertEvent event;
+    event.sequence = 7;
+    event.timestampMs = 1759999998000;
+    event.firing = true;
+    event.rule = alert.rule;
+    event.value = 37.25;
+    alerts.events.push_back(event);
+    return snapshot;
+}
+
+std::string encodeAll(const std::vector<Snapshot>& snapshots) {
+    WireEncoder encoder;
+    std::string stream;
+    for (const Snapshot& snapshot : snapshots) encoder.encode(snapshot, stream);
+    return stream;
+}
+
+} // namespace
+
+MONITOR_TEST(wire, RoundTripsEverySection) {
+    std::vector<Snapshot> sent;
+    sent.push_back(fullSnapshot());
+    // A tick with changed values and a string not seen before
+    Snapshot next = fullSnapshot();
+    next.version = 43;
+    next.timestampMs += 1000;
+    editSection(next.cpu).coreUsage[1] = 12.0;
+    editSection(next.processes)[0].name = "server-renamed";
+    sent.push_back(next);
+    // A new layout: schema, dictionary and keyframe again
+    Snapshot grown = next;
+    grown.version = 44;
+    DiskInfo disk;
+    disk.name = "nvme0n1";
+    disk.readIops = 1500.5;
+    editSection(grown.disks).push_back(disk);
+    sent.push_back(grown);
+
+    const std::string stream = encodeAll(sent);
+
+    // Fed a byte at a time, so every frame also arrives split
+    WireDecoder decoder;
+    std::vector<Snapshot> received;
+    for (char byte : stream) REQUIRE(decoder.feed(&byte, 1, received));
+    REQUIRE(received.size() == 3);
+
+    // Every field the encoder sends: the decoded snapshots encode to the
+    // same stream
+    CHECK(encodeAll(received) == stream);
+
+    const Snapshot& first = received[0];
+    CHECK_EQ(first.version, uint64_t(42));
+    CHECK_EQ(first.timestampMs, int64_t(1760000000123));
+    CHECK_EQ(first.cpu->coreUsage.size(), size_t(2));
+    CHECK_EQ(first.cpu->coreTimes[1].system, 9.75);
+    CHECK_EQ(first.gpu->name, std::string("Test GPU"));
+    CHECK_EQ(first.memory->oomKills, uint64_t(2));
+    CHECK(first.memory->pressure.available);
+    CHECK_EQ(first.disks->at(0).latency, 1.25);
+    CHECK_EQ(first.network->interfaces.at(0).txDropped, uint64_t(9));
+    REQUIRE(first.processes->size() == 2);
+    const ProcessInfo& proc = first.processes->at(0);
+    CHECK_EQ(proc.pid, 1234);
+    CHECK_EQ(proc.memoryUsage, 512.25);
+    CHECK_EQ(proc.state, 'R');
+    CHECK_EQ(proc.fields, uint32_t(kProcessAllFields));
+    CHECK_EQ(proc.cmdline, std::string("server --port 80"));
+    CHECK_EQ(first.watchedProcesses->at(0).pid, 777);
+    CHECK_EQ(first.cgroups->at(0).parent, -1);
+    CHECK_EQ(first.threads->at(0).waitP99, 12.5);
+    CHECK_EQ(first.self->collectors.at(0).lateMaxUs, 300.0);
+    CHECK_EQ(first.stats->metrics.at(0).windows.at(1).p95, 80.5);
+    CHECK_EQ(first.anomalies->flagged.at(0).score, -4.5);
+    CHECK_EQ(first.alerts->events.at(0).rule, std::string("cpu.usage > 30"));
+
+    CHECK_EQ(received[1].cpu->coreUsage[1], 12.0);
+    CHECK_EQ(received[1].processes->at(0).name, std::string("server-renamed"));
+    CHECK_EQ(received[1].gpu->name, std::string("Test GPU"));
+    REQUIRE(received[2].disks->size() == 2);
+    CHECK_EQ(received[2].disks->at(1).name, std::string("nvme0n1"));
+    CHECK_EQ(received[2].disks->at(1).readIops, 1500.5);
+}
+
+MONITOR_TEST(wire, RejectsOtherProtocolVersions) {
+    std::string stream = encodeAll({fullSnapshot()});
+    // Length prefix, 'H', "MCWP", then the version byte
+    REQUIRE(stream.size() > 9 && stream[4] == 'H');
+    stream[9] = static_cast<char>(WireEncoder::kProtocolVersion - 1);
+
+    WireDecoder decoder;
+    std::vector<Snapshot> received;
+    CHECK(!decoder.feed(stream.data(), stream.size(), received));
+    CHECK(received.empty());
+    // Stays failed rather than decoding what follows
+    CHECK(!decoder.feed(stream.data() + 10, stream.size() - 10, received));
+
+    decoder.reset();
+    stream[9] = static_cast<char>(WireEncoder::kProtocolVersion);
+    CHECK(decoder.feed(stream.data(), stream.size(), received));
+    CHECK_EQ(received.size(), size_t(1));
+}
+
+MONITOR_TEST(wire, RejectsMalformedFrames) {
+    const std::string hello = encodeAll({fullSnapshot()}).substr(0, 10);
+    std::vector<Snapshot> received;
+
+    // A tick before any keyframe
+    WireDecoder decoder;
+    std::string stream = hello + std::string("\x04\0\0\0T\x01\x01\x02", 8);
+    CHECK(!decoder.feed(stream.data(), stream.size(), received));
+
+    // A keyframe shorter than its schema: one field where an empty layout
+    // already has dozens
+    decoder.reset();
+    stream = hello + std::string("\x0e\0\0\0S", 5) + std::string(13, '\0') +
+             std::string("\x03\0\0\0K\x01\0", 7);
+    CHECK(!decoder.feed(stream.data(), stream.size(), received));
+
+    // An unknown frame type
+    decoder.reset();
+    stream = hello + std::string("\x01\0\0\0X", 5);
+    CHECK(!decoder.feed(stream.data(), stream.size(), received));
+    CHECK(received.empty());
+}
@@ -8,6 +8,9 @@ from flask_socketio import SocketIO, emit
 import os
 import sys
 
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+import monitor_wire
+
 # Get the project root directory (2 levels up from this file)
 BASE_DIR = os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
 WEB_DIR = os.path.join(BASE_DIR, 'web')
@@ -27,6 +30,16 @@ socketio = SocketIO(app, cors_allowed_origins="*", async_mode='threading')
 # Path to C++ monitor executable
 MONITOR_EXE = None
 
+# Read the monitor's binary delta stream instead of NDJSON (--binary)
+USE_BINARY = '--binary' in sys.argv
+
+# Attach to an already running `monitor --shm NAME` instead of spawning one
+SHM_NAME = None
+if '--shm' in sys.argv:
+    index = sys.argv.index('--shm')
+    has_name = index + 1 < len(sys.argv) and not sys.argv[index + 1].startswith('--')
+    SHM_NAME = sys.argv[index + 1] if has_name else '/monitor_core'
+
 def find_monitor_exe():
     """Find the monitor executable"""
     # Check common build locations relative to BASE_DIR
@@ -44,10 +57,51 @@ def find_monitor_exe():
     
     return None
 
+def read_updates(stream):
+    """Yields snapshot dicts from the monitor's stdout in either format"""
+    if USE_BINARY:
+        yield from monitor_wire.read_snapshots(stream)
+        return
+
+    errors = 0
+    for raw in stream:
+        stripped = raw.decode('utf-8', 'replace').strip()
+        if not stripped:
+            continue
+        try:
+            yield json.loads(stripped)
+        except json.JSONDecodeError as e:
+            # Only log first few errors to avoid spam
+            errors += 1
+            if errors <= 5:
+                print(f"❌ JSON decode error: {e}")
+                print(f"Line start: {stripped[:100]}")
+
+def shm_worker():
+    """Background worker that reads from a shared-memory ring"""
+    import monitor_shm
+
+    try:
+        reader = monitor_shm.ShmReader(SHM_NAME)
+    except monitor_shm.ShmError as e:
+        print(f"ERROR: {e}")
+        socketio.emit('error', {'message': str(e)})
+        return
+
+    print(f"Reading snapshots from shared memory {SHM_NAME}")
+    with reader:
+        for data in reader.updates():
+            socketio.emit('system_update', data)
+    print("Monitor writing to shared memory has exited")
+
 def monitor_worker():
     """Background worker that reads from C++ monitor"""
     global MONITOR_EXE
     
+    if SHM_NAME:
+        shm_worker()
+        return
+
     if not MONITOR_EXE:
         MONITOR_EXE = find_monitor_exe()
     
@@ -61,62 +115,35 @@ def monitor_worker():
     print(f"Starting monitor from: {MONITOR_EXE}")
     
     try:
+        # NDJSON mode: one complete JSON document per line.
+        # Binary mode: framed delta stream decoded by monitor_wire.
         process = subprocess.Popen(
-            [MONITOR_EXE],
+            [MONITOR_EXE, '--format', 'binary' if USE_BINARY else 'ndjson'],
             stdout=subprocess.PIPE,
             stderr=subprocess.PIPE,
-            text=True,
-            bufsize=1,
-            universal_newlines=True
+            bufsize=0
         )
         
         # Start a thread to read stderr
         def read_stderr():
             for line in process.stderr:
-                print(f"Monitor stderr: {line.strip()}")
+                print(f"Monitor stderr: {line.decode('utf-8', 'replace').strip()}")
         
         stderr_thread = threading.Thread(target=read_stderr, daemon=True)
         stderr_thread.start()
         
         line_count = 0
-        json_buffer = ""
-        brace_count = 0
         
-        for line in process.stdout:
-            # Count braces in this line
-            open_braces = line.count('{')
-            close_braces = line.count('}')
-            brace_count += open_braces - close_braces
-            
-            # Add line to buffer
-            json_buffer += line
-            
-            # Only try to parse when braces are balanced (complete JSON)
-            # Check that buffer starts with { and ends with } (or }\n)
-            if brace_count == 0 and json_buffer.strip():
-                stripped = json_buffer.strip()
-                if stripped.startswith('{') and stripped.endswith('}'):
-                    try:
-                        data = json.loads(stripped)
-                        # Successfully parsed - emit and reset buffer
-                        socketio.emit('system_update', data)
-                        line_count += 1
-                        if line_count <= 3:
-                            print(f"✅ Sent update #{line_count} to clients")
-                        json_buffer = ""  # Reset buffer
-                    except json.JSONDecodeError as e:
-                        # Only log first few errors to avoid spam
-                        if line_count < 5:
-                            print(f"❌ JSON decode error: {e}")
-                            print(f"Buffer length: {len(stripped)}")
-                            print(f"Buffer start: {stripped[:100]}")
-                            print(f"Buffer end: {stripped[-100:]}")
-                        json_buffer = ""  # Reset on error
-                    except Exception as e:
-                        print(f"❌ Error processing data: {e}")
-                        import traceback
-                        traceback.print_exc()
-                        json_buffer = ""  # Reset on error
+        for data in read_updates(process.stdout):
+            try:
+                socketio.emit('system_update', data)
+                line_count += 1
+                if line_count <= 3:
+                    print(f"✅ Sent update #{line_count} to clients")
+            except Exception as e:
+                print(f"❌ Error processing data: {e}")
+                import traceback
+                traceback.print_exc()
         
         print("Monitor process stdout ended")
                 
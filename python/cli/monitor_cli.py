@@ -10,6 +10,9 @@ from rich.panel import Panel
 from rich.text import Text
 import time
 
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+import monitor_wire
+
 console = Console()
 
 def find_monitor_exe():
@@ -76,6 +79,10 @@ def create_cpu_panel(cpu_data):
     content += f"Cores: {cores}\n"
     if frequency > 0:
         content += f"Frequency: {frequency:.0f} MHz\n"
+    times = cpu_data.get('times')
+    if times:
+        content += (f"User {times.get('user', 0):.1f}%  System {times.get('system', 0):.1f}%  "
+                    f"I/O wait {times.get('iowait', 0):.1f}%  Steal {times.get('steal', 0):.1f}%\n")
     
     # Core usage bars
     core_usage = cpu_data.get('coreUsage', [])
@@ -116,6 +123,11 @@ def create_memory_panel(mem_data):
     content += f"Used: {used:.0f} MB\n"
     content += f"Free: {free:.0f} MB\n"
     content += f"Usage: {usage:.1f}%\n"
+    if 'cached' in mem_data:
+        content += f"Cached: {mem_data.get('cached', 0):.0f} MB  Swap: {mem_data.get('swapUsed', 0):.0f} MB\n"
+    pressure = mem_data.get('pressure', {})
+    if pressure.get('available'):
+        content += f"Pressure: some {pressure.get('some10', 0):.1f}%  full {pressure.get('full10', 0):.1f}%\n"
     
     # Memory bar
     bar_length = int(usage / 2)
@@ -154,7 +166,39 @@ def create_processes_panel(processes):
     
     return Panel(table, border_style="blue")
 
+def read_json_lines(stream):
+    """Yields one dict per NDJSON line, skipping lines that fail to parse"""
+    for line in stream:
+        try:
+            yield json.loads(line)
+        except json.JSONDecodeError:
+            continue
+
+def run_shm(name):
+    """Displays snapshots from a running `monitor --shm NAME`"""
+    import monitor_shm
+
+    try:
+        reader = monitor_shm.ShmReader(name)
+    except monitor_shm.ShmError as e:
+        console.print(f"[bold red]ERROR:[/bold red] {e}")
+        sys.exit(1)
+
+    console.print(f"[green]Reading from shared memory:[/green] {name}")
+    try:
+        with reader, Live(create_layout({}), refresh_per_second=2, screen=True) as live:
+            for data in reader.updates():
+                live.update(create_layout(data))
+    except KeyboardInterrupt:
+        console.print("\n[yellow]Shutting down...[/yellow]")
+
 def main():
+    if '--shm' in sys.argv:
+        index = sys.argv.index('--shm')
+        has_name = index + 1 < len(sys.argv) and not sys.argv[index + 1].startswith('--')
+        run_shm(sys.argv[index + 1] if has_name else '/monitor_core')
+        return
+
     monitor_exe = find_monitor_exe()
     
     if not monitor_exe:
@@ -170,18 +214,23 @@ def main():
     console.print("[yellow]Press Ctrl+C to exit[/yellow]\n")
     
     try:
+        # NDJSON mode: one complete JSON document per line.
+        # With --binary, read the delta-encoded stream instead.
+        use_binary = '--binary' in sys.argv
         process = subprocess.Popen(
-            [monitor_exe],
+            [monitor_exe, '--format', 'binary' if use_binary else 'ndjson'],
             stdout=subprocess.PIPE,
             stderr=subprocess.PIPE,
-            text=True,
-            bufsize=1
+            bufsize=0
         )
         
         with Live(create_layout({}), refresh_per_second=2, screen=True) as live:
-            for line in process.stdout:
+            if use_binary:
+                updates = monitor_wire.read_snapshots(process.stdout)
+            else:
+                updates = read_json_lines(process.stdout)
+            for data in updates:
                 try:
-                    data = json.loads(line.strip())
                     live.update(create_layout(data))
                 except json.JSONDecodeError:
                     continue
@@ -0,0 +1,140 @@
+"""Reader for the shared snapshot ring of `monitor --shm NAME` (Linux).
+
+Wraps libmonitor_shm (cpp/include/monitor_shm.h) with ctypes. Any number of
+readers can attach to one running monitor; reading the newest snapshot is a
+copy out of shared memory with no syscalls, and the monitor never waits for
+readers. Snapshots are dicts with the same shape as the JSON output.
+"""
+
+import ctypes
+import json
+import os
+
+DEFAULT_NAME = '/monitor_core'
+
+_BASE_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+class ShmError(Exception):
+    """Raised when the library or the ring cannot be opened."""
+
+
+def _find_library():
+    candidates = [
+        os.environ.get('MONITOR_SHM_LIB', ''),
+        os.path.join(_BASE_DIR, 'cpp', 'build', 'libmonitor_shm.so'),
+        os.path.join(_BASE_DIR, 'cpp', 'build', 'Release', 'libmonitor_shm.so'),
+        os.path.join(_BASE_DIR, 'cpp', 'build', 'Debug', 'libmonitor_shm.so'),
+    ]
+    for path in candidates:
+        if path and os.path.exists(path):
+            return path
+    return None
+
+
+_lib = None
+
+
+def _load():
+    global _lib
+    if _lib is not None:
+        return _lib
+    path = _find_library()
+    if not path:
+        raise ShmError('libmonitor_shm.so not found; build the C++ monitor first')
+    lib = ctypes.CDLL(path)
+    lib.mc_shm_open.restype = ctypes.c_void_p
+    lib.mc_shm_open.argtypes = [ctypes.c_char_p]
+    lib.mc_shm_close.restype = None
+    lib.mc_shm_close.argtypes = [ctypes.c_void_p]
+    lib.mc_shm_published.restype = ctypes.c_uint64
+    lib.mc_shm_published.argtypes = [ctypes.c_void_p]
+    lib.mc_shm_dropped.restype = ctypes.c_uint64
+    lib.mc_shm_dropped.argtypes = [ctypes.c_void_p]
+    lib.mc_shm_writer_pid.restype = ctypes.c_int64
+    lib.mc_shm_writer_pid.argtypes = [ctypes.c_void_p]
+    lib.mc_shm_read_latest.restype = ctypes.c_int64
+    lib.mc_shm_read_latest.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t,
+                                       ctypes.POINTER(ctypes.c_uint64)]
+    lib.mc_shm_wait.restype = ctypes.c_int
+    lib.mc_shm_wait.argtypes = [ctypes.c_void_p, ctypes.c_uint64, ctypes.c_int]
+    _lib = lib
+    return lib
+
+
+class ShmReader:
+    """Attaches to a running `monitor --shm NAME`."""
+
+    def __init__(self, name=DEFAULT_NAME):
+        self._lib = _load()
+        self._handle = self._lib.mc_shm_open(name.encode())
+        if not self._handle:
+            raise ShmError(f'shared-memory ring {name} not found; start monitor --shm {name}')
+        self._buffer = ctypes.create_string_buffer(64 * 1024)
+        self._counter = ctypes.c_uint64(0)
+
+    def close(self):
+        if self._handle:
+            self._lib.mc_shm_close(self._handle)
+            self._handle = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+    @property
+    def published(self):
+        return self._lib.mc_shm_published(self._handle)
+
+    @property
+    def dropped(self):
+        """Snapshots the writer dropped because they did not fit a slot."""
+        return self._lib.mc_shm_dropped(self._handle)
+
+    def writer_alive(self):
+        pid = self._lib.mc_shm_writer_pid(self._handle)
+        try:
+            os.kill(pid, 0)
+        except ProcessLookupError:
+            return False
+        except PermissionError:
+            pass
+        return True
+
+    def latest(self):
+        """Returns (counter, snapshot dict) for the newest snapshot, or (0, None)."""
+        while True:
+            length = self._lib.mc_shm_read_latest(self._handle, self._buffer, len(self._buffer),
+                                                  ctypes.byref(self._counter))
+            if length >= 0:
+                break
+            self._buffer = ctypes.create_string_buffer(-length)
+        if length == 0:
+            return 0, None
+        return self._counter.value, json.loads(self._buffer.raw[:length])
+
+    def wait(self, after, timeout_ms=-1):
+        """Blocks until a snapshot newer than `after` exists; False on timeout."""
+        return self._lib.mc_shm_wait(self._handle, after, timeout_ms) == 1
+
+    def updates(self, timeout_ms=5000):
+        """Yields each new snapshot; stops when the writer goes away.
+
+        A slow consumer skips to the newest snapshot rather than falling behind.
+        """
+        seen = 0
+        while True:
+            if not self.wait(seen, timeout_ms):
+                if not self.writer_alive():
+                    return
+                continue
+            counter, snapshot = self.latest()
+            if snapshot is None or counter <= seen:
+                continue
+            seen = counter
+            yield snapshot
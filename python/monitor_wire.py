@@ -0,0 +1,386 @@
+"""Decoder for the binary snapshot stream of `monitor --format binary`.
+
+The frame layout and field order are documented in cpp/src/wire_protocol.h.
+Decoded snapshots are dicts with the same shape as the JSON output, so
+callers can switch between `--format ndjson` and `--format binary` freely.
+"""
+
+import struct
+
+PROTOCOL_VERSION = 14
+
+_DISK_FIELDS = 11
+_PROCESS_FIELDS = 16
+# ProcessField bits (include/system_monitor.h) and the keys each one adds
+_PROCESS_THREADS = 1 << 0
+_PROCESS_STATE = 1 << 1
+_PROCESS_UID = 1 << 2
+_PROCESS_SWITCHES = 1 << 3
+_PROCESS_FDS = 1 << 4
+_PROCESS_IO = 1 << 5
+_PROCESS_PSS = 1 << 6
+_PROCESS_CMDLINE = 1 << 7
+_INTERFACE_FIELDS = 9
+_SOCKET_FIELDS = ('tcp', 'tcpTimeWait', 'tcpOrphan', 'udp', 'established', 'synSent', 'synRecv',
+                  'finWait1', 'finWait2', 'closeWait', 'lastAck', 'listen', 'closing', 'closed',
+                  'udpConnected')
+_CPU_TIMES = ('user', 'nice', 'system', 'idle', 'iowait', 'irq', 'softirq', 'steal')
+_MEMORY_FIELDS = ('cached', 'buffers', 'slab', 'slabReclaimable', 'shmem', 'swapTotal', 'swapUsed',
+                  'dirty', 'writeback', 'hugePagesTotal', 'hugePagesUsed', 'pageFaults', 'majorFaults',
+                  'swapIn', 'swapOut', 'pagesScanned', 'pagesReclaimed', 'allocStalls')
+_PRESSURE_FIELDS = ('some10', 'some60', 'some300', 'full10', 'full60', 'full300')
+_CGROUP_VALUES = ('cpuUsage', 'cpuThrottled', 'memoryCurrent', 'memoryAnon', 'memoryFile',
+                  'ioReadSpeed', 'ioWriteSpeed', 'ioReadIops', 'ioWriteIops', 'cpuPressure',
+                  'memoryPressure', 'memoryPressureFull', 'ioPressure', 'ioPressureFull')
+_THREAD_VALUES = ('cpuUsage', 'cpuP50', 'cpuP95', 'cpuP99', 'cpuMax', 'waitP50', 'waitP95', 'waitP99',
+                  'waitMax', 'contextSwitches', 'migrations')
+_TIMING_VALUES = ('lastUs', 'meanUs', 'p50Us', 'p95Us', 'p99Us', 'maxUs', 'lateP99Us', 'lateMaxUs')
+_WINDOW_VALUES = ('mean', 'stddev', 'p50', 'p95', 'p99', 'max')
+
+
+class WireError(Exception):
+    """Raised when the stream is malformed or uses an unknown version."""
+
+
+def _varint(buf, pos):
+    result = 0
+    shift = 0
+    while True:
+        byte = buf[pos]
+        pos += 1
+        result |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return result, pos
+        shift += 7
+
+
+def _zigzag(buf, pos):
+    value, pos = _varint(buf, pos)
+    return (value >> 1) ^ -(value & 1), pos
+
+
+class WireDecoder:
+    """Incremental decoder: feed() raw bytes, get back completed snapshots."""
+
+    def __init__(self):
+        self._pending = bytearray()
+        self._fields = None
+        self._strings = {}
+        self._layout = (0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+
+    def feed(self, data):
+        """Consumes `data` and returns the list of snapshots it completed."""
+        self._pending += data
+        snapshots = []
+        offset = 0
+        while len(self._pending) - offset >= 4:
+            (length,) = struct.unpack_from('<I', self._pending, offset)
+            if len(self._pending) - offset - 4 < length:
+                break
+            frame = bytes(self._pending[offset + 4:offset + 4 + length])
+            offset += 4 + length
+            snapshot = self._frame(frame)
+            if snapshot is not None:
+                snapshots.append(snapshot)
+        del self._pending[:offset]
+        return snapshots
+
+    def _frame(self, frame):
+        kind = frame[:1]
+        payload = frame[1:]
+
+        if kind == b'H':
+            if payload[:4] != b'MCWP' or payload[4] != PROTOCOL_VERSION:
+                raise WireError('unsupported stream header')
+            return None
+
+        if kind == b'S':
+            cores, pos = _varint(payload, 0)
+            disks, pos = _varint(payload, pos)
+            processes, pos = _varint(payload, pos)
+            interfaces, pos = _varint(payload, pos)
+            cgroups, pos = _varint(payload, pos)
+            watched, pos = _varint(payload, pos)
+            threads, pos = _varint(payload, pos)
+            collectors, pos = _varint(payload, pos)
+            windows, pos = _varint(payload, pos)
+            metrics, pos = _varint(payload, pos)
+            anomalies, pos = _varint(payload, pos)
+            active, pos = _varint(payload, pos)
+            events, pos = _varint(payload, pos)
+            self._layout = (cores, disks, processes, interfaces, cgroups, watched, threads, collectors,
+                            windows, metrics, anomalies, active, events)
+            self._strings = {}
+            self._fields = None
+            return None
+
+        if kind == b'D':
+            count, pos = _varint(payload, 0)
+            for _ in range(count):
+                string_id, pos = _varint(payload, pos)
+                length, pos = _varint(payload, pos)
+                self._strings[string_id] = payload[pos:pos + length].decode('utf-8', 'replace')
+                pos += length
+            return None
+
+        if kind == b'K':
+            count, pos = _varint(payload, 0)
+            fields = [0] * count
+            for i in range(count):
+                fields[i], pos = _zigzag(payload, pos)
+            self._fields = fields
+            return self._snapshot()
+
+        if kind == b'T':
+            if self._fields is None:
+                raise WireError('tick before keyframe')
+            fields = self._fields
+            count, pos = _varint(payload, 0)
+            index = -1
+            for _ in range(count):
+                gap, pos = _varint(payload, pos)
+                delta, pos = _zigzag(payload, pos)
+                index += gap
+                fields[index] += delta
+            return self._snapshot()
+
+        raise WireError(f'unknown frame type {kind!r}')
+
+    def _snapshot(self):
+        f = self._fields
+        s = self._strings
+        (cores, disks, processes, interfaces, cgroups, watched, threads, collectors,
+         windows, metrics, anomalies, active, events) = self._layout
+
+        snapshot = {
+            'version': f[0],
+            'timestampMs': f[1],
+            'cpu': {
+                'usage': f[2] / 100,
+                'cores': f[3],
+                'frequency': f[4] / 100,
+                'coreUsage': [v / 100 for v in f[5:5 + cores]],
+            },
+        }
+        pos = 5 + cores
+
+        def times(at):
+            return {name: f[at + i] / 100 for i, name in enumerate(_CPU_TIMES)}
+        snapshot['cpu']['times'] = times(pos)
+        pos += len(_CPU_TIMES)
+        snapshot['cpu']['coreTimes'] = [times(pos + i * len(_CPU_TIMES)) for i in range(cores)]
+        pos += cores * len(_CPU_TIMES)
+        snapshot['cpu']['coreFrequency'] = [v / 100 for v in f[pos:pos + cores]]
+        pos += cores
+
+        snapshot['gpu'] = {
+            'name': s.get(f[pos], ''),
+            'usage': f[pos + 1] / 100,
+            'memoryUsed': f[pos + 2] / 100,
+            'memoryTotal': f[pos + 3] / 100,
+            'temperature': f[pos + 4] / 100,
+        }
+        pos += 5
+
+        snapshot['memory'] = {
+            'total': f[pos] / 100,
+            'used': f[pos + 1] / 100,
+            'free': f[pos + 2] / 100,
+            'usagePercent': f[pos + 3] / 100,
+        }
+        pos += 4
+        for name in _MEMORY_FIELDS:
+            snapshot['memory'][name] = f[pos] / 100
+            pos += 1
+        snapshot['memory']['oomKills'] = f[pos]
+        pos += 1
+        pressure = {name: f[pos + i] / 100 for i, name in enumerate(_PRESSURE_FIELDS)}
+        pos += len(_PRESSURE_FIELDS)
+        pressure['available'] = bool(f[pos])
+        pos += 1
+        snapshot['memory']['pressure'] = pressure
+
+        disk_list = []
+        for _ in range(disks):
+            disk_list.append({
+                'name': s.get(f[pos], ''),
+                'mountPoint': s.get(f[pos + 1], ''),
+                'total': f[pos + 2] / 100,
+                'used': f[pos + 3] / 100,
+                'free': f[pos + 4] / 100,
+                'readSpeed': f[pos + 5] / 100,
+                'writeSpeed': f[pos + 6] / 100,
+                'readIops': f[pos + 7] / 100,
+                'writeIops': f[pos + 8] / 100,
+                'queueDepth': f[pos + 9] / 100,
+                'latency': f[pos + 10] / 100,
+            })
+            pos += _DISK_FIELDS
+        snapshot['disks'] = disk_list
+
+        snapshot['network'] = {
+            'downloadSpeed': f[pos] / 100,
+            'uploadSpeed': f[pos + 1] / 100,
+            'activeConnections': f[pos + 2],
+        }
+        pos += 3
+        snapshot['network']['sockets'] = dict(zip(_SOCKET_FIELDS, f[pos:pos + len(_SOCKET_FIELDS)]))
+        pos += len(_SOCKET_FIELDS)
+        interface_list = []
+        for _ in range(interfaces):
+            interface_list.append({
+                'name': s.get(f[pos], ''),
+                'downloadSpeed': f[pos + 1] / 100,
+                'uploadSpeed': f[pos + 2] / 100,
+                'rxPackets': f[pos + 3] / 100,
+                'txPackets': f[pos + 4] / 100,
+                'rxErrors': f[pos + 5],
+                'txErrors': f[pos + 6],
+                'rxDropped': f[pos + 7],
+                'txDropped': f[pos + 8],
+            })
+            pos += _INTERFACE_FIELDS
+        snapshot['network']['interfaces'] = interface_list
+
+        snapshot['processActivity'] = {
+            'total': f[pos],
+            'spawned': f[pos + 1],
+            'exited': f[pos + 2],
+            'eventDriven': bool(f[pos + 3]),
+        }
+        pos += 4
+
+        def process(at):
+            proc = {
+                'name': s.get(f[at], ''),
+                'pid': f[at + 1],
+                'cpuUsage': f[at + 2] / 100,
+                'memoryUsage': f[at + 3] / 100,
+            }
+            mask = f[at + 4]
+            if mask & _PROCESS_THREADS:
+                proc['threads'] = f[at + 5]
+            if mask & _PROCESS_STATE:
+                proc['state'] = chr(f[at + 6])
+            if mask & _PROCESS_UID:
+                proc['uid'] = f[at + 7]
+            if mask & _PROCESS_SWITCHES:
+                proc['voluntarySwitches'] = f[at + 8] / 100
+                proc['involuntarySwitches'] = f[at + 9] / 100
+            if mask & _PROCESS_FDS:
+                proc['fdCount'] = f[at + 10]
+            if mask & _PROCESS_IO:
+                proc['ioReadSpeed'] = f[at + 11] / 100
+                proc['ioWriteSpeed'] = f[at + 12] / 100
+            if mask & _PROCESS_PSS:
+                proc['pss'] = f[at + 13] / 100
+                proc['swap'] = f[at + 14] / 100
+            if mask & _PROCESS_CMDLINE:
+                proc['cmdline'] = s.get(f[at + 15], '')
+            return proc
+
+        snapshot['processes'] = [process(pos + i * _PROCESS_FIELDS) for i in range(processes)]
+        pos += processes * _PROCESS_FIELDS
+        snapshot['watchedProcesses'] = [process(pos + i * _PROCESS_FIELDS) for i in range(watched)]
+        pos += watched * _PROCESS_FIELDS
+
+        cgroup_list = []
+        for _ in range(cgroups):
+            group = {'path': s.get(f[pos], ''), 'parent': f[pos + 1]}
+            pos += 2
+            for name in _CGROUP_VALUES:
+                group[name] = f[pos] / 100
+                pos += 1
+            cgroup_list.append(group)
+        snapshot['cgroups'] = cgroup_list
+
+        snapshot['threadSampler'] = {
+            'enabled': bool(f[pos]),
+            'pinned': bool(f[pos + 1]),
+            'rate': f[pos + 2] / 100,
+            'overhead': f[pos + 3] / 100,
+            'dropped': f[pos + 4],
+            'missedTicks': f[pos + 5],
+        }
+        pos += 6
+        thread_list = []
+        for _ in range(threads):
+            values = {name: f[pos + 4 + i] / 100 for i, name in enumerate(_THREAD_VALUES)}
+            thread_list.append({
+                'pid': f[pos],
+                'tid': f[pos + 1],
+                'name': s.get(f[pos + 2], ''),
+                'samples': f[pos + 3],
+                'cpuUsage': values['cpuUsage'],
+                'cpu': {'p50': values['cpuP50'], 'p95': values['cpuP95'], 'p99': values['cpuP99'],
+                        'max': values['cpuMax']},
+                'wait': {'p50': values['waitP50'], 'p95': values['waitP95'], 'p99': values['waitP99'],
+                         'max': values['waitMax']},
+                'contextSwitches': values['contextSwitches'],
+                'migrations': values['migrations'],
+            })
+            pos += 4 + len(_THREAD_VALUES)
+        snapshot['threads'] = thread_list
+
+        own = {
+            'cpuUsage': f[pos] / 100,
+            'cpuSeconds': f[pos + 1] / 100,
+            'rssMB': f[pos + 2] / 100,
+            'syscalls': f[pos + 3] / 100,
+        }
+        pos += 4
+        timing_list = []
+        for _ in range(collectors):
+            timing = {'name': s.get(f[pos], ''), 'samples': f[pos + 1], 'skipped': f[pos + 2]}
+            timing.update({name: f[pos + 3 + i] / 100 for i, name in enumerate(_TIMING_VALUES)})
+            timing_list.append(timing)
+            pos += 3 + len(_TIMING_VALUES)
+        own['collectors'] = timing_list
+
+        stats = {'windows': list(f[pos:pos + windows]), 'metrics': []}
+        pos += windows
+        for _ in range(metrics):
+            metric = {'name': s.get(f[pos], ''), 'windows': []}
+            pos += 1
+            for _ in range(windows):
+                window = {'count': f[pos]}
+                window.update({name: f[pos + 1 + i] / 100 for i, name in enumerate(_WINDOW_VALUES)})
+                metric['windows'].append(window)
+                pos += 1 + len(_WINDOW_VALUES)
+            stats['metrics'].append(metric)
+        snapshot['stats'] = stats
+
+        flagged = {'series': f[pos], 'flagged': []}
+        pos += 1
+        for _ in range(anomalies):
+            flagged['flagged'].append({'metric': s.get(f[pos], ''), 'detector': s.get(f[pos + 1], ''),
+                                       'value': f[pos + 2] / 100, 'expected': f[pos + 3] / 100,
+                                       'score': f[pos + 4] / 100, 'sinceMs': f[pos + 5]})
+            pos += 6
+        snapshot['anomalies'] = flagged
+
+        alerts = {'active': [], 'events': []}
+        for _ in range(active):
+            alerts['active'].append({'rule': s.get(f[pos], ''), 'target': s.get(f[pos + 1], ''),
+                                     'value': f[pos + 2] / 100, 'sinceMs': f[pos + 3]})
+            pos += 4
+        for _ in range(events):
+            alerts['events'].append({'sequence': f[pos], 'timestampMs': f[pos + 1], 'firing': bool(f[pos + 2]),
+                                     'rule': s.get(f[pos + 3], ''), 'target': s.get(f[pos + 4], ''),
+                                     'value': f[pos + 5] / 100})
+            pos += 6
+        snapshot['alerts'] = alerts
+        snapshot['self'] = own
+
+        return snapshot
+
+
+def read_snapshots(stream, chunk_size=65536):
+    """Yields decoded snapshots from a binary file object (e.g. Popen.stdout)."""
+    decoder = WireDecoder()
+    while True:
+        data = stream.read1(chunk_size) if hasattr(stream, 'read1') else stream.read(chunk_size)
+        if not data:
+            return
+        for snapshot in decoder.feed(data):
+            yield snapshot
@@ -1,6 +1,3 @@
-// Initialize WebSocket connection
-const socket = io();
-
 // Create gradient function
 function createGradient(ctx, colorStart, colorEnd) {
     const gradient = ctx.createLinearGradient(0, 0, 0, 400);
@@ -291,59 +288,97 @@ function updateProcesses(processes) {
     });
 }
 
-// WebSocket event handlers
-socket.on('connect', () => {
+// Connection event handlers
+function onConnect() {
     console.log('✅ Connected to server');
     document.getElementById('status').classList.add('connected');
     document.querySelector('#status span:last-child').textContent = 'Connected';
-});
+}
 
-socket.on('disconnect', () => {
+function onDisconnect() {
     console.log('❌ Disconnected from server');
     document.getElementById('status').classList.remove('connected');
     document.querySelector('#status span:last-child').textContent = 'Disconnected';
-});
+}
 
-socket.on('system_update', (data) => {
-    console.log('📊 Received system_update:', data);
+function onSystemUpdate(data) {
     try {
-        if (data.cpu) {
-            console.log('Updating CPU:', data.cpu);
-            updateCPU(data.cpu);
-        }
-        if (data.gpu) {
-            console.log('Updating GPU:', data.gpu);
-            updateGPU(data.gpu);
-        }
-        if (data.memory) {
-            console.log('Updating Memory:', data.memory);
-            updateMemory(data.memory);
-        }
-        if (data.network) {
-            console.log('Updating Network:', data.network);
-            updateNetwork(data.network);
-        }
-        if (data.disks) {
-            console.log('Updating Disks:', data.disks);
-            updateDisks(data.disks);
-        }
-        if (data.processes) {
-            console.log('Updating Processes:', data.processes);
-            updateProcesses(data.processes);
-        }
+        if (data.cpu) updateCPU(data.cpu);
+        if (data.gpu) updateGPU(data.gpu);
+        if (data.memory) updateMemory(data.memory);
+        if (data.network) updateNetwork(data.network);
+        if (data.disks) updateDisks(data.disks);
+        if (data.processes) updateProcesses(data.processes);
     } catch (error) {
         console.error('Error updating UI:', error);
     }
-});
+}
 
-socket.on('error', (data) => {
+function onError(data) {
     console.error('❌ Error:', data);
     if (data && data.message) {
         alert('Error: ' + data.message);
     }
-});
+}
 
-// Debug: Log all socket events
-socket.onAny((event, ...args) => {
-    console.log('🔔 Socket event:', event, args);
-});
+// Socket.IO, when served by api/server.py
+function connectSocketIO() {
+    const socket = io();
+    socket.on('connect', onConnect);
+    socket.on('disconnect', onDisconnect);
+    socket.on('system_update', onSystemUpdate);
+    socket.on('error', onError);
+}
+
+// Plain WebSocket, when served by `monitor --http`: every message is one
+// snapshot in the NDJSON format. Reconnects after a second if dropped.
+function connectWebSocket() {
+    const scheme = window.location.protocol === 'https:' ? 'wss://' : 'ws://';
+    const ws = new WebSocket(scheme + window.location.host + '/ws');
+    ws.onopen = onConnect;
+    ws.onmessage = (event) => onSystemUpdate(JSON.parse(event.data));
+    ws.onclose = () => {
+        onDisconnect();
+        setTimeout(connectWebSocket, 1000);
+    };
+}
+
+// Fills the charts with the last maxDataPoints seconds when the monitor
+// keeps a history (`monitor --http PORT --history`); without one the
+// requests fail and the charts start empty
+function loadHistory() {
+    const series = (metric) => fetch('/api/history?metric=' + metric + '&since=' + maxDataPoints)
+        .then((response) => (response.ok ? response.json() : { points: [] }))
+        .then((history) => history.points)
+        .catch(() => []);
+    const label = (point) => {
+        const time = new Date(point.timestampMs);
+        return time.getMinutes() + ':' + time.getSeconds();
+    };
+    const fill = (chart, datasets) => {
+        chart.data.labels = datasets[0].map(label);
+        datasets.forEach((points, i) => {
+            chart.data.datasets[i].data = points.map((point) => point.avg);
+        });
+        chart.update('none');
+    };
+    return Promise.all(['cpu.usage', 'memory.usagePercent', 'network.downloadSpeed', 'network.uploadSpeed']
+        .map(series))
+        .then(([cpu, memory, download, upload]) => {
+            fill(cpuChart, [cpu]);
+            fill(memChart, [memory]);
+            if (download.length === upload.length) fill(netChart, [download, upload]);
+        });
+}
+
+// Both servers answer /api/status; only the built-in one names a transport
+fetch('/api/status')
+    .then((response) => response.json())
+    .catch(() => ({}))
+    .then((status) => {
+        if (status.transport === 'websocket' || typeof io === 'undefined') {
+            loadHistory().then(connectWebSocket);
+        } else {
+            connectSocketIO();
+        }
+    });